@@ -1,11 +1,39 @@
 #include <stdio.h>      // printf, fputs, fgets, stdout
-#include <stdlib.h>     // exit, atoi
-#include <string.h>     // memset, strcmp, strlen
+#include <stdlib.h>     // exit, atoi, malloc, qsort
+#include <string.h>     // memset, strcmp, strlen, memcpy, memmove
+#include <stdint.h>     // uint32_t, uint64_t
 #include <unistd.h>     // read, write, close
-#include <arpa/inet.h>  // inet_addr, htons, sockaddr_in
-#include <sys/socket.h> // socket, connect
+#include <errno.h>      // errno, EAGAIN, EINTR
+#include <fcntl.h>      // fcntl, O_NONBLOCK
+#include <poll.h>       // poll：同时等待可读和可写
+#include <time.h>       // clock_gettime
+#include <arpa/inet.h>  // inet_addr, htons, htonl, ntohl, sockaddr_in
+#include <sys/socket.h> // socket, connect, shutdown, setsockopt
+#include <netinet/tcp.h> // TCP_NODELAY
+
+/*
+ * 用法：
+ *   echo_client2 <IP> <port>                             交互模式：输入一行、等回声、再输入下一行
+ *   echo_client2 <IP> <port> <count> [window] [size]     流水线模式：测试服务器吞吐量
+ *
+ * 交互模式每次都要等上一条消息完整返回才发送下一条，吞吐量受往返时延（RTT）限制：
+ * 每秒最多 1/RTT 条消息。流水线模式不等回声，最多 window 条消息同时在途，
+ * 测出的是服务器本身的处理能力。window 为 1 时就退化成一问一答。
+ *
+ * 流水线模式的每条消息带一个 8 字节的头：[4 字节长度][4 字节序号]，后面是 size 字节的数据。
+ * 回声服务器原样返回，客户端在字节流中按长度切分出消息，用序号找到对应的发送时刻，
+ * 记录每条消息的时延；序号不在途或数据不符时报错退出。
+ */
 
 #define BUF_SIZE 1024 // 读写缓冲区大小
+#define HDR_SIZE 8                  // 流水线消息头：长度 + 序号
+#define MAX_MSG_SIZE 65536          // 单条消息数据的最大长度
+#define MAX_WINDOW 4096             // 最大在途消息数，必须是 2 的幂
+#define PIPE_BUF_SIZE (256 * 1024)  // 流水线模式的发送/接收缓冲区
+
+void pipeline_bench(int sock, long count, int window, int size);
+uint64_t now_ns(void);
+int cmp_u64(const void* a, const void* b);
 void error_handling(char *message);
 
 int main(int argc, char* argv[])
@@ -14,12 +42,24 @@ int main(int argc, char* argv[])
     struct sockaddr_in serv_addr; // 服务器地址
     int str_len, recv_tot, recv_cur; // 发送长度、累计接收长度、单次接收长度
     char message[BUF_SIZE];       // 发送/接收缓冲区
+    int window = 16, size = 64;   // 流水线模式：在途消息数、每条消息的数据长度
+
+    if(argc < 3 || argc > 6)
+    {
+        printf("Usage: %s <IP> <port> [count] [window] [size]\n", argv[0]);
+        exit(1);
+    }
+    if(argc >= 5)
+        window = atoi(argv[4]);
+    if(argc == 6)
+        size = atoi(argv[5]);
+    if(window < 1 || window > MAX_WINDOW || size < 1 || size > MAX_MSG_SIZE)
+        error_handling("window must be 1 ~ 4096, size must be 1 ~ 65536");
 
     // 创建 TCP 套接字
     if( (sock = socket(PF_INET, SOCK_STREAM, 0)) == -1)
         error_handling("socket() error");
     
-    // 这里假定已正确传入 IP 和端口参数
     memset(&serv_addr, 0, sizeof(serv_addr));
     serv_addr.sin_family = AF_INET;
     // IP 字符串转换为网络字节序
@@ -30,7 +70,14 @@ int main(int argc, char* argv[])
     // 连接服务器
     if(connect(sock, (struct sockaddr*)&serv_addr, sizeof(serv_addr)) == -1)
         error_handling("connect() error");
-    
+
+    if(argc >= 4)
+    {
+        pipeline_bench(sock, atol(argv[3]), window, size);
+        close(sock);
+        return 0;
+    }
+
     // 交互式回显：输入一行 -> 发送 -> 循环接收直到长度一致
     while(1)
     {
@@ -62,6 +109,133 @@ int main(int argc, char* argv[])
     return 0;
 }
 
+/*
+ * 流水线模式：套接字设为非阻塞，poll 同时等待可读和可写。
+ * 可写且在途消息不足 window 条时继续发送，可读时接收回声并按消息头切分、匹配序号
+ */
+void pipeline_bench(int sock, long count, int window, int size)
+{
+    static uint64_t sent_at[MAX_WINDOW];    // 在途消息的发送时刻，下标为 序号 % MAX_WINDOW
+    char *wbuf, *rbuf;
+    size_t wlen = 0, rlen = 0, off, msg_len = HDR_SIZE + size;
+    long next_seq = 0, recv_cnt = 0;
+    uint64_t *latencies, start, elapsed, now;
+    uint32_t hdr[2], seq;
+    struct pollfd pfd;
+    ssize_t n;
+    int eof = 0, on = 1;
+
+    wbuf = malloc(PIPE_BUF_SIZE + msg_len);
+    rbuf = malloc(PIPE_BUF_SIZE + msg_len);
+    latencies = malloc(sizeof(uint64_t) * (count > 0 ? count : 1));
+    if(wbuf == NULL || rbuf == NULL || latencies == NULL)
+        error_handling("malloc() error");
+    fcntl(sock, F_SETFL, fcntl(sock, F_GETFL, 0) | O_NONBLOCK);
+    // 消息已经在 wbuf 中攒成批再写出，不需要 Nagle 算法；否则批尾不足一个 MSS 的部分
+    // 要等对方的（延迟）ACK 才能发出，个别消息的时延会多出约 40ms
+    setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+    pfd.fd = sock;
+
+    start = now_ns();
+    while(recv_cnt < count)
+    {
+        // 在途消息不足 window 条：继续组装消息，发送时刻在放入缓冲区时记录
+        while(next_seq < count && next_seq - recv_cnt < window && wlen + msg_len <= PIPE_BUF_SIZE)
+        {
+            hdr[0] = htonl(size);
+            hdr[1] = htonl((uint32_t)next_seq);
+            memcpy(wbuf + wlen, hdr, HDR_SIZE);
+            memset(wbuf + wlen + HDR_SIZE, 'a' + next_seq % 26, size);
+            wlen += msg_len;
+            sent_at[next_seq & (MAX_WINDOW - 1)] = now_ns();
+            next_seq++;
+        }
+
+        pfd.events = POLLIN | (wlen > 0 ? POLLOUT : 0);
+        if(poll(&pfd, 1, -1) == -1)
+        {
+            if(errno == EINTR)
+                continue;
+            error_handling("poll() error");
+        }
+
+        if(pfd.revents & POLLOUT)
+        {
+            n = write(sock, wbuf, wlen);
+            if(n == -1 && errno != EAGAIN && errno != EINTR)
+                error_handling("write() error");
+            if(n > 0)
+            {
+                memmove(wbuf, wbuf + n, wlen - n);
+                wlen -= n;
+            }
+        }
+
+        if(pfd.revents & (POLLIN | POLLERR | POLLHUP))
+        {
+            n = read(sock, rbuf + rlen, PIPE_BUF_SIZE + msg_len - rlen);
+            if(n == 0)
+            {
+                eof = 1;
+                break;
+            }
+            if(n == -1 && errno != EAGAIN && errno != EINTR)
+                error_handling("read() error");
+            if(n > 0)
+                rlen += n;
+
+            // 切分出完整的消息：检查长度、序号和数据，记录时延
+            now = now_ns();
+            for(off = 0; rlen - off >= msg_len; off += msg_len)
+            {
+                memcpy(hdr, rbuf + off, HDR_SIZE);
+                seq = ntohl(hdr[1]);
+                if(ntohl(hdr[0]) != (uint32_t)size || seq != (uint32_t)recv_cnt
+                   || rbuf[off + HDR_SIZE] != (char)('a' + seq % 26)
+                   || rbuf[off + msg_len - 1] != (char)('a' + seq % 26))
+                    error_handling("response does not match any outstanding message");
+                latencies[recv_cnt++] = now - sent_at[seq & (MAX_WINDOW - 1)];
+            }
+            memmove(rbuf, rbuf + off, rlen - off);
+            rlen -= off;
+        }
+    }
+    elapsed = now_ns() - start;
+
+    // 全部收到后半关闭，告诉服务器不会再发送
+    shutdown(sock, SHUT_WR);
+    if(eof)
+        fprintf(stderr, "server closed connection, %ld messages unanswered\n", next_seq - recv_cnt);
+
+    printf("%ld/%ld messages of %d bytes, window %d, %.3f s, %.0f msg/s, %.1f MB/s\n",
+           recv_cnt, count, size, window, elapsed / 1e9, recv_cnt / (elapsed / 1e9),
+           recv_cnt * (double)msg_len / (elapsed / 1e9) / 1e6);
+    if(recv_cnt > 0)
+    {
+        qsort(latencies, recv_cnt, sizeof(uint64_t), cmp_u64);
+        printf("latency: p50 %.1f us, p99 %.1f us, max %.1f us\n", latencies[recv_cnt / 2] / 1e3,
+               latencies[(long)(recv_cnt * 0.99)] / 1e3, latencies[recv_cnt - 1] / 1e3);
+    }
+    free(wbuf);
+    free(rbuf);
+    free(latencies);
+}
+
+uint64_t now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+int cmp_u64(const void* a, const void* b)
+{
+    uint64_t x = *(const uint64_t*)a, y = *(const uint64_t*)b;
+
+    return x < y ? -1 : x > y;
+}
+
 void error_handling(char *message)
 {
     // 将错误信息输出到标准错误并终止程序
@@ -0,0 +1,887 @@
+#include <stdio.h>      // fputs
+#include <stdlib.h>     // malloc / calloc / free / getenv / atof / atoi / rand_r
+#include <string.h>     // memset / memcpy
+#include <stdint.h>     // uint8_t / uint16_t / uint32_t / uint64_t
+#include <unistd.h>     // close / getpid
+#include <errno.h>      // errno
+#include <poll.h>       // poll：等待套接字可读或定时器到期
+#include <time.h>       // clock_gettime
+#include <arpa/inet.h>  // inet_addr / htons / htonl / ntohl
+#include <sys/socket.h> // socket / bind / connect / send / recv / recvfrom
+#include "rudp.h"
+
+/*
+ * rudp 的实现，接口说明见 rudp.h
+ *
+ * 包头（28 字节，网络字节序）：
+ *   [1 类型][1 标志][2 接收窗口][4 会话号][4 序号][4 累计确认][4 SACK 位图][4 时间戳][4 时间戳回显]
+ *   后面紧跟消息数据（仅 DATA 包）
+ *
+ *   - 会话号：客户端随机生成，服务器端沿用；会话号不同的包（例如上一次会话残留的重传）直接丢弃
+ *   - 累计确认 ack：接收方期望的下一个序号（ack 之前的都已收到）
+ *   - SACK 位图：第 i 位表示序号 ack+1+i 的包已收到
+ *   - 时间戳回显：ACK 原样带回触发它的 DATA 包中的时间戳，发送方据此计算 RTT，
+ *     对重传包也能得到正确的样本（不存在 Karn 算法要解决的歧义）
+ */
+
+#define PKT_DATA 1
+#define PKT_ACK 2
+#define FLAG_FIN 1              // DATA 包标志：关闭标记（不携带数据，占用一个序号）
+
+#define HDR_SIZE 28
+#define PKT_MAX (HDR_SIZE + RUDP_MAX_PAYLOAD)
+#define WMASK (RUDP_WINDOW - 1)
+#define DUP_THRESH 3            // 快速重传阈值：之后已有 3 个包被确认
+#define INIT_RTO_US 200000      // 初始 RTO：200ms
+#define MIN_RTO_US 20000        // RTO 下限：20ms（面向局域网/本机，比 TCP 的 200ms 更激进）
+#define MAX_RTO_US 2000000      // RTO 上限：2s
+#define MAX_RETX 12             // 同一个包超时重传超过该次数，认为连接失效
+#define IMPAIR_SLOTS 1024       // 延迟注入队列容量
+
+/* 序号比较：考虑 32 位回绕 */
+#define SEQ_LT(a, b) ((int32_t)((uint32_t)(a) - (uint32_t)(b)) < 0)
+
+/* 接收槽位状态 */
+enum { SLOT_EMPTY = 0, SLOT_READY, SLOT_DELIVERED };
+
+typedef struct {
+    uint8_t type, flags;
+    uint16_t wnd;
+    uint32_t conv, seq, ack, sack, ts, ts_echo;
+} pkt_hdr;
+
+/* 发送槽位：保存已分配序号、尚未被确认的消息，以便重传 */
+typedef struct {
+    uint8_t data[RUDP_MAX_PAYLOAD];
+    uint16_t len;
+    uint8_t flags;
+    uint8_t sacked;             // 已被 SACK 确认
+    uint64_t sent_us;           // 最近一次发送时间
+    int retx;                   // 超时重传次数
+} snd_slot;
+
+/* 接收槽位 */
+typedef struct {
+    uint8_t data[RUDP_MAX_PAYLOAD];
+    uint16_t len;
+    uint8_t flags;
+    uint8_t state;
+} rcv_slot;
+
+/* 延迟注入队列中的一个包 */
+typedef struct {
+    uint64_t due_us;
+    uint16_t len;
+    uint8_t used;
+    uint8_t buf[PKT_MAX];
+} delayed_pkt;
+
+struct rudp_conn {
+    int sock;
+    int flags;
+    int dead;                   // 连接失效（重传次数过多）
+    uint32_t conv;
+
+    /* 发送方向：[snd_una, snd_nxt) 已发送未确认，[snd_nxt, snd_end) 已入队未发送 */
+    snd_slot* snd;
+    uint32_t snd_una, snd_nxt, snd_end;
+    uint32_t peer_wnd_edge;     // 对端允许发送的序号上界（ack + 通告窗口）
+    uint32_t cwnd, ssthresh, cwnd_acc;
+    int in_recovery;
+    uint32_t recovery_end;      // 恢复阶段结束点：snd_una 越过它时退出恢复
+    uint64_t rto_deadline;      // 超时重传定时器（0 表示未启动）
+    uint64_t persist_deadline;  // 零窗口探测定时器（0 表示未启动）
+    int64_t srtt_us, rttvar_us, rto_us;
+    int fin_sent;
+
+    /* 接收方向：[rcv_read, rcv_nxt) 已收到连续的数据，rcv_nxt 之后可能有乱序到达的数据 */
+    rcv_slot* rcv;
+    uint32_t rcv_read, rcv_nxt;
+    uint16_t last_wnd;          // 上一次通告的窗口
+    int fin_recv;               // 已收到（但未必已交付）对端的关闭标记
+    int fin_delivered;          // 关闭标记已交付给应用
+
+    /* 丢包/延迟注入 */
+    double loss;
+    int64_t delay_us, jitter_us;
+    unsigned int rand_seed;
+    delayed_pkt* delayed;
+    int delayed_cnt;
+
+    rudp_stats st;
+};
+
+static uint64_t now_us(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static void put_hdr(uint8_t* p, const pkt_hdr* h)
+{
+    uint32_t v;
+
+    p[0] = h->type;
+    p[1] = h->flags;
+    p[2] = h->wnd >> 8;
+    p[3] = h->wnd & 0xff;
+    v = htonl(h->conv);    memcpy(p + 4, &v, 4);
+    v = htonl(h->seq);     memcpy(p + 8, &v, 4);
+    v = htonl(h->ack);     memcpy(p + 12, &v, 4);
+    v = htonl(h->sack);    memcpy(p + 16, &v, 4);
+    v = htonl(h->ts);      memcpy(p + 20, &v, 4);
+    v = htonl(h->ts_echo); memcpy(p + 24, &v, 4);
+}
+
+static void get_hdr(const uint8_t* p, pkt_hdr* h)
+{
+    uint32_t v;
+
+    h->type = p[0];
+    h->flags = p[1];
+    h->wnd = (uint16_t)((p[2] << 8) | p[3]);
+    memcpy(&v, p + 4, 4);  h->conv = ntohl(v);
+    memcpy(&v, p + 8, 4);  h->seq = ntohl(v);
+    memcpy(&v, p + 12, 4); h->ack = ntohl(v);
+    memcpy(&v, p + 16, 4); h->sack = ntohl(v);
+    memcpy(&v, p + 20, 4); h->ts = ntohl(v);
+    memcpy(&v, p + 24, 4); h->ts_echo = ntohl(v);
+}
+
+/* -------------------- 丢包/延迟注入 -------------------- */
+
+/* 所有出站包都经过这里：按概率丢弃，或放入延迟队列，否则立即发送 */
+static void raw_send(rudp_conn* c, const uint8_t* pkt, int len)
+{
+    int i;
+    int64_t d;
+
+    if(c->loss > 0 && rand_r(&c->rand_seed) < c->loss * ((double)RAND_MAX + 1))
+    {
+        c->st.impair_drops++;
+        return;
+    }
+    if(c->delay_us > 0 || c->jitter_us > 0)
+    {
+        d = c->delay_us;
+        if(c->jitter_us > 0)
+            d += rand_r(&c->rand_seed) % (c->jitter_us + 1);
+        for(i = 0; i < IMPAIR_SLOTS; i++)
+        {
+            if(!c->delayed[i].used)
+            {
+                c->delayed[i].used = 1;
+                c->delayed[i].due_us = now_us() + d;
+                c->delayed[i].len = (uint16_t)len;
+                memcpy(c->delayed[i].buf, pkt, len);
+                c->delayed_cnt++;
+                return;
+            }
+        }
+        // 延迟队列满：退化为立即发送
+    }
+    send(c->sock, pkt, len, 0);
+}
+
+/* 发送延迟队列中已到期的包；抖动会让到期顺序与入队顺序不同，从而模拟乱序 */
+static void flush_delayed(rudp_conn* c)
+{
+    uint64_t now;
+    int i;
+
+    if(c->delayed_cnt == 0)
+        return;
+    now = now_us();
+    for(i = 0; i < IMPAIR_SLOTS; i++)
+    {
+        if(c->delayed[i].used && c->delayed[i].due_us <= now)
+        {
+            send(c->sock, c->delayed[i].buf, c->delayed[i].len, 0);
+            c->delayed[i].used = 0;
+            c->delayed_cnt--;
+        }
+    }
+}
+
+static uint64_t next_delayed_due(rudp_conn* c)
+{
+    uint64_t due = 0;
+    int i;
+
+    if(c->delayed_cnt == 0)
+        return 0;
+    for(i = 0; i < IMPAIR_SLOTS; i++)
+        if(c->delayed[i].used && (due == 0 || c->delayed[i].due_us < due))
+            due = c->delayed[i].due_us;
+    return due;
+}
+
+void rudp_set_impair(rudp_conn* c, double loss_pct, int delay_ms, int jitter_ms)
+{
+    c->loss = loss_pct / 100.0;
+    c->delay_us = (int64_t)delay_ms * 1000;
+    c->jitter_us = (int64_t)jitter_ms * 1000;
+}
+
+/* -------------------- 发送 ACK / DATA -------------------- */
+
+/* 当前可以通告给对端的接收窗口：rcv_nxt 之后还有多少空槽位 */
+static uint16_t rcv_window(rudp_conn* c)
+{
+    return (uint16_t)(RUDP_WINDOW - (c->rcv_nxt - c->rcv_read));
+}
+
+static void send_ack(rudp_conn* c, uint32_t ts_echo)
+{
+    uint8_t pkt[HDR_SIZE];
+    pkt_hdr h;
+    uint32_t s;
+    int i;
+
+    memset(&h, 0, sizeof(h));
+    h.type = PKT_ACK;
+    h.conv = c->conv;
+    h.ack = c->rcv_nxt;
+    h.wnd = rcv_window(c);
+    h.ts_echo = ts_echo;
+
+    // SACK 位图：rcv_nxt 之后已乱序收到的包
+    for(i = 0; i < 32; i++)
+    {
+        s = c->rcv_nxt + 1 + i;
+        if(s - c->rcv_read >= RUDP_WINDOW)
+            break;
+        if(c->rcv[s & WMASK].state != SLOT_EMPTY)
+            h.sack |= 1u << i;
+    }
+    c->last_wnd = h.wnd;
+    put_hdr(pkt, &h);
+    raw_send(c, pkt, HDR_SIZE);
+}
+
+static void send_data(rudp_conn* c, uint32_t seq)
+{
+    uint8_t pkt[PKT_MAX];
+    snd_slot* s = &c->snd[seq & WMASK];
+    pkt_hdr h;
+
+    memset(&h, 0, sizeof(h));
+    h.type = PKT_DATA;
+    h.flags = s->flags;
+    h.conv = c->conv;
+    h.seq = seq;
+    h.ack = c->rcv_nxt;             // 顺带携带本端的接收状态（对端目前只用 ACK 包中的确认）
+    h.wnd = rcv_window(c);
+    s->sent_us = now_us();
+    h.ts = (uint32_t)s->sent_us;
+    put_hdr(pkt, &h);
+    memcpy(pkt + HDR_SIZE, s->data, s->len);
+    raw_send(c, pkt, HDR_SIZE + s->len);
+    c->st.data_sent++;
+
+    if(c->rto_deadline == 0)
+        c->rto_deadline = s->sent_us + c->rto_us;
+}
+
+/* 在拥塞窗口、对端接收窗口允许的范围内发送新数据 */
+static void try_send(rudp_conn* c)
+{
+    uint64_t now;
+
+    while(c->snd_nxt != c->snd_end
+          && c->snd_nxt - c->snd_una < c->cwnd
+          && SEQ_LT(c->snd_nxt, c->peer_wnd_edge))
+    {
+        send_data(c, c->snd_nxt);
+        c->snd_nxt++;
+    }
+
+    // 零窗口：对端窗口已满且没有在途数据时，启动探测定时器，
+    // 防止对端的"窗口更新"ACK 丢失导致双方永远等待
+    if(c->snd_nxt != c->snd_end && c->snd_nxt == c->snd_una
+       && !SEQ_LT(c->snd_nxt, c->peer_wnd_edge))
+    {
+        now = now_us();
+        if(c->persist_deadline == 0)
+            c->persist_deadline = now + c->rto_us;
+        else if(now >= c->persist_deadline)
+        {
+            send_data(c, c->snd_nxt);   // 探测包：对端有空间就接收，没有就丢弃，但都会回 ACK
+            c->snd_nxt++;
+            c->persist_deadline = 0;
+        }
+    }
+    else
+        c->persist_deadline = 0;
+}
+
+/* -------------------- 处理收到的包 -------------------- */
+
+/* RFC 6298：用新的 RTT 样本更新 SRTT / RTTVAR / RTO */
+static void update_rtt(rudp_conn* c, int64_t sample)
+{
+    int64_t err;
+
+    if(sample <= 0)
+        sample = 1;
+    if(c->srtt_us == 0)
+    {
+        c->srtt_us = sample;
+        c->rttvar_us = sample / 2;
+    }
+    else
+    {
+        err = sample - c->srtt_us;
+        if(err < 0)
+            err = -err;
+        c->rttvar_us = (3 * c->rttvar_us + err) / 4;
+        c->srtt_us = (7 * c->srtt_us + sample) / 8;
+    }
+    c->rto_us = c->srtt_us + 4 * c->rttvar_us;
+    if(c->rto_us < MIN_RTO_US)
+        c->rto_us = MIN_RTO_US;
+    if(c->rto_us > MAX_RTO_US)
+        c->rto_us = MAX_RTO_US;
+}
+
+/* 检测到丢包：进入快速恢复，拥塞窗口减半（每个窗口只减一次） */
+static void enter_recovery(rudp_conn* c)
+{
+    if(c->in_recovery)
+        return;
+    c->ssthresh = c->cwnd / 2 < 2 ? 2 : c->cwnd / 2;
+    c->cwnd = c->ssthresh;
+    c->cwnd_acc = 0;
+    c->in_recovery = 1;
+    c->recovery_end = c->snd_nxt;
+}
+
+static void handle_ack(rudp_conn* c, const pkt_hdr* h)
+{
+    uint32_t s, newly = 0, sacked_above, thresh;
+    uint64_t now = now_us();
+    int i;
+
+    // 确认号超出已发送范围：无效包
+    if(SEQ_LT(c->snd_nxt, h->ack) || SEQ_LT(h->ack, c->snd_una - RUDP_WINDOW))
+        return;
+
+    if(h->ts_echo != 0)
+        update_rtt(c, (int32_t)((uint32_t)now - h->ts_echo));
+
+    // 累计确认：释放 ack 之前的槽位
+    if(SEQ_LT(c->snd_una, h->ack))
+    {
+        while(SEQ_LT(c->snd_una, h->ack))
+        {
+            if(!c->snd[c->snd_una & WMASK].sacked)
+                newly++;
+            c->snd[c->snd_una & WMASK].sacked = 0;
+            c->snd_una++;
+        }
+        // 有新数据被确认：重启超时定时器
+        c->rto_deadline = c->snd_una != c->snd_nxt ? now + c->rto_us : 0;
+    }
+
+    // 选择确认
+    for(i = 0; i < 32; i++)
+    {
+        s = h->ack + 1 + i;
+        if(!SEQ_LT(s, c->snd_nxt))
+            break;
+        // 过时的 ACK 可能确认已释放的序号，其槽位也许已被新消息复用，必须跳过
+        if(SEQ_LT(s, c->snd_una))
+            continue;
+        if((h->sack & (1u << i)) && !c->snd[s & WMASK].sacked)
+        {
+            c->snd[s & WMASK].sacked = 1;
+            newly++;
+        }
+    }
+
+    // 只采用最新 ACK 中的窗口，乱序到达的旧 ACK 不能把窗口缩回去
+    if(h->ack == c->snd_una)
+        c->peer_wnd_edge = h->ack + h->wnd;
+
+    if(c->in_recovery && !SEQ_LT(c->snd_una, c->recovery_end))
+        c->in_recovery = 0;
+
+    // 拥塞窗口增长：慢启动每确认一个包 +1；拥塞避免每确认一个窗口 +1。
+    // 快速恢复期间窗口保持不变；超时后 cwnd 已回到 1，恢复期间也照常慢启动
+    if((!c->in_recovery || c->cwnd < c->ssthresh) && newly > 0)
+    {
+        if(c->cwnd < c->ssthresh)
+            c->cwnd += newly;
+        else
+        {
+            c->cwnd_acc += newly;
+            if(c->cwnd_acc >= c->cwnd)
+            {
+                c->cwnd_acc -= c->cwnd;
+                c->cwnd++;
+            }
+        }
+        if(c->cwnd > RUDP_WINDOW)
+            c->cwnd = RUDP_WINDOW;
+    }
+
+    // 快速重传：从高序号往低序号扫描，某个未确认的包之后已有 DUP_THRESH 个包被确认，则判定丢失。
+    // 在途包太少时凑不齐 DUP_THRESH 个确认，阈值降为"在途数 - 1"（RFC 5827 提前重传），避免只能等超时。
+    // 距上次发送不足一个 SRTT 的不重复重传（重传包可能还在路上）
+    thresh = c->snd_nxt - c->snd_una - 1;
+    if(thresh > DUP_THRESH)
+        thresh = DUP_THRESH;
+    if(thresh < 1)
+        thresh = 1;
+    sacked_above = 0;
+    for(s = c->snd_nxt; s != c->snd_una;)
+    {
+        s--;
+        if(c->snd[s & WMASK].sacked)
+            sacked_above++;
+        else if(sacked_above >= thresh
+                && now - c->snd[s & WMASK].sent_us > (uint64_t)c->srtt_us)
+        {
+            enter_recovery(c);
+            send_data(c, s);
+            c->st.fast_retx++;
+        }
+    }
+}
+
+static void handle_data(rudp_conn* c, const pkt_hdr* h, const uint8_t* payload, int len)
+{
+    rcv_slot* r;
+
+    c->st.data_recv++;
+
+    if(SEQ_LT(h->seq, c->rcv_nxt) || h->seq - c->rcv_read >= RUDP_WINDOW)
+    {
+        // 已收到过（重复），或超出接收窗口：丢弃，但仍要回 ACK 让对端知道当前状态
+        if(SEQ_LT(h->seq, c->rcv_nxt))
+            c->st.dup_recv++;
+        send_ack(c, h->ts);
+        return;
+    }
+
+    r = &c->rcv[h->seq & WMASK];
+    if(r->state == SLOT_EMPTY)
+    {
+        memcpy(r->data, payload, len);
+        r->len = (uint16_t)len;
+        r->flags = h->flags;
+        r->state = SLOT_READY;
+        if(h->flags & FLAG_FIN)
+            c->fin_recv = 1;
+        // 推进 rcv_nxt：越过所有已收到的连续序号
+        while(c->rcv_nxt - c->rcv_read < RUDP_WINDOW
+              && c->rcv[c->rcv_nxt & WMASK].state != SLOT_EMPTY)
+            c->rcv_nxt++;
+    }
+    else
+        c->st.dup_recv++;
+
+    send_ack(c, h->ts);
+}
+
+static void handle_packet(rudp_conn* c, const uint8_t* pkt, int len)
+{
+    pkt_hdr h;
+
+    if(len < HDR_SIZE)
+        return;
+    get_hdr(pkt, &h);
+    if(h.conv != c->conv)
+        return;     // 其它会话的残留包
+    if(h.type == PKT_ACK)
+        handle_ack(c, &h);
+    else if(h.type == PKT_DATA && len - HDR_SIZE <= RUDP_MAX_PAYLOAD)
+        handle_data(c, &h, pkt + HDR_SIZE, len - HDR_SIZE);
+}
+
+/* 超时重传：重传最早的未确认包，RTO 指数退避，拥塞窗口回到 1 */
+static void check_timers(rudp_conn* c)
+{
+    uint64_t now = now_us();
+    uint32_t s;
+    snd_slot* slot;
+
+    if(c->rto_deadline == 0 || now < c->rto_deadline)
+        return;
+    if(c->snd_una == c->snd_nxt)
+    {
+        c->rto_deadline = 0;
+        return;
+    }
+
+    for(s = c->snd_una; s != c->snd_nxt; s++)
+        if(!c->snd[s & WMASK].sacked)
+            break;
+    if(s == c->snd_nxt)
+        s = c->snd_una;
+    slot = &c->snd[s & WMASK];
+    // 超出对端窗口的是零窗口探测包：对端只是暂时没有读取，不计入失效判定
+    if(SEQ_LT(s, c->peer_wnd_edge) && ++slot->retx > MAX_RETX)
+    {
+        c->dead = 1;
+        return;
+    }
+
+    c->ssthresh = c->cwnd / 2 < 2 ? 2 : c->cwnd / 2;
+    c->cwnd = 1;
+    c->cwnd_acc = 0;
+    c->in_recovery = 1;
+    c->recovery_end = c->snd_nxt;
+    c->rto_us *= 2;
+    if(c->rto_us > MAX_RTO_US)
+        c->rto_us = MAX_RTO_US;
+
+    c->rto_deadline = 0;
+    send_data(c, s);        // send_data 会以新的 RTO 重新启动定时器
+    c->st.timeout_retx++;
+}
+
+/*
+ * 驱动一次 I/O：等待最多 timeout_ms 毫秒（-1 为不限），处理收到的包、到期的定时器，
+ * 并在窗口允许时发送新数据
+ */
+static int rudp_poll(rudp_conn* c, int timeout_ms)
+{
+    struct pollfd pfd;
+    uint8_t pkt[PKT_MAX];
+    uint64_t now, deadline = 0, due;
+    int len, wait_ms;
+
+    if(c->dead)
+        return -1;
+
+    now = now_us();
+    if(timeout_ms >= 0)
+        deadline = now + (uint64_t)timeout_ms * 1000;
+    // 等待时间不能越过最近的定时器
+    if(c->rto_deadline && (deadline == 0 || c->rto_deadline < deadline))
+        deadline = c->rto_deadline;
+    if(c->persist_deadline && (deadline == 0 || c->persist_deadline < deadline))
+        deadline = c->persist_deadline;
+    due = next_delayed_due(c);
+    if(due && (deadline == 0 || due < deadline))
+        deadline = due;
+
+    if(deadline == 0)
+        wait_ms = -1;
+    else if(deadline <= now)
+        wait_ms = 0;
+    else
+        wait_ms = (int)((deadline - now + 999) / 1000);
+
+    pfd.fd = c->sock;
+    pfd.events = POLLIN;
+    if(poll(&pfd, 1, wait_ms) > 0)
+    {
+        // 一次性取走所有已到达的包
+        while((len = recv(c->sock, pkt, sizeof(pkt), MSG_DONTWAIT)) >= 0)
+            handle_packet(c, pkt, len);
+    }
+
+    check_timers(c);
+    try_send(c);
+    flush_delayed(c);
+    return c->dead ? -1 : 0;
+}
+
+/* -------------------- 建立连接 -------------------- */
+
+static rudp_conn* conn_new(int sock, int flags)
+{
+    rudp_conn* c = calloc(1, sizeof(rudp_conn));
+    const char* env;
+
+    if(c == NULL)
+        return NULL;
+    c->sock = sock;
+    c->flags = flags;
+    c->snd = calloc(RUDP_WINDOW, sizeof(snd_slot));
+    c->rcv = calloc(RUDP_WINDOW, sizeof(rcv_slot));
+    c->delayed = calloc(IMPAIR_SLOTS, sizeof(delayed_pkt));
+    if(!c->snd || !c->rcv || !c->delayed)
+    {
+        free(c->snd);
+        free(c->rcv);
+        free(c->delayed);
+        free(c);
+        return NULL;
+    }
+    c->peer_wnd_edge = RUDP_WINDOW;
+    c->cwnd = 4;
+    c->ssthresh = RUDP_WINDOW;
+    c->rto_us = INIT_RTO_US;
+    c->last_wnd = RUDP_WINDOW;
+    c->rand_seed = (unsigned int)(now_us() ^ getpid());
+
+    // 环境变量方式开启丢包/延迟注入：无需修改使用本库的程序
+    if((env = getenv("RUDP_LOSS")) != NULL)
+        c->loss = atof(env) / 100.0;
+    if((env = getenv("RUDP_DELAY_MS")) != NULL)
+        c->delay_us = (int64_t)atoi(env) * 1000;
+    if((env = getenv("RUDP_JITTER_MS")) != NULL)
+        c->jitter_us = (int64_t)atoi(env) * 1000;
+    return c;
+}
+
+rudp_conn* rudp_connect(const char* ip, int port, int flags)
+{
+    struct sockaddr_in addr;
+    rudp_conn* c;
+    int sock;
+
+    sock = socket(PF_INET, SOCK_DGRAM, 0);
+    if(sock == -1)
+        return NULL;
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = inet_addr(ip);
+    addr.sin_port = htons(port);
+    // 已连接 UDP：只接收来自对端的包，且 send/recv 无需携带地址
+    if(connect(sock, (struct sockaddr*)&addr, sizeof(addr)) == -1)
+    {
+        close(sock);
+        return NULL;
+    }
+
+    c = conn_new(sock, flags);
+    if(c == NULL)
+    {
+        close(sock);
+        return NULL;
+    }
+    // 会话号：随机且非 0
+    do
+        c->conv = (uint32_t)rand_r(&c->rand_seed) ^ ((uint32_t)rand_r(&c->rand_seed) << 16);
+    while(c->conv == 0);
+    return c;
+}
+
+rudp_conn* rudp_accept(int port, int flags)
+{
+    struct sockaddr_in addr, peer;
+    socklen_t peer_sz;
+    uint8_t pkt[PKT_MAX];
+    pkt_hdr h;
+    rudp_conn* c;
+    int sock, len;
+
+    sock = socket(PF_INET, SOCK_DGRAM, 0);
+    if(sock == -1)
+        return NULL;
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons(port);
+    if(bind(sock, (struct sockaddr*)&addr, sizeof(addr)) == -1)
+    {
+        close(sock);
+        return NULL;
+    }
+
+    // 等待第一个 DATA 包：MSG_PEEK 只查看不取出，该包稍后由正常流程处理
+    while(1)
+    {
+        peer_sz = sizeof(peer);
+        len = recvfrom(sock, pkt, sizeof(pkt), MSG_PEEK, (struct sockaddr*)&peer, &peer_sz);
+        if(len == -1 && errno == EINTR)
+            continue;
+        if(len == -1)
+        {
+            close(sock);
+            return NULL;
+        }
+        if(len >= HDR_SIZE)
+        {
+            get_hdr(pkt, &h);
+            if(h.type == PKT_DATA && h.seq == 0)
+                break;
+        }
+        recv(sock, pkt, sizeof(pkt), 0);    // 丢弃残留的无关包
+    }
+
+    if(connect(sock, (struct sockaddr*)&peer, sizeof(peer)) == -1)
+    {
+        close(sock);
+        return NULL;
+    }
+    c = conn_new(sock, flags);
+    if(c == NULL)
+    {
+        close(sock);
+        return NULL;
+    }
+    c->conv = h.conv;
+    return c;
+}
+
+/* -------------------- 收发接口 -------------------- */
+
+static int enqueue(rudp_conn* c, const void* buf, int len, uint8_t flags)
+{
+    snd_slot* s;
+
+    // 发送窗口已满：驱动 I/O 直到有槽位被确认释放
+    while(c->snd_end - c->snd_una >= RUDP_WINDOW)
+        if(rudp_poll(c, -1) == -1)
+            return -1;
+
+    s = &c->snd[c->snd_end & WMASK];
+    memcpy(s->data, buf, len);
+    s->len = (uint16_t)len;
+    s->flags = flags;
+    s->sacked = 0;
+    s->retx = 0;
+    c->snd_end++;
+    try_send(c);
+    flush_delayed(c);
+    return len;
+}
+
+int rudp_send(rudp_conn* c, const void* buf, int len)
+{
+    if(len < 1 || len > RUDP_MAX_PAYLOAD || c->dead || c->fin_sent)
+        return -1;
+    return enqueue(c, buf, len, 0);
+}
+
+/* 取出一条可交付的消息；没有则返回 0 */
+static int deliver(rudp_conn* c, void* buf, int cap)
+{
+    rcv_slot* r = NULL;
+    uint32_t s;
+    int len;
+
+    if(c->flags & RUDP_UNORDERED)
+    {
+        // 无序交付：任意一个已到达且未交付的消息都可以交给应用；
+        // 关闭标记必须等前面的消息全部交付后才交付
+        for(s = c->rcv_read; s - c->rcv_read < RUDP_WINDOW; s++)
+        {
+            r = &c->rcv[s & WMASK];
+            if(r->state == SLOT_READY && (!(r->flags & FLAG_FIN) || s == c->rcv_read))
+                break;
+            r = NULL;
+        }
+    }
+    else if(c->rcv_read != c->rcv_nxt && c->rcv[c->rcv_read & WMASK].state == SLOT_READY)
+        r = &c->rcv[c->rcv_read & WMASK];
+
+    if(r == NULL)
+        return 0;
+
+    if(r->flags & FLAG_FIN)
+    {
+        c->fin_delivered = 1;
+        len = -1;
+    }
+    else
+    {
+        len = r->len < cap ? r->len : cap;
+        memcpy(buf, r->data, len);
+    }
+    r->state = SLOT_DELIVERED;
+
+    // 释放 rcv_read 开始的连续已交付槽位
+    while(c->rcv_read != c->rcv_nxt && c->rcv[c->rcv_read & WMASK].state == SLOT_DELIVERED)
+    {
+        c->rcv[c->rcv_read & WMASK].state = SLOT_EMPTY;
+        c->rcv_read++;
+    }
+
+    // 窗口从"快满"恢复到一半以上时，主动发送窗口更新
+    if(c->last_wnd < RUDP_WINDOW / 2 && rcv_window(c) >= RUDP_WINDOW / 2)
+        send_ack(c, 0);
+    return len;
+}
+
+int rudp_recv(rudp_conn* c, void* buf, int cap, int timeout_ms)
+{
+    uint64_t deadline = 0, now;
+    int len, wait;
+
+    if(c->fin_delivered)
+        return -1;
+    if(timeout_ms >= 0)
+        deadline = now_us() + (uint64_t)timeout_ms * 1000;
+
+    while(1)
+    {
+        len = deliver(c, buf, cap);
+        if(len != 0)
+            return len;
+
+        wait = -1;
+        if(timeout_ms >= 0)
+        {
+            now = now_us();
+            if(now >= deadline)
+            {
+                // 超时前再处理一次已到达的包（timeout_ms 为 0 时相当于非阻塞检查）
+                if(rudp_poll(c, 0) == -1)
+                    return -1;
+                len = deliver(c, buf, cap);
+                return len;
+            }
+            wait = (int)((deadline - now + 999) / 1000);
+        }
+        if(rudp_poll(c, wait) == -1)
+            return -1;
+    }
+}
+
+int rudp_flush(rudp_conn* c, int timeout_ms)
+{
+    uint64_t deadline = now_us() + (uint64_t)timeout_ms * 1000, now;
+
+    while(c->snd_una != c->snd_end)
+    {
+        now = now_us();
+        if(now >= deadline)
+            return 1;
+        if(rudp_poll(c, (int)((deadline - now + 999) / 1000)) == -1)
+            return -1;
+    }
+    return 0;
+}
+
+void rudp_get_stats(rudp_conn* c, rudp_stats* st)
+{
+    *st = c->st;
+    st->srtt_ms = c->srtt_us / 1000.0;
+    st->rttvar_ms = c->rttvar_us / 1000.0;
+    st->rto_ms = c->rto_us / 1000.0;
+    st->cwnd = c->cwnd;
+}
+
+void rudp_close(rudp_conn* c)
+{
+    uint64_t deadline = now_us() + 2000000;
+    uint8_t dummy;
+
+    // 关闭标记作为一条不带数据的 DATA 包按序可靠发送
+    if(!c->dead && !c->fin_sent)
+    {
+        enqueue(c, &dummy, 0, FLAG_FIN);
+        c->fin_sent = 1;
+    }
+
+    // 等待：本端的数据与关闭标记全部被确认，且收到了对端的关闭标记
+    while(!c->dead && (c->snd_una != c->snd_end || !c->fin_recv) && now_us() < deadline)
+        rudp_poll(c, 10);
+    flush_delayed(c);
+
+    close(c->sock);
+    free(c->snd);
+    free(c->rcv);
+    free(c->delayed);
+    free(c);
+}
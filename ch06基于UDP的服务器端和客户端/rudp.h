@@ -0,0 +1,66 @@
+#ifndef RUDP_H
+#define RUDP_H
+
+/*
+ * rudp：基于 UDP 的可靠传输小型库（选择确认 ARQ）
+ *
+ * 特性：
+ *   - 面向消息：每次 rudp_send 发送一条消息（1 ~ RUDP_MAX_PAYLOAD 字节），对端 rudp_recv 收到同样边界的一条消息
+ *   - 序号 + 累计确认 + 32 位选择确认（SACK）位图
+ *   - 基于时间戳回显的 RTT 估计（RFC 6298 的 SRTT/RTTVAR），超时重传（RTO）带指数退避
+ *   - 快速重传：某个包之后已有 3 个包被确认时，判定其丢失并立即重传
+ *   - 滑动窗口 + 拥塞控制（慢启动 / 拥塞避免 / 丢包时窗口减半），接收方通告窗口做流量控制
+ *   - 可选"无序交付"：消息一到就交给应用，不必等待前面丢失的消息重传（消除队头阻塞），仍保证每条消息恰好交付一次
+ *   - 丢包/延迟注入：用于在本机测试，见 rudp_set_impair 与环境变量 RUDP_LOSS / RUDP_DELAY_MS / RUDP_JITTER_MS
+ *
+ * 使用方式：单线程，所有 I/O 都在 rudp_send / rudp_recv / rudp_flush / rudp_close 内部驱动。
+ * 注意：对端若长时间不读取数据，其接收窗口会被填满，本端的 rudp_send 将阻塞等待。
+ */
+
+#define RUDP_MAX_PAYLOAD 1200   // 单条消息的最大长度（留出余量，避免 IP 分片）
+#define RUDP_WINDOW 256         // 发送/接收窗口的槽位数（最多在途的消息数），必须是 2 的幂
+#define RUDP_UNORDERED 1        // rudp_connect / rudp_accept 的 flags：无序交付
+
+typedef struct rudp_conn rudp_conn;
+
+/* 连接统计 */
+typedef struct {
+    unsigned long data_sent;        // 发送的数据包总数（含重传）
+    unsigned long fast_retx;        // 快速重传次数
+    unsigned long timeout_retx;     // 超时重传次数
+    unsigned long data_recv;        // 收到的数据包总数（含重复）
+    unsigned long dup_recv;         // 收到的重复数据包数
+    unsigned long impair_drops;     // 被丢包注入丢弃的出站包数
+    double srtt_ms;                 // 平滑 RTT
+    double rttvar_ms;               // RTT 偏差
+    double rto_ms;                  // 当前重传超时
+    unsigned cwnd;                  // 当前拥塞窗口（包）
+} rudp_stats;
+
+/* 客户端：创建连接到 ip:port 的会话（UDP 无握手，立即返回） */
+rudp_conn* rudp_connect(const char* ip, int port, int flags);
+
+/* 服务器端：绑定 port 并阻塞等待第一个数据包，之后只与该对端通信 */
+rudp_conn* rudp_accept(int port, int flags);
+
+/* 发送一条消息：窗口满时阻塞。成功返回 len，连接失效返回 -1 */
+int rudp_send(rudp_conn* c, const void* buf, int len);
+
+/*
+ * 接收一条消息：timeout_ms 为 -1 表示一直等待
+ * 返回消息长度；超时返回 0；对端关闭或连接失效返回 -1
+ */
+int rudp_recv(rudp_conn* c, void* buf, int cap, int timeout_ms);
+
+/* 等待已发送的消息全部被确认：成功返回 0，超时返回 1，连接失效返回 -1 */
+int rudp_flush(rudp_conn* c, int timeout_ms);
+
+/* 设置出站方向的丢包率（0~100%）、固定延迟与随机抖动（毫秒） */
+void rudp_set_impair(rudp_conn* c, double loss_pct, int delay_ms, int jitter_ms);
+
+void rudp_get_stats(rudp_conn* c, rudp_stats* st);
+
+/* 发送关闭标记并等待双方的关闭都被确认（最多约 2 秒），然后释放资源 */
+void rudp_close(rudp_conn* c);
+
+#endif
@@ -0,0 +1,169 @@
+#include <stdio.h>      // 标准输入输出：printf / fputs / fgets 等
+#include <stdlib.h>     // 标准库：exit / atoi / atof / malloc 等
+#include <string.h>     // 字符串操作：strcmp / strlen / memset / memcpy 等
+#include <stdint.h>     // uint32_t
+#include <time.h>       // clock_gettime：计时
+#include "rudp.h"       // 可靠 UDP 库
+
+/*
+ * 基于 rudp 的可靠 UDP 客户端
+ *
+ * 两种模式：
+ *   echo：与 uecho_client.c 相同，从标准输入读一行发送，打印服务器的回声
+ *   bulk：连续发送 count 条 size 字节的消息，每条消息开头 4 字节为序号，
+ *         接收全部回声并校验内容，输出吞吐量与重传统计
+ *
+ * 用法：
+ *   rudp_client <IP> <port> echo
+ *   rudp_client <IP> <port> bulk <count> <size> [loss%] [delay_ms] [unordered]
+ *
+ * 注意：bulk 模式限制"已发送未收到回声"的消息不超过半个窗口。
+ * 否则双方都在阻塞发送、都不读取，接收窗口被填满后会相互等待。
+ */
+
+#define BUF_SIZE RUDP_MAX_PAYLOAD
+void run_echo(rudp_conn *conn);
+void run_bulk(rudp_conn *conn, int count, int size, int unordered);
+void error_handling(char *message);
+
+int main(int argc, char* argv[])
+{
+    rudp_conn *conn;
+    int flags = 0;
+
+    if(argc == 4 && !strcmp(argv[3], "echo"))
+    {
+        conn = rudp_connect(argv[1], atoi(argv[2]), 0);
+        if(conn == NULL)
+            error_handling("rudp_connect() error");
+        run_echo(conn);
+    }
+    else if(argc >= 6 && argc <= 9 && !strcmp(argv[3], "bulk"))
+    {
+        if(argc >= 9 && atoi(argv[8]) == 1)
+            flags = RUDP_UNORDERED;
+        conn = rudp_connect(argv[1], atoi(argv[2]), flags);
+        if(conn == NULL)
+            error_handling("rudp_connect() error");
+        if(argc >= 7)
+            rudp_set_impair(conn, atof(argv[6]), argc >= 8 ? atoi(argv[7]) : 0,
+                            argc >= 8 ? atoi(argv[7]) / 4 : 0);
+        run_bulk(conn, atoi(argv[4]), atoi(argv[5]), flags == RUDP_UNORDERED);
+    }
+    else
+    {
+        printf("Usage: %s <IP> <port> echo\n", argv[0]);
+        printf("       %s <IP> <port> bulk <count> <size> [loss%%] [delay_ms] [unordered]\n", argv[0]);
+        exit(1);
+    }
+
+    rudp_close(conn);
+    return 0;
+}
+
+void run_echo(rudp_conn *conn)
+{
+    char message[BUF_SIZE];
+    int str_len;
+
+    while(1)
+    {
+        fputs("Insert message(q/Q to quit): ", stdout);
+        if(fgets(message, sizeof(message), stdin) == NULL)
+            break;
+        if(!strcmp(message, "q\n") || !strcmp(message, "Q\n"))
+            break;
+
+        if(rudp_send(conn, message, strlen(message)) == -1)
+            error_handling("rudp_send() error");
+        str_len = rudp_recv(conn, message, sizeof(message) - 1, -1);
+        if(str_len <= 0)
+            error_handling("rudp_recv() error");
+        message[str_len] = 0;
+        printf("Message from server: %s", message);
+    }
+}
+
+/* 取出一条回声并校验：内容应为"序号 + 按序号填充的字节" */
+static int check_echo(const char *buf, int len, int size, int count, char *seen)
+{
+    uint32_t idx;
+    int i;
+
+    if(len != size)
+        return -1;
+    memcpy(&idx, buf, 4);
+    if(idx >= (uint32_t)count || seen[idx])
+        return -1;
+    for(i = 4; i < size; i++)
+        if(buf[i] != (char)(idx + i))
+            return -1;
+    seen[idx] = 1;
+    return (int)idx;
+}
+
+void run_bulk(rudp_conn *conn, int count, int size, int unordered)
+{
+    char buf[BUF_SIZE];
+    char *seen;
+    int sent = 0, echoed = 0, in_order = 0, len, idx, last_idx = -1, i;
+    struct timespec t0, t1;
+    double secs;
+    rudp_stats st;
+
+    if(count < 1 || size < 4 || size > RUDP_MAX_PAYLOAD)
+        error_handling("invalid count or size");
+    seen = calloc(count, 1);
+    if(seen == NULL)
+        error_handling("calloc() error");
+
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    while(echoed < count)
+    {
+        // 在途消息不超过半个窗口时继续发送
+        if(sent < count && sent - echoed < RUDP_WINDOW / 2)
+        {
+            memcpy(buf, &sent, 4);
+            for(i = 4; i < size; i++)
+                buf[i] = (char)(sent + i);
+            if(rudp_send(conn, buf, size) == -1)
+                error_handling("rudp_send() error");
+            sent++;
+            len = rudp_recv(conn, buf, sizeof(buf), 0);     // 顺便取走已到达的回声（不阻塞）
+        }
+        else
+            len = rudp_recv(conn, buf, sizeof(buf), -1);
+
+        if(len == -1)
+            error_handling("connection lost");
+        if(len > 0)
+        {
+            if((idx = check_echo(buf, len, size, count, seen)) < 0)
+                error_handling("corrupt or duplicate echo");
+            if(idx == last_idx + 1)
+                in_order++;
+            last_idx = idx;
+            echoed++;
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    secs = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9;
+
+    rudp_get_stats(conn, &st);
+    printf("%d messages x %d bytes echoed and verified in %.3f s (%.1f msg/s, %.2f MB/s each way)\n",
+           count, size, secs, count / secs, (double)count * size / secs / (1024 * 1024));
+    printf("delivery: %s, %d of %d arrived in sequence\n",
+           unordered ? "unordered" : "ordered", in_order, count);
+    printf("sent %lu pkts (%lu fast / %lu timeout retx), %lu injected drops, "
+           "srtt %.2f ms, rttvar %.2f ms, rto %.1f ms, cwnd %u\n",
+           st.data_sent, st.fast_retx, st.timeout_retx, st.impair_drops,
+           st.srtt_ms, st.rttvar_ms, st.rto_ms, st.cwnd);
+    free(seen);
+}
+
+void error_handling(char *message)
+{
+    fputs(message, stderr);
+    fputc('\n', stderr);
+    exit(1);
+}
@@ -0,0 +1,81 @@
+#include <stdio.h>      // 标准输入输出：printf / fputs / fputc 等
+#include <stdlib.h>     // 标准库：exit / atoi / atof 等
+#include <string.h>     // 字符串操作：strcmp 等
+#include "rudp.h"       // 可靠 UDP 库：rudp_accept / rudp_recv / rudp_send / rudp_close
+
+/*
+ * 基于 rudp 的可靠 UDP 回声服务器
+ *
+ * 与 uecho_server.c 相同，把收到的每条消息原样发回；区别在于底层由 rudp 负责
+ * 序号、确认、重传和拥塞控制，丢包时消息不会丢失。
+ *
+ * 参数：
+ *   <port>         监听端口
+ *   [loss%]        出站丢包率（注入），例如 5 表示 5%
+ *   [delay_ms]     出站延迟（注入）
+ *   [unordered]    为 1 时无序交付
+ * 一个会话结束（客户端关闭）后继续等待下一个客户端。
+ */
+
+#define BUF_SIZE RUDP_MAX_PAYLOAD
+void error_handling(char *message);
+
+int main(int argc, char* argv[])
+{
+    rudp_conn *conn;
+    rudp_stats st;
+    char message[BUF_SIZE];
+    int str_len, flags = 0, delay_ms = 0;
+    double loss = 0;
+    unsigned long msgs;
+
+    if(argc < 2 || argc > 5)
+    {
+        printf("Usage: %s <port> [loss%%] [delay_ms] [unordered]\n", argv[0]);
+        exit(1);
+    }
+    if(argc >= 3)
+        loss = atof(argv[2]);
+    if(argc >= 4)
+        delay_ms = atoi(argv[3]);
+    if(argc >= 5 && atoi(argv[4]) == 1)
+        flags = RUDP_UNORDERED;
+
+    while(1)
+    {
+        // 等待新客户端的第一个数据包
+        conn = rudp_accept(atoi(argv[1]), flags);
+        if(conn == NULL)
+            error_handling("rudp_accept() error");
+        if(loss > 0 || delay_ms > 0)
+            rudp_set_impair(conn, loss, delay_ms, delay_ms / 4);
+        puts("client connected");
+        fflush(stdout);
+
+        // 回声：rudp_recv 返回 -1 表示对端已关闭（或连接失效）
+        msgs = 0;
+        while((str_len = rudp_recv(conn, message, BUF_SIZE, -1)) > 0)
+        {
+            if(rudp_send(conn, message, str_len) == -1)
+                break;
+            msgs++;
+        }
+
+        rudp_get_stats(conn, &st);
+        printf("session done: %lu messages echoed, sent %lu pkts (%lu fast / %lu timeout retx), "
+               "%lu dup recv, %lu injected drops, srtt %.2f ms\n",
+               msgs, st.data_sent, st.fast_retx, st.timeout_retx,
+               st.dup_recv, st.impair_drops, st.srtt_ms);
+        fflush(stdout);
+        rudp_close(conn);
+    }
+
+    return 0;
+}
+
+void error_handling(char *message)
+{
+    fputs(message, stderr);
+    fputc('\n', stderr);
+    exit(1);
+}
@@ -0,0 +1,255 @@
+#define _GNU_SOURCE
+#include <stdio.h>      // 标准输入输出：printf / fputs / fputc 等
+#include <stdlib.h>     // 标准库：exit / atoi / malloc 等
+#include <string.h>     // 内存与字符串操作：memset / strcmp 等
+#include <unistd.h>     // POSIX：close 等
+#include <errno.h>      // errno / EAGAIN
+#include <time.h>       // clock_gettime：计时
+#include <netinet/in.h> // IPPROTO_UDP
+#include <netinet/udp.h> // UDP_SEGMENT / UDP_GRO：UDP 分段卸载选项
+#include <arpa/inet.h>  // inet_addr / htons 等
+#include <sys/socket.h> // socket / setsockopt / send / recvmsg / CMSG_*
+#include <sys/resource.h> // getrusage：统计进程消耗的 CPU 时间
+
+/*
+ * UDP GSO/GRO（分段卸载 / 接收合并）基准测试
+ *
+ * 逐个数据报发送时，每个 1400 字节的数据报都要走一遍完整的协议栈和一次系统调用。
+ * Linux 4.18+ 提供 UDP 分段卸载：
+ *   - 发送端 UDP_SEGMENT（GSO）：应用一次交给内核一个大缓冲区（最多约 64KB），
+ *     并指定分段大小 gso_size，内核（或网卡）在协议栈最底层才把它切成多个 MTU 大小的数据报。
+ *     协议栈只走一遍，系统调用次数降到原来的 1/(64KB/gso_size)
+ *   - 接收端 UDP_GRO（5.0+）：内核把同一条流上连续到达的数据报合并成一个大缓冲区交给应用，
+ *     并通过控制消息（cmsg）告知原始分段大小，应用据此自己切分
+ *
+ * 用法：
+ *   接收端：udp_gso_bench recv <port> [gro]
+ *   发送端：udp_gso_bench send <IP> <port> <seconds> [seg_size] [gso]
+ *   gro / gso 参数为 1 时启用对应的卸载，为 0（默认）时逐个数据报收发，便于对比。
+ *
+ * 两端都会输出 pkt/s、系统调用次数，以及每百万数据报消耗的 CPU 时间（user+sys）。
+ * 注意：线上的每个数据报仍然是独立的 UDP 数据报，对端不启用 GRO 也能正常接收。
+ */
+
+#define DEFAULT_SEG_SIZE 1400   // 默认分段大小：以太网 MTU 1500 - IP/UDP 头，留出余量
+#define MAX_GSO_BYTES 65000     // 一次 GSO 发送的最大总字节数（必须小于 64KB 的 UDP 长度上限）
+#define MAX_GSO_SEGS 64         // 内核限制：一次 GSO 最多 64 个分段（UDP_MAX_SEGMENTS）
+#define RECV_BUF_SIZE 65536     // 接收缓冲区：要能容纳一次 GRO 合并后的数据
+void run_sender(int argc, char* argv[]);
+void run_receiver(int argc, char* argv[]);
+double now_secs(void);
+double cpu_secs(void);
+void error_handling(char *message);
+
+int main(int argc, char* argv[])
+{
+    if(argc >= 3 && !strcmp(argv[1], "recv"))
+        run_receiver(argc, argv);
+    else if(argc >= 5 && !strcmp(argv[1], "send"))
+        run_sender(argc, argv);
+    else
+    {
+        printf("Usage: %s recv <port> [gro]\n", argv[0]);
+        printf("       %s send <IP> <port> <seconds> [seg_size] [gso]\n", argv[0]);
+        exit(1);
+    }
+    return 0;
+}
+
+/*
+ * 发送端：在给定时间内尽可能快地发送 seg_size 大小的数据报
+ *   gso=0：每个数据报一次 send
+ *   gso=1：每次 send 交给内核 segs 个分段（segs * seg_size 字节），由内核切分
+ */
+void run_sender(int argc, char* argv[])
+{
+    int sock, seconds, seg_size = DEFAULT_SEG_SIZE, gso = 0, segs, len;
+    struct sockaddr_in serv_addr;
+    char *buf;
+    unsigned long long pkts = 0, calls = 0;
+    double start, elapsed, cpu0, cpu;
+
+    seconds = atoi(argv[4]);
+    if(argc >= 6)
+        seg_size = atoi(argv[5]);
+    if(argc >= 7)
+        gso = atoi(argv[6]);
+    if(seg_size < 1 || seg_size > MAX_GSO_BYTES)
+        error_handling("invalid seg_size");
+
+    sock = socket(PF_INET, SOCK_DGRAM, 0);
+    if(sock == -1)
+        error_handling("socket() error");
+
+    memset(&serv_addr, 0, sizeof(serv_addr));
+    serv_addr.sin_family = AF_INET;
+    serv_addr.sin_addr.s_addr = inet_addr(argv[2]);
+    serv_addr.sin_port = htons(atoi(argv[3]));
+    if(connect(sock, (struct sockaddr*)&serv_addr, sizeof(serv_addr)) == -1)
+        error_handling("connect() error");
+
+    // 每次 send 的分段数：受 64KB 总长度和 64 个分段两个上限约束
+    segs = 1;
+    if(gso)
+    {
+        segs = MAX_GSO_BYTES / seg_size;
+        if(segs > MAX_GSO_SEGS)
+            segs = MAX_GSO_SEGS;
+        if(segs < 1)
+            segs = 1;
+
+        // 套接字级别设置分段大小：之后该套接字上每次 send 的大缓冲区都按 seg_size 切分
+        // （也可以通过 sendmsg 的 cmsg 逐次指定）
+        if(setsockopt(sock, IPPROTO_UDP, UDP_SEGMENT, &seg_size, sizeof(seg_size)) == -1)
+            error_handling("setsockopt(UDP_SEGMENT) error (kernel < 4.18?)");
+    }
+    len = segs * seg_size;
+    buf = malloc(len);
+    if(buf == NULL)
+        error_handling("malloc() error");
+    memset(buf, 'g', len);
+
+    printf("sending %d-byte datagrams, %d per send() (%s)\n",
+           seg_size, segs, gso ? "UDP_SEGMENT" : "one per syscall");
+
+    cpu0 = cpu_secs();
+    start = now_secs();
+    do
+    {
+        // 发送过快时本地发送缓冲区可能满（ENOBUFS），简单重试即可
+        if(send(sock, buf, len, 0) == len)
+        {
+            pkts += segs;
+            calls++;
+        }
+        else if(errno != ENOBUFS && errno != EAGAIN && errno != ECONNREFUSED)
+            error_handling("send() error");
+        elapsed = now_secs() - start;
+    } while(elapsed < seconds);
+    cpu = cpu_secs() - cpu0;
+
+    printf("sent %llu datagrams in %llu calls, %.2f s\n", pkts, calls, elapsed);
+    printf("%.0f pkt/s, %.1f MB/s, CPU %.3f s per million datagrams\n",
+           pkts / elapsed, pkts * (double)seg_size / elapsed / (1024 * 1024),
+           pkts ? cpu / pkts * 1e6 : 0.0);
+
+    free(buf);
+    close(sock);
+}
+
+/*
+ * 接收端：统计每秒收到的数据报数
+ *   gro=0：每次 recvmsg 得到一个数据报
+ *   gro=1：每次 recvmsg 可能得到多个合并在一起的数据报，
+ *          cmsg(UDP_GRO) 给出原始分段大小 gso_size，数据报个数 = ceil(len / gso_size)
+ */
+void run_receiver(int argc, char* argv[])
+{
+    int sock, gro = 0, on = 1, len, gso_size;
+    struct sockaddr_in serv_addr;
+    static char buf[RECV_BUF_SIZE];
+    char control[CMSG_SPACE(sizeof(int))];
+    struct msghdr msg;
+    struct iovec iov;
+    struct cmsghdr *cmsg;
+    struct timeval tv;
+    unsigned long long pkts = 0, calls = 0, total_pkts = 0;
+    double last, now, cpu0, cpu;
+
+    if(argc >= 4)
+        gro = atoi(argv[3]);
+
+    sock = socket(PF_INET, SOCK_DGRAM, 0);
+    if(sock == -1)
+        error_handling("socket() error");
+
+    memset(&serv_addr, 0, sizeof(serv_addr));
+    serv_addr.sin_family = AF_INET;
+    serv_addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    serv_addr.sin_port = htons(atoi(argv[2]));
+    if(bind(sock, (struct sockaddr*)&serv_addr, sizeof(serv_addr)) == -1)
+        error_handling("bind() error");
+
+    if(gro && setsockopt(sock, IPPROTO_UDP, UDP_GRO, &on, sizeof(on)) == -1)
+        error_handling("setsockopt(UDP_GRO) error (kernel < 5.0?)");
+
+    // 1 秒超时：发送端停止后，接收端也能定期输出统计并在空闲时退出
+    tv.tv_sec = 1;
+    tv.tv_usec = 0;
+    setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+
+    printf("receiving on port %s (%s)\n", argv[2], gro ? "UDP_GRO" : "no GRO");
+
+    cpu0 = cpu_secs();
+    last = now_secs();
+    while(1)
+    {
+        iov.iov_base = buf;
+        iov.iov_len = sizeof(buf);
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+
+        len = recvmsg(sock, &msg, 0);
+        if(len == -1 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+            error_handling("recvmsg() error");
+
+        if(len >= 0)
+        {
+            // 默认认为是单个数据报；若带有 UDP_GRO 控制消息，则按 gso_size 计算合并的个数
+            gso_size = 0;
+            for(cmsg = CMSG_FIRSTHDR(&msg); cmsg != NULL; cmsg = CMSG_NXTHDR(&msg, cmsg))
+                if(cmsg->cmsg_level == IPPROTO_UDP && cmsg->cmsg_type == UDP_GRO)
+                    memcpy(&gso_size, CMSG_DATA(cmsg), sizeof(int));
+            pkts += gso_size > 0 ? (len + gso_size - 1) / gso_size : 1;
+            calls++;
+        }
+
+        now = now_secs();
+        if(now - last >= 1.0)
+        {
+            if(pkts == 0 && total_pkts > 0)
+                break;      // 收到过数据后出现 1 秒空闲：认为发送端已结束
+            if(pkts > 0)
+            {
+                printf("%.0f pkt/s, %.1f datagrams per recvmsg\n",
+                       pkts / (now - last), calls ? (double)pkts / calls : 0.0);
+                fflush(stdout);
+            }
+            total_pkts += pkts;
+            pkts = calls = 0;
+            last = now;
+        }
+    }
+    cpu = cpu_secs() - cpu0;
+    printf("received %llu datagrams, CPU %.3f s per million datagrams\n",
+           total_pkts, total_pkts ? cpu / total_pkts * 1e6 : 0.0);
+    close(sock);
+}
+
+double now_secs(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* 本进程已消耗的 CPU 时间：用户态 + 内核态 */
+double cpu_secs(void)
+{
+    struct rusage ru;
+
+    getrusage(RUSAGE_SELF, &ru);
+    return ru.ru_utime.tv_sec + ru.ru_utime.tv_usec / 1e6
+         + ru.ru_stime.tv_sec + ru.ru_stime.tv_usec / 1e6;
+}
+
+void error_handling(char *message)
+{
+    fputs(message, stderr);
+    fputc('\n', stderr);
+    exit(1);
+}
@@ -0,0 +1,170 @@
+#define _GNU_SOURCE             // recvmmsg / sendmmsg / struct mmsghdr 是 GNU 扩展
+#include <stdio.h>      // 标准输入输出：printf / fputs / fputc 等
+#include <stdlib.h>     // 标准库：exit / atoi / calloc 等
+#include <string.h>     // 内存操作：memset / memcpy 等
+#include <stdint.h>     // uint32_t：数据报中的轮次标记
+#include <unistd.h>     // POSIX：close 等
+#include <errno.h>      // errno / EAGAIN：接收超时判断
+#include <time.h>       // clock_gettime：计时
+#include <arpa/inet.h>  // inet_addr / htons 等
+#include <sys/socket.h> // socket / connect / setsockopt / recvmmsg / sendmmsg
+
+/*
+ * UDP 回声压测客户端：测量回声服务器每秒能回多少个数据报（pkt/s）
+ *
+ * 做法：已连接 UDP 套接字 + 固定"在途窗口"
+ *   - 始终保持 window 个数据报在途：收到几个回包，就补发几个
+ *   - 发送和接收都用 sendmmsg / recvmmsg 批量进行，避免客户端自己成为瓶颈
+ *   - 接收超时（50ms 没有任何回包）视为在途数据报丢失，重新填满窗口
+ *   - 每个数据报开头 4 字节是"轮次"（epoch），每次超时加 1。超时之后才到达的旧回包轮次不符，
+ *     只计为迟到，不再从在途数中扣除，否则在途数会变成负数、窗口会被算得比 window 还大
+ *
+ * 可以分别对 uecho_server 与 uecho_mmsg_server 运行，比较两者的 pkt/s。
+ */
+
+#define DEFAULT_WINDOW 256      // 默认在途数据报数量
+#define DEFAULT_MSG_SIZE 30     // 默认数据报大小（与 uecho_server.c 的 BUF_SIZE 相同）
+#define MAX_WINDOW 1024
+#define RECV_TIMEOUT_US 50000   // 接收超时：50ms
+void error_handling(char *message);
+
+int main(int argc, char* argv[])
+{
+    int sock;
+    struct sockaddr_in serv_addr;
+    struct timeval tv;
+    int seconds, window = DEFAULT_WINDOW, msg_size = DEFAULT_MSG_SIZE;
+    struct mmsghdr *smsgs, *rmsgs;
+    struct iovec *siovs, *riovs;
+    char *sbuf, *rbufs;
+    int i, n, fresh, inflight = 0, want;
+    uint32_t epoch = 0, tag;
+    unsigned long long sent = 0, echoed = 0, lost = 0, late = 0;
+    struct timespec start, now;
+    double elapsed;
+
+    if(argc < 4 || argc > 6)
+    {
+        printf("Usage: %s <IP> <port> <seconds> [window] [msg_size]\n", argv[0]);
+        exit(1);
+    }
+    seconds = atoi(argv[3]);
+    if(argc >= 5)
+        window = atoi(argv[4]);
+    if(argc >= 6)
+        msg_size = atoi(argv[5]);
+    if(window < 1 || window > MAX_WINDOW || msg_size < (int)sizeof(uint32_t))
+        error_handling("invalid window or msg_size");
+
+    sock = socket(PF_INET, SOCK_DGRAM, 0);
+    if(sock == -1)
+        error_handling("socket() error");
+
+    memset(&serv_addr, 0, sizeof(serv_addr));
+    serv_addr.sin_family = AF_INET;
+    serv_addr.sin_addr.s_addr = inet_addr(argv[1]);
+    serv_addr.sin_port = htons(atoi(argv[2]));
+
+    // 已连接 UDP：之后 sendmmsg/recvmmsg 都不需要再携带地址
+    if(connect(sock, (struct sockaddr*)&serv_addr, sizeof(serv_addr)) == -1)
+        error_handling("connect() error");
+
+    // 接收超时：用于判定"窗口内的数据报已丢失"
+    tv.tv_sec = 0;
+    tv.tv_usec = RECV_TIMEOUT_US;
+    setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+
+    // -------------------- 预分配消息数组 --------------------
+    // 发送的内容都一样，所有发送消息共用同一块缓冲区
+    smsgs = calloc(window, sizeof(struct mmsghdr));
+    rmsgs = calloc(window, sizeof(struct mmsghdr));
+    siovs = calloc(window, sizeof(struct iovec));
+    riovs = calloc(window, sizeof(struct iovec));
+    sbuf = malloc(msg_size);
+    rbufs = malloc((size_t)window * msg_size);
+    if(!smsgs || !rmsgs || !siovs || !riovs || !sbuf || !rbufs)
+        error_handling("malloc() error");
+    memset(sbuf, 'x', msg_size);
+    memcpy(sbuf, &epoch, sizeof(epoch));
+
+    for(i = 0; i < window; i++)
+    {
+        siovs[i].iov_base = sbuf;
+        siovs[i].iov_len = msg_size;
+        smsgs[i].msg_hdr.msg_iov = &siovs[i];
+        smsgs[i].msg_hdr.msg_iovlen = 1;
+        riovs[i].iov_base = rbufs + (size_t)i * msg_size;
+        riovs[i].iov_len = msg_size;
+        rmsgs[i].msg_hdr.msg_iov = &riovs[i];
+        rmsgs[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    do
+    {
+        // 补满窗口
+        want = window - inflight;
+        if(want > window)
+            want = window;
+        if(want > 0)
+        {
+            n = sendmmsg(sock, smsgs, want, 0);
+            if(n > 0)
+            {
+                inflight += n;
+                sent += n;
+            }
+        }
+
+        // 至少等到 1 个回包，再顺便取走所有已到达的回包（最多 window 个，旧回包也可能在其中）
+        n = recvmmsg(sock, rmsgs, window, MSG_WAITFORONE, NULL);
+        if(n > 0)
+        {
+            // 只有本轮发出的数据报的回包才从在途数中扣除
+            fresh = 0;
+            for(i = 0; i < n; i++)
+            {
+                memcpy(&tag, rbufs + (size_t)i * msg_size, sizeof(tag));
+                if(rmsgs[i].msg_len >= sizeof(tag) && tag == epoch)
+                    fresh++;
+            }
+            late += n - fresh;
+            inflight -= fresh;
+            if(inflight < 0)
+                inflight = 0;
+            echoed += fresh;
+        }
+        else if(n == -1 && (errno == EAGAIN || errno == EWOULDBLOCK))
+        {
+            // 超时：认为在途的都丢了，换一个轮次，之后到达的旧回包不再计入
+            lost += inflight;
+            inflight = 0;
+            epoch++;
+            memcpy(sbuf, &epoch, sizeof(epoch));
+        }
+        else if(n == -1 && errno != EINTR && errno != ECONNREFUSED)
+            error_handling("recvmmsg() error");
+
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        elapsed = (now.tv_sec - start.tv_sec) + (now.tv_nsec - start.tv_nsec) / 1e9;
+    } while(elapsed < seconds);
+
+    printf("sent %llu, echoed %llu, lost %llu (%llu arrived late) in %.2f s\n", sent, echoed, lost, late, elapsed);
+    printf("%.0f echoed pkt/s\n", echoed / elapsed);
+
+    free(rbufs);
+    free(sbuf);
+    free(riovs);
+    free(siovs);
+    free(rmsgs);
+    free(smsgs);
+    close(sock);
+    return 0;
+}
+
+void error_handling(char *message)
+{
+    fputs(message, stderr);
+    fputc('\n', stderr);
+    exit(1);
+}
@@ -0,0 +1,377 @@
+#define _GNU_SOURCE     // ppoll
+#include <stdio.h>      // 标准输入输出：printf / fputs / fputc 等
+#include <stdlib.h>     // 标准库：exit / atoi / atof / calloc 等
+#include <string.h>     // 内存操作：memset / memcpy 等
+#include <stdint.h>     // uint32_t / uint64_t
+#include <unistd.h>     // POSIX：close 等
+#include <signal.h>     // signal：Ctrl+C 提前结束并输出统计
+#include <errno.h>      // errno / EINTR
+#include <poll.h>       // ppoll：等待回包或下一个发送时刻（纳秒精度）
+#include <time.h>       // clock_gettime：高精度时间
+#include <arpa/inet.h>  // inet_addr / htons / htonl / ntohl
+#include <sys/socket.h> // socket / connect / setsockopt / send / recvmsg / CMSG_*
+#include <linux/net_tstamp.h> // SOF_TIMESTAMPING_*：内核时间戳选项
+#include <linux/errqueue.h>   // struct scm_timestamping：时间戳控制消息
+
+/*
+ * UDP 往返时延探测工具（类似 ping），配合 uecho_server 使用
+ *
+ * 按固定速率向回声服务器发送带序号和发送时间的探测包，根据回包中的序号匹配请求，统计：
+ *   - 丢包：发送后到结束时仍未收到回包
+ *   - 乱序：回包序号小于之前已收到的最大序号
+ *   - 重复：同一序号收到多次
+ *   - 抖动：相邻两个回包 RTT 之差的平滑平均（RFC 3550 的到达间隔抖动算法）
+ *   - 时延分布：对数-线性直方图，输出 p50/p90/p99/p99.9/p99.99 以及各区间的计数
+ *
+ * 时间戳：
+ *   发送时间在 send 之前用 clock_gettime 取得并写入包内；
+ *   接收时间优先使用 SO_TIMESTAMPING 的内核软件接收时间戳（数据报到达协议栈的时刻），
+ *   它不包含"内核唤醒进程、进程被调度运行"的延迟，测量更稳定；内核不支持时退回 clock_gettime。
+ *   内核时间戳是 CLOCK_REALTIME，所以发送时间也使用 CLOCK_REALTIME（测量期间若系统时间被调整会产生误差）。
+ *
+ * 探测包格式（16 字节，不超过 uecho_server.c 的 BUF_SIZE 30）：
+ *   [4 魔数][4 序号][8 发送时间（纳秒）]
+ */
+
+#define PROBE_MAGIC 0x50524f42u     // "PROB"
+#define PROBE_SIZE 16
+#define MAX_PROBE_SIZE 30           // uecho_server.c 一次最多回 30 字节
+#define DEFAULT_RATE 100            // 默认每秒发送的探测包数
+#define DRAIN_MS 1000               // 发送结束后继续等待迟到回包的时间
+
+/*
+ * 对数-线性直方图（与 HdrHistogram 的思路相同）：
+ * 小于 SUB_BUCKETS 纳秒的值每个值一个桶；之后每个 2 的幂区间 [2^k, 2^(k+1)) 再线性分成 SUB_BUCKETS 份。
+ * 相对误差不超过 1/SUB_BUCKETS（约 6%），64 位范围内总共只需要约 1000 个桶。
+ */
+#define SUB_BITS 4
+#define SUB_BUCKETS (1 << SUB_BITS)
+#define HIST_BUCKETS ((64 - SUB_BITS + 1) * SUB_BUCKETS)
+
+typedef struct {
+    unsigned long counts[HIST_BUCKETS];
+    unsigned long total;
+    uint64_t min, max;
+    double sum;
+} histogram;
+
+static volatile sig_atomic_t stop = 0;
+void on_sigint(int sig);
+uint64_t now_ns(void);
+int hist_index(uint64_t v);
+uint64_t hist_lower(int idx);
+void hist_add(histogram *h, uint64_t v);
+uint64_t hist_percentile(const histogram *h, double pct);
+void hist_print(const histogram *h);
+void error_handling(char *message);
+
+int main(int argc, char* argv[])
+{
+    int sock, count, size = PROBE_SIZE, on, len, kernel_ts = 0;
+    double rate = DEFAULT_RATE;
+    struct sockaddr_in serv_addr;
+    unsigned char pkt[MAX_PROBE_SIZE], rbuf[64];
+    char control[CMSG_SPACE(sizeof(struct scm_timestamping))];
+    struct msghdr msg;
+    struct iovec iov;
+    struct cmsghdr *cmsg;
+    struct scm_timestamping tss;
+    struct pollfd pfd;
+    struct timespec wait_ts;
+    uint64_t *sent_ns, start, next, interval, now, recv_ns, t, rtt, prev_rtt = 0, drain_end = 0;
+    unsigned char *got;
+    uint32_t seq, v, max_seq = 0;
+    int sent = 0, received = 0, reordered = 0, dup = 0, have_prev = 0;
+    int sec_recv = 0;
+    uint64_t sec_min = 0, sec_max = 0, sec_sum = 0, sec_start;
+    double jitter = 0, d;
+    static histogram hist;
+
+    if(argc < 4 || argc > 6)
+    {
+        printf("Usage: %s <IP> <port> <count> [rate_pps] [size]\n", argv[0]);
+        exit(1);
+    }
+    count = atoi(argv[3]);
+    if(argc >= 5)
+        rate = atof(argv[4]);
+    if(argc >= 6)
+        size = atoi(argv[5]);
+    if(count < 1 || rate <= 0 || size < PROBE_SIZE || size > MAX_PROBE_SIZE)
+        error_handling("invalid count, rate or size");
+
+    sent_ns = calloc(count, sizeof(uint64_t));
+    got = calloc(count, 1);
+    if(sent_ns == NULL || got == NULL)
+        error_handling("calloc() error");
+
+    sock = socket(PF_INET, SOCK_DGRAM, 0);
+    if(sock == -1)
+        error_handling("socket() error");
+
+    memset(&serv_addr, 0, sizeof(serv_addr));
+    serv_addr.sin_family = AF_INET;
+    serv_addr.sin_addr.s_addr = inet_addr(argv[1]);
+    serv_addr.sin_port = htons(atoi(argv[2]));
+    // 已连接 UDP：只会收到服务器发回的数据报
+    if(connect(sock, (struct sockaddr*)&serv_addr, sizeof(serv_addr)) == -1)
+        error_handling("connect() error");
+
+    // 请求内核软件接收时间戳：RX_SOFTWARE 负责生成，SOFTWARE 负责通过 cmsg 上报
+    on = SOF_TIMESTAMPING_RX_SOFTWARE | SOF_TIMESTAMPING_SOFTWARE;
+    if(setsockopt(sock, SOL_SOCKET, SO_TIMESTAMPING, &on, sizeof(on)) == 0)
+        kernel_ts = 1;
+    else
+        fputs("SO_TIMESTAMPING unavailable, using clock_gettime after recvmsg\n", stderr);
+
+    signal(SIGINT, on_sigint);
+    printf("UDP ping %s:%s, %d probes at %.0f/s, %d bytes, %s receive timestamps\n",
+           argv[1], argv[2], count, rate, size, kernel_ts ? "kernel" : "user-space");
+
+    memset(pkt, 0, sizeof(pkt));
+    interval = (uint64_t)(1e9 / rate);
+    start = now_ns();
+    next = start;
+    sec_start = start;
+    pfd.fd = sock;
+    pfd.events = POLLIN;
+
+    while(!stop)
+    {
+        now = now_ns();
+
+        // -------------------- 按计划时刻发送 --------------------
+        // 发送时刻按"起点 + 序号 × 间隔"计算，而不是"上次发送 + 间隔"，
+        // 这样处理回包的耗时不会累积成发送速率的偏差
+        while(sent < count && now >= next)
+        {
+            v = htonl(PROBE_MAGIC);
+            memcpy(pkt, &v, 4);
+            v = htonl((uint32_t)sent);
+            memcpy(pkt + 4, &v, 4);
+            sent_ns[sent] = now_ns();
+            memcpy(pkt + 8, &sent_ns[sent], 8);     // 本机读回，不需要字节序转换
+            if(send(sock, pkt, size, 0) == -1 && errno != ECONNREFUSED)
+                error_handling("send() error");
+            sent++;
+            next = start + (uint64_t)sent * interval;
+            now = now_ns();
+        }
+        if(sent == count && drain_end == 0)
+            drain_end = now + (uint64_t)DRAIN_MS * 1000000;
+        if(drain_end && (now >= drain_end || received == count))
+            break;
+
+        // -------------------- 每秒输出一行 --------------------
+        if(now - sec_start >= 1000000000ull)
+        {
+            if(sec_recv > 0)
+                printf("sent %d, received %d, last second: %d replies, min/avg/max %.1f/%.1f/%.1f us\n",
+                       sent, received, sec_recv, sec_min / 1e3, (double)sec_sum / sec_recv / 1e3, sec_max / 1e3);
+            else
+                printf("sent %d, received %d, last second: no replies\n", sent, received);
+            fflush(stdout);
+            sec_recv = 0;
+            sec_sum = sec_max = 0;
+            sec_start = now;
+        }
+
+        // -------------------- 等待回包，最多到下一个发送时刻 --------------------
+        t = sent < count ? next : drain_end;
+        if(t > sec_start + 1000000000ull)
+            t = sec_start + 1000000000ull;
+        // 用纳秒精度的 ppoll：poll 的毫秒超时会把不足 1ms 的间隔截成 0，变成忙等
+        t = t > now ? t - now : 0;
+        wait_ts.tv_sec = t / 1000000000ull;
+        wait_ts.tv_nsec = t % 1000000000ull;
+        if(ppoll(&pfd, 1, &wait_ts, NULL) <= 0)
+            continue;
+
+        iov.iov_base = rbuf;
+        iov.iov_len = sizeof(rbuf);
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+        len = recvmsg(sock, &msg, MSG_DONTWAIT);
+        recv_ns = now_ns();
+        if(len < PROBE_SIZE)
+            continue;       // 出错、ICMP 端口不可达或无关数据报
+
+        // 优先使用内核接收时间戳（ts[0] 为软件时间戳）
+        for(cmsg = CMSG_FIRSTHDR(&msg); cmsg != NULL; cmsg = CMSG_NXTHDR(&msg, cmsg))
+        {
+            if(cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SO_TIMESTAMPING)
+            {
+                memcpy(&tss, CMSG_DATA(cmsg), sizeof(tss));
+                if(tss.ts[0].tv_sec != 0)
+                    recv_ns = (uint64_t)tss.ts[0].tv_sec * 1000000000ull + tss.ts[0].tv_nsec;
+            }
+        }
+
+        memcpy(&v, rbuf, 4);
+        if(ntohl(v) != PROBE_MAGIC)
+            continue;
+        memcpy(&v, rbuf + 4, 4);
+        seq = ntohl(v);
+        if(seq >= (uint32_t)sent)
+            continue;
+        if(got[seq])
+        {
+            dup++;
+            continue;
+        }
+        got[seq] = 1;
+        received++;
+
+        // 用本地记录的发送时间，不信任回包里的数据
+        rtt = recv_ns > sent_ns[seq] ? recv_ns - sent_ns[seq] : 0;
+        hist_add(&hist, rtt);
+
+        if(received > 1 && seq < max_seq)
+            reordered++;
+        if(seq > max_seq)
+            max_seq = seq;
+
+        // RFC 3550：J = J + (|D| - J) / 16，D 为相邻两个回包的时延差
+        if(have_prev)
+        {
+            d = (double)rtt - (double)prev_rtt;
+            if(d < 0)
+                d = -d;
+            jitter += (d - jitter) / 16;
+        }
+        prev_rtt = rtt;
+        have_prev = 1;
+
+        if(sec_recv == 0 || rtt < sec_min)
+            sec_min = rtt;
+        if(rtt > sec_max)
+            sec_max = rtt;
+        sec_sum += rtt;
+        sec_recv++;
+    }
+
+    // -------------------- 汇总 --------------------
+    printf("\n--- %s:%s UDP ping statistics ---\n", argv[1], argv[2]);
+    printf("%d sent, %d received, %.2f%% loss, %d reordered, %d duplicates\n",
+           sent, received, sent ? 100.0 * (sent - received) / sent : 0.0, reordered, dup);
+    if(hist.total > 0)
+    {
+        printf("rtt min/avg/max = %.1f/%.1f/%.1f us, jitter %.1f us\n",
+               hist.min / 1e3, hist.sum / hist.total / 1e3, hist.max / 1e3, jitter / 1e3);
+        printf("p50 %.1f us, p90 %.1f us, p99 %.1f us, p99.9 %.1f us, p99.99 %.1f us\n",
+               hist_percentile(&hist, 50) / 1e3, hist_percentile(&hist, 90) / 1e3,
+               hist_percentile(&hist, 99) / 1e3, hist_percentile(&hist, 99.9) / 1e3,
+               hist_percentile(&hist, 99.99) / 1e3);
+        hist_print(&hist);
+    }
+
+    free(got);
+    free(sent_ns);
+    close(sock);
+    return 0;
+}
+
+void on_sigint(int sig)
+{
+    (void)sig;
+    stop = 1;
+}
+
+/* 与内核软件时间戳同一时钟：CLOCK_REALTIME */
+uint64_t now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+/* 值 -> 桶编号：最高位决定所在的 2 的幂区间，其后 SUB_BITS 位决定区间内的线性子桶 */
+int hist_index(uint64_t v)
+{
+    int msb;
+
+    if(v < SUB_BUCKETS)
+        return (int)v;
+    msb = 63 - __builtin_clzll(v);
+    return (msb - SUB_BITS + 1) * SUB_BUCKETS + (int)((v >> (msb - SUB_BITS)) & (SUB_BUCKETS - 1));
+}
+
+/* 桶编号 -> 该桶的下界 */
+uint64_t hist_lower(int idx)
+{
+    int group = idx / SUB_BUCKETS, sub = idx % SUB_BUCKETS;
+
+    if(group == 0)
+        return (uint64_t)sub;
+    return (uint64_t)(SUB_BUCKETS + sub) << (group - 1);
+}
+
+void hist_add(histogram *h, uint64_t v)
+{
+    h->counts[hist_index(v)]++;
+    if(h->total == 0 || v < h->min)
+        h->min = v;
+    if(v > h->max)
+        h->max = v;
+    h->sum += v;
+    h->total++;
+}
+
+/* 百分位数：返回所在桶的上界（不超过实际最大值），偏保守 */
+uint64_t hist_percentile(const histogram *h, double pct)
+{
+    unsigned long target, acc = 0;
+    uint64_t upper;
+    int i;
+
+    target = (unsigned long)(pct / 100.0 * h->total + 0.5);
+    if(target < 1)
+        target = 1;
+    for(i = 0; i < HIST_BUCKETS; i++)
+    {
+        acc += h->counts[i];
+        if(acc >= target)
+        {
+            upper = i + 1 < HIST_BUCKETS ? hist_lower(i + 1) - 1 : h->max;
+            return upper < h->max ? upper : h->max;
+        }
+    }
+    return h->max;
+}
+
+/* 输出所有非空桶：区间、计数、累计百分比和一个简单的条形图 */
+void hist_print(const histogram *h)
+{
+    unsigned long acc = 0, peak = 0;
+    int i, j, bar;
+
+    for(i = 0; i < HIST_BUCKETS; i++)
+        if(h->counts[i] > peak)
+            peak = h->counts[i];
+
+    printf("%14s %14s %10s %8s\n", "from(us)", "to(us)", "count", "cum%");
+    for(i = 0; i < HIST_BUCKETS; i++)
+    {
+        if(h->counts[i] == 0)
+            continue;
+        acc += h->counts[i];
+        printf("%14.3f %14.3f %10lu %7.3f%% ",
+               hist_lower(i) / 1e3, (i + 1 < HIST_BUCKETS ? hist_lower(i + 1) : h->max) / 1e3,
+               h->counts[i], 100.0 * acc / h->total);
+        bar = (int)(40.0 * h->counts[i] / peak + 0.5);
+        for(j = 0; j < bar; j++)
+            fputc('#', stdout);
+        fputc('\n', stdout);
+    }
+}
+
+void error_handling(char *message)
+{
+    fputs(message, stderr);
+    fputc('\n', stderr);
+    exit(1);
+}
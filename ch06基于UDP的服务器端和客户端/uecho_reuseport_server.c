@@ -0,0 +1,209 @@
+#define _GNU_SOURCE             // recvmmsg / sendmmsg / pthread_setaffinity_np / CPU_SET 是 GNU 扩展
+#include <stdio.h>      // 标准输入输出：printf / fputs / fputc 等
+#include <stdlib.h>     // 标准库：exit / atoi / calloc 等
+#include <string.h>     // 内存操作：memset 等
+#include <unistd.h>     // POSIX：close / sleep / sysconf 等
+#include <errno.h>      // errno / EINTR
+#include <sched.h>      // cpu_set_t / CPU_ZERO / CPU_SET：CPU 亲和性
+#include <pthread.h>    // pthread_create / pthread_setaffinity_np：多线程
+#include <arpa/inet.h>  // 网络字节序转换：htonl / htons 等
+#include <sys/socket.h> // 套接字 API：socket / setsockopt / bind / recvmmsg / sendmmsg 等
+
+/*
+ * 基于 SO_REUSEPORT 分片的多线程 UDP 回声服务器
+ *
+ * uecho_server.c 只有一个线程、一个套接字，只能用满一个 CPU 核。
+ * 如果多个线程共享同一个 UDP 套接字，它们会在套接字的接收队列锁上互相争抢。
+ *
+ * SO_REUSEPORT 允许多个套接字绑定同一个 IP:端口，内核按数据报的四元组哈希
+ * 把不同客户端（流）分到不同的套接字上：
+ *   - 每个工作线程拥有自己的套接字，收发路径上没有任何共享锁
+ *   - 同一个客户端的数据报总是落到同一个套接字上，不会乱序
+ *   - 可选把第 i 个线程绑定到第 i 个 CPU 上，减少线程迁移带来的缓存失效
+ *
+ * 统计：每个线程只写自己的计数器（按缓存行对齐，避免伪共享），
+ * 主线程每秒读取一次并汇总输出，同样不需要加锁。
+ */
+
+#define DEFAULT_THREADS 4       // 默认工作线程数
+#define MAX_THREADS 64
+#define BATCH 32                // 每个线程每次 recvmmsg 最多收取的数据报数
+#define BUF_SIZE 2048           // 每个数据报缓冲区大小
+#define CACHE_LINE 64
+void* worker(void* arg);
+void error_handling(char *message);
+
+/* 每个线程独享的计数器：对齐到缓存行，不同线程的计数器不会落在同一缓存行上 */
+typedef struct {
+    unsigned long pkts;         // 已回声的数据报数
+    unsigned long bytes;        // 已回声的字节数
+    unsigned long calls;        // recvmmsg 调用次数
+} __attribute__((aligned(CACHE_LINE))) worker_stats;
+
+typedef struct {
+    int id;                     // 线程编号
+    int port;                   // 监听端口
+    int cpu;                    // 绑定的 CPU（-1 表示不绑定）
+    worker_stats stats;         // 本线程的计数器
+} worker_arg;
+
+int main(int argc, char* argv[])
+{
+    int threads = DEFAULT_THREADS, pin = 0, ncpu;
+    static worker_arg args[MAX_THREADS];
+    pthread_t t_id;
+    unsigned long prev_pkts[MAX_THREADS], pkts, total, bytes, calls;
+    int i;
+
+    // 参数：<port> [threads] [pin]，pin 为 1 时把线程绑定到 CPU 上
+    if(argc < 2 || argc > 4)
+    {
+        printf("Usage: %s <port> [threads] [pin]\n", argv[0]);
+        exit(1);
+    }
+    if(argc >= 3)
+        threads = atoi(argv[2]);
+    if(argc >= 4)
+        pin = atoi(argv[3]);
+    if(threads < 1 || threads > MAX_THREADS)
+        error_handling("invalid thread count");
+
+    ncpu = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    printf("SO_REUSEPORT UDP echo: %d threads, %s\n",
+           threads, pin ? "pinned" : "not pinned");
+
+    // -------------------- 启动工作线程 --------------------
+    // 每个线程自己创建并绑定套接字（见 worker）
+    for(i = 0; i < threads; i++)
+    {
+        args[i].id = i;
+        args[i].port = atoi(argv[1]);
+        args[i].cpu = pin ? i % ncpu : -1;
+        prev_pkts[i] = 0;
+        if(pthread_create(&t_id, NULL, worker, &args[i]) != 0)
+            error_handling("pthread_create() error");
+        pthread_detach(t_id);
+    }
+
+    // -------------------- 主线程：每秒汇总一次统计 --------------------
+    // 读取其它线程的计数器时不加锁：统计值允许有少量误差，
+    // __atomic_load_n 保证读到的是完整的值
+    while(1)
+    {
+        sleep(1);
+        total = bytes = calls = 0;
+        printf("per-thread pkt/s:");
+        for(i = 0; i < threads; i++)
+        {
+            pkts = __atomic_load_n(&args[i].stats.pkts, __ATOMIC_RELAXED);
+            printf(" %lu", pkts - prev_pkts[i]);
+            total += pkts - prev_pkts[i];
+            prev_pkts[i] = pkts;
+            bytes += __atomic_load_n(&args[i].stats.bytes, __ATOMIC_RELAXED);
+            calls += __atomic_load_n(&args[i].stats.calls, __ATOMIC_RELAXED);
+        }
+        printf(" | total %lu pkt/s, %lu bytes, %lu calls so far\n", total, bytes, calls);
+        fflush(stdout);
+    }
+
+    return 0;
+}
+
+/*
+ * 工作线程：创建自己的 SO_REUSEPORT 套接字，批量收发回声
+ */
+void* worker(void* arg)
+{
+    worker_arg *wa = (worker_arg*)arg;
+    int sock, opt = 1, i, n, sent, ret;
+    unsigned long bytes;
+    struct sockaddr_in serv_addr;
+    cpu_set_t cpus;
+    // 消息数组在线程自己的栈上，缓冲区是线程局部存储（__thread）：各线程之间没有共享的数据
+    struct mmsghdr msgs[BATCH];
+    struct iovec iovs[BATCH];
+    struct sockaddr_in addrs[BATCH];
+    static __thread char bufs[BATCH][BUF_SIZE];
+
+    // 可选：把线程固定到某个 CPU 上
+    if(wa->cpu >= 0)
+    {
+        CPU_ZERO(&cpus);
+        CPU_SET(wa->cpu, &cpus);
+        if(pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus) != 0)
+            fputs("pthread_setaffinity_np() failed, running unpinned\n", stderr);
+    }
+
+    sock = socket(PF_INET, SOCK_DGRAM, 0);
+    if(sock == -1)
+        error_handling("socket() error");
+
+    // 关键：必须在 bind 之前设置 SO_REUSEPORT，所有套接字都要设置
+    if(setsockopt(sock, SOL_SOCKET, SO_REUSEPORT, &opt, sizeof(opt)) == -1)
+        error_handling("setsockopt(SO_REUSEPORT) error");
+
+    memset(&serv_addr, 0, sizeof(serv_addr));
+    serv_addr.sin_family = AF_INET;
+    serv_addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    serv_addr.sin_port = htons(wa->port);
+    if(bind(sock, (struct sockaddr*)&serv_addr, sizeof(serv_addr)) == -1)
+        error_handling("bind() error");
+
+    memset(msgs, 0, sizeof(msgs));
+    for(i = 0; i < BATCH; i++)
+    {
+        iovs[i].iov_base = bufs[i];
+        msgs[i].msg_hdr.msg_iov = &iovs[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+        msgs[i].msg_hdr.msg_name = &addrs[i];
+    }
+
+    while(1)
+    {
+        for(i = 0; i < BATCH; i++)
+        {
+            iovs[i].iov_len = BUF_SIZE;
+            msgs[i].msg_hdr.msg_namelen = sizeof(struct sockaddr_in);
+        }
+
+        n = recvmmsg(sock, msgs, BATCH, MSG_WAITFORONE, NULL);
+        if(n <= 0)
+            continue;
+
+        bytes = 0;
+        for(i = 0; i < n; i++)
+        {
+            iovs[i].iov_len = msgs[i].msg_len;
+            bytes += msgs[i].msg_len;
+        }
+
+        // 返回 -1 时只有当前这一个数据报发送失败：跳过它，继续发后面的回包
+        sent = 0;
+        while(sent < n)
+        {
+            ret = sendmmsg(sock, msgs + sent, n - sent, 0);
+            if(ret == -1)
+            {
+                if(errno != EINTR)
+                    sent++;
+                continue;
+            }
+            sent += ret;
+        }
+
+        // 只有本线程写自己的计数器；用原子存储保证主线程读到完整值
+        __atomic_store_n(&wa->stats.pkts, wa->stats.pkts + n, __ATOMIC_RELAXED);
+        __atomic_store_n(&wa->stats.bytes, wa->stats.bytes + bytes, __ATOMIC_RELAXED);
+        __atomic_store_n(&wa->stats.calls, wa->stats.calls + 1, __ATOMIC_RELAXED);
+    }
+
+    close(sock);
+    return NULL;
+}
+
+void error_handling(char *message)
+{
+    fputs(message, stderr);
+    fputc('\n', stderr);
+    exit(1);
+}
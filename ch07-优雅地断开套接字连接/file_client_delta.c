@@ -0,0 +1,275 @@
+#include <arpa/inet.h>   // inet_addr, htonl, htons, ntohl, sockaddr_in
+#include <endian.h>      // htobe64, be64toh：64 位整数的字节序转换
+#include <fcntl.h>       // open, O_*
+#include <math.h>        // sqrt：按文件大小选择块大小
+#include <stdint.h>      // uint8_t, uint32_t, uint64_t
+#include <stdio.h>       // printf, puts, fputs, rename
+#include <stdlib.h>      // exit, atoi, malloc, free
+#include <string.h>      // memset, memcpy
+#include <sys/mman.h>    // mmap, munmap：映射旧文件，计算签名与复制块都直接读内存
+#include <sys/socket.h>  // socket, connect
+#include <sys/stat.h>    // fstat
+#include <unistd.h>      // read, write, close
+
+/*
+ * rsync 风格的增量同步 —— 客户端（接收方）
+ * 算法与协议说明见 file_server_delta.c
+ *
+ * 接收方流程：
+ *   1) 把已有的 received.data（旧版本，可能不存在）切块，发送块签名表
+ *   2) 按发送方的指令重建新文件到 received.data.tmp：
+ *        'L' 字面量直接写入；'C' 从旧文件复制对应的块
+ *   3) 校验整文件强校验与长度，一致后 rename 覆盖 received.data
+ *      （rename 是原子的：中途失败不会破坏旧文件，下次仍可增量同步）
+ */
+
+#define BUF_SIZE (64 * 1024)      // 接收缓冲区大小
+#define MIN_BLOCK_SIZE 1024       // 块大小下限
+#define MAX_BLOCK_SIZE (1 << 16)  // 块大小上限
+#define SIG_ENTRY_SIZE 12         // 每块签名：4 字节弱校验 + 8 字节强校验
+#define OLD_FILE "received.data"
+#define TMP_FILE "received.data.tmp"
+
+/* 带缓冲的输入：指令头很短，逐个 read 会产生大量系统调用 */
+typedef struct {
+  int sock;
+  uint8_t buf[BUF_SIZE];
+  size_t pos, len;
+  uint64_t wire_bytes;  // 统计：收到的总字节数
+} in_buf;
+
+uint32_t weak_sum(const uint8_t* p, uint32_t len);
+uint64_t strong_sum(const uint8_t* p, size_t len, uint64_t h);
+void send_signatures(int sock, const uint8_t* old, size_t old_size, uint32_t bs);
+void in_read(in_buf* in, void* p, size_t len);
+int write_full(int fd, const void* buf, size_t len);
+void error_handling(char* message);
+
+int main(int argc, char* argv[]) {
+  int sock, old_fd, tmp_fd;
+  struct sockaddr_in serv_addr;
+  struct stat st;
+  const uint8_t* old;
+  size_t old_size;
+  uint32_t bs, v[2], n, first, cnt;
+  uint64_t tail[2], new_size, hash, written, copied;
+  static in_buf in;
+  static uint8_t lit[BUF_SIZE];
+  const uint8_t* src;
+  size_t src_len;
+  char op;
+
+  if (argc != 3) {
+    printf("Usage: %s <IP> <port>\n", argv[0]);
+    exit(1);
+  }
+
+  // -------------------------
+  // 映射旧文件（不存在则视为空文件，此时退化为全量传输）
+  // -------------------------
+  old = NULL;
+  old_size = 0;
+  old_fd = open(OLD_FILE, O_RDONLY);
+  if (old_fd != -1 && fstat(old_fd, &st) == 0 && st.st_size > 0) {
+    old_size = (size_t)st.st_size;
+    old = mmap(NULL, old_size, PROT_READ, MAP_PRIVATE, old_fd, 0);
+    if (old == MAP_FAILED)
+      error_handling("mmap() error");
+  }
+
+  // 块大小取 sqrt(文件大小)，与 rsync 的经验值一致：
+  // 块越小匹配越细但签名表越大，sqrt 让两者的开销大致平衡
+  bs = (uint32_t)sqrt((double)old_size);
+  if (bs < MIN_BLOCK_SIZE)
+    bs = MIN_BLOCK_SIZE;
+  if (bs > MAX_BLOCK_SIZE)
+    bs = MAX_BLOCK_SIZE;
+
+  sock = socket(PF_INET, SOCK_STREAM, 0);
+  if (sock == -1)
+    error_handling("socket() error");
+
+  memset(&serv_addr, 0, sizeof(serv_addr));
+  serv_addr.sin_family = AF_INET;
+  serv_addr.sin_addr.s_addr = inet_addr(argv[1]);
+  serv_addr.sin_port = htons(atoi(argv[2]));
+
+  if (connect(sock, (struct sockaddr*)&serv_addr, sizeof(serv_addr)) == -1)
+    error_handling("connect() error");
+
+  // -------------------------
+  // 第一步：发送旧文件的块签名表
+  // -------------------------
+  send_signatures(sock, old, old_size, bs);
+
+  // -------------------------
+  // 第二步：按指令重建新文件
+  // -------------------------
+  tmp_fd = open(TMP_FILE, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (tmp_fd == -1)
+    error_handling("open() error");
+
+  in.sock = sock;
+  in.pos = in.len = 0;
+  in.wire_bytes = 0;
+  hash = 0xcbf29ce484222325ULL;  // 边写边累积整文件强校验
+  written = copied = 0;
+
+  while (1) {
+    in_read(&in, &op, 1);
+    if (op == 'E')
+      break;
+
+    if (op == 'L') {
+      in_read(&in, &n, 4);
+      n = ntohl(n);
+      if (n > BUF_SIZE)
+        error_handling("bad literal length");
+      in_read(&in, lit, n);
+      src = lit;
+      src_len = n;
+    } else if (op == 'C') {
+      in_read(&in, v, sizeof(v));
+      first = ntohl(v[0]);
+      cnt = ntohl(v[1]);
+      if ((uint64_t)(first + (uint64_t)cnt) * bs > old_size)
+        error_handling("bad block reference");
+      src = old + (size_t)first * bs;
+      src_len = (size_t)cnt * bs;
+      copied += src_len;
+    } else {
+      error_handling("bad opcode");
+    }
+
+    if (write_full(tmp_fd, src, src_len) == -1)
+      error_handling("write() error");
+    hash = strong_sum(src, src_len, hash);
+    written += src_len;
+  }
+
+  // -------------------------
+  // 第三步：校验长度与整文件强校验，通过后原子替换旧文件
+  // -------------------------
+  in_read(&in, tail, sizeof(tail));
+  new_size = be64toh(tail[0]);
+  if (written != new_size || hash != be64toh(tail[1])) {
+    unlink(TMP_FILE);
+    error_handling("checksum mismatch");
+  }
+  close(tmp_fd);
+  if (rename(TMP_FILE, OLD_FILE) == -1)
+    error_handling("rename() error");
+
+  puts("Received file date");
+  printf("file %llu bytes: %llu reused locally, %llu bytes on wire (%.1f%%)\n",
+         (unsigned long long)new_size, (unsigned long long)copied,
+         (unsigned long long)in.wire_bytes,
+         new_size > 0 ? in.wire_bytes * 100.0 / new_size : 0.0);
+
+  write(sock, "Thank you", 10);
+
+  if (old != NULL)
+    munmap((void*)old, old_size);
+  if (old_fd != -1)
+    close(old_fd);
+  close(sock);
+  return 0;
+}
+
+/* Adler 风格弱校验，与 file_server_delta.c 完全一致 */
+uint32_t weak_sum(const uint8_t* p, uint32_t len) {
+  uint32_t a = 0, b = 0, i;
+
+  for (i = 0; i < len; i++) {
+    a += p[i];
+    b += (len - i) * p[i];
+  }
+  return (a & 0xffff) | ((b & 0xffff) << 16);
+}
+
+/* 强校验：64 位 FNV-1a，h 为初始值（便于分段累积） */
+uint64_t strong_sum(const uint8_t* p, size_t len, uint64_t h) {
+  size_t i;
+
+  for (i = 0; i < len; i++) {
+    h ^= p[i];
+    h *= 0x100000001b3ULL;
+  }
+  return h;
+}
+
+/*
+ * 发送签名表：只对完整的块计算签名，文件末尾不足一块的部分不参与匹配
+ * 签名先攒进缓冲区再批量写出
+ */
+void send_signatures(int sock, const uint8_t* old, size_t old_size, uint32_t bs) {
+  static uint8_t buf[BUF_SIZE];
+  uint32_t cnt = (uint32_t)(old_size / bs), i, hdr[2];
+  size_t len = 0;
+
+  hdr[0] = htonl(bs);
+  hdr[1] = htonl(cnt);
+  if (write_full(sock, hdr, sizeof(hdr)) == -1)
+    error_handling("write() error");
+
+  for (i = 0; i < cnt; i++) {
+    if (len + SIG_ENTRY_SIZE > sizeof(buf)) {
+      if (write_full(sock, buf, len) == -1)
+        error_handling("write() error");
+      len = 0;
+    }
+    *(uint32_t*)(buf + len) = htonl(weak_sum(old + (size_t)i * bs, bs));
+    *(uint64_t*)(buf + len + 4) =
+        htobe64(strong_sum(old + (size_t)i * bs, bs, 0xcbf29ce484222325ULL));
+    len += SIG_ENTRY_SIZE;
+  }
+  if (len > 0 && write_full(sock, buf, len) == -1)
+    error_handling("write() error");
+}
+
+/* 从输入缓冲区读出恰好 len 字节，缓冲区空了就从 socket 补充 */
+void in_read(in_buf* in, void* p, size_t len) {
+  uint8_t* dst = (uint8_t*)p;
+  size_t n;
+  ssize_t r;
+
+  while (len > 0) {
+    if (in->pos == in->len) {
+      r = read(in->sock, in->buf, sizeof(in->buf));
+      if (r <= 0)
+        error_handling("read() error");
+      in->pos = 0;
+      in->len = (size_t)r;
+      in->wire_bytes += r;
+    }
+    n = in->len - in->pos;
+    if (n > len)
+      n = len;
+    memcpy(dst, in->buf + in->pos, n);
+    in->pos += n;
+    dst += n;
+    len -= n;
+  }
+}
+
+/* 写满 len 字节 */
+int write_full(int fd, const void* buf, size_t len) {
+  const char* p = (const char*)buf;
+  ssize_t n;
+
+  while (len > 0) {
+    n = write(fd, p, len);
+    if (n <= 0)
+      return -1;
+    p += n;
+    len -= n;
+  }
+  return 0;
+}
+
+void error_handling(char* message) {
+  // 输出错误信息并退出程序
+  fputs(message, stderr);
+  fputc('\n', stderr);
+  exit(1);
+}
@@ -0,0 +1,179 @@
+#include <arpa/inet.h>   // inet_addr, htons, ntohl, sockaddr_in
+#include <stdint.h>      // uint8_t, uint32_t, uint64_t
+#include <stdio.h>       // printf, puts, fputs, FILE, fopen, fwrite, fclose
+#include <stdlib.h>      // exit, atoi
+#include <string.h>      // memset, memcpy
+#include <sys/socket.h>  // socket, connect
+#include <sys/time.h>    // gettimeofday：统计耗时
+#include <unistd.h>      // read, write, close
+
+/*
+ * 带流式压缩的文件传输 —— 客户端（接收方）
+ * 帧格式与压缩块格式见 file_server_lz.c
+ *
+ * 接收方按帧读取：压缩长度为 0 的帧直接写文件，否则先解压再写文件。
+ * LZ 解压只是顺序的内存拷贝，速度远高于网络，因此放在接收线程内联完成即可。
+ */
+
+#define CHUNK_SIZE (64 * 1024)  // 每块原始数据的最大长度（与服务器一致）
+#define MIN_MATCH 4
+
+int lz_decompress(const uint8_t* src, int src_len, uint8_t* dst, int dst_len);
+int read_full(int fd, void* buf, size_t len);
+void error_handling(char* message);
+
+int main(int argc, char* argv[]) {
+  int sock;
+  struct sockaddr_in serv_addr;
+  FILE* fp;
+  uint32_t hdr[2], raw_len, comp_len;
+  static uint8_t in[CHUNK_SIZE], out[CHUNK_SIZE];
+  uint64_t raw_bytes = 0, wire_bytes = 0;
+  struct timeval start, end;
+  double secs;
+
+  if (argc != 3) {
+    printf("Usage: %s <IP> <port>\n", argv[0]);
+    exit(1);
+  }
+
+  sock = socket(PF_INET, SOCK_STREAM, 0);
+  if (sock == -1)
+    error_handling("socket() error");
+
+  fp = fopen("received.data", "wb");
+  if (fp == NULL)
+    error_handling("fopen() error");
+
+  memset(&serv_addr, 0, sizeof(serv_addr));
+  serv_addr.sin_family = AF_INET;
+  serv_addr.sin_addr.s_addr = inet_addr(argv[1]);
+  serv_addr.sin_port = htons(atoi(argv[2]));
+
+  if (connect(sock, (struct sockaddr*)&serv_addr, sizeof(serv_addr)) == -1)
+    error_handling("connect() error");
+
+  gettimeofday(&start, NULL);
+  while (1) {
+    if (read_full(sock, hdr, sizeof(hdr)) == -1)
+      error_handling("read() error");
+    raw_len = ntohl(hdr[0]);
+    comp_len = ntohl(hdr[1]);
+    wire_bytes += sizeof(hdr);
+    if (raw_len == 0)
+      break;
+    if (raw_len > CHUNK_SIZE || comp_len > CHUNK_SIZE)
+      error_handling("bad frame header");
+
+    if (comp_len == 0) {
+      // 原始块（发送方判断不可压缩）：直接写文件
+      if (read_full(sock, out, raw_len) == -1)
+        error_handling("read() error");
+      wire_bytes += raw_len;
+    } else {
+      if (read_full(sock, in, comp_len) == -1)
+        error_handling("read() error");
+      if (lz_decompress(in, (int)comp_len, out, (int)raw_len) != (int)raw_len)
+        error_handling("corrupt compressed chunk");
+      wire_bytes += comp_len;
+    }
+    fwrite(out, 1, raw_len, fp);
+    raw_bytes += raw_len;
+  }
+  gettimeofday(&end, NULL);
+
+  puts("Received file date");
+  secs = (end.tv_sec - start.tv_sec) + (end.tv_usec - start.tv_usec) / 1e6;
+  printf("%llu bytes on wire -> %llu bytes, ratio %.2f, %.1f MB/s (raw)\n",
+         (unsigned long long)wire_bytes, (unsigned long long)raw_bytes,
+         wire_bytes ? (double)raw_bytes / wire_bytes : 0.0,
+         secs > 0 ? raw_bytes / secs / (1024 * 1024) : 0.0);
+
+  write(sock, "Thank you", 10);
+
+  fclose(fp);
+  close(sock);
+  return 0;
+}
+
+/*
+ * LZ4 风格解压
+ * 对每个长度、偏移都做越界检查，损坏或恶意的数据不会写出 dst 之外
+ * 返回解压后长度，出错返回 -1
+ */
+int lz_decompress(const uint8_t* src, int src_len, uint8_t* dst, int dst_len) {
+  const uint8_t* ip = src;
+  const uint8_t* ip_end = src + src_len;
+  uint8_t* op = dst;
+  uint8_t* op_end = dst + dst_len;
+  const uint8_t* ref;
+  int token, lit, mlen, off;
+
+  while (ip < ip_end) {
+    token = *ip++;
+
+    // 字面量长度（token 高 4 位 + 扩展字节）
+    lit = token >> 4;
+    if (lit == 15) {
+      do {
+        if (ip >= ip_end)
+          return -1;
+        lit += *ip;
+      } while (*ip++ == 255);
+    }
+    if (lit > ip_end - ip || lit > op_end - op)
+      return -1;
+    memcpy(op, ip, lit);
+    ip += lit;
+    op += lit;
+
+    // 最后一个序列只有字面量
+    if (ip == ip_end)
+      break;
+
+    // 匹配：2 字节小端偏移 + 长度（token 低 4 位 + 4 + 扩展字节）
+    if (ip_end - ip < 2)
+      return -1;
+    off = ip[0] | (ip[1] << 8);
+    ip += 2;
+    mlen = token & 15;
+    if (mlen == 15) {
+      do {
+        if (ip >= ip_end)
+          return -1;
+        mlen += *ip;
+      } while (*ip++ == 255);
+    }
+    mlen += MIN_MATCH;
+    if (off == 0 || off > op - dst || mlen > op_end - op)
+      return -1;
+
+    // 匹配源与目标可能重叠（off < mlen 表示重复模式），必须逐字节向前拷贝
+    ref = op - off;
+    while (mlen-- > 0)
+      *op++ = *ref++;
+  }
+  return (int)(op - dst);
+}
+
+/* 读满 len 字节，对端提前关闭返回 -1 */
+int read_full(int fd, void* buf, size_t len) {
+  char* p = (char*)buf;
+  ssize_t n;
+
+  while (len > 0) {
+    n = read(fd, p, len);
+    if (n <= 0)
+      return -1;
+    p += n;
+    len -= n;
+  }
+  return 0;
+}
+
+void error_handling(char* message) {
+  // 输出错误信息并退出程序
+  fputs(message, stderr);
+  fputc('\n', stderr);
+  exit(1);
+}
@@ -0,0 +1,214 @@
+#define _GNU_SOURCE
+#include <arpa/inet.h>   // inet_addr, htonl, htons, ntohl, sockaddr_in
+#include <endian.h>      // be64toh：64 位整数的字节序转换（文件偏移量）
+#include <fcntl.h>       // open, fallocate, O_*：以系统调用方式创建并预分配文件
+#include <pthread.h>     // pthread_create, pthread_join：多线程并行接收
+#include <stdint.h>      // uint32_t, uint64_t
+#include <stdio.h>       // printf, puts, fputs
+#include <stdlib.h>      // exit, atoi
+#include <string.h>      // memset
+#include <sys/socket.h>  // socket, connect
+#include <sys/time.h>    // gettimeofday：统计耗时
+#include <unistd.h>      // read, write, pwrite, ftruncate, close
+
+/*
+ * 多连接并行（条带化）文件传输 —— 客户端（接收方）
+ * 协议说明见 file_server_stripe.c
+ *
+ * 接收方的要点：
+ *   - 先用 fallocate 按文件总大小预分配磁盘空间，避免多线程乱序写入时
+ *     文件系统反复扩展文件、产生碎片
+ *   - 每个接收线程按区间头里的偏移量用 pwrite 写入，各线程互不干扰，无需加锁
+ */
+
+#define DEFAULT_STREAMS 4  // 默认请求的并行流数量
+#define MAX_STREAMS 32     // 并行流数量上限（与服务器一致）
+#define BUF_SIZE (64 * 1024)  // 每个接收线程的缓冲区大小
+#define RANGE_HDR_SIZE 12  // 区间头：8 字节偏移 + 4 字节长度
+
+/* 每个接收线程的参数与统计 */
+typedef struct {
+  int sock;             // 该线程负责的数据连接
+  int file_fd;          // 输出文件（各线程共享，pwrite 显式传偏移）
+  uint64_t file_size;   // 文件总大小：用于校验区间是否越界
+  uint64_t bytes_recv;  // 统计：本连接接收的字节数
+  uint32_t ranges;      // 统计：本连接接收的区间个数
+} stream_arg;
+
+void* recv_stream(void* arg);
+int write_full(int fd, const void* buf, size_t len);
+int read_full(int fd, void* buf, size_t len);
+void error_handling(char* message);
+
+int main(int argc, char* argv[]) {
+  int ctrl_sock, file_fd;
+  struct sockaddr_in serv_addr;
+  uint32_t want_streams, streams;
+  uint64_t file_size, total;
+  unsigned char reply[12];
+  stream_arg args[MAX_STREAMS];
+  pthread_t t_ids[MAX_STREAMS];
+  struct timeval start, end;
+  double secs;
+  uint32_t i;
+
+  if (argc != 3 && argc != 4) {
+    printf("Usage: %s <IP> <port> [streams]\n", argv[0]);
+    exit(1);
+  }
+  want_streams = (argc == 4) ? (uint32_t)atoi(argv[3]) : DEFAULT_STREAMS;
+
+  memset(&serv_addr, 0, sizeof(serv_addr));
+  serv_addr.sin_family = AF_INET;
+  serv_addr.sin_addr.s_addr = inet_addr(argv[1]);
+  serv_addr.sin_port = htons(atoi(argv[2]));
+
+  // -------------------------
+  // 第一步：建立控制连接，告诉服务器期望的流数量，读取文件大小与实际流数量
+  // -------------------------
+  ctrl_sock = socket(PF_INET, SOCK_STREAM, 0);
+  if (ctrl_sock == -1)
+    error_handling("socket() error");
+  if (connect(ctrl_sock, (struct sockaddr*)&serv_addr, sizeof(serv_addr)) == -1)
+    error_handling("connect() error");
+
+  want_streams = htonl(want_streams);
+  if (write_full(ctrl_sock, &want_streams, 4) == -1)
+    error_handling("write() error");
+  if (read_full(ctrl_sock, reply, sizeof(reply)) == -1)
+    error_handling("read() error");
+  file_size = be64toh(*(uint64_t*)reply);
+  streams = ntohl(*(uint32_t*)(reply + 8));
+  if (streams == 0 || streams > MAX_STREAMS)
+    error_handling("bad stream count from server");
+
+  // -------------------------
+  // 预分配输出文件：
+  // fallocate 真正分配磁盘块；若文件系统不支持（如 tmpfs 旧内核），退回 ftruncate
+  // -------------------------
+  file_fd = open("received.data", O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (file_fd == -1)
+    error_handling("open() error");
+  if (file_size > 0 && fallocate(file_fd, 0, 0, (off_t)file_size) == -1)
+    if (ftruncate(file_fd, (off_t)file_size) == -1)
+      error_handling("ftruncate() error");
+
+  // -------------------------
+  // 第二步：建立 N 条数据连接，每条连接一个接收线程
+  // -------------------------
+  gettimeofday(&start, NULL);
+  for (i = 0; i < streams; i++) {
+    args[i].sock = socket(PF_INET, SOCK_STREAM, 0);
+    if (args[i].sock == -1)
+      error_handling("socket() error");
+    if (connect(args[i].sock, (struct sockaddr*)&serv_addr, sizeof(serv_addr)) == -1)
+      error_handling("connect() error");
+    args[i].file_fd = file_fd;
+    args[i].file_size = file_size;
+    args[i].bytes_recv = 0;
+    args[i].ranges = 0;
+    pthread_create(&t_ids[i], NULL, recv_stream, &args[i]);
+  }
+
+  total = 0;
+  for (i = 0; i < streams; i++) {
+    pthread_join(t_ids[i], NULL);
+    total += args[i].bytes_recv;
+  }
+  gettimeofday(&end, NULL);
+
+  if (total != file_size)
+    error_handling("incomplete transfer");
+  puts("Received file date");
+
+  secs = (end.tv_sec - start.tv_sec) + (end.tv_usec - start.tv_usec) / 1e6;
+  for (i = 0; i < streams; i++)
+    printf("stream %2u: %10llu bytes, %4u ranges\n", i,
+           (unsigned long long)args[i].bytes_recv, args[i].ranges);
+  printf("received %llu bytes over %u streams in %.3f s (%.1f MB/s)\n",
+         (unsigned long long)total, streams, secs,
+         secs > 0 ? total / secs / (1024 * 1024) : 0.0);
+
+  // 第三步：在控制连接上发送确认（与 file_client.c 一致）
+  write(ctrl_sock, "Thank you", 10);
+
+  close(file_fd);
+  close(ctrl_sock);
+  return 0;
+}
+
+/*
+ * 接收线程：循环"读区间头 -> 读区间数据并 pwrite 到对应偏移"，
+ * 读到长度为 0 的结束头后退出
+ */
+void* recv_stream(void* arg) {
+  stream_arg* sa = (stream_arg*)arg;
+  unsigned char hdr[RANGE_HDR_SIZE];
+  char buf[BUF_SIZE];
+  uint64_t off;
+  uint32_t len, chunk;
+
+  while (1) {
+    if (read_full(sa->sock, hdr, sizeof(hdr)) == -1)
+      error_handling("read() error");
+    off = be64toh(*(uint64_t*)hdr);
+    len = ntohl(*(uint32_t*)(hdr + 8));
+    if (len == 0)
+      break;
+    if (off + len > sa->file_size)
+      error_handling("range out of bounds");
+
+    // 按缓冲区大小分块读取，再 pwrite 到文件的对应位置
+    while (len > 0) {
+      chunk = len < BUF_SIZE ? len : BUF_SIZE;
+      if (read_full(sa->sock, buf, chunk) == -1)
+        error_handling("read() error");
+      if (pwrite(sa->file_fd, buf, chunk, (off_t)off) != (ssize_t)chunk)
+        error_handling("pwrite() error");
+      off += chunk;
+      len -= chunk;
+      sa->bytes_recv += chunk;
+    }
+    sa->ranges++;
+  }
+
+  close(sa->sock);
+  return NULL;
+}
+
+/* 写满 len 字节 */
+int write_full(int fd, const void* buf, size_t len) {
+  const char* p = (const char*)buf;
+  ssize_t n;
+
+  while (len > 0) {
+    n = write(fd, p, len);
+    if (n <= 0)
+      return -1;
+    p += n;
+    len -= n;
+  }
+  return 0;
+}
+
+/* 读满 len 字节，对端提前关闭返回 -1 */
+int read_full(int fd, void* buf, size_t len) {
+  char* p = (char*)buf;
+  ssize_t n;
+
+  while (len > 0) {
+    n = read(fd, p, len);
+    if (n <= 0)
+      return -1;
+    p += n;
+    len -= n;
+  }
+  return 0;
+}
+
+void error_handling(char* message) {
+  // 输出错误信息并退出程序
+  fputs(message, stderr);
+  fputc('\n', stderr);
+  exit(1);
+}
@@ -0,0 +1,410 @@
+#include <arpa/inet.h>   // htonl, htons, ntohl, sockaddr_in：字节序转换、IPv4 地址结构
+#include <endian.h>      // htobe64：64 位整数的字节序转换（整文件校验值）
+#include <fcntl.h>       // open, O_RDONLY
+#include <stdint.h>      // uint8_t, uint32_t, uint64_t
+#include <stdio.h>       // printf, fputs
+#include <stdlib.h>      // exit, atoi, malloc, calloc, free
+#include <string.h>      // memset, memcpy
+#include <sys/mman.h>    // mmap, munmap：把要发送的文件映射到内存，便于滚动扫描
+#include <sys/socket.h>  // socket, bind, listen, accept, shutdown
+#include <sys/stat.h>    // fstat：获取文件大小
+#include <unistd.h>      // read, write, close
+
+/*
+ * rsync 风格的增量同步 —— 服务器端（发送方）
+ *
+ * file_server.c 每次都把整个文件重新发送一遍。当接收方已经有一份"旧版本"时，
+ * 大部分数据其实没有变化。本示例采用 rsync 的算法只传输差异：
+ *
+ *   1) 接收方把旧文件按固定块大小切块，为每块计算
+ *        - 弱校验（Adler 风格的 32 位滚动校验和，可 O(1) 滑动）
+ *        - 强校验（64 位 FNV-1a 哈希，弱校验命中后用来确认）
+ *      然后把"块签名表"发给发送方。
+ *   2) 发送方用大小为块长的窗口在新文件上逐字节滑动：
+ *        - 弱校验在签名表中命中且强校验一致 -> 发送"块引用"（接收方从旧文件复制）
+ *        - 否则窗口右移 1 字节，移出的字节累积为"字面量（literal）"
+ *   3) 最后发送整文件强校验，接收方重建后校验，防止哈希碰撞导致静默损坏。
+ *
+ * 协议（整数均为网络字节序）：
+ *   接收方 -> 发送方：[4 块大小][4 块数量] + 块数量 * ([4 弱校验][8 强校验])
+ *   发送方 -> 接收方：若干条指令，然后半关闭
+ *     'L' [4 长度][长度字节的字面量数据]
+ *     'C' [4 起始块号][4 连续块数]       连续的块引用合并为一条
+ *     'E' [8 新文件总长][8 整文件强校验] 结束
+ *   接收方 -> 发送方："Thank you"（与 file_client.c 一致）
+ */
+
+#define BUF_SIZE (64 * 1024)    // 发送缓冲区大小，也是单条字面量指令的最大长度
+#define MAX_BLOCK_SIZE (1 << 20)  // 允许的最大块大小（防止恶意/错误的签名头）
+#define MAX_BLOCK_CNT (1 << 22)   // 允许的最大块数：签名表 + 哈希索引约 96MB，块数乘 2 也不会溢出
+#define SIG_ENTRY_SIZE 12       // 每块签名：4 字节弱校验 + 8 字节强校验
+
+/* 块签名表 + 以弱校验为键的链式哈希索引 */
+typedef struct {
+  uint32_t block_size;
+  uint32_t block_cnt;
+  uint32_t* weak;    // 每块的弱校验
+  uint64_t* strong;  // 每块的强校验
+  int32_t* head;     // 哈希桶：弱校验 -> 第一个块号（-1 表示空）
+  int32_t* next;     // 同一个桶里的下一个块号
+  uint32_t mask;     // 桶数量 - 1（桶数量为 2 的幂）
+} sig_table;
+
+/* 带缓冲的输出：把小指令攒成大块再 write，减少系统调用次数 */
+typedef struct {
+  int sock;
+  char buf[BUF_SIZE];
+  size_t len;
+  uint64_t wire_bytes;  // 统计：实际发送的总字节数
+} out_buf;
+
+uint32_t weak_sum(const uint8_t* p, uint32_t len);
+uint64_t strong_sum(const uint8_t* p, size_t len, uint64_t h);
+void read_signatures(int sock, sig_table* sig);
+int32_t find_block(const sig_table* sig, uint32_t weak, const uint8_t* p);
+void emit_literal(out_buf* out, const uint8_t* p, size_t len);
+void emit_copy(out_buf* out, uint32_t first, uint32_t cnt);
+void out_put(out_buf* out, const void* p, size_t len);
+void out_flush(out_buf* out);
+int read_full(int fd, void* buf, size_t len);
+void error_handling(char* message);
+
+int main(int argc, char* argv[]) {
+  int serv_sock, clnt_sock, file_fd;
+  struct sockaddr_in serv_addr, clnt_addr;
+  socklen_t clnt_addr_sz;
+  struct stat st;
+  const uint8_t* data;
+  size_t size, pos, lit_start;
+  uint32_t bs, a, b, weak;
+  int32_t blk, run_first, run_cnt;
+  uint64_t copied, literal, tail[2];
+  sig_table sig;
+  static out_buf out;
+  char buf[30];
+
+  if (argc != 3) {
+    printf("Usage: %s <port> <file>\n", argv[0]);
+    exit(1);
+  }
+
+  // -------------------------
+  // 把新文件映射到内存：滚动扫描需要随机访问窗口两端的字节
+  // -------------------------
+  file_fd = open(argv[2], O_RDONLY);
+  if (file_fd == -1)
+    error_handling("open() error");
+  if (fstat(file_fd, &st) == -1)
+    error_handling("fstat() error");
+  size = (size_t)st.st_size;
+  data = NULL;
+  if (size > 0) {
+    data = mmap(NULL, size, PROT_READ, MAP_PRIVATE, file_fd, 0);
+    if (data == MAP_FAILED)
+      error_handling("mmap() error");
+    madvise((void*)data, size, MADV_SEQUENTIAL);  // 顺序扫描，提示内核加大预读
+  }
+
+  serv_sock = socket(PF_INET, SOCK_STREAM, 0);
+  if (serv_sock == -1)
+    error_handling("socket() error");
+
+  memset(&serv_addr, 0, sizeof(serv_addr));
+  serv_addr.sin_family = AF_INET;
+  serv_addr.sin_addr.s_addr = htonl(INADDR_ANY);
+  serv_addr.sin_port = htons(atoi(argv[1]));
+
+  if (bind(serv_sock, (struct sockaddr*)&serv_addr, sizeof(serv_addr)) == -1)
+    error_handling("bind() error");
+  if (listen(serv_sock, 5) == -1)
+    error_handling("listen() error");
+
+  clnt_addr_sz = sizeof(clnt_addr);
+  clnt_sock = accept(serv_sock, (struct sockaddr*)&clnt_addr, &clnt_addr_sz);
+  if (clnt_sock == -1)
+    error_handling("accept() error");
+
+  // -------------------------
+  // 第一步：读取接收方旧文件的块签名表
+  // -------------------------
+  read_signatures(clnt_sock, &sig);
+  bs = sig.block_size;
+
+  // -------------------------
+  // 第二步：滚动扫描新文件
+  // lit_start..pos 之间是尚未发送的字面量；
+  // run_first/run_cnt 记录正在累积的"连续块引用"
+  // -------------------------
+  out.sock = clnt_sock;
+  out.len = 0;
+  out.wire_bytes = 0;
+  copied = literal = 0;
+  pos = lit_start = 0;
+  run_first = -1;
+  run_cnt = 0;
+  a = b = 0;
+  weak = 0;
+  if (sig.block_cnt > 0 && size >= bs) {
+    weak = weak_sum(data, bs);
+    a = weak & 0xffff;
+    b = weak >> 16;
+  }
+
+  while (sig.block_cnt > 0 && pos + bs <= size) {
+    blk = find_block(&sig, weak, data + pos);
+    if (blk >= 0) {
+      // 命中：先把之前累积的字面量发出去，再记录块引用
+      if (pos > lit_start) {
+        if (run_cnt > 0) {
+          emit_copy(&out, (uint32_t)run_first, (uint32_t)run_cnt);
+          run_cnt = 0;
+        }
+        emit_literal(&out, data + lit_start, pos - lit_start);
+        literal += pos - lit_start;
+      }
+      // 与上一个块引用相邻则合并，否则先发出上一段
+      if (run_cnt > 0 && blk == run_first + run_cnt) {
+        run_cnt++;
+      } else {
+        if (run_cnt > 0)
+          emit_copy(&out, (uint32_t)run_first, (uint32_t)run_cnt);
+        run_first = blk;
+        run_cnt = 1;
+      }
+      copied += bs;
+      pos += bs;
+      lit_start = pos;
+
+      // 窗口整体跳过一个块后需要重新计算弱校验
+      if (pos + bs <= size) {
+        weak = weak_sum(data + pos, bs);
+        a = weak & 0xffff;
+        b = weak >> 16;
+      }
+      continue;
+    }
+
+    // 未命中：窗口右移 1 字节，O(1) 更新滚动校验
+    //   a' = a - out + in
+    //   b' = b - bs * out + a'
+    if (pos + bs < size) {
+      a = (a - data[pos] + data[pos + bs]) & 0xffff;
+      b = (b - bs * data[pos] + a) & 0xffff;
+      weak = a | (b << 16);
+    }
+    pos++;
+  }
+
+  // 收尾：剩余的块引用与字面量（包括不足一块的文件尾部）
+  if (run_cnt > 0 && lit_start < size) {
+    emit_copy(&out, (uint32_t)run_first, (uint32_t)run_cnt);
+    run_cnt = 0;
+  }
+  if (lit_start < size) {
+    emit_literal(&out, data + lit_start, size - lit_start);
+    literal += size - lit_start;
+  }
+  if (run_cnt > 0)
+    emit_copy(&out, (uint32_t)run_first, (uint32_t)run_cnt);
+
+  // 结束指令：新文件长度 + 整文件强校验
+  tail[0] = htobe64((uint64_t)size);
+  tail[1] = htobe64(strong_sum(data, size, 0xcbf29ce484222325ULL));
+  out_put(&out, "E", 1);
+  out_put(&out, tail, sizeof(tail));
+  out_flush(&out);
+
+  shutdown(clnt_sock, SHUT_WR);
+
+  memset(buf, 0, sizeof(buf));
+  read(clnt_sock, buf, sizeof(buf) - 1);
+  printf("Message from client: %s\n", buf);
+  printf("file %zu bytes: %llu copied from receiver, %llu literal, %llu bytes on wire (%.1f%%)\n",
+         size, (unsigned long long)copied, (unsigned long long)literal,
+         (unsigned long long)out.wire_bytes,
+         size > 0 ? out.wire_bytes * 100.0 / size : 0.0);
+
+  if (data != NULL)
+    munmap((void*)data, size);
+  free(sig.weak);
+  free(sig.strong);
+  free(sig.head);
+  free(sig.next);
+  close(file_fd);
+  close(clnt_sock);
+  close(serv_sock);
+  return 0;
+}
+
+/*
+ * Adler 风格弱校验：a = 字节和，b = 前缀和之和，各取低 16 位
+ * 与 rsync 相同，可以在窗口滑动时 O(1) 更新
+ */
+uint32_t weak_sum(const uint8_t* p, uint32_t len) {
+  uint32_t a = 0, b = 0, i;
+
+  for (i = 0; i < len; i++) {
+    a += p[i];
+    b += (len - i) * p[i];
+  }
+  return (a & 0xffff) | ((b & 0xffff) << 16);
+}
+
+/* 强校验：64 位 FNV-1a，h 为初始值（便于分段累积） */
+uint64_t strong_sum(const uint8_t* p, size_t len, uint64_t h) {
+  size_t i;
+
+  for (i = 0; i < len; i++) {
+    h ^= p[i];
+    h *= 0x100000001b3ULL;
+  }
+  return h;
+}
+
+/* 读取签名表并建立弱校验哈希索引 */
+void read_signatures(int sock, sig_table* sig) {
+  uint32_t hdr[2], i, nbuckets, h;
+  unsigned char entry[SIG_ENTRY_SIZE];
+
+  if (read_full(sock, hdr, sizeof(hdr)) == -1)
+    error_handling("read() error");
+  sig->block_size = ntohl(hdr[0]);
+  sig->block_cnt = ntohl(hdr[1]);
+  if (sig->block_size == 0 || sig->block_size > MAX_BLOCK_SIZE)
+    error_handling("bad block size");
+  // 块数来自对端，分配内存、计算桶数量之前先检查上限
+  if (sig->block_cnt > MAX_BLOCK_CNT)
+    error_handling("bad block count");
+
+  // 桶数量取不小于 2 * 块数的 2 的幂，让链平均长度 < 1
+  nbuckets = 1;
+  while (nbuckets < sig->block_cnt * 2)
+    nbuckets <<= 1;
+  sig->mask = nbuckets - 1;
+
+  sig->weak = malloc(sizeof(uint32_t) * (sig->block_cnt + 1));
+  sig->strong = malloc(sizeof(uint64_t) * (sig->block_cnt + 1));
+  sig->next = malloc(sizeof(int32_t) * (sig->block_cnt + 1));
+  sig->head = malloc(sizeof(int32_t) * nbuckets);
+  if (!sig->weak || !sig->strong || !sig->next || !sig->head)
+    error_handling("malloc() error");
+  memset(sig->head, 0xff, sizeof(int32_t) * nbuckets);  // 全部置为 -1
+
+  for (i = 0; i < sig->block_cnt; i++) {
+    if (read_full(sock, entry, sizeof(entry)) == -1)
+      error_handling("read() error");
+    sig->weak[i] = ntohl(*(uint32_t*)entry);
+    sig->strong[i] = be64toh(*(uint64_t*)(entry + 4));
+  }
+
+  // 倒序插入，使同一桶内块号小的排在前面（相同内容优先引用靠前的块）
+  for (i = sig->block_cnt; i-- > 0;) {
+    h = (sig->weak[i] * 2654435761u) & sig->mask;
+    sig->next[i] = sig->head[h];
+    sig->head[h] = (int32_t)i;
+  }
+}
+
+/* 在签名表中查找窗口 p 对应的块：先比弱校验，命中后再算强校验确认 */
+int32_t find_block(const sig_table* sig, uint32_t weak, const uint8_t* p) {
+  int32_t i = sig->head[(weak * 2654435761u) & sig->mask];
+  uint64_t strong = 0;
+  int have_strong = 0;
+
+  for (; i >= 0; i = sig->next[i]) {
+    if (sig->weak[i] != weak)
+      continue;
+    // 强校验开销大，只在弱校验命中时计算一次
+    if (!have_strong) {
+      strong = strong_sum(p, sig->block_size, 0xcbf29ce484222325ULL);
+      have_strong = 1;
+    }
+    if (sig->strong[i] == strong)
+      return i;
+  }
+  return -1;
+}
+
+/* 发送字面量：超过 BUF_SIZE 的拆成多条指令 */
+void emit_literal(out_buf* out, const uint8_t* p, size_t len) {
+  uint32_t n, net_len;
+
+  while (len > 0) {
+    n = len < BUF_SIZE ? (uint32_t)len : BUF_SIZE;
+    net_len = htonl(n);
+    out_put(out, "L", 1);
+    out_put(out, &net_len, 4);
+    out_put(out, p, n);
+    p += n;
+    len -= n;
+  }
+}
+
+/* 发送块引用：从第 first 块开始的 cnt 个连续块 */
+void emit_copy(out_buf* out, uint32_t first, uint32_t cnt) {
+  uint32_t v[2];
+
+  v[0] = htonl(first);
+  v[1] = htonl(cnt);
+  out_put(out, "C", 1);
+  out_put(out, v, sizeof(v));
+}
+
+/* 追加到输出缓冲区，满了就 flush；大块数据直接写出，避免多余的 memcpy */
+void out_put(out_buf* out, const void* p, size_t len) {
+  const char* src = (const char*)p;
+  ssize_t n;
+
+  if (out->len + len > BUF_SIZE) {
+    out_flush(out);
+    if (len >= BUF_SIZE) {
+      while (len > 0) {
+        n = write(out->sock, src, len);
+        if (n <= 0)
+          error_handling("write() error");
+        out->wire_bytes += n;
+        src += n;
+        len -= n;
+      }
+      return;
+    }
+  }
+  memcpy(out->buf + out->len, src, len);
+  out->len += len;
+}
+
+void out_flush(out_buf* out) {
+  size_t done = 0;
+  ssize_t n;
+
+  while (done < out->len) {
+    n = write(out->sock, out->buf + done, out->len - done);
+    if (n <= 0)
+      error_handling("write() error");
+    done += n;
+  }
+  out->wire_bytes += out->len;
+  out->len = 0;
+}
+
+/* 读满 len 字节，对端提前关闭返回 -1 */
+int read_full(int fd, void* buf, size_t len) {
+  char* p = (char*)buf;
+  ssize_t n;
+
+  while (len > 0) {
+    n = read(fd, p, len);
+    if (n <= 0)
+      return -1;
+    p += n;
+    len -= n;
+  }
+  return 0;
+}
+
+void error_handling(char* message) {
+  // 输出错误信息并退出
+  fputs(message, stderr);
+  fputc('\n', stderr);
+  exit(1);
+}
@@ -0,0 +1,360 @@
+#include <arpa/inet.h>   // htonl, htons, sockaddr_in
+#include <pthread.h>     // pthread_create, pthread_mutex_*, pthread_cond_*：压缩线程与发送线程流水线
+#include <stdint.h>      // uint8_t, uint32_t
+#include <stdio.h>       // printf, fputs, FILE, fopen, fread, fclose
+#include <stdlib.h>      // exit, atoi
+#include <string.h>      // memset, memcpy
+#include <sys/socket.h>  // socket, bind, listen, accept, shutdown
+#include <sys/time.h>    // gettimeofday：统计耗时
+#include <unistd.h>      // read, write, close
+
+/*
+ * 带流式压缩的文件传输 —— 服务器端（发送方）
+ *
+ * file_server.c 直接发送原始字节。对于文本类文件（日志、源码、CSV 等），
+ * 在带宽受限的链路上先压缩再发送可以快好几倍。本示例：
+ *
+ *   - 实现一个 LZ4 风格的快速 LZ77 压缩器（无第三方依赖），按块（CHUNK_SIZE）独立压缩
+ *   - 压缩在单独的线程中进行，通过有界队列交给主线程发送：
+ *       压缩线程：fread -> 压缩 -> 入队
+ *       主线程  ：出队 -> write
+ *     这样 CPU 压缩与网络 I/O 重叠进行，而不是串行等待
+ *   - 不可压缩的块（压缩后节省不足 1/16）直接以原始形式发送（bypass）；
+ *     连续多块不可压缩时（如已压缩的 zip/jpg），只隔几块试探一次，节省 CPU
+ *   - 传输结束后打印压缩率与吞吐量
+ *
+ * 帧格式（整数为网络字节序）：
+ *   [4 原始长度][4 压缩长度][数据]
+ *   压缩长度为 0 表示数据以原始形式发送（长度 = 原始长度）
+ *   原始长度为 0 的帧表示文件结束
+ *
+ * 压缩块格式（与 LZ4 block 格式相同的思路）：
+ *   若干"序列"：[token][字面量长度扩展][字面量][2 字节偏移(小端)][匹配长度扩展]
+ *   token 高 4 位为字面量长度，低 4 位为 (匹配长度 - 4)，值为 15 时后面跟 255 累加的扩展字节
+ *   最后一个序列只有字面量，没有偏移和匹配
+ */
+
+#define CHUNK_SIZE (64 * 1024)  // 每块原始数据大小（偏移用 16 位即可表示）
+#define QUEUE_LEN 8             // 压缩线程与发送线程之间的队列长度
+#define MIN_MATCH 4             // 最短匹配长度
+#define HASH_LOG 14             // 哈希表大小 2^14
+#define PROBE_INTERVAL 8        // 连续不可压缩时，每隔多少块试探压缩一次
+
+/* 队列中的一个槽位：保存一块已处理好的帧 */
+typedef struct {
+  uint32_t raw_len;   // 原始长度（0 表示结束）
+  uint32_t comp_len;  // 压缩长度（0 表示 bypass，data 中是原始数据）
+  uint8_t data[CHUNK_SIZE];
+} frame_slot;
+
+/* 有界环形队列：压缩线程生产、主线程消费 */
+typedef struct {
+  frame_slot slots[QUEUE_LEN];
+  int head, tail, count;
+  pthread_mutex_t mutex;
+  pthread_cond_t not_full, not_empty;
+} frame_queue;
+
+/* 压缩线程参数与统计 */
+typedef struct {
+  FILE* fp;
+  frame_queue* queue;
+  uint64_t raw_bytes;      // 原始字节数
+  uint64_t comp_in_bytes;  // 实际交给压缩器的原始字节数（跳过压缩的块不计）
+  uint64_t payload_bytes;  // 实际发送的负载字节数（压缩或原始）
+  uint32_t chunks, bypassed;
+  double comp_secs;        // 压缩线程在压缩上花费的时间
+} comp_arg;
+
+void* compress_thread(void* arg);
+int lz_compress(const uint8_t* src, int src_len, uint8_t* dst, int dst_cap);
+frame_slot* queue_begin_put(frame_queue* q);
+void queue_end_put(frame_queue* q);
+frame_slot* queue_begin_get(frame_queue* q);
+void queue_end_get(frame_queue* q);
+int write_full(int fd, const void* buf, size_t len);
+double now_secs(void);
+void error_handling(char* message);
+
+int main(int argc, char* argv[]) {
+  int serv_sock, clnt_sock;
+  struct sockaddr_in serv_addr, clnt_addr;
+  socklen_t clnt_addr_sz;
+  static frame_queue queue;
+  comp_arg ca;
+  pthread_t t_id;
+  frame_slot* slot;
+  uint32_t hdr[2], len;
+  double start, secs;
+  char buf[30];
+
+  if (argc != 3) {
+    printf("Usage: %s <port> <file>\n", argv[0]);
+    exit(1);
+  }
+
+  ca.fp = fopen(argv[2], "rb");
+  if (ca.fp == NULL)
+    error_handling("fopen() error");
+
+  serv_sock = socket(PF_INET, SOCK_STREAM, 0);
+  if (serv_sock == -1)
+    error_handling("socket() error");
+
+  memset(&serv_addr, 0, sizeof(serv_addr));
+  serv_addr.sin_family = AF_INET;
+  serv_addr.sin_addr.s_addr = htonl(INADDR_ANY);
+  serv_addr.sin_port = htons(atoi(argv[1]));
+
+  if (bind(serv_sock, (struct sockaddr*)&serv_addr, sizeof(serv_addr)) == -1)
+    error_handling("bind() error");
+  if (listen(serv_sock, 5) == -1)
+    error_handling("listen() error");
+
+  clnt_addr_sz = sizeof(clnt_addr);
+  clnt_sock = accept(serv_sock, (struct sockaddr*)&clnt_addr, &clnt_addr_sz);
+  if (clnt_sock == -1)
+    error_handling("accept() error");
+
+  // -------------------------
+  // 启动压缩线程，主线程只负责发送
+  // -------------------------
+  pthread_mutex_init(&queue.mutex, NULL);
+  pthread_cond_init(&queue.not_full, NULL);
+  pthread_cond_init(&queue.not_empty, NULL);
+  ca.queue = &queue;
+  ca.raw_bytes = ca.payload_bytes = ca.comp_in_bytes = 0;
+  ca.chunks = ca.bypassed = 0;
+  ca.comp_secs = 0;
+
+  start = now_secs();
+  pthread_create(&t_id, NULL, compress_thread, &ca);
+
+  while (1) {
+    slot = queue_begin_get(&queue);
+    hdr[0] = htonl(slot->raw_len);
+    hdr[1] = htonl(slot->comp_len);
+    len = slot->comp_len ? slot->comp_len : slot->raw_len;
+    if (write_full(clnt_sock, hdr, sizeof(hdr)) == -1 ||
+        write_full(clnt_sock, slot->data, len) == -1)
+      error_handling("write() error");
+    if (slot->raw_len == 0) {
+      queue_end_get(&queue);
+      break;
+    }
+    queue_end_get(&queue);
+  }
+  pthread_join(t_id, NULL);
+  shutdown(clnt_sock, SHUT_WR);
+
+  memset(buf, 0, sizeof(buf));
+  read(clnt_sock, buf, sizeof(buf) - 1);
+  secs = now_secs() - start;
+  printf("Message from client: %s\n", buf);
+
+  printf("chunks: %u (%u sent raw)\n", ca.chunks, ca.bypassed);
+  printf("raw %llu bytes -> %llu bytes on wire, ratio %.2f\n",
+         (unsigned long long)ca.raw_bytes, (unsigned long long)ca.payload_bytes,
+         ca.payload_bytes ? (double)ca.raw_bytes / ca.payload_bytes : 0.0);
+  printf("compress: %.1f MB/s, end-to-end: %.1f MB/s (raw)\n",
+         ca.comp_secs > 0 ? ca.comp_in_bytes / ca.comp_secs / (1024 * 1024) : 0.0,
+         secs > 0 ? ca.raw_bytes / secs / (1024 * 1024) : 0.0);
+
+  fclose(ca.fp);
+  close(clnt_sock);
+  close(serv_sock);
+  return 0;
+}
+
+/*
+ * 压缩线程：读一块 -> 尝试压缩 -> 放入队列
+ * 直接把压缩结果写进队列槽位，避免额外的拷贝
+ */
+void* compress_thread(void* arg) {
+  comp_arg* ca = (comp_arg*)arg;
+  static uint8_t raw[CHUNK_SIZE];
+  frame_slot* slot;
+  int n, c, skip = 0, misses = 0;
+  double t;
+
+  while (1) {
+    n = (int)fread(raw, 1, CHUNK_SIZE, ca->fp);
+    slot = queue_begin_put(ca->queue);
+    slot->raw_len = (uint32_t)n;
+    slot->comp_len = 0;
+
+    if (n > 0) {
+      c = -2;  // -2：本块未尝试压缩；-1：尝试过但压缩效果不够
+      // 连续不可压缩时进入"跳过"模式：只在 skip 归零时试探一次
+      if (skip == 0) {
+        t = now_secs();
+        // 压缩结果至少要节省 1/16，否则不值得接收方再花 CPU 解压
+        c = lz_compress(raw, n, slot->data, n - n / 16);
+        ca->comp_secs += now_secs() - t;
+        ca->comp_in_bytes += n;
+      } else {
+        skip--;
+      }
+
+      if (c > 0) {
+        slot->comp_len = (uint32_t)c;
+        misses = 0;
+      } else {
+        memcpy(slot->data, raw, n);
+        ca->bypassed++;
+        if (c == -1 && ++misses >= 4)
+          skip = PROBE_INTERVAL - 1;
+      }
+      ca->raw_bytes += n;
+      ca->payload_bytes += slot->comp_len ? slot->comp_len : (uint32_t)n;
+      ca->chunks++;
+    }
+    queue_end_put(ca->queue);
+
+    if (n == 0)  // 结束帧已入队
+      break;
+  }
+  return NULL;
+}
+
+/* 写入 token 中的长度扩展：值 >= 15 时用若干个 255 累加再加余数 */
+static uint8_t* put_len_ext(uint8_t* op, int len) {
+  len -= 15;
+  while (len >= 255) {
+    *op++ = 255;
+    len -= 255;
+  }
+  *op++ = (uint8_t)len;
+  return op;
+}
+
+/*
+ * LZ4 风格压缩
+ * 返回压缩后长度；若输出超过 dst_cap（即压缩效果不够好）返回 -1
+ */
+int lz_compress(const uint8_t* src, int src_len, uint8_t* dst, int dst_cap) {
+  static uint32_t table[1 << HASH_LOG];  // 4 字节序列的哈希 -> 最近出现位置 + 1（0 表示空）
+  const uint8_t* dst_end = dst + dst_cap;
+  uint8_t *op = dst, *token;
+  int ip = 0, anchor = 0, ref, mlen, lit, step_cnt = 0;
+  uint32_t seq, h;
+
+  memset(table, 0, sizeof(table));
+
+  while (ip + MIN_MATCH <= src_len) {
+    memcpy(&seq, src + ip, 4);
+    h = (seq * 2654435761u) >> (32 - HASH_LOG);
+    ref = (int)table[h] - 1;
+    table[h] = (uint32_t)ip + 1;
+
+    if (ref < 0 || ip - ref > 65535 || memcmp(src + ref, src + ip, 4) != 0) {
+      // 未命中：长时间找不到匹配时加大步长（数据大概率不可压缩，快速跳过）
+      ip += 1 + (step_cnt++ >> 6);
+      continue;
+    }
+    step_cnt = 0;
+
+    // 向后扩展匹配
+    mlen = MIN_MATCH;
+    while (ip + mlen < src_len && src[ref + mlen] == src[ip + mlen])
+      mlen++;
+
+    // 输出一个序列：token + 字面量 + 偏移 + 匹配长度扩展
+    // 最坏情况所需空间：1 + lit/255 + 1 + lit + 2 + mlen/255 + 1
+    lit = ip - anchor;
+    if (op + 1 + lit / 255 + 1 + lit + 2 + mlen / 255 + 1 > dst_end)
+      return -1;
+    token = op++;
+    *token = (uint8_t)((lit >= 15 ? 15 : lit) << 4);
+    if (lit >= 15)
+      op = put_len_ext(op, lit);
+    memcpy(op, src + anchor, lit);
+    op += lit;
+    *op++ = (uint8_t)((ip - ref) & 0xff);
+    *op++ = (uint8_t)((ip - ref) >> 8);
+    *token |= (uint8_t)(mlen - MIN_MATCH >= 15 ? 15 : mlen - MIN_MATCH);
+    if (mlen - MIN_MATCH >= 15)
+      op = put_len_ext(op, mlen - MIN_MATCH);
+
+    ip += mlen;
+    anchor = ip;
+  }
+
+  // 最后一个序列：只有字面量
+  lit = src_len - anchor;
+  if (op + 1 + lit / 255 + 1 + lit > dst_end)
+    return -1;
+  token = op++;
+  *token = (uint8_t)((lit >= 15 ? 15 : lit) << 4);
+  if (lit >= 15)
+    op = put_len_ext(op, lit);
+  memcpy(op, src + anchor, lit);
+  op += lit;
+  return (int)(op - dst);
+}
+
+/* 生产者：等待空槽位 */
+frame_slot* queue_begin_put(frame_queue* q) {
+  pthread_mutex_lock(&q->mutex);
+  while (q->count == QUEUE_LEN)
+    pthread_cond_wait(&q->not_full, &q->mutex);
+  pthread_mutex_unlock(&q->mutex);
+  // 只有生产者会写 tail 槽位，解锁后填充数据是安全的
+  return &q->slots[q->tail];
+}
+
+/* 生产者：槽位填好，提交给消费者 */
+void queue_end_put(frame_queue* q) {
+  pthread_mutex_lock(&q->mutex);
+  q->tail = (q->tail + 1) % QUEUE_LEN;
+  q->count++;
+  pthread_cond_signal(&q->not_empty);
+  pthread_mutex_unlock(&q->mutex);
+}
+
+/* 消费者：等待有数据的槽位 */
+frame_slot* queue_begin_get(frame_queue* q) {
+  pthread_mutex_lock(&q->mutex);
+  while (q->count == 0)
+    pthread_cond_wait(&q->not_empty, &q->mutex);
+  pthread_mutex_unlock(&q->mutex);
+  return &q->slots[q->head];
+}
+
+/* 消费者：槽位用完，归还给生产者 */
+void queue_end_get(frame_queue* q) {
+  pthread_mutex_lock(&q->mutex);
+  q->head = (q->head + 1) % QUEUE_LEN;
+  q->count--;
+  pthread_cond_signal(&q->not_full);
+  pthread_mutex_unlock(&q->mutex);
+}
+
+/* 写满 len 字节 */
+int write_full(int fd, const void* buf, size_t len) {
+  const char* p = (const char*)buf;
+  ssize_t n;
+
+  while (len > 0) {
+    n = write(fd, p, len);
+    if (n <= 0)
+      return -1;
+    p += n;
+    len -= n;
+  }
+  return 0;
+}
+
+double now_secs(void) {
+  struct timeval tv;
+
+  gettimeofday(&tv, NULL);
+  return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+void error_handling(char* message) {
+  // 输出错误信息并退出
+  fputs(message, stderr);
+  fputc('\n', stderr);
+  exit(1);
+}
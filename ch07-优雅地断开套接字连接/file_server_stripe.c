@@ -0,0 +1,286 @@
+#define _GNU_SOURCE
+#include <arpa/inet.h>     // htonl, htons, ntohl, sockaddr_in：字节序转换、IPv4 地址结构
+#include <endian.h>        // htobe64, be64toh：64 位整数的字节序转换（文件偏移量）
+#include <fcntl.h>         // open, O_RDONLY：以系统调用方式打开文件（sendfile 需要 fd）
+#include <pthread.h>       // pthread_create, pthread_join, pthread_mutex_*：多线程并行发送
+#include <stdint.h>        // uint32_t, uint64_t：固定宽度整数（协议头）
+#include <stdio.h>         // printf, fputs：输出提示与统计
+#include <stdlib.h>        // exit, atoi, malloc, free
+#include <string.h>        // memset
+#include <sys/sendfile.h>  // sendfile：内核态直接把文件页发送到 socket（零拷贝）
+#include <sys/socket.h>    // socket, bind, listen, accept, shutdown：套接字 API
+#include <sys/stat.h>      // fstat：获取文件大小
+#include <sys/time.h>      // gettimeofday：统计耗时
+#include <unistd.h>        // read, write, close
+
+/*
+ * 多连接并行（条带化）文件传输 —— 服务器端（发送方）
+ *
+ * 原始的 file_server.c 只用一条 TCP 连接发送文件。单条 TCP 流的吞吐量受
+ * "拥塞窗口 / RTT" 限制，在高带宽时延积（BDP）链路或有"单流限速"的网络上跑不满带宽。
+ * 本示例让客户端与服务器协商 N 条并行连接，把文件切成若干"区间（range）"，
+ * 分摊到多条连接上同时发送。
+ *
+ * 协议（所有整数均为网络字节序）：
+ *   1) 控制连接：客户端先建立一条连接，发送 4 字节"期望的并行流数量"
+ *      服务器回复：8 字节文件大小 + 4 字节实际采用的流数量 N
+ *   2) 数据连接：客户端再建立 N 条连接，每条连接上服务器重复发送
+ *        [8 字节偏移量][4 字节长度][长度字节的文件数据]
+ *      长度为 0 的区间头表示"本连接发送结束"
+ *   3) 所有数据连接结束后，客户端在控制连接上回复 "Thank you"（与 file_server.c 一致）
+ *
+ * 动态再平衡：
+ *   区间不是预先平均分给各连接的，而是由一个共享的"下一个区间"游标按需领取：
+ *   每个发送线程发完手里的区间后再去领下一个。慢的连接自然领得少、快的连接领得多，
+ *   不会出现"其它流早已结束，只剩最慢的那条流在拖尾"的情况。
+ */
+
+#define DEFAULT_STREAMS 4             // 客户端未指定时的并行流数量
+#define MAX_STREAMS 32                // 并行流数量上限
+#define MIN_RANGE_SIZE (64 * 1024)    // 单个区间最小 64KB（太小则协议头开销占比变大）
+#define MAX_RANGE_SIZE (1024 * 1024)  // 单个区间最大 1MB（太大则再平衡粒度变粗）
+#define RANGE_HDR_SIZE 12             // 区间头：8 字节偏移 + 4 字节长度
+
+/* 所有发送线程共享的"区间分配器"：用互斥锁保护 next_off 游标 */
+typedef struct {
+  pthread_mutex_t mutex;
+  uint64_t next_off;    // 下一个尚未分配的文件偏移
+  uint64_t file_size;   // 文件总大小
+  uint32_t range_size;  // 每次领取的区间长度
+} range_alloc;
+
+/* 每个发送线程的参数与统计 */
+typedef struct {
+  int sock;             // 该线程负责的数据连接
+  int file_fd;          // 要发送的文件（各线程共享同一个 fd，sendfile 显式传偏移，互不影响）
+  range_alloc* alloc;   // 共享区间分配器
+  uint64_t bytes_sent;  // 统计：本连接发送的字节数
+  uint32_t ranges;      // 统计：本连接发送的区间个数
+} stream_arg;
+
+void* send_stream(void* arg);
+int next_range(range_alloc* alloc, uint64_t* off, uint32_t* len);
+int write_full(int fd, const void* buf, size_t len);
+int read_full(int fd, void* buf, size_t len);
+void error_handling(char* message);
+
+int main(int argc, char* argv[]) {
+  int serv_sock, ctrl_sock;
+  int file_fd;
+  struct sockaddr_in serv_addr, clnt_addr;
+  socklen_t clnt_addr_sz;
+  struct stat st;
+  uint32_t want_streams, streams;
+  unsigned char reply[12];
+  char buf[30];
+  range_alloc alloc;
+  stream_arg args[MAX_STREAMS];
+  pthread_t t_ids[MAX_STREAMS];
+  struct timeval start, end;
+  double secs;
+  uint32_t i;
+
+  if (argc != 3) {
+    printf("Usage: %s <port> <file>\n", argv[0]);
+    exit(1);
+  }
+
+  // -------------------------
+  // 用 open 而不是 fopen：sendfile 需要的是文件描述符
+  // -------------------------
+  file_fd = open(argv[2], O_RDONLY);
+  if (file_fd == -1)
+    error_handling("open() error");
+  if (fstat(file_fd, &st) == -1)
+    error_handling("fstat() error");
+
+  serv_sock = socket(PF_INET, SOCK_STREAM, 0);
+  if (serv_sock == -1)
+    error_handling("socket() error");
+
+  memset(&serv_addr, 0, sizeof(serv_addr));
+  serv_addr.sin_family = AF_INET;
+  serv_addr.sin_addr.s_addr = htonl(INADDR_ANY);
+  serv_addr.sin_port = htons(atoi(argv[1]));
+
+  if (bind(serv_sock, (struct sockaddr*)&serv_addr, sizeof(serv_addr)) == -1)
+    error_handling("bind() error");
+
+  // backlog 要大于并行流数量，否则客户端一次性发起的 N 个 connect 可能排不下
+  if (listen(serv_sock, MAX_STREAMS + 1) == -1)
+    error_handling("listen() error");
+
+  // -------------------------
+  // 第一步：控制连接，协商并行流数量
+  // -------------------------
+  clnt_addr_sz = sizeof(clnt_addr);
+  ctrl_sock = accept(serv_sock, (struct sockaddr*)&clnt_addr, &clnt_addr_sz);
+  if (ctrl_sock == -1)
+    error_handling("accept() error");
+
+  if (read_full(ctrl_sock, &want_streams, 4) == -1)
+    error_handling("read() error");
+  streams = ntohl(want_streams);
+  if (streams == 0)
+    streams = DEFAULT_STREAMS;
+  if (streams > MAX_STREAMS)
+    streams = MAX_STREAMS;
+
+  // 回复：文件大小（8 字节）+ 实际流数量（4 字节）
+  *(uint64_t*)reply = htobe64((uint64_t)st.st_size);
+  *(uint32_t*)(reply + 8) = htonl(streams);
+  if (write_full(ctrl_sock, reply, sizeof(reply)) == -1)
+    error_handling("write() error");
+
+  // -------------------------
+  // 区间大小：让每条流平均能领到约 8 个区间，便于再平衡，
+  // 同时限制在 [MIN_RANGE_SIZE, MAX_RANGE_SIZE] 之间
+  // -------------------------
+  pthread_mutex_init(&alloc.mutex, NULL);
+  alloc.next_off = 0;
+  alloc.file_size = (uint64_t)st.st_size;
+  alloc.range_size = (uint32_t)(alloc.file_size / (streams * 8));
+  if (alloc.range_size < MIN_RANGE_SIZE)
+    alloc.range_size = MIN_RANGE_SIZE;
+  if (alloc.range_size > MAX_RANGE_SIZE)
+    alloc.range_size = MAX_RANGE_SIZE;
+
+  // -------------------------
+  // 第二步：接受 N 条数据连接，每条连接交给一个发送线程
+  // -------------------------
+  gettimeofday(&start, NULL);
+  for (i = 0; i < streams; i++) {
+    clnt_addr_sz = sizeof(clnt_addr);
+    args[i].sock = accept(serv_sock, (struct sockaddr*)&clnt_addr, &clnt_addr_sz);
+    if (args[i].sock == -1)
+      error_handling("accept() error");
+    args[i].file_fd = file_fd;
+    args[i].alloc = &alloc;
+    args[i].bytes_sent = 0;
+    args[i].ranges = 0;
+    pthread_create(&t_ids[i], NULL, send_stream, &args[i]);
+  }
+
+  for (i = 0; i < streams; i++)
+    pthread_join(t_ids[i], NULL);
+  gettimeofday(&end, NULL);
+
+  // -------------------------
+  // 第三步：等待客户端在控制连接上确认（与 file_server.c 相同）
+  // -------------------------
+  memset(buf, 0, sizeof(buf));
+  read(ctrl_sock, buf, sizeof(buf) - 1);
+  printf("Message from client: %s\n", buf);
+
+  secs = (end.tv_sec - start.tv_sec) + (end.tv_usec - start.tv_usec) / 1e6;
+  for (i = 0; i < streams; i++)
+    printf("stream %2u: %10llu bytes, %4u ranges\n", i,
+           (unsigned long long)args[i].bytes_sent, args[i].ranges);
+  printf("sent %lld bytes over %u streams in %.3f s (%.1f MB/s)\n",
+         (long long)st.st_size, streams, secs,
+         secs > 0 ? st.st_size / secs / (1024 * 1024) : 0.0);
+
+  pthread_mutex_destroy(&alloc.mutex);
+  close(file_fd);
+  close(ctrl_sock);
+  close(serv_sock);
+  return 0;
+}
+
+/*
+ * 发送线程：循环"领取区间 -> 发送区间头 -> sendfile 发送区间数据"，
+ * 区间领完后发送长度为 0 的结束头，并半关闭连接
+ */
+void* send_stream(void* arg) {
+  stream_arg* sa = (stream_arg*)arg;
+  unsigned char hdr[RANGE_HDR_SIZE];
+  uint64_t off;
+  uint32_t len;
+  off_t pos;
+  ssize_t n;
+
+  while (next_range(sa->alloc, &off, &len)) {
+    *(uint64_t*)hdr = htobe64(off);
+    *(uint32_t*)(hdr + 8) = htonl(len);
+    if (write_full(sa->sock, hdr, sizeof(hdr)) == -1)
+      error_handling("write() error");
+
+    // sendfile 直接从页缓存发送，不经过用户态缓冲区；
+    // 显式传入 pos，不会改变共享 file_fd 的文件位置，多个线程可以安全并发使用
+    pos = (off_t)off;
+    while (pos < (off_t)(off + len)) {
+      n = sendfile(sa->sock, sa->file_fd, &pos, (off + len) - pos);
+      if (n <= 0)
+        error_handling("sendfile() error");
+    }
+    sa->bytes_sent += len;
+    sa->ranges++;
+  }
+
+  // 结束标记：偏移任意、长度为 0
+  memset(hdr, 0, sizeof(hdr));
+  write_full(sa->sock, hdr, sizeof(hdr));
+  shutdown(sa->sock, SHUT_WR);
+
+  // 等待客户端关闭连接（read 返回 0），确保数据已全部被对端取走
+  read(sa->sock, hdr, 1);
+  close(sa->sock);
+  return NULL;
+}
+
+/*
+ * 从共享分配器领取下一个区间
+ * 返回 1 表示领到区间（off、len 有效），返回 0 表示文件已全部分配完
+ */
+int next_range(range_alloc* alloc, uint64_t* off, uint32_t* len) {
+  int ok = 0;
+
+  pthread_mutex_lock(&alloc->mutex);
+  if (alloc->next_off < alloc->file_size) {
+    *off = alloc->next_off;
+    *len = alloc->range_size;
+    if (*off + *len > alloc->file_size)
+      *len = (uint32_t)(alloc->file_size - *off);
+    alloc->next_off += *len;
+    ok = 1;
+  }
+  pthread_mutex_unlock(&alloc->mutex);
+  return ok;
+}
+
+/* 写满 len 字节（TCP 的 write 可能只写出一部分） */
+int write_full(int fd, const void* buf, size_t len) {
+  const char* p = (const char*)buf;
+  ssize_t n;
+
+  while (len > 0) {
+    n = write(fd, p, len);
+    if (n <= 0)
+      return -1;
+    p += n;
+    len -= n;
+  }
+  return 0;
+}
+
+/* 读满 len 字节（TCP 的 read 可能只读到一部分），对端提前关闭返回 -1 */
+int read_full(int fd, void* buf, size_t len) {
+  char* p = (char*)buf;
+  ssize_t n;
+
+  while (len > 0) {
+    n = read(fd, p, len);
+    if (n <= 0)
+      return -1;
+    p += n;
+    len -= n;
+  }
+  return 0;
+}
+
+void error_handling(char* message) {
+  // 输出错误信息并退出
+  fputs(message, stderr);
+  fputc('\n', stderr);
+  exit(1);
+}
@@ -0,0 +1,163 @@
+#include <stdio.h>      // fopen / fgets / fprintf / snprintf
+#include <stdlib.h>     // strtol
+#include <string.h>     // strchr / strcmp / strspn
+#include <limits.h>     // INT_MAX
+#include <sys/socket.h> // setsockopt / SOL_SOCKET / SO_SNDBUF / SO_RCVBUF
+#include <netinet/in.h> // IPPROTO_TCP
+#include <netinet/tcp.h> // TCP_NODELAY / TCP_CORK / TCP_QUICKACK / TCP_NOTSENT_LOWAT
+#include "sockopt_profile.h"
+
+/*
+ * sockopt_profile 的实现，接口说明见 sockopt_profile.h
+ */
+
+void sp_default(sockopt_profile* p)
+{
+    memset(p, 0, sizeof(*p));
+}
+
+/* 配置文件中的键名对应的字段，无法识别的键返回 NULL */
+static int* field(sockopt_profile* p, const char* key)
+{
+    if(!strcmp(key, "sndbuf"))
+        return &p->sndbuf;
+    if(!strcmp(key, "rcvbuf"))
+        return &p->rcvbuf;
+    if(!strcmp(key, "nodelay"))
+        return &p->nodelay;
+    if(!strcmp(key, "cork"))
+        return &p->cork;
+    if(!strcmp(key, "quickack"))
+        return &p->quickack;
+    if(!strcmp(key, "notsent_lowat"))
+        return &p->notsent_lowat;
+    return NULL;
+}
+
+int sp_load(sockopt_profile* p, const char* path)
+{
+    FILE* fp;
+    char line[256], key[64];
+    char *s, *end;
+    int* f;
+    int lineno = 0, ret = 0, pos;
+    long v, mult;
+
+    fp = fopen(path, "r");
+    if(fp == NULL)
+        return -1;
+    while(fgets(line, sizeof(line), fp) != NULL)
+    {
+        lineno++;
+        if((s = strchr(line, '#')) != NULL)
+            *s = 0;
+        s = line + strspn(line, " \t\r\n");
+        if(*s == 0)
+            continue;
+        // "键 = 值"，值可以带 K / M 后缀
+        pos = 0;
+        sscanf(s, "%63[a-z_] =%n", key, &pos);
+        f = pos > 0 ? field(p, key) : NULL;
+        v = f != NULL ? strtol(s + pos, &end, 10) : 0;
+        if(f == NULL || end == s + pos)
+        {
+            fprintf(stderr, "%s:%d: unrecognized line\n", path, lineno);
+            ret = -1;
+            continue;
+        }
+        mult = 1;
+        if(*end == 'K' || *end == 'k')
+        {
+            mult = 1024;
+            end++;
+        }
+        else if(*end == 'M' || *end == 'm')
+        {
+            mult = 1024 * 1024;
+            end++;
+        }
+        // 字段都是 int，负数没有意义；先检查范围再乘后缀，避免溢出后截断成别的值
+        if(end[strspn(end, " \t\r\n")] != 0 || v < 0 || v > INT_MAX / mult)
+        {
+            fprintf(stderr, "%s:%d: unrecognized line\n", path, lineno);
+            ret = -1;
+            continue;
+        }
+        *f = (int)(v * mult);
+    }
+    fclose(fp);
+    return ret;
+}
+
+/* 一行 "键 = 值"，注释对齐到同一列 */
+static void save_line(FILE* fp, const char* key, int v, const char* comment)
+{
+    char kv[64];
+
+    snprintf(kv, sizeof(kv), "%s = %d", key, v);
+    fprintf(fp, "%-24s# %s\n", kv, comment);
+}
+
+void sp_save(const sockopt_profile* p, FILE* fp)
+{
+    save_line(fp, "sndbuf", p->sndbuf, "SO_SNDBUF, 0 = kernel default");
+    save_line(fp, "rcvbuf", p->rcvbuf, "SO_RCVBUF, 0 = kernel default");
+    save_line(fp, "nodelay", p->nodelay, "TCP_NODELAY");
+    save_line(fp, "cork", p->cork, "TCP_CORK around multi-write messages");
+    save_line(fp, "quickack", p->quickack, "TCP_QUICKACK after each read");
+    save_line(fp, "notsent_lowat", p->notsent_lowat, "TCP_NOTSENT_LOWAT, 0 = not set");
+}
+
+static void size_str(int v, char* buf, int size)
+{
+    if(v == 0)
+        snprintf(buf, size, "default");
+    else if(v % (1024 * 1024) == 0)
+        snprintf(buf, size, "%dM", v / (1024 * 1024));
+    else if(v % 1024 == 0)
+        snprintf(buf, size, "%dK", v / 1024);
+    else
+        snprintf(buf, size, "%d", v);
+}
+
+const char* sp_describe(const sockopt_profile* p, char* buf, int size)
+{
+    char snd[16], rcv[16], lowat[16];
+
+    size_str(p->sndbuf, snd, sizeof(snd));
+    size_str(p->rcvbuf, rcv, sizeof(rcv));
+    size_str(p->notsent_lowat, lowat, sizeof(lowat));
+    snprintf(buf, size, "sndbuf=%s rcvbuf=%s nodelay=%d cork=%d quickack=%d notsent_lowat=%s",
+             snd, rcv, p->nodelay, p->cork, p->quickack, lowat);
+    return buf;
+}
+
+int sp_apply(const sockopt_profile* p, int fd)
+{
+    int ret = 0;
+
+    if(p->sndbuf > 0 && setsockopt(fd, SOL_SOCKET, SO_SNDBUF, &p->sndbuf, sizeof(int)) == -1)
+        ret = -1;
+    if(p->rcvbuf > 0 && setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &p->rcvbuf, sizeof(int)) == -1)
+        ret = -1;
+    if(p->nodelay && setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &p->nodelay, sizeof(int)) == -1)
+        ret = -1;
+    if(p->notsent_lowat > 0
+       && setsockopt(fd, IPPROTO_TCP, TCP_NOTSENT_LOWAT, &p->notsent_lowat, sizeof(int)) == -1)
+        ret = -1;
+    return ret;
+}
+
+void sp_cork(const sockopt_profile* p, int fd, int on)
+{
+    if(p->cork)
+        setsockopt(fd, IPPROTO_TCP, TCP_CORK, &on, sizeof(on));
+}
+
+void sp_quickack(const sockopt_profile* p, int fd)
+{
+    int on = 1;
+
+    if(p->quickack)
+        setsockopt(fd, IPPROTO_TCP, TCP_QUICKACK, &on, sizeof(on));
+}
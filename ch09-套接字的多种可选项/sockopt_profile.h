@@ -0,0 +1,54 @@
+#ifndef SOCKOPT_PROFILE_H
+#define SOCKOPT_PROFILE_H
+
+#include <stdio.h>      // FILE
+
+/*
+ * 套接字可选项配置（profile）：sockopt_tune 测出推荐值写入配置文件，服务器启动时读入并应用
+ *
+ * 配置文件每行一个 "键 = 值"（值可以带 K / M 后缀），'#' 之后是注释：
+ *   sndbuf = 0            # SO_SNDBUF，0 表示不设置（使用内核的自动调节）
+ *   rcvbuf = 262144       # SO_RCVBUF，同上
+ *   nodelay = 1           # TCP_NODELAY：禁用 Nagle 算法
+ *   cork = 0              # 每条消息分几次 write 时用 TCP_CORK 合并成一个报文段
+ *   quickack = 0          # 每次 read 后设置 TCP_QUICKACK，立即回复 ACK
+ *   notsent_lowat = 0     # TCP_NOTSENT_LOWAT，0 表示不设置
+ *
+ * SO_SNDBUF / SO_RCVBUF / TCP_NODELAY / TCP_NOTSENT_LOWAT 设置一次就一直有效，由 sp_apply 设置；
+ * 接收缓冲区要在 listen / connect 之前设置才能影响窗口扩大因子，所以监听套接字也要 sp_apply
+ * （accept 得到的套接字会继承）。TCP_CORK 和 TCP_QUICKACK 与每次读写相关，由 sp_cork / sp_quickack
+ * 在读写前后调用，配置中没有启用时它们什么也不做。
+ *
+ * 编译：gcc xxx.c sockopt_profile.c
+ */
+
+typedef struct {
+    int sndbuf, rcvbuf;         // 字节，0 = 内核默认
+    int nodelay;
+    int cork;
+    int quickack;
+    int notsent_lowat;          // 字节，0 = 不设置
+} sockopt_profile;
+
+/* 内核默认值：什么都不设置 */
+void sp_default(sockopt_profile* p);
+
+/* 读取配置文件，文件中没有出现的键保持原值。成功返回 0；打不开或有无法识别的行返回 -1 */
+int sp_load(sockopt_profile* p, const char* path);
+
+/* 以配置文件的格式写出，sp_load 可以读回 */
+void sp_save(const sockopt_profile* p, FILE* fp);
+
+/* 一行简短描述，如 "sndbuf=default rcvbuf=256K nodelay=1 ..."，用于打印 */
+const char* sp_describe(const sockopt_profile* p, char* buf, int size);
+
+/* 设置持续生效的可选项；成功返回 0，任一 setsockopt 失败返回 -1 */
+int sp_apply(const sockopt_profile* p, int fd);
+
+/* 一条消息分多次写出时：写第一部分前 sp_cork(p, fd, 1)，写完最后一部分后 sp_cork(p, fd, 0) */
+void sp_cork(const sockopt_profile* p, int fd, int on);
+
+/* 每次 read 之后调用：TCP_QUICKACK 不是持久的，内核可能随时回到延迟 ACK 模式 */
+void sp_quickack(const sockopt_profile* p, int fd);
+
+#endif
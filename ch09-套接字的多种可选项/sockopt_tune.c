@@ -0,0 +1,438 @@
+#include <stdio.h>      // printf / fopen / fputs
+#include <stdlib.h>     // exit / atoi / malloc / qsort
+#include <string.h>     // memset / strcmp
+#include <stdint.h>     // uint32_t / uint64_t
+#include <unistd.h>     // read / write / close
+#include <errno.h>      // errno / EINTR
+#include <math.h>       // pow：几何平均
+#include <time.h>       // clock_gettime
+#include <pthread.h>    // 服务器端线程
+#include <arpa/inet.h>  // htonl / ntohl / inet_addr
+#include <sys/socket.h> // socket / bind / listen / accept / connect / shutdown
+#include "sockopt_profile.h" // 可选项配置：测试和服务器使用同一套设置代码
+
+/*
+ * 套接字可选项自动调优：在回环地址上测量不同可选项组合下的吞吐量和时延，给出推荐配置
+ *
+ * set_buf / get_buf / get_nagle 只在未连接的套接字上读写一个可选项，看不出对性能的影响。
+ * 本程序对每个候选配置、每种消息大小（64B / 1KB / 16KB / 128KB）做两项测试：
+ *   吞吐量：客户端连续发送消息，服务器端线程接收，测 MB/s
+ *   时延：  一问一答，服务器端线程原样回复，测往返时延的 p50 / p99
+ * 每条消息按常见的应用写法分两次 write：先写 8 字节的头（长度），再写数据。
+ * 这正是 Nagle 算法和延迟 ACK 互相等待的场景，TCP_NODELAY / TCP_CORK / TCP_QUICKACK 的差别由此体现。
+ *
+ * 可选项组合太多（缓冲区 4x4、Nagle、CORK、QUICKACK、NOTSENT_LOWAT 共 384 种），
+ * 这里按顺序逐项调优，每一步选出最好的值固定下来再调下一项：
+ * 先调影响最大的 TCP_NODELAY、TCP_CORK、TCP_QUICKACK（否则时延被 40ms 的延迟 ACK 掩盖，
+ * 缓冲区大小的差别测不出来），再调 SO_SNDBUF x SO_RCVBUF 网格，最后是 TCP_NOTSENT_LOWAT。
+ * 每个配置的得分 = 各消息大小上 相对内核默认配置的提升比例 的几何平均：
+ *   throughput：吞吐量之比；latency：p99 时延之比（倒数）；balanced（默认）：两者再取几何平均
+ * 得分比当前最优高出 3% 以上时再测一次取平均，仍然高出才替换，避免测量噪声把配置推离默认值。
+ *
+ * 推荐配置以 sockopt_profile 的格式打印出来，给出文件名时同时写入文件，
+ * 服务器启动时用 sp_load 读入（如 ch17 echo_epollserv 的 profile 参数）。
+ *
+ * 用法：sockopt_tune [balanced|throughput|latency] [ms_per_test] [profile_out]
+ */
+
+#define HDR_SIZE 8
+#define MAX_MSG (128 * 1024)
+#define MAX_SAMPLES 1000000
+#define MIN_GAIN 1.03           // 得分至少高出 3% 才替换当前最优配置
+#define N_SIZES 4
+#define N_BUFS 4
+
+enum { GOAL_BALANCED, GOAL_THROUGHPUT, GOAL_LATENCY };
+
+static const int msg_sizes[N_SIZES] = { 64, 1024, 16 * 1024, 128 * 1024 };
+static const int buf_sizes[N_BUFS] = { 0, 64 * 1024, 256 * 1024, 1024 * 1024 };   // 0 = 内核默认
+
+typedef struct {
+    double mbps[N_SIZES];       // 吞吐量
+    double p50[N_SIZES], p99[N_SIZES];  // 往返时延（us）
+    double score;
+} result;
+
+typedef struct {
+    const sockopt_profile* prof;
+    int fd, size, echo;
+    uint64_t bytes;             // 服务器端收到的字节数
+} server_arg;
+
+static int test_ms = 200, goal = GOAL_BALANCED;
+static result base;             // 内核默认配置的结果，用于计算得分
+
+void measure(const sockopt_profile* p, result* r);
+void run_throughput(const sockopt_profile* p, int size, double* mbps);
+void run_latency(const sockopt_profile* p, int size, double* p50, double* p99);
+void* server_main(void* arg);
+void conn_pair(const sockopt_profile* p, int* cli, int* srv);
+void send_msg(const sockopt_profile* p, int fd, char* buf, int size);
+int recv_msg(const sockopt_profile* p, int fd, char* buf);
+int read_full(const sockopt_profile* p, int fd, char* buf, int len);
+void write_full(int fd, const char* buf, int len);
+double score(const result* r);
+int try_profile(const sockopt_profile* cand, sockopt_profile* best, result* best_r);
+void print_result(const sockopt_profile* p, const result* r, const char* mark);
+int cmp_u64(const void* a, const void* b);
+uint64_t now_ns(void);
+void error_handling(char *message);
+
+int main(int argc, char *argv[])
+{
+    sockopt_profile best, cand;
+    result best_r;
+    char desc[256];
+    FILE* fp;
+    int i, j;
+
+    if(argc > 4 || (argc >= 2 && strcmp(argv[1], "balanced") && strcmp(argv[1], "throughput")
+                    && strcmp(argv[1], "latency")))
+    {
+        printf("Usage: %s [balanced|throughput|latency] [ms_per_test] [profile_out]\n", argv[0]);
+        exit(1);
+    }
+    if(argc >= 2)
+        goal = !strcmp(argv[1], "throughput") ? GOAL_THROUGHPUT
+             : !strcmp(argv[1], "latency") ? GOAL_LATENCY : GOAL_BALANCED;
+    if(argc >= 3 && (test_ms = atoi(argv[2])) <= 0)
+        error_handling("ms_per_test must be > 0");
+
+    printf("message sizes:");
+    for(i = 0; i < N_SIZES; i++)
+        printf(" %d", msg_sizes[i]);
+    printf(" bytes, %d ms per test, each cell: throughput MB/s | p99 RTT us\n", test_ms);
+
+    // 基准：内核默认配置
+    sp_default(&best);
+    measure(&best, &base);
+    base.score = 1.0;
+    best_r = base;
+    printf("\n[baseline]\n");
+    print_result(&best, &best_r, "");
+
+    // 先调影响最大的 Nagle / CORK / QUICKACK，每步只改变一个可选项
+    printf("\n[TCP_NODELAY]\n");
+    cand = best;
+    cand.nodelay = !best.nodelay;
+    try_profile(&cand, &best, &best_r);
+
+    printf("\n[TCP_CORK]\n");
+    cand = best;
+    cand.cork = !best.cork;
+    try_profile(&cand, &best, &best_r);
+
+    printf("\n[TCP_QUICKACK]\n");
+    cand = best;
+    cand.quickack = !best.quickack;
+    try_profile(&cand, &best, &best_r);
+
+    // 再在发送 / 接收缓冲区网格中选出最好的一组
+    printf("\n[SO_SNDBUF x SO_RCVBUF]\n");
+    for(i = 0; i < N_BUFS; i++)
+        for(j = 0; j < N_BUFS; j++)
+        {
+            cand = best;
+            cand.sndbuf = buf_sizes[i];
+            cand.rcvbuf = buf_sizes[j];
+            try_profile(&cand, &best, &best_r);
+        }
+
+    printf("\n[TCP_NOTSENT_LOWAT]\n");
+    cand = best;
+    cand.notsent_lowat = 16 * 1024;
+    try_profile(&cand, &best, &best_r);
+    cand = best;
+    cand.notsent_lowat = 128 * 1024;
+    try_profile(&cand, &best, &best_r);
+
+    printf("\nrecommended (%s, score %.2f): %s\n", argc >= 2 ? argv[1] : "balanced", best_r.score,
+           sp_describe(&best, desc, sizeof(desc)));
+    print_result(&best, &best_r, "");
+    printf("\n");
+    sp_save(&best, stdout);
+    if(argc == 4)
+    {
+        fp = fopen(argv[3], "w");
+        if(fp == NULL)
+            error_handling("fopen() error");
+        fprintf(fp, "# generated by sockopt_tune (%s)\n", argc >= 2 ? argv[1] : "balanced");
+        sp_save(&best, fp);
+        fclose(fp);
+        printf("profile written to %s\n", argv[3]);
+    }
+    return 0;
+}
+
+/* 测量候选配置，得分明显更高时替换当前最优；返回是否替换 */
+int try_profile(const sockopt_profile* cand, sockopt_profile* best, result* best_r)
+{
+    result r, again;
+    int i;
+
+    // 与当前最优相同的配置不必重测
+    if(!memcmp(cand, best, sizeof(*cand)))
+    {
+        print_result(cand, best_r, " (current)");
+        return 0;
+    }
+    measure(cand, &r);
+    r.score = score(&r);
+    if(r.score > best_r->score * MIN_GAIN)
+    {
+        // 可能只是测量噪声：再测一次，取两次的平均值重新比较
+        measure(cand, &again);
+        for(i = 0; i < N_SIZES; i++)
+        {
+            r.mbps[i] = (r.mbps[i] + again.mbps[i]) / 2;
+            r.p50[i] = (r.p50[i] + again.p50[i]) / 2;
+            r.p99[i] = (r.p99[i] + again.p99[i]) / 2;
+        }
+        r.score = score(&r);
+    }
+    if(r.score > best_r->score * MIN_GAIN)
+    {
+        print_result(cand, &r, " <- best");
+        *best = *cand;
+        *best_r = r;
+        return 1;
+    }
+    print_result(cand, &r, "");
+    return 0;
+}
+
+void measure(const sockopt_profile* p, result* r)
+{
+    int i;
+
+    memset(r, 0, sizeof(*r));
+    for(i = 0; i < N_SIZES; i++)
+    {
+        run_throughput(p, msg_sizes[i], &r->mbps[i]);
+        run_latency(p, msg_sizes[i], &r->p50[i], &r->p99[i]);
+    }
+}
+
+double score(const result* r)
+{
+    double thr = 1, lat = 1;
+    int i;
+
+    for(i = 0; i < N_SIZES; i++)
+    {
+        thr *= r->mbps[i] / base.mbps[i];
+        lat *= base.p99[i] / r->p99[i];
+    }
+    thr = pow(thr, 1.0 / N_SIZES);
+    lat = pow(lat, 1.0 / N_SIZES);
+    if(goal == GOAL_THROUGHPUT)
+        return thr;
+    if(goal == GOAL_LATENCY)
+        return lat;
+    return sqrt(thr * lat);
+}
+
+void print_result(const sockopt_profile* p, const result* r, const char* mark)
+{
+    char desc[256];
+    int i;
+
+    printf("  %-78s", sp_describe(p, desc, sizeof(desc)));
+    for(i = 0; i < N_SIZES; i++)
+        printf(" %7.0f|%-7.0f", r->mbps[i], r->p99[i]);
+    printf(" score %.2f%s\n", r->score, mark);
+}
+
+/* 吞吐量：客户端连续发送 test_ms 毫秒后半关闭，服务器端线程读到 EOF 为止 */
+void run_throughput(const sockopt_profile* p, int size, double* mbps)
+{
+    static char buf[MAX_MSG];
+    server_arg sa;
+    pthread_t t_id;
+    uint64_t start, deadline;
+    int cli, n = 0;
+
+    conn_pair(p, &cli, &sa.fd);
+    sa.prof = p;
+    sa.size = size;
+    sa.echo = 0;
+    sa.bytes = 0;
+    pthread_create(&t_id, NULL, server_main, &sa);
+
+    start = now_ns();
+    deadline = start + test_ms * 1000000ull;
+    do
+        send_msg(p, cli, buf, size);
+    while(++n % 16 != 0 || now_ns() < deadline);
+    shutdown(cli, SHUT_WR);
+    pthread_join(t_id, NULL);
+    *mbps = sa.bytes / ((now_ns() - start) / 1e9) / 1e6;
+    close(cli);
+    close(sa.fd);
+}
+
+/* 时延：一问一答 test_ms 毫秒，每次记录往返时延 */
+void run_latency(const sockopt_profile* p, int size, double* p50, double* p99)
+{
+    static char buf[MAX_MSG];
+    static uint64_t samples[MAX_SAMPLES];
+    server_arg sa;
+    pthread_t t_id;
+    uint64_t t, deadline;
+    int cli, n = 0;
+
+    conn_pair(p, &cli, &sa.fd);
+    sa.prof = p;
+    sa.size = size;
+    sa.echo = 1;
+    pthread_create(&t_id, NULL, server_main, &sa);
+
+    deadline = now_ns() + test_ms * 1000000ull;
+    do
+    {
+        t = now_ns();
+        send_msg(p, cli, buf, size);
+        if(recv_msg(p, cli, buf) != size)
+            error_handling("echo mismatch");
+        samples[n++] = now_ns() - t;
+    }
+    while(n < MAX_SAMPLES && now_ns() < deadline);
+    shutdown(cli, SHUT_WR);
+    pthread_join(t_id, NULL);
+    close(cli);
+    close(sa.fd);
+
+    qsort(samples, n, sizeof(uint64_t), cmp_u64);
+    *p50 = samples[n / 2] / 1e3;
+    *p99 = samples[(int)(n * 0.99)] / 1e3;
+}
+
+/* 服务器端：接收消息直到 EOF，echo 时原样回复 */
+void* server_main(void* arg)
+{
+    static char buf[MAX_MSG];
+    server_arg* sa = arg;
+    int len;
+
+    while((len = recv_msg(sa->prof, sa->fd, buf)) >= 0)
+    {
+        sa->bytes += HDR_SIZE + len;
+        if(sa->echo)
+            send_msg(sa->prof, sa->fd, buf, len);
+    }
+    return NULL;
+}
+
+/*
+ * 建立一对回环连接。缓冲区大小要在 listen / connect 之前设置，
+ * 接收窗口的扩大因子在握手时就确定了；accept 得到的套接字继承监听套接字的设置
+ */
+void conn_pair(const sockopt_profile* p, int* cli, int* srv)
+{
+    struct sockaddr_in addr;
+    socklen_t addr_sz = sizeof(addr);
+    int lsock;
+
+    lsock = socket(PF_INET, SOCK_STREAM, 0);
+    *cli = socket(PF_INET, SOCK_STREAM, 0);
+    if(lsock == -1 || *cli == -1)
+        error_handling("socket() error");
+    if(sp_apply(p, lsock) == -1 || sp_apply(p, *cli) == -1)
+        error_handling("setsockopt() error");
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = inet_addr("127.0.0.1");
+    addr.sin_port = 0;                              // 由内核分配端口
+    if(bind(lsock, (struct sockaddr*)&addr, sizeof(addr)) == -1 || listen(lsock, 1) == -1)
+        error_handling("bind() error");
+    getsockname(lsock, (struct sockaddr*)&addr, &addr_sz);
+    if(connect(*cli, (struct sockaddr*)&addr, sizeof(addr)) == -1)
+        error_handling("connect() error");
+    *srv = accept(lsock, NULL, NULL);
+    if(*srv == -1 || sp_apply(p, *srv) == -1)
+        error_handling("accept() error");
+    close(lsock);
+}
+
+/* 一条消息：先写 4 字节长度 + 4 字节保留的头，再写数据；启用 cork 时两次写合并成一个报文段 */
+void send_msg(const sockopt_profile* p, int fd, char* buf, int size)
+{
+    uint32_t hdr[2];
+
+    hdr[0] = htonl(size);
+    hdr[1] = 0;
+    sp_cork(p, fd, 1);
+    write_full(fd, (char*)hdr, HDR_SIZE);
+    write_full(fd, buf, size);
+    sp_cork(p, fd, 0);
+}
+
+/* 接收一条消息，返回数据长度；对方关闭连接时返回 -1 */
+int recv_msg(const sockopt_profile* p, int fd, char* buf)
+{
+    uint32_t hdr[2];
+    int len;
+
+    if(read_full(p, fd, (char*)hdr, HDR_SIZE) != HDR_SIZE)
+        return -1;
+    len = ntohl(hdr[0]);
+    if(len > MAX_MSG || read_full(p, fd, buf, len) != len)
+        error_handling("bad message");
+    return len;
+}
+
+int read_full(const sockopt_profile* p, int fd, char* buf, int len)
+{
+    int got = 0, n;
+
+    while(got < len)
+    {
+        n = read(fd, buf + got, len - got);
+        if(n == -1 && errno == EINTR)
+            continue;
+        if(n <= 0)
+            break;
+        sp_quickack(p, fd);
+        got += n;
+    }
+    return got;
+}
+
+void write_full(int fd, const char* buf, int len)
+{
+    int n;
+
+    while(len > 0)
+    {
+        n = write(fd, buf, len);
+        if(n == -1 && errno == EINTR)
+            continue;
+        if(n == -1)
+            error_handling("write() error");
+        buf += n;
+        len -= n;
+    }
+}
+
+int cmp_u64(const void* a, const void* b)
+{
+    uint64_t x = *(const uint64_t*)a, y = *(const uint64_t*)b;
+
+    return x < y ? -1 : x > y;
+}
+
+uint64_t now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+void error_handling(char *message)
+{
+    fputs(message, stderr);
+    fputc('\n', stderr);
+    exit(1);
+}
@@ -0,0 +1,254 @@
+#include <stdio.h>      // fprintf / fflush
+#include <stddef.h>     // offsetof
+#include <string.h>     // memset / memcpy
+#include <stdint.h>     // uint64_t
+#include <signal.h>     // sigset_t / sigtimedwait / pthread_sigmask
+#include <time.h>       // clock_gettime
+#include <pthread.h>    // 采样线程、互斥锁
+#include <sys/socket.h> // getsockopt
+#include <netinet/in.h> // IPPROTO_TCP
+#include <linux/tcp.h>  // TCP_INFO / struct tcp_info（含 tcpi_delivery_rate，glibc 的版本没有）
+#include "tcp_stats.h"
+
+/*
+ * tcp_stats 的实现，接口说明见 tcp_stats.h
+ */
+
+#define TS_BUCKETS 48                   // log2 直方图：第 b 个桶为 [2^(b-1), 2^b)，第 0 个桶为 0
+
+enum { M_RTT, M_RTTVAR, M_CWND, M_UNACKED, M_RETRANS, M_RATE, M_COUNT };
+
+static const char* metric_names[M_COUNT] = {
+    "rtt_us", "rttvar_us", "cwnd", "unacked", "total_retrans", "delivery_Bps"
+};
+
+typedef struct {
+    uint64_t count, sum, min, max;
+    uint64_t buckets[TS_BUCKETS];
+} histogram;
+
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static int conns[TS_MAX_CONN];          // 登记的连接，删除时用最后一个填补空位
+static int conn_cnt, cursor;            // cursor：下一个要采样的位置（轮流采样）
+static histogram hists[M_COUNT];
+static uint64_t samples, app_limited, failed, added, sample_ns;
+static int64_t start_ns;
+
+static int64_t now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static void hist_add(histogram* h, uint64_t v)
+{
+    int b = v == 0 ? 0 : 64 - __builtin_clzll(v);
+
+    if(b >= TS_BUCKETS)
+        b = TS_BUCKETS - 1;
+    h->buckets[b]++;
+    if(h->count == 0 || v < h->min)
+        h->min = v;
+    if(v > h->max)
+        h->max = v;
+    h->count++;
+    h->sum += v;
+}
+
+/* 第 q 分位数所在桶的上界（不超过最大值） */
+static uint64_t hist_quantile(const histogram* h, double q)
+{
+    uint64_t need = (uint64_t)(h->count * q), seen = 0, upper;
+    int b;
+
+    for(b = 0; b < TS_BUCKETS; b++)
+    {
+        seen += h->buckets[b];
+        if(seen > need)
+            break;
+    }
+    upper = b == 0 ? 0 : (1ULL << b) - 1;
+    return upper < h->max ? upper : h->max;
+}
+
+/* 采样一个连接：只在 getsockopt 期间持有锁，保证 fd 不会在采样途中被关闭并复用 */
+static void sample_one(void)
+{
+    struct tcp_info ti;
+    socklen_t len = sizeof(ti);
+    int64_t t0;
+    int ok;
+
+    pthread_mutex_lock(&lock);
+    if(conn_cnt == 0)
+    {
+        pthread_mutex_unlock(&lock);
+        return;
+    }
+    if(cursor >= conn_cnt)
+        cursor = 0;
+    t0 = now_ns();
+    memset(&ti, 0, sizeof(ti));
+    ok = getsockopt(conns[cursor++], IPPROTO_TCP, TCP_INFO, &ti, &len) == 0;
+    sample_ns += now_ns() - t0;
+    if(!ok)
+    {
+        failed++;
+        pthread_mutex_unlock(&lock);
+        return;
+    }
+    samples++;
+    hist_add(&hists[M_RTT], ti.tcpi_rtt);
+    hist_add(&hists[M_RTTVAR], ti.tcpi_rttvar);
+    hist_add(&hists[M_CWND], ti.tcpi_snd_cwnd);
+    hist_add(&hists[M_UNACKED], ti.tcpi_unacked);
+    hist_add(&hists[M_RETRANS], ti.tcpi_total_retrans);
+    // 旧内核返回的 tcp_info 较短，没有交付速率字段
+    if(len >= offsetof(struct tcp_info, tcpi_delivery_rate) + sizeof(ti.tcpi_delivery_rate))
+    {
+        hist_add(&hists[M_RATE], ti.tcpi_delivery_rate);
+        app_limited += ti.tcpi_delivery_rate_app_limited;
+    }
+    pthread_mutex_unlock(&lock);
+}
+
+static void* sampler_main(void* arg)
+{
+    sigset_t set;
+    struct timespec timeout;
+    int64_t next, now;
+    int i, n;
+
+    (void)arg;
+    sigemptyset(&set);
+    sigaddset(&set, SIGUSR1);
+    next = now_ns() + TS_INTERVAL_MS * 1000000LL;
+    while(1)
+    {
+        // 等到下一个采样时刻，期间收到 SIGUSR1 就输出统计。
+        // 采样时刻按时钟推进，不看 sigtimedwait 为什么返回：信号再频繁也不会推迟采样
+        now = now_ns();
+        if(now < next)
+        {
+            timeout.tv_sec = (next - now) / 1000000000LL;
+            timeout.tv_nsec = (next - now) % 1000000000LL;
+            if(sigtimedwait(&set, NULL, &timeout) == SIGUSR1)
+            {
+                ts_dump(stdout);
+                fflush(stdout);
+            }
+            continue;
+        }
+        // 连接数不足 TS_PER_TICK 时每个连接只采一次，避免同一连接在一个周期内被重复计入
+        pthread_mutex_lock(&lock);
+        n = conn_cnt < TS_PER_TICK ? conn_cnt : TS_PER_TICK;
+        pthread_mutex_unlock(&lock);
+        for(i = 0; i < n; i++)
+            sample_one();
+        // 采样落后（例如进程被挂起过）时不补采，直接从现在开始计时
+        next += TS_INTERVAL_MS * 1000000LL;
+        if(next <= now)
+            next = now + TS_INTERVAL_MS * 1000000LL;
+    }
+    return NULL;
+}
+
+int ts_start(void)
+{
+    sigset_t set;
+    pthread_t t_id;
+
+    sigemptyset(&set);
+    sigaddset(&set, SIGUSR1);
+    if(pthread_sigmask(SIG_BLOCK, &set, NULL) != 0)
+        return -1;
+    start_ns = now_ns();
+    if(pthread_create(&t_id, NULL, sampler_main, NULL) != 0)
+        return -1;
+    pthread_detach(t_id);
+    return 0;
+}
+
+void ts_add(int fd)
+{
+    pthread_mutex_lock(&lock);
+    if(conn_cnt < TS_MAX_CONN)
+    {
+        conns[conn_cnt++] = fd;
+        added++;
+    }
+    pthread_mutex_unlock(&lock);
+}
+
+void ts_remove(int fd)
+{
+    int i;
+
+    pthread_mutex_lock(&lock);
+    for(i = 0; i < conn_cnt; i++)
+        if(conns[i] == fd)
+        {
+            conns[i] = conns[--conn_cnt];
+            break;
+        }
+    pthread_mutex_unlock(&lock);
+}
+
+void ts_dump(FILE* fp)
+{
+    histogram h[M_COUNT];
+    uint64_t n_samples, n_failed, n_added, n_app_limited, n_ns;
+    double up_s, us_per;
+    int m, b, live;
+
+    // 先在锁内复制一份，再慢慢输出，不让输出阻塞 ts_add / ts_remove
+    pthread_mutex_lock(&lock);
+    memcpy(h, hists, sizeof(h));
+    n_samples = samples;
+    n_failed = failed;
+    n_added = added;
+    n_app_limited = app_limited;
+    n_ns = sample_ns;
+    live = conn_cnt;
+    pthread_mutex_unlock(&lock);
+
+    up_s = (now_ns() - start_ns) / 1e9;
+    us_per = n_samples + n_failed > 0 ? n_ns / 1e3 / (n_samples + n_failed) : 0;
+    fprintf(fp, "tcp_info: %llu samples, %d live / %llu total connections, %.2f us/sample, "
+                "%.4f%% of time spent sampling\n", (unsigned long long)n_samples, live,
+            (unsigned long long)n_added, us_per, up_s > 0 ? n_ns / 1e9 / up_s * 100 : 0);
+    fprintf(fp, "  %-14s %10s %10s %10s %10s %10s %10s\n", "metric", "n", "min", "avg", "p50", "p99", "max");
+    for(m = 0; m < M_COUNT; m++)
+    {
+        if(h[m].count == 0)
+            continue;
+        fprintf(fp, "  %-14s %10llu %10llu %10.0f %10llu %10llu %10llu\n", metric_names[m],
+                (unsigned long long)h[m].count, (unsigned long long)h[m].min, (double)h[m].sum / h[m].count,
+                (unsigned long long)hist_quantile(&h[m], 0.5), (unsigned long long)hist_quantile(&h[m], 0.99),
+                (unsigned long long)h[m].max);
+    }
+    if(h[M_RATE].count > 0)
+        fprintf(fp, "  delivery rate app-limited in %.1f%% of samples\n",
+                100.0 * n_app_limited / h[M_RATE].count);
+
+    // 直方图：只列出非空的桶，[a,b) 为取值范围
+    for(m = 0; m < M_COUNT; m++)
+    {
+        if(h[m].count == 0)
+            continue;
+        fprintf(fp, "  %s:", metric_names[m]);
+        for(b = 0; b < TS_BUCKETS; b++)
+        {
+            if(h[m].buckets[b] == 0)
+                continue;
+            if(b == 0)
+                fprintf(fp, " 0:%llu", (unsigned long long)h[m].buckets[b]);
+            else
+                fprintf(fp, " [%llu,%llu):%llu", 1ULL << (b - 1), 1ULL << b,
+                        (unsigned long long)h[m].buckets[b]);
+        }
+        fprintf(fp, "\n");
+    }
+}
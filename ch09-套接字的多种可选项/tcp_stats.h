@@ -0,0 +1,40 @@
+#ifndef TCP_STATS_H
+#define TCP_STATS_H
+
+#include <stdio.h>      // FILE
+
+/*
+ * 连接的传输层遥测：后台线程定期对登记的连接调用 getsockopt(TCP_INFO)，汇总成直方图
+ *
+ * 采样的字段：rtt、rttvar（us）、cwnd、unacked（报文段数）、total_retrans（该连接累计重传数）、
+ * delivery_rate（内核估计的交付速率，字节/秒）。另外统计 delivery_rate 受应用限制（app-limited，
+ * 发送方没有足够数据可发）的样本比例。客户端看到的时延高而 rtt 正常、app-limited 比例高时，
+ * 瓶颈在应用；rtt / rttvar 高、重传多、cwnd 小时，瓶颈在网络。
+ *
+ * 采样开销有上限：每 TS_INTERVAL_MS 毫秒最多采样 TS_PER_TICK 个连接，按登记顺序轮流采样，
+ * 连接再多，每秒的 getsockopt 次数也不超过 TS_PER_TICK * 1000 / TS_INTERVAL_MS。
+ * 每个连接只在调用 getsockopt 时持有锁，ts_remove 最多等待一次系统调用。
+ *
+ * 统计输出：向进程发送 SIGUSR1（kill -USR1 <pid>），采样线程把直方图写到标准输出；
+ * 也可以直接调用 ts_dump。采样线程用 sigtimedwait 同时等待定时和信号，
+ * 所以 ts_start 会在调用线程中屏蔽 SIGUSR1，必须在创建其他线程之前调用（之后的线程继承屏蔽字，
+ * 信号只会交给采样线程；epoll_wait / accept 等也不会被 EINTR 打断）。
+ *
+ * 编译：gcc xxx.c tcp_stats.c -lpthread
+ */
+
+#define TS_INTERVAL_MS 100              // 采样周期
+#define TS_PER_TICK 8                   // 每个周期最多采样的连接数
+#define TS_MAX_CONN 4096                // 最多登记的连接数，超出的连接不采样
+
+/* 启动采样线程。成功返回 0，失败返回 -1 */
+int ts_start(void);
+
+/* 登记 / 注销一个连接：accept 之后 ts_add，close 之前 ts_remove */
+void ts_add(int fd);
+void ts_remove(int fd);
+
+/* 输出当前的统计和直方图 */
+void ts_dump(FILE* fp);
+
+#endif
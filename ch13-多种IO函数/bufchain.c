@@ -0,0 +1,526 @@
+#include <stdlib.h>     // malloc / free
+#include <string.h>     // memcpy
+#include <limits.h>     // IOV_MAX
+#include <pthread.h>    // pthread_mutex_*：保护空闲链表
+#include <errno.h>      // errno / ENOBUFS
+#include <poll.h>       // poll：等待错误队列中的完成通知
+#include <sys/uio.h>    // readv / writev / struct iovec
+#include <sys/socket.h> // sendmsg / recvmsg / MSG_ZEROCOPY / MSG_ERRQUEUE
+#include <netinet/in.h> // IP_RECVERR / IPV6_RECVERR
+#include <linux/errqueue.h> // struct sock_extended_err：零拷贝完成通知
+#include "bufchain.h"
+
+/*
+ * bufchain 的实现，接口说明见 bufchain.h
+ */
+
+#ifndef IOV_MAX
+#define IOV_MAX 1024
+#endif
+#define BC_MAX_READ_CHUNKS 64       // 一次 bc_readv 最多使用的新数据块数
+#define BC_ZC_MAX_PENDING 256       // 最多同时等待完成通知的零拷贝发送数
+#define BC_ZC_CLOSE_WAIT_MS 2000    // bc_zc_close 等待完成通知的最长时间
+#define BC_ZC_PROBE 32              // 前这么多次发送全被内核复制时，放弃零拷贝
+
+#ifndef SO_ZEROCOPY
+#define SO_ZEROCOPY 60
+#endif
+#ifndef MSG_ZEROCOPY
+#define MSG_ZEROCOPY 0x4000000
+#endif
+#ifndef SO_EE_ORIGIN_ZEROCOPY
+#define SO_EE_ORIGIN_ZEROCOPY 5
+#endif
+#ifndef SO_EE_CODE_ZEROCOPY_COPIED
+#define SO_EE_CODE_ZEROCOPY_COPIED 1
+#endif
+
+struct bc_chunk {
+    int refcnt;
+    size_t used;                    // 已写入的字节数：只有唯一引用者可以继续在其后追加
+    bc_chunk* next_free;
+    char data[BC_CHUNK_SIZE];
+};
+
+struct bc_slice {
+    bc_chunk* chunk;
+    char* base;
+    size_t len;
+    bc_slice* next;
+};
+
+/* 一次零拷贝发送：内核按发送顺序从 0 开始编号，完成通知给出一段编号区间 */
+typedef struct {
+    unsigned int seq;
+    int done;
+    bufchain held;                  // 发出的数据的引用，完成前不能还给池
+} bc_zc_send;
+
+struct bc_zc {
+    int fd;
+    unsigned int next_seq;
+    bc_zc_send q[BC_ZC_MAX_PENDING];
+    int head, cnt;
+    unsigned long completed;
+    int disabled;                   // 内核总是复制（如回环地址）：零拷贝只增加开销，改回普通发送
+    bc_zc_stat st;
+};
+
+static pthread_mutex_t pool_mutex = PTHREAD_MUTEX_INITIALIZER;
+static bc_chunk* free_chunks;
+static bc_slice* free_slices;
+
+/* -------------------- 池 -------------------- */
+
+static bc_chunk* chunk_alloc(void)
+{
+    bc_chunk* k;
+
+    pthread_mutex_lock(&pool_mutex);
+    k = free_chunks;
+    if(k != NULL)
+        free_chunks = k->next_free;
+    pthread_mutex_unlock(&pool_mutex);
+    if(k == NULL)
+        k = malloc(sizeof(bc_chunk));
+    if(k != NULL)
+    {
+        k->refcnt = 1;
+        k->used = 0;
+    }
+    return k;
+}
+
+static void chunk_unref(bc_chunk* k)
+{
+    if(__atomic_sub_fetch(&k->refcnt, 1, __ATOMIC_ACQ_REL) != 0)
+        return;
+    pthread_mutex_lock(&pool_mutex);
+    k->next_free = free_chunks;
+    free_chunks = k;
+    pthread_mutex_unlock(&pool_mutex);
+}
+
+static bc_slice* slice_alloc(bc_chunk* k, char* base, size_t len)
+{
+    bc_slice* s;
+
+    pthread_mutex_lock(&pool_mutex);
+    s = free_slices;
+    if(s != NULL)
+        free_slices = s->next;
+    pthread_mutex_unlock(&pool_mutex);
+    if(s == NULL)
+        s = malloc(sizeof(bc_slice));
+    if(s != NULL)
+    {
+        s->chunk = k;
+        s->base = base;
+        s->len = len;
+        s->next = NULL;
+    }
+    return s;
+}
+
+static void slice_free(bc_slice* s)
+{
+    chunk_unref(s->chunk);
+    pthread_mutex_lock(&pool_mutex);
+    s->next = free_slices;
+    free_slices = s;
+    pthread_mutex_unlock(&pool_mutex);
+}
+
+static void push_tail(bufchain* c, bc_slice* s)
+{
+    if(c->tail != NULL)
+        c->tail->next = s;
+    else
+        c->head = s;
+    c->tail = s;
+    c->len += s->len;
+}
+
+/* 链尾切片所在数据块的剩余空间：数据块只被本切片引用且切片恰好到写入位置为止时才可追加 */
+static size_t tail_room(const bufchain* c)
+{
+    bc_slice* t = c->tail;
+
+    if(t == NULL || __atomic_load_n(&t->chunk->refcnt, __ATOMIC_ACQUIRE) != 1
+       || t->base + t->len != t->chunk->data + t->chunk->used)
+        return 0;
+    return BC_CHUNK_SIZE - t->chunk->used;
+}
+
+/* -------------------- 链操作 -------------------- */
+
+void bc_init(bufchain* c)
+{
+    c->head = c->tail = NULL;
+    c->len = 0;
+}
+
+void bc_clear(bufchain* c)
+{
+    bc_slice *s, *next;
+
+    for(s = c->head; s != NULL; s = next)
+    {
+        next = s->next;
+        slice_free(s);
+    }
+    bc_init(c);
+}
+
+ssize_t bc_readv(bufchain* c, int fd, int nchunks)
+{
+    struct iovec iov[BC_MAX_READ_CHUNKS + 1];
+    bc_chunk* fresh[BC_MAX_READ_CHUNKS];
+    bc_slice* s;
+    size_t room, take;
+    ssize_t n, left;
+    int niov = 0, i, nfresh = 0;
+
+    if(nchunks > BC_MAX_READ_CHUNKS)
+        nchunks = BC_MAX_READ_CHUNKS;
+
+    // 先填满链尾数据块的剩余空间，再使用新的数据块
+    room = tail_room(c);
+    if(room > 0)
+    {
+        iov[niov].iov_base = c->tail->chunk->data + c->tail->chunk->used;
+        iov[niov++].iov_len = room;
+    }
+    for(i = 0; i < nchunks; i++)
+    {
+        fresh[i] = chunk_alloc();
+        if(fresh[i] == NULL)
+            break;
+        iov[niov].iov_base = fresh[i]->data;
+        iov[niov++].iov_len = BC_CHUNK_SIZE;
+        nfresh++;
+    }
+    if(niov == 0)
+        return -1;
+
+    n = readv(fd, iov, niov);
+
+    // 按读到的字节数把数据挂到链上，没用到的新数据块还给池
+    left = n > 0 ? n : 0;
+    if(room > 0 && left > 0)
+    {
+        take = (size_t)left < room ? (size_t)left : room;
+        c->tail->chunk->used += take;
+        c->tail->len += take;
+        c->len += take;
+        left -= take;
+    }
+    for(i = 0; i < nfresh; i++)
+    {
+        if(left > 0)
+        {
+            take = left < BC_CHUNK_SIZE ? (size_t)left : BC_CHUNK_SIZE;
+            fresh[i]->used = take;
+            s = slice_alloc(fresh[i], fresh[i]->data, take);
+            if(s == NULL)
+            {
+                chunk_unref(fresh[i]);
+                continue;
+            }
+            push_tail(c, s);
+            left -= take;
+        }
+        else
+            chunk_unref(fresh[i]);
+    }
+    return n;
+}
+
+ssize_t bc_writev(bufchain* c, int fd)
+{
+    struct iovec iov[IOV_MAX];
+    bc_slice* s;
+    ssize_t n;
+    int niov = 0;
+
+    for(s = c->head; s != NULL && niov < IOV_MAX; s = s->next)
+    {
+        iov[niov].iov_base = s->base;
+        iov[niov++].iov_len = s->len;
+    }
+    if(niov == 0)
+        return 0;
+    n = writev(fd, iov, niov);
+    if(n > 0)
+        bc_consume(c, n);
+    return n;
+}
+
+int bc_append(bufchain* c, const void* data, size_t len)
+{
+    const char* p = data;
+    bc_chunk* k;
+    bc_slice* s;
+    size_t room, take;
+
+    room = tail_room(c);
+    if(room > 0)
+    {
+        take = len < room ? len : room;
+        memcpy(c->tail->chunk->data + c->tail->chunk->used, p, take);
+        c->tail->chunk->used += take;
+        c->tail->len += take;
+        c->len += take;
+        p += take;
+        len -= take;
+    }
+    while(len > 0)
+    {
+        k = chunk_alloc();
+        if(k == NULL)
+            return -1;
+        take = len < BC_CHUNK_SIZE ? len : BC_CHUNK_SIZE;
+        memcpy(k->data, p, take);
+        k->used = take;
+        s = slice_alloc(k, k->data, take);
+        if(s == NULL)
+        {
+            chunk_unref(k);
+            return -1;
+        }
+        push_tail(c, s);
+        p += take;
+        len -= take;
+    }
+    return 0;
+}
+
+int bc_prepend(bufchain* c, const void* data, size_t len)
+{
+    bufchain hdr;
+
+    bc_init(&hdr);
+    if(bc_append(&hdr, data, len) == -1)
+    {
+        bc_clear(&hdr);
+        return -1;
+    }
+    if(hdr.head == NULL)
+        return 0;
+    // 协议头的切片接到原链之前
+    hdr.tail->next = c->head;
+    if(c->tail == NULL)
+        c->tail = hdr.tail;
+    c->head = hdr.head;
+    c->len += hdr.len;
+    return 0;
+}
+
+int bc_append_ref(bufchain* dst, const bufchain* src, size_t off, size_t len)
+{
+    bc_slice *s, *r;
+    size_t take;
+
+    for(s = src->head; s != NULL && len > 0; s = s->next)
+    {
+        if(off >= s->len)
+        {
+            off -= s->len;
+            continue;
+        }
+        take = s->len - off < len ? s->len - off : len;
+        r = slice_alloc(s->chunk, s->base + off, take);
+        if(r == NULL)
+            return -1;
+        __atomic_add_fetch(&s->chunk->refcnt, 1, __ATOMIC_RELAXED);
+        push_tail(dst, r);
+        len -= take;
+        off = 0;
+    }
+    return 0;
+}
+
+void bc_consume(bufchain* c, size_t n)
+{
+    bc_slice* s;
+
+    while(n > 0 && c->head != NULL)
+    {
+        s = c->head;
+        if(n < s->len)
+        {
+            s->base += n;
+            s->len -= n;
+            c->len -= n;
+            return;
+        }
+        n -= s->len;
+        c->len -= s->len;
+        c->head = s->next;
+        if(c->head == NULL)
+            c->tail = NULL;
+        slice_free(s);
+    }
+}
+
+size_t bc_copyout(const bufchain* c, size_t off, void* buf, size_t len)
+{
+    char* p = buf;
+    bc_slice* s;
+    size_t take, got = 0;
+
+    for(s = c->head; s != NULL && got < len; s = s->next)
+    {
+        if(off >= s->len)
+        {
+            off -= s->len;
+            continue;
+        }
+        take = s->len - off < len - got ? s->len - off : len - got;
+        memcpy(p + got, s->base + off, take);
+        got += take;
+        off = 0;
+    }
+    return got;
+}
+
+/* -------------------- MSG_ZEROCOPY 发送 -------------------- */
+
+bc_zc* bc_zc_open(int fd)
+{
+    bc_zc* z;
+    int on = 1;
+
+    if(setsockopt(fd, SOL_SOCKET, SO_ZEROCOPY, &on, sizeof(on)) == -1)
+        return NULL;
+    z = calloc(1, sizeof(bc_zc));
+    if(z != NULL)
+        z->fd = fd;
+    return z;
+}
+
+ssize_t bc_writev_zc(bufchain* c, bc_zc* z)
+{
+    struct iovec iov[IOV_MAX];
+    struct msghdr msg;
+    bc_zc_send* e;
+    bc_slice* s;
+    ssize_t n;
+    int niov = 0;
+
+    if(c->len < BC_ZC_MIN || z->disabled)
+    {
+        z->st.copy_sends++;
+        return bc_writev(c, z->fd);
+    }
+    // 等待通知的发送太多时先回收，避免占用的数据块无限增长
+    while(z->cnt == BC_ZC_MAX_PENDING)
+        bc_zc_reap(z, -1);
+
+    for(s = c->head; s != NULL && niov < IOV_MAX; s = s->next)
+    {
+        iov[niov].iov_base = s->base;
+        iov[niov++].iov_len = s->len;
+    }
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = iov;
+    msg.msg_iovlen = niov;
+    n = sendmsg(z->fd, &msg, MSG_ZEROCOPY);
+    if(n == -1 && errno == ENOBUFS)
+    {
+        // 超出可锁定内存（optmem）限制：这一次退回复制发送
+        z->st.copy_sends++;
+        return bc_writev(c, z->fd);
+    }
+    if(n < 0)
+        return n;
+
+    // 发出的部分转为 bc_zc 持有的引用，再从链上移除
+    e = &z->q[(z->head + z->cnt) % BC_ZC_MAX_PENDING];
+    e->seq = z->next_seq++;
+    e->done = 0;
+    bc_init(&e->held);
+    bc_append_ref(&e->held, c, 0, n);
+    bc_consume(c, n);
+    z->cnt++;
+    z->st.zc_sends++;
+    return n;
+}
+
+int bc_zc_reap(bc_zc* z, int timeout_ms)
+{
+    struct pollfd pfd;
+    struct msghdr msg;
+    struct cmsghdr* cm;
+    struct sock_extended_err* serr;
+    bc_zc_send* e;
+    char control[128];
+    unsigned int lo, hi;
+    int i;
+
+    if(z->cnt > 0 && timeout_ms != 0)
+    {
+        // 错误队列非空时 poll 报告 POLLERR，不需要关注任何事件
+        pfd.fd = z->fd;
+        pfd.events = 0;
+        poll(&pfd, 1, timeout_ms);
+    }
+
+    while(z->cnt > 0)
+    {
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+        if(recvmsg(z->fd, &msg, MSG_ERRQUEUE | MSG_DONTWAIT) == -1)
+            break;
+        for(cm = CMSG_FIRSTHDR(&msg); cm != NULL; cm = CMSG_NXTHDR(&msg, cm))
+        {
+            if(!((cm->cmsg_level == SOL_IP && cm->cmsg_type == IP_RECVERR)
+                 || (cm->cmsg_level == SOL_IPV6 && cm->cmsg_type == IPV6_RECVERR)))
+                continue;
+            serr = (struct sock_extended_err*)CMSG_DATA(cm);
+            if(serr->ee_errno != 0 || serr->ee_origin != SO_EE_ORIGIN_ZEROCOPY)
+                continue;
+            // [ee_info, ee_data] 区间内的发送都已完成
+            lo = serr->ee_info;
+            hi = serr->ee_data;
+            z->completed += hi - lo + 1;
+            if(serr->ee_code & SO_EE_CODE_ZEROCOPY_COPIED)
+                z->st.zc_copied += hi - lo + 1;
+            if(z->completed >= BC_ZC_PROBE && z->st.zc_copied == z->completed)
+                z->disabled = 1;
+            for(i = 0; i < z->cnt; i++)
+            {
+                e = &z->q[(z->head + i) % BC_ZC_MAX_PENDING];
+                if(e->seq - lo <= hi - lo)
+                    e->done = 1;
+            }
+        }
+    }
+
+    // 按发送顺序释放已完成的发送
+    while(z->cnt > 0 && z->q[z->head].done)
+    {
+        bc_clear(&z->q[z->head].held);
+        z->head = (z->head + 1) % BC_ZC_MAX_PENDING;
+        z->cnt--;
+    }
+    return z->cnt;
+}
+
+void bc_zc_close(bc_zc* z, bc_zc_stat* st)
+{
+    int before;
+
+    while(z->cnt > 0)
+    {
+        before = z->cnt;
+        if(bc_zc_reap(z, BC_ZC_CLOSE_WAIT_MS) == before)
+            break;
+    }
+    if(st != NULL)
+        *st = z->st;
+    // 仍未完成的发送：内核可能还在引用这些页，只能放弃这些数据块，不还给池
+    if(z->cnt == 0)
+        free(z);
+}
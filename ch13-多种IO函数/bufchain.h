@@ -0,0 +1,82 @@
+#ifndef BUFCHAIN_H
+#define BUFCHAIN_H
+
+#include <sys/types.h>  // ssize_t / size_t
+
+/*
+ * 基于 readv / writev 的分散-聚集缓冲链
+ *
+ * 数据存放在池化的固定大小数据块（chunk）中，每个数据块带引用计数；
+ * 缓冲链（bufchain）是一串切片（slice），每个切片引用某个数据块中的一段。
+ *   - bc_readv：一次 readv 直接读入多个数据块，不经过中间缓冲区
+ *   - bc_writev：把链上的切片组成 iovec 数组（每次最多 IOV_MAX 个），一次 writev 写出
+ *   - bc_append_ref：引用另一条链中的一段（只增加引用计数，不复制数据），
+ *     例如把同一条消息发给多个客户端
+ *   - bc_prepend：在链首插入协议头，后面的数据不需要移动
+ * 数据块和切片都从全局空闲链表分配，引用计数归零后回到空闲链表，运行期间基本不调用 malloc。
+ * 池由互斥锁保护，可以在多个线程中使用（同一条链不能被多个线程同时操作）。
+ *
+ * 可选的 MSG_ZEROCOPY 发送（bc_zc_*）：大块数据用 sendmsg(MSG_ZEROCOPY) 发出，内核直接引用数据块所在的页，
+ * 不再复制到 skb。内核发完之前这些页不能被改写，所以发出的切片不立即释放，而是挂在 bc_zc 上，
+ * 等错误队列（MSG_ERRQUEUE）送来完成通知后才把数据块还给池。小于 BC_ZC_MIN 的发送仍走普通 writev；
+ * 如果内核报告前几十次发送都仍然做了复制（回环地址、网卡不支持），之后也改回普通 writev。
+ */
+
+#define BC_CHUNK_SIZE 4096
+#define BC_ZC_MIN (16 * 1024)       // 链上数据少于此值时直接复制发送：零拷贝的页锁定和完成通知开销更大
+
+typedef struct bc_chunk bc_chunk;
+typedef struct bc_slice bc_slice;
+typedef struct bc_zc bc_zc;
+
+typedef struct {
+    bc_slice* head;
+    bc_slice* tail;
+    size_t len;             // 链上的总字节数
+} bufchain;
+
+void bc_init(bufchain* c);
+void bc_clear(bufchain* c);                 // 释放链上的所有切片
+
+/* 最多用 nchunks 个新数据块（加上链尾数据块的剩余空间）调用一次 readv，返回值同 readv */
+ssize_t bc_readv(bufchain* c, int fd, int nchunks);
+
+/* 把链首的数据用一次 writev 写出（最多 IOV_MAX 个切片），写出的部分从链上移除；返回值同 writev */
+ssize_t bc_writev(bufchain* c, int fd);
+
+/* 复制 len 字节到链尾（用于生成少量数据，如响应头）；失败返回 -1 */
+int bc_append(bufchain* c, const void* data, size_t len);
+
+/* 在链首插入 len 字节（协议头），原有数据不移动；失败返回 -1 */
+int bc_prepend(bufchain* c, const void* data, size_t len);
+
+/* 把 src 中从 off 开始的 len 字节以引用方式追加到 dst 链尾，不复制数据；失败返回 -1 */
+int bc_append_ref(bufchain* dst, const bufchain* src, size_t off, size_t len);
+
+/* 从链首移除 n 字节 */
+void bc_consume(bufchain* c, size_t n);
+
+/* 把从 off 开始最多 len 字节复制到 buf（用于解析协议头），返回复制的字节数 */
+size_t bc_copyout(const bufchain* c, size_t off, void* buf, size_t len);
+
+/* -------------------- MSG_ZEROCOPY 发送 -------------------- */
+
+typedef struct {
+    unsigned long zc_sends;         // 以 MSG_ZEROCOPY 发出的次数
+    unsigned long zc_copied;        // 其中内核报告仍然做了复制的次数（例如回环地址、网卡不支持 SG）
+    unsigned long copy_sends;       // 数据太少或内核暂时无法锁定页面，改为复制发送的次数
+} bc_zc_stat;
+
+/* 在套接字上开启 SO_ZEROCOPY；内核不支持时返回 NULL，调用方继续使用 bc_writev */
+bc_zc* bc_zc_open(int fd);
+
+/* 同 bc_writev；数据足够多时以 MSG_ZEROCOPY 发出，发出的切片保留到内核完成通知到达 */
+ssize_t bc_writev_zc(bufchain* c, bc_zc* z);
+
+/* 读取完成通知并释放已完成的切片；timeout_ms 为等待通知的最长时间（0 不等待），返回仍未完成的发送数 */
+int bc_zc_reap(bc_zc* z, int timeout_ms);
+
+/* 等待所有发送完成后释放 bc_zc（必须在关闭套接字之前调用），st 不为 NULL 时填入统计 */
+void bc_zc_close(bc_zc* z, bc_zc_stat* st);
+
+#endif
@@ -0,0 +1,68 @@
+#ifndef PRI_PROTO_H
+#define PRI_PROTO_H
+
+#include <stdint.h>     // uint8_t / uint32_t / uint64_t
+#include <string.h>     // memcpy
+#include <arpa/inet.h>  // htonl / ntohl
+
+/*
+ * 带优先通道的分帧协议，pri_send 与 pri_recv 共用
+ *
+ * 每一帧：[1 类型][1 命令][2 保留][4 载荷长度][8 ID] + 载荷
+ *   - 数据帧（PF_DATA）：批量数据，载荷最长 PF_DATA_MAX
+ *   - 控制帧（PF_CTRL）：没有载荷，命令见 PC_*，ID 的含义由命令决定
+ * 发送端的控制帧在帧边界处插到发送队列最前面；接收端解析出控制帧后立即处理，
+ * 不排在已经收到、尚未处理的数据后面。
+ */
+
+#define PF_HDR_SIZE 16
+#define PF_DATA_MAX 16384           // 数据帧越小，控制帧在帧边界上等待的时间越短
+
+#define PF_DATA 0
+#define PF_CTRL 1
+
+#define PC_PING 1                   // ID 为发送时刻（ns），接收端原样以 PC_PONG 回复
+#define PC_PONG 2
+#define PC_CANCEL 3                 // 丢弃所有已排队、尚未处理的数据
+#define PC_CANCEL_ACK 4             // ID 为接收端丢弃的字节数
+
+typedef struct {
+    uint8_t type;
+    uint8_t cmd;
+    uint32_t len;
+    uint64_t id;
+} pri_frame;
+
+static inline void pf_put(uint8_t* p, const pri_frame* f)
+{
+    uint32_t v32;
+
+    p[0] = f->type;
+    p[1] = f->cmd;
+    p[2] = p[3] = 0;
+    v32 = htonl(f->len);
+    memcpy(p + 4, &v32, 4);
+    v32 = htonl((uint32_t)(f->id >> 32));
+    memcpy(p + 8, &v32, 4);
+    v32 = htonl((uint32_t)f->id);
+    memcpy(p + 12, &v32, 4);
+}
+
+/* 解析帧头：格式错误返回 -1 */
+static inline int pf_get(const uint8_t* p, pri_frame* f)
+{
+    uint32_t hi, lo;
+
+    f->type = p[0];
+    f->cmd = p[1];
+    memcpy(&lo, p + 4, 4);
+    f->len = ntohl(lo);
+    memcpy(&hi, p + 8, 4);
+    memcpy(&lo, p + 12, 4);
+    f->id = ((uint64_t)ntohl(hi) << 32) | ntohl(lo);
+    if(f->type > PF_CTRL || f->len > PF_DATA_MAX || (f->type == PF_CTRL && f->len != 0))
+        return -1;
+    return 0;
+}
+
+#endif
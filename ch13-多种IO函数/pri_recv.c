@@ -0,0 +1,289 @@
+#include <stdio.h>      // 标准输入输出：printf / fputs / fputc 等
+#include <stdlib.h>     // 标准库：exit / atoi 等
+#include <string.h>     // 字符串/内存操作：memset / strcmp 等
+#include <stdint.h>     // uint8_t / uint64_t
+#include <unistd.h>     // POSIX：read / write / close 等
+#include <errno.h>      // errno / EAGAIN
+#include <fcntl.h>      // fcntl：非阻塞套接字
+#include <arpa/inet.h>  // 网络地址转换/字节序：htonl / htons 等
+#include <netinet/in.h> // IPv4 地址结构：struct sockaddr_in / INADDR_ANY 等
+#include <sys/socket.h> // 套接字 API：socket / bind / listen / accept 等
+#include <sys/epoll.h>  // epoll：等待可读 / 定时器
+#include <sys/timerfd.h>// timerfd：模拟按固定速率处理数据
+#include "pri_proto.h"  // 带优先通道的分帧协议
+
+/*
+ * 带优先通道的接收端，配合 pri_send 使用（取代 oob_recv 的 MSG_OOB + SIGURG）
+ *
+ * 应用处理数据的速度（rate_MBps）比网络慢，收到的数据帧先进入应用队列，再按速率慢慢处理。
+ *   - 控制帧在解析时立即处理（PING 回 PONG，CANCEL 清空应用队列后回 CANCEL_ACK），
+ *     不排在队列中的数据后面；整个过程在 epoll 循环中完成，不需要信号
+ *   - 应用队列超过 RX_QUEUE_MAX 时停止读取（流量控制），低于 RX_QUEUE_RESUME 再继续。
+ *     停止读取期间控制帧会被堵在内核接收缓冲区里，所以把 SO_RCVBUF 设得比较小，
+ *     让发送端的积压留在发送端的用户态队列中（那里控制帧可以插队），而不是在内核缓冲区里
+ * fifo 模式用于对比：控制帧和数据帧一样进入应用队列，按顺序处理；SO_RCVBUF 使用系统默认值。
+ *
+ * 用法：pri_recv <port> [rate_MBps] [fifo]
+ */
+
+#define RCVBUF_SIZE (32 * 1024)      // 控制帧最多被堵在这么多数据后面
+#define READ_BUF_SIZE (64 * 1024)
+#define RX_QUEUE_MAX (1024 * 1024)
+#define RX_QUEUE_RESUME (RX_QUEUE_MAX - 64 * 1024)   // 暂停时间越短，被堵住的控制帧等得越少
+#define APP_Q_MAX 4096
+#define TICK_MS 5
+#define DEFAULT_RATE 20
+#define EPOLL_SIZE 4
+
+// 应用队列：连续的数据帧合并成一项，只记录字节数（演示用，不保存内容）
+typedef struct {
+    int cmd;                // 0 表示数据，否则为控制命令（仅 fifo 模式）
+    uint64_t val;           // 数据：剩余字节数；控制：帧 ID
+} app_entry;
+
+static app_entry app_q[APP_Q_MAX];
+static int app_head, app_tail;
+static uint64_t queued;     // 队列中的数据字节数
+static int fifo;
+static uint64_t processed, dropped, ctrl_cnt;
+
+void on_frame(int sock, const pri_frame* f, uint32_t payload);
+void handle_ctrl(int sock, int cmd, uint64_t id);
+void app_process(int sock, uint64_t budget);
+void send_ctrl(int sock, int cmd, uint64_t id);
+void error_handling(char *message);
+
+int main(int argc, char *argv[])
+{
+    int serv_sock, clnt_sock, epfd, tfd, event_cnt, i, n, rate = DEFAULT_RATE, reading = 1, done = 0;
+    int rcvbuf = RCVBUF_SIZE, option = 1;
+    struct sockaddr_in serv_adr, clnt_adr;
+    socklen_t adr_sz;
+    struct epoll_event event, ep_events[EPOLL_SIZE];
+    struct itimerspec its;
+    uint64_t expirations, received = 0;
+    static uint8_t buf[READ_BUF_SIZE];
+    uint8_t hdr[PF_HDR_SIZE];
+    size_t hlen = 0, off;
+    uint32_t payload_left = 0;
+    pri_frame cur;
+
+    if(argc < 2 || argc > 4)
+    {
+        printf("Usage : %s <port> [rate_MBps] [fifo]\n", argv[0]);
+        exit(1);
+    }
+    if(argc >= 3)
+        rate = atoi(argv[2]);
+    if(argc == 4 && strcmp(argv[3], "fifo") == 0)
+        fifo = 1;
+    if(rate < 1)
+        error_handling("invalid rate_MBps");
+
+    serv_sock = socket(PF_INET, SOCK_STREAM, 0);
+    setsockopt(serv_sock, SOL_SOCKET, SO_REUSEADDR, &option, sizeof(option));
+    // 接收缓冲区大小要在 listen 之前设置，才会影响窗口协商
+    if(!fifo)
+        setsockopt(serv_sock, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+    memset(&serv_adr, 0, sizeof(serv_adr));
+    serv_adr.sin_family = AF_INET;
+    serv_adr.sin_addr.s_addr = htonl(INADDR_ANY);
+    serv_adr.sin_port = htons(atoi(argv[1]));
+    if(bind(serv_sock, (struct sockaddr*)&serv_adr, sizeof(serv_adr)) == -1)
+        error_handling("bind() error");
+    if(listen(serv_sock, 5) == -1)
+        error_handling("listen() error");
+
+    adr_sz = sizeof(clnt_adr);
+    clnt_sock = accept(serv_sock, (struct sockaddr*)&clnt_adr, &adr_sz);
+    if(clnt_sock == -1)
+        error_handling("accept() error");
+    close(serv_sock);
+    fcntl(clnt_sock, F_SETFL, fcntl(clnt_sock, F_GETFL, 0) | O_NONBLOCK);
+    printf("%s mode: processing at %d MB/s\n", fifo ? "fifo" : "priority", rate);
+
+    // -------------------- 处理定时器：每 TICK_MS 处理 rate * TICK_MS 的数据 --------------------
+    tfd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK);
+    its.it_value.tv_sec = its.it_interval.tv_sec = 0;
+    its.it_value.tv_nsec = its.it_interval.tv_nsec = TICK_MS * 1000000L;
+    timerfd_settime(tfd, 0, &its, NULL);
+
+    epfd = epoll_create(EPOLL_SIZE);
+    event.events = EPOLLIN;
+    event.data.fd = tfd;
+    epoll_ctl(epfd, EPOLL_CTL_ADD, tfd, &event);
+    event.events = EPOLLIN;
+    event.data.fd = clnt_sock;
+    epoll_ctl(epfd, EPOLL_CTL_ADD, clnt_sock, &event);
+
+    while(!done)
+    {
+        event_cnt = epoll_wait(epfd, ep_events, EPOLL_SIZE, -1);
+        for(i = 0; i < event_cnt; i++)
+        {
+            if(ep_events[i].data.fd == tfd)
+            {
+                read(tfd, &expirations, sizeof(expirations));
+                app_process(clnt_sock, (uint64_t)rate * 1024 * 1024 * TICK_MS * expirations / 1000);
+                if(!reading && queued < RX_QUEUE_RESUME)
+                {
+                    reading = 1;
+                    event.events = EPOLLIN;
+                    event.data.fd = clnt_sock;
+                    epoll_ctl(epfd, EPOLL_CTL_ADD, clnt_sock, &event);
+                }
+                continue;
+            }
+
+            n = read(clnt_sock, buf, sizeof(buf));
+            if(n == 0)
+            {
+                done = 1;
+                break;
+            }
+            if(n < 0)
+            {
+                if(errno == EAGAIN || errno == EWOULDBLOCK)
+                    continue;
+                error_handling("read() error");
+            }
+            received += n;
+
+            // -------------------- 解析帧：帧头和载荷都可能被拆到两次 read 中 --------------------
+            off = 0;
+            while(off < (size_t)n)
+            {
+                if(payload_left > 0)
+                {
+                    // 数据帧载荷：演示中只计字节数
+                    if((size_t)n - off < payload_left)
+                    {
+                        on_frame(clnt_sock, &cur, n - off);
+                        payload_left -= n - off;
+                        off = n;
+                    }
+                    else
+                    {
+                        on_frame(clnt_sock, &cur, payload_left);
+                        off += payload_left;
+                        payload_left = 0;
+                    }
+                    continue;
+                }
+                hdr[hlen++] = buf[off++];
+                if(hlen < PF_HDR_SIZE)
+                    continue;
+                hlen = 0;
+                if(pf_get(hdr, &cur) == -1)
+                    error_handling("bad frame");
+                if(cur.type == PF_CTRL)
+                    on_frame(clnt_sock, &cur, 0);
+                else
+                    payload_left = cur.len;
+            }
+
+            if(queued >= RX_QUEUE_MAX)
+            {
+                // 流量控制：应用跟不上，暂停读取
+                reading = 0;
+                epoll_ctl(epfd, EPOLL_CTL_DEL, clnt_sock, NULL);
+            }
+        }
+    }
+
+    printf("received %.1f MB, processed %.1f MB, dropped %.1f MB, %llu control frames\n",
+           received / (1024.0 * 1024), processed / (1024.0 * 1024),
+           dropped / (1024.0 * 1024), (unsigned long long)ctrl_cnt);
+    close(tfd);
+    close(epfd);
+    close(clnt_sock);
+    return 0;
+}
+
+/* 收到一个控制帧，或一段数据帧载荷（payload 字节） */
+void on_frame(int sock, const pri_frame* f, uint32_t payload)
+{
+    int last = (app_tail + APP_Q_MAX - 1) % APP_Q_MAX;
+
+    if(f->type == PF_CTRL && !fifo)
+    {
+        handle_ctrl(sock, f->cmd, f->id);      // 优先通道：不进入应用队列
+        return;
+    }
+    if(f->type == PF_DATA && app_head != app_tail && app_q[last].cmd == 0)
+        app_q[last].val += payload;            // 与前一段数据合并
+    else
+    {
+        if((app_tail + 1) % APP_Q_MAX == app_head)
+            error_handling("application queue overflow");
+        app_q[app_tail].cmd = f->type == PF_CTRL ? f->cmd : 0;
+        app_q[app_tail].val = f->type == PF_CTRL ? f->id : payload;
+        app_tail = (app_tail + 1) % APP_Q_MAX;
+    }
+    if(f->type == PF_DATA)
+        queued += payload;
+}
+
+/* 应用层处理：消耗 budget 字节的数据；fifo 模式下控制帧轮到它时才处理 */
+void app_process(int sock, uint64_t budget)
+{
+    app_entry* e;
+    uint64_t take;
+
+    while(app_head != app_tail)
+    {
+        e = &app_q[app_head];
+        if(e->cmd != 0)
+        {
+            app_head = (app_head + 1) % APP_Q_MAX;
+            handle_ctrl(sock, e->cmd, e->val);
+            continue;
+        }
+        if(budget == 0)
+            break;
+        take = e->val < budget ? e->val : budget;
+        e->val -= take;
+        budget -= take;
+        queued -= take;
+        processed += take;
+        if(e->val == 0)
+            app_head = (app_head + 1) % APP_Q_MAX;
+    }
+}
+
+void handle_ctrl(int sock, int cmd, uint64_t id)
+{
+    ctrl_cnt++;
+    if(cmd == PC_PING)
+        send_ctrl(sock, PC_PONG, id);
+    else if(cmd == PC_CANCEL)
+    {
+        // 丢弃队列中所有尚未处理的数据
+        dropped += queued;
+        send_ctrl(sock, PC_CANCEL_ACK, queued);
+        queued = 0;
+        app_head = app_tail = 0;
+    }
+}
+
+/* 回复控制帧：只有 16 字节，发送端持续读取，直接写即可 */
+void send_ctrl(int sock, int cmd, uint64_t id)
+{
+    uint8_t p[PF_HDR_SIZE];
+    pri_frame f;
+
+    f.type = PF_CTRL;
+    f.cmd = (uint8_t)cmd;
+    f.len = 0;
+    f.id = id;
+    pf_put(p, &f);
+    if(write(sock, p, sizeof(p)) != sizeof(p))
+        error_handling("write() error");
+}
+
+void error_handling(char *message)
+{
+    fputs(message, stderr);
+    fputc('\n', stderr);
+    exit(1);
+}
@@ -0,0 +1,303 @@
+#include <stdio.h>      // 标准输入输出：printf / fputs / fputc 等
+#include <stdlib.h>     // 标准库：exit / atoi / qsort 等
+#include <string.h>     // 字符串/内存操作：memset / strcmp 等
+#include <stdint.h>     // uint8_t / uint64_t
+#include <unistd.h>     // POSIX：read / close 等
+#include <errno.h>      // errno / EAGAIN
+#include <fcntl.h>      // fcntl：非阻塞套接字
+#include <time.h>       // clock_gettime
+#include <arpa/inet.h>  // 网络地址转换/字节序：inet_addr / htons 等
+#include <netinet/in.h> // IPPROTO_TCP
+#include <netinet/tcp.h>// TCP_NOTSENT_LOWAT
+#include <sys/socket.h> // 套接字 API：socket / connect / setsockopt 等
+#include <sys/uio.h>    // writev：帧头和载荷一次写出
+#include <sys/epoll.h>  // epoll：等待可写 / 可读 / 定时器
+#include <sys/timerfd.h>// timerfd：定时发送 PING
+#include "pri_proto.h"  // 带优先通道的分帧协议
+
+/*
+ * 带优先通道的发送端，配合 pri_recv 使用（取代 oob_send 的 MSG_OOB）
+ *
+ * MSG_OOB 只能携带 1 个字节的紧急数据，接收端还要在 SIGURG 信号处理函数中 recv。
+ * 这里改为在分帧层实现优先通道，不使用信号：
+ *   - 发送队列分两条：控制帧队列和数据帧队列。每写完一帧，先看控制帧队列，
+ *     所以控制帧最多等待一个正在发送的数据帧（PF_DATA_MAX 字节）就能插到最前面
+ *   - 只在用户态排队还不够：已经写进内核发送缓冲区的数据，后来的控制帧无法越过。
+ *     TCP_NOTSENT_LOWAT 限制内核中"尚未发出"的字节数，超过后 write 返回 EAGAIN，
+ *     积压的批量数据因此留在用户态队列里，控制帧可以越过它们
+ *
+ * 程序开始时把 bulk_MB 的批量数据全部排入发送队列，然后每 ping_ms 发送一个 PING 控制帧，
+ * 统计 PONG 的往返时延；seconds 秒后发送 CANCEL：丢弃本地还没发出的数据，
+ * 并让接收端丢弃已经收到、尚未处理的数据。
+ * fifo 模式用于对比：控制帧与数据帧排在同一个队列里，也不设置 TCP_NOTSENT_LOWAT。
+ *
+ * 用法：pri_send <IP> <port> <bulk_MB> [seconds] [ping_ms] [fifo]
+ */
+
+#define NOTSENT_LOWAT (16 * 1024)
+#define CTRL_Q_MAX 256
+#define MAX_PINGS 100000
+#define DEFAULT_SECS 3
+#define DEFAULT_PING_MS 50
+#define EPOLL_SIZE 4
+
+typedef struct {
+    pri_frame f;
+    uint64_t after_data;            // fifo 模式：在此之前必须已经开始发送的数据帧数
+} ctrl_entry;
+
+static ctrl_entry ctrl_q[CTRL_Q_MAX];
+static int ctrl_head, ctrl_tail;
+static uint64_t data_total, data_started;   // 数据帧总数 / 已开始发送的数据帧数
+static int fifo;
+
+// 正在发送的帧：可能被 EAGAIN 打断，下次从 cur_off 继续
+static uint8_t cur_hdr[PF_HDR_SIZE];
+static size_t cur_len, cur_off;
+static int have_cur;
+static uint8_t zeros[PF_DATA_MAX];          // 数据帧的载荷（演示用，内容无关紧要）
+
+uint64_t now_ns(void);
+void queue_ctrl(int cmd, uint64_t id);
+int flush_frames(int sock);
+int cmp_u64(const void* a, const void* b);
+void error_handling(char *message);
+
+int main(int argc, char *argv[])
+{
+    int sock, epfd, tfd, event_cnt, i, n, secs = DEFAULT_SECS, ping_ms = DEFAULT_PING_MS;
+    int lowat = NOTSENT_LOWAT, want_out = 0, done = 0, cancelled = 0, acked = 0;
+    struct sockaddr_in serv_adr;
+    struct epoll_event event, ep_events[EPOLL_SIZE];
+    struct itimerspec its;
+    uint64_t expirations, start, cancel_at = 0, dropped_remote = 0;
+    static uint64_t rtts[MAX_PINGS];
+    int nrtt = 0, pings = 0;
+    uint8_t rbuf[PF_HDR_SIZE * 64];
+    size_t rlen = 0, off;
+    pri_frame f;
+    double bulk_mb;
+
+    if(argc < 4 || argc > 7)
+    {
+        printf("Usage : %s <IP> <port> <bulk_MB> [seconds] [ping_ms] [fifo]\n", argv[0]);
+        exit(1);
+    }
+    bulk_mb = atof(argv[3]);
+    if(argc >= 5)
+        secs = atoi(argv[4]);
+    if(argc >= 6)
+        ping_ms = atoi(argv[5]);
+    if(argc == 7 && strcmp(argv[6], "fifo") == 0)
+        fifo = 1;
+    if(bulk_mb <= 0 || secs < 1 || ping_ms < 1)
+        error_handling("invalid bulk_MB, seconds or ping_ms");
+    data_total = (uint64_t)(bulk_mb * 1024 * 1024 / PF_DATA_MAX);
+
+    sock = socket(PF_INET, SOCK_STREAM, 0);
+    memset(&serv_adr, 0, sizeof(serv_adr));
+    serv_adr.sin_family = AF_INET;
+    serv_adr.sin_addr.s_addr = inet_addr(argv[1]);
+    serv_adr.sin_port = htons(atoi(argv[2]));
+    if(connect(sock, (struct sockaddr*)&serv_adr, sizeof(serv_adr)) == -1)
+        error_handling("connect() error!");
+    if(!fifo && setsockopt(sock, IPPROTO_TCP, TCP_NOTSENT_LOWAT, &lowat, sizeof(lowat)) == -1)
+        error_handling("setsockopt(TCP_NOTSENT_LOWAT) error");
+    fcntl(sock, F_SETFL, fcntl(sock, F_GETFL, 0) | O_NONBLOCK);
+
+    // -------------------- PING 定时器 --------------------
+    tfd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK);
+    its.it_value.tv_sec = its.it_interval.tv_sec = ping_ms / 1000;
+    its.it_value.tv_nsec = its.it_interval.tv_nsec = (ping_ms % 1000) * 1000000L;
+    timerfd_settime(tfd, 0, &its, NULL);
+
+    epfd = epoll_create(EPOLL_SIZE);
+    event.events = EPOLLIN;
+    event.data.fd = tfd;
+    epoll_ctl(epfd, EPOLL_CTL_ADD, tfd, &event);
+    event.events = EPOLLIN;
+    event.data.fd = sock;
+    epoll_ctl(epfd, EPOLL_CTL_ADD, sock, &event);
+
+    printf("%s mode: %.1f MB bulk queued (%llu frames of %d bytes), PING every %d ms\n",
+           fifo ? "fifo" : "priority", bulk_mb, (unsigned long long)data_total, PF_DATA_MAX, ping_ms);
+    start = now_ns();
+
+    while(!done)
+    {
+        // 有待发送的帧就关注可写事件
+        if(flush_frames(sock) == -1)
+            error_handling("write() error");
+        n = have_cur || ctrl_head != ctrl_tail || data_started < data_total;
+        if(n != want_out)
+        {
+            want_out = n;
+            event.events = EPOLLIN | (want_out ? EPOLLOUT : 0);
+            event.data.fd = sock;
+            epoll_ctl(epfd, EPOLL_CTL_MOD, sock, &event);
+        }
+
+        event_cnt = epoll_wait(epfd, ep_events, EPOLL_SIZE, -1);
+        for(i = 0; i < event_cnt; i++)
+        {
+            if(ep_events[i].data.fd == tfd)
+            {
+                read(tfd, &expirations, sizeof(expirations));
+                if(cancelled)
+                    continue;
+                if(now_ns() - start >= (uint64_t)secs * 1000000000ull)
+                {
+                    // 取消：本地没发出的数据不再发送（fifo 模式下 CANCEL 只能排在所有数据之后）
+                    if(!fifo)
+                        data_total = data_started;
+                    queue_ctrl(PC_CANCEL, 0);
+                    cancel_at = now_ns();
+                    cancelled = 1;
+                }
+                else
+                {
+                    queue_ctrl(PC_PING, now_ns());
+                    pings++;
+                }
+                continue;
+            }
+            if(!(ep_events[i].events & EPOLLIN))
+                continue;
+
+            // -------------------- 读取接收端的回复（只有控制帧） --------------------
+            n = read(sock, rbuf + rlen, sizeof(rbuf) - rlen);
+            if(n == 0)
+            {
+                done = 1;
+                break;
+            }
+            if(n < 0)
+                continue;
+            rlen += n;
+            for(off = 0; off + PF_HDR_SIZE <= rlen; off += PF_HDR_SIZE)
+            {
+                if(pf_get(rbuf + off, &f) == -1 || f.type != PF_CTRL)
+                    error_handling("bad frame");
+                if(f.cmd == PC_PONG && nrtt < MAX_PINGS)
+                    rtts[nrtt++] = now_ns() - f.id;
+                else if(f.cmd == PC_CANCEL_ACK)
+                {
+                    dropped_remote = f.id;
+                    acked = 1;
+                    done = 1;
+                }
+            }
+            memmove(rbuf, rbuf + off, rlen - off);
+            rlen -= off;
+        }
+    }
+
+    // -------------------- 统计 --------------------
+    printf("sent %.1f MB of bulk data; %d PINGs, %d PONGs\n",
+           (double)data_started * PF_DATA_MAX / (1024 * 1024), pings, nrtt);
+    if(nrtt > 0)
+    {
+        qsort(rtts, nrtt, sizeof(rtts[0]), cmp_u64);
+        printf("control RTT: min %.3f ms, p50 %.3f ms, p99 %.3f ms, max %.3f ms\n",
+               rtts[0] / 1e6, rtts[nrtt / 2] / 1e6, rtts[(int)(nrtt * 0.99)] / 1e6, rtts[nrtt - 1] / 1e6);
+    }
+    if(acked)
+        printf("CANCEL acknowledged after %.3f ms, receiver dropped %.1f MB of queued data\n",
+               (now_ns() - cancel_at) / 1e6, dropped_remote / (1024.0 * 1024));
+
+    close(tfd);
+    close(epfd);
+    close(sock);
+    return 0;
+}
+
+/* 控制帧入队 */
+void queue_ctrl(int cmd, uint64_t id)
+{
+    ctrl_entry* e;
+
+    if((ctrl_tail + 1) % CTRL_Q_MAX == ctrl_head)
+        return;     // 队列满：丢弃这个控制帧
+    e = &ctrl_q[ctrl_tail];
+    e->f.type = PF_CTRL;
+    e->f.cmd = (uint8_t)cmd;
+    e->f.len = 0;
+    e->f.id = id;
+    e->after_data = data_total;
+    ctrl_tail = (ctrl_tail + 1) % CTRL_Q_MAX;
+}
+
+/*
+ * 尽量多地写出帧，直到内核不再接受（EAGAIN）或没有待发送的帧。
+ * 每写完一帧才选择下一帧：控制帧优先；fifo 模式下控制帧要等排在它前面的数据帧都开始发送
+ */
+int flush_frames(int sock)
+{
+    struct iovec iov[2];
+    pri_frame f;
+    ssize_t n;
+
+    while(1)
+    {
+        if(!have_cur)
+        {
+            if(ctrl_head != ctrl_tail && (!fifo || data_started >= ctrl_q[ctrl_head].after_data))
+            {
+                f = ctrl_q[ctrl_head].f;
+                ctrl_head = (ctrl_head + 1) % CTRL_Q_MAX;
+            }
+            else if(data_started < data_total)
+            {
+                f.type = PF_DATA;
+                f.cmd = 0;
+                f.len = PF_DATA_MAX;
+                f.id = data_started++;
+            }
+            else
+                return 0;
+            pf_put(cur_hdr, &f);
+            cur_len = PF_HDR_SIZE + f.len;
+            cur_off = 0;
+            have_cur = 1;
+        }
+
+        // 帧头与载荷用一次 writev 写出，从上次中断的位置继续
+        if(cur_off < PF_HDR_SIZE)
+        {
+            iov[0].iov_base = cur_hdr + cur_off;
+            iov[0].iov_len = PF_HDR_SIZE - cur_off;
+            iov[1].iov_base = zeros;
+            iov[1].iov_len = cur_len - PF_HDR_SIZE;
+            n = writev(sock, iov, 2);
+        }
+        else
+            n = write(sock, zeros, cur_len - cur_off);
+        if(n == -1)
+            return (errno == EAGAIN || errno == EWOULDBLOCK) ? 0 : -1;
+        cur_off += n;
+        if(cur_off == cur_len)
+            have_cur = 0;
+    }
+}
+
+int cmp_u64(const void* a, const void* b)
+{
+    uint64_t x = *(const uint64_t*)a, y = *(const uint64_t*)b;
+
+    return x < y ? -1 : x > y;
+}
+
+uint64_t now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+void error_handling(char *message)
+{
+    fputs(message, stderr);
+    fputc('\n', stderr);
+    exit(1);
+}
@@ -0,0 +1,479 @@
+#include <stdio.h>      // 标准输入输出：printf / fputs / snprintf 等
+#include <stdlib.h>     // 标准库：exit / atoi / malloc 等
+#include <string.h>     // 字符串/内存操作：memset / memcmp / strchr / strstr 等
+#include <unistd.h>     // POSIX：read / write / close 等
+#include <errno.h>      // errno / EAGAIN
+#include <time.h>       // time：未识别连接的超时
+#include <pthread.h>    // pthread_create：每个已识别的连接交给一个处理线程
+#include <arpa/inet.h>  // 网络字节序转换：htonl / htons 等
+#include <sys/socket.h> // 套接字 API：socket / bind / listen / accept / recv 等，以及 MSG_PEEK 标志
+#include <sys/epoll.h>  // epoll：事件驱动地等待新连接的首批数据
+#include <sys/stat.h>   // fstat：HTTP 响应的 Content-length
+#include <fcntl.h>      // open
+#include "bufchain.h"   // readv / writev 缓冲链
+
+/*
+ * 单端口多协议前端：用 MSG_PEEK 识别协议
+ *
+ * peek_recv.c 用 recv(..., MSG_PEEK|MSG_DONTWAIT) 忙等，只为演示"偷看"输入缓冲。
+ * 这里把它用在实际问题上：所有服务共用一个端口、一个 accept 队列，
+ * 新连接的首批数据到达后，用 MSG_PEEK 查看开头几个字节判断协议：
+ *   - HTTP：以 "GET " / "HEAD " / "POST " 等方法名开头（ch24 webserv_linux）
+ *   - 聊天：以 '[' 开头，即 ch18 chat_clnt 发送的 "[name] msg"
+ *   - 计算器：第一个字节是操作数个数 cnt（1~31），即 ch05 op_client。单凭这个字节不可靠（以 '\t' 开头的
+ *     回声数据也落在这个范围），所以还要检查帧长：op_client 一次写出 1 + 4*cnt + 1 字节后就等待结果，
+ *     输入缓冲中恰好是这么多字节、且最后一个字节是运算符时才认为是计算器
+ *   - 其余都当作回声协议（ch04/ch05 echo_client）
+ * MSG_PEEK 不会把数据从输入缓冲中取走，识别出协议后直接把套接字交给对应的处理函数，
+ * 处理函数从头读到的仍是完整的请求，不需要把已经看过的字节复制给它。
+ *
+ * 事件驱动，没有忙等：待识别的连接以边缘触发（EPOLLET）注册到 epoll。
+ * 如果数据还不够判断（例如只到了 "GE"），MSG_PEEK 之后数据仍留在缓冲区中，
+ * 条件触发会让 epoll_wait 立即再次返回；边缘触发则要等新数据到达才会再通知。
+ * 识别后把套接字从 epoll 中移除，交给新线程处理。像计算器请求但帧还不完整的连接，CALC_WAIT 秒内
+ * 没有补齐就当作回声。交互式客户端（chat_clnt、echo_client）连上后要等用户输入才发数据，
+ * SNIFF_TIMEOUT 秒内什么都没发的连接按 DEFAULT_PROTO（聊天）处理：还没发言的聊天成员也要能收到广播，
+ * 回声客户端被当作聊天成员时，自己发出的消息同样会被发回来。发来了数据却仍无法识别的连接直接关闭。
+ * 待识别的连接另外记在一个列表中，超时检查只遍历这些连接，每秒一次。
+ *
+ * 回声、聊天、HTTP 的处理函数使用 bufchain（readv / writev 缓冲链）收发数据，
+ * 数据从套接字或文件直接读入池化的数据块，再直接从数据块写出，中间没有 memcpy。
+ * 带 zerocopy 参数时，回声和 HTTP 的大块发送改用 MSG_ZEROCOPY（见 bufchain.h 的 bc_zc_*），
+ * 连写进内核 skb 的那一次复制也省掉。
+ *
+ * 用法：sniff_server <port> [zerocopy]
+ */
+
+#define EPOLL_SIZE 64
+#define MAX_FD 4096
+#define PEEK_SIZE 128           // 识别协议所需的最多字节数（最长的计算器请求为 1 + 4*31 + 1 字节）
+#define SNIFF_TIMEOUT 5         // 连接建立后多少秒内没有发来数据就按 DEFAULT_PROTO 处理
+#define DEFAULT_PROTO PROTO_CHAT
+#define CALC_WAIT 1             // 不完整的计算器帧最多等待多少秒，之后按回声处理
+#define HTTP_HDR_MAX 1024       // HTTP 请求头的最大长度
+#define HTTP_READ_CHUNKS 16     // 每次从文件读入的数据块数
+#define ECHO_READ_CHUNKS 16     // 64KB：一次读得够多，才能达到零拷贝发送的门槛
+#define MAX_CHAT 256
+#define OPSZ 4                  // 计算器协议：每个操作数 4 字节（与 ch05 op_client 相同）
+
+enum { PROTO_UNKNOWN = 0, PROTO_HTTP, PROTO_CHAT, PROTO_CALC, PROTO_ECHO };
+
+static const char* proto_name[] = { "unknown", "http", "chat", "calc", "echo" };
+static time_t pending_since[MAX_FD];    // 待识别连接的建立时间，0 表示不在等待识别
+static int pending_fds[MAX_FD];         // 待识别的连接，删除时用最后一个填补空位
+static int pending_pos[MAX_FD];         // 每个待识别连接在 pending_fds 中的位置
+static int pending_cnt = 0;
+
+static pthread_mutex_t chat_mutex = PTHREAD_MUTEX_INITIALIZER;
+static int chat_socks[MAX_CHAT];
+static int chat_cnt = 0;
+static int zerocopy = 0;                // 回声 / HTTP 是否使用 MSG_ZEROCOPY 发送
+
+int classify(const unsigned char* p, int n, int final);
+void dispatch(int epfd, int fd, int proto);
+void pending_add(int fd);
+void pending_del(int fd);
+void* handle_http(void* arg);
+void* handle_chat(void* arg);
+void* handle_calc(void* arg);
+void* handle_echo(void* arg);
+int read_full(int fd, void* buf, int len);
+ssize_t send_chain(bufchain* c, int fd, bc_zc* z);
+void zc_finish(bc_zc* z, int fd);
+void error_handling(char *message);
+
+int main(int argc, char* argv[])
+{
+    int serv_sock, clnt_sock, epfd, event_cnt, i, fd, n, proto, final, option = 1;
+    time_t last_scan = 0;
+    struct sockaddr_in serv_addr, clnt_addr;
+    socklen_t clnt_addr_sz;
+    struct epoll_event event, ep_events[EPOLL_SIZE];
+    unsigned char peek[PEEK_SIZE];
+    time_t now;
+
+    if(argc != 2 && argc != 3)
+    {
+        printf("Usage: %s <port> [zerocopy]\n", argv[0]);
+        exit(1);
+    }
+    if(argc == 3 && strcmp(argv[2], "zerocopy") == 0)
+        zerocopy = 1;
+
+    serv_sock = socket(PF_INET, SOCK_STREAM, 0);
+    if(serv_sock == -1)
+        error_handling("socket() error");
+    setsockopt(serv_sock, SOL_SOCKET, SO_REUSEADDR, &option, sizeof(option));
+    memset(&serv_addr, 0, sizeof(serv_addr));
+    serv_addr.sin_family = AF_INET;
+    serv_addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    serv_addr.sin_port = htons(atoi(argv[1]));
+    if(bind(serv_sock, (struct sockaddr*)&serv_addr, sizeof(serv_addr)) == -1)
+        error_handling("bind() error");
+    if(listen(serv_sock, 128) == -1)
+        error_handling("listen() error");
+
+    epfd = epoll_create(EPOLL_SIZE);
+    event.events = EPOLLIN;
+    event.data.fd = serv_sock;
+    epoll_ctl(epfd, EPOLL_CTL_ADD, serv_sock, &event);
+
+    while(1)
+    {
+        // 超时 1 秒：顺便清理长时间无法识别的连接
+        event_cnt = epoll_wait(epfd, ep_events, EPOLL_SIZE, 1000);
+        if(event_cnt == -1 && errno != EINTR)
+            error_handling("epoll_wait() error");
+
+        for(i = 0; i < event_cnt; i++)
+        {
+            fd = ep_events[i].data.fd;
+            if(fd == serv_sock)
+            {
+                clnt_addr_sz = sizeof(clnt_addr);
+                clnt_sock = accept(serv_sock, (struct sockaddr*)&clnt_addr, &clnt_addr_sz);
+                if(clnt_sock == -1)
+                    continue;
+                if(clnt_sock >= MAX_FD)
+                {
+                    close(clnt_sock);
+                    continue;
+                }
+                // 边缘触发：只有新数据到达才会再次通知，数据不够识别时不会空转
+                event.events = EPOLLIN | EPOLLET | EPOLLRDHUP;
+                event.data.fd = clnt_sock;
+                epoll_ctl(epfd, EPOLL_CTL_ADD, clnt_sock, &event);
+                pending_add(clnt_sock);
+                continue;
+            }
+
+            // 偷看输入缓冲的开头，数据仍留在缓冲区中
+            n = recv(fd, peek, PEEK_SIZE, MSG_PEEK | MSG_DONTWAIT);
+            if(n == -1 && (errno == EAGAIN || errno == EWOULDBLOCK))
+                continue;
+            // 对端已关闭或缓冲区已满时不会再有更多数据，必须现在做出判断
+            final = n <= 0 || n == PEEK_SIZE || (ep_events[i].events & EPOLLRDHUP);
+            proto = n > 0 ? classify(peek, n, final) : PROTO_UNKNOWN;
+            if(proto == PROTO_UNKNOWN && !final)
+                continue;   // 数据不够判断：等下一批数据到达
+            dispatch(epfd, fd, proto);
+        }
+
+        // -------------------- 处理等待过久的连接（每秒检查一次） --------------------
+        now = time(NULL);
+        if(now == last_scan)
+            continue;
+        last_scan = now;
+        // 倒序遍历：dispatch 删除当前元素时，填补进来的是已经检查过的最后一个
+        for(i = pending_cnt - 1; i >= 0; i--)
+        {
+            fd = pending_fds[i];
+            if(now - pending_since[fd] <= CALC_WAIT)
+                continue;
+            // 边缘触发不会为已有的数据再次通知：不完整的计算器帧在这里按回声处理
+            n = recv(fd, peek, PEEK_SIZE, MSG_PEEK | MSG_DONTWAIT);
+            if(n == -1 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            {
+                // 一直没有数据：交互式客户端还在等用户输入
+                if(now - pending_since[fd] > SNIFF_TIMEOUT)
+                    dispatch(epfd, fd, DEFAULT_PROTO);
+                continue;
+            }
+            proto = n > 0 ? classify(peek, n, 1) : PROTO_UNKNOWN;
+            if(proto != PROTO_UNKNOWN || n <= 0 || now - pending_since[fd] > SNIFF_TIMEOUT)
+                dispatch(epfd, fd, proto);
+        }
+    }
+
+    close(epfd);
+    close(serv_sock);
+    return 0;
+}
+
+/*
+ * 根据开头的 n 个字节判断协议；数据不够判断时返回 PROTO_UNKNOWN。
+ * final 为真表示不会再有更多数据（对端已关闭、缓冲区已满或等待超时），不完整的计算器帧按回声处理
+ */
+int classify(const unsigned char* p, int n, int final)
+{
+    static const char* methods[] = { "GET ", "HEAD ", "POST ", "PUT ", "DELETE ", "OPTIONS " };
+    int i, len, frame;
+
+    if(p[0] >= 1 && p[0] < 32)
+    {
+        // 计算器请求：1 字节个数 + 4*cnt 字节操作数 + 1 字节运算符，客户端发完整个请求后等待结果
+        frame = 1 + OPSZ * p[0] + 1;
+        if(n == frame && (p[n - 1] == '+' || p[n - 1] == '-' || p[n - 1] == '*'))
+            return PROTO_CALC;
+        if(n < frame && !final)
+            return PROTO_UNKNOWN;
+        return PROTO_ECHO;
+    }
+    if(p[0] == '[')
+        return PROTO_CHAT;
+
+    for(i = 0; i < (int)(sizeof(methods) / sizeof(methods[0])); i++)
+    {
+        len = strlen(methods[i]);
+        if(memcmp(p, methods[i], n < len ? n : len) == 0)
+        {
+            if(n >= len)
+                return PROTO_HTTP;
+            return PROTO_UNKNOWN;   // 可能是 HTTP 方法名的前缀：再等一些数据
+        }
+    }
+    return PROTO_ECHO;
+}
+
+/* 识别完成：从 epoll 中移除，交给对应的处理线程；无法识别的连接直接关闭 */
+void dispatch(int epfd, int fd, int proto)
+{
+    static void* (*handlers[])(void*) = { NULL, handle_http, handle_chat, handle_calc, handle_echo };
+    pthread_t t_id;
+
+    epoll_ctl(epfd, EPOLL_CTL_DEL, fd, NULL);
+    pending_del(fd);
+    if(proto == PROTO_UNKNOWN)
+    {
+        close(fd);  // 对端已关闭，或 PEEK_SIZE 字节仍无法识别
+        return;
+    }
+    printf("fd %d: %s\n", fd, proto_name[proto]);
+    fflush(stdout);
+    // 把描述符本身交给处理线程（值传递，不存在传栈变量地址的问题）
+    if(pthread_create(&t_id, NULL, handlers[proto], (void*)(long)fd) != 0)
+        close(fd);
+    else
+        pthread_detach(t_id);
+}
+
+/* 登记 / 注销一个待识别的连接 */
+void pending_add(int fd)
+{
+    pending_since[fd] = time(NULL);
+    pending_pos[fd] = pending_cnt;
+    pending_fds[pending_cnt++] = fd;
+}
+
+void pending_del(int fd)
+{
+    int last;
+
+    if(pending_since[fd] == 0)
+        return;
+    last = pending_fds[--pending_cnt];
+    pending_fds[pending_pos[fd]] = last;
+    pending_pos[last] = pending_pos[fd];
+    pending_since[fd] = 0;
+}
+
+/* -------------------- HTTP：只支持 GET，返回当前目录下的文件（同 ch24 webserv_linux） -------------------- */
+void* handle_http(void* arg)
+{
+    int fd = (int)(long)arg, file = -1, len;
+    char req[HTTP_HDR_MAX + 1], hdr[256], path[256], *p, *end;
+    bufchain in, out;
+    bc_zc* z;
+    struct stat st;
+    size_t n;
+
+    // 请求读入缓冲链，直到出现请求头结束的空行
+    bc_init(&in);
+    bc_init(&out);
+    n = 0;
+    while(in.len < HTTP_HDR_MAX && bc_readv(&in, fd, 1) > 0)
+    {
+        n = bc_copyout(&in, 0, req, HTTP_HDR_MAX);
+        req[n] = 0;
+        if(strstr(req, "\r\n\r\n") != NULL || strstr(req, "\n\n") != NULL)
+            break;
+    }
+    req[n] = 0;
+    bc_clear(&in);
+
+    if(strncmp(req, "GET /", 5) == 0)
+    {
+        p = req + 5;
+        end = strchr(p, ' ');
+        if(end != NULL && end - p < (int)sizeof(path) && end > p && memchr(p, '/', end - p) == NULL)
+        {
+            memcpy(path, p, end - p);
+            path[end - p] = 0;
+            file = open(path, O_RDONLY);
+        }
+    }
+    if(file == -1 || fstat(file, &st) == -1 || !S_ISREG(st.st_mode))
+    {
+        len = snprintf(hdr, sizeof(hdr), "HTTP/1.0 400 Bad Request\r\nServer:Linux Web Server \r\n"
+                       "Content-length:0\r\n\r\n");
+        write(fd, hdr, len);
+        if(file != -1)
+            close(file);
+        close(fd);
+        return NULL;
+    }
+
+    // 文件内容直接 readv 进数据块，响应头插到链首，与第一批文件内容一起 writev 出去
+    bc_readv(&out, file, HTTP_READ_CHUNKS);
+    len = snprintf(hdr, sizeof(hdr), "HTTP/1.0 200 OK\r\nServer:Linux Web Server \r\n"
+                   "Content-length:%lld\r\nContent-type:%s\r\n\r\n", (long long)st.st_size,
+                   strstr(path, ".htm") != NULL ? "text/html" : "text/plain");
+    bc_prepend(&out, hdr, len);
+    z = zerocopy ? bc_zc_open(fd) : NULL;
+    while(out.len > 0)
+    {
+        if(send_chain(&out, fd, z) <= 0)
+            break;
+        if(out.len < BC_CHUNK_SIZE)
+            bc_readv(&out, file, HTTP_READ_CHUNKS);
+    }
+    bc_clear(&out);
+    close(file);
+    zc_finish(z, fd);
+    close(fd);
+    return NULL;
+}
+
+/*
+ * -------------------- 聊天：把收到的消息转发给所有聊天客户端（同 ch18 chat_serv） --------------------
+ * 消息只读入一次；发给每个客户端时只是引用同一批数据块，不复制
+ */
+void* handle_chat(void* arg)
+{
+    int fd = (int)(long)arg, i;
+    bufchain in, out;
+
+    pthread_mutex_lock(&chat_mutex);
+    if(chat_cnt == MAX_CHAT)
+    {
+        pthread_mutex_unlock(&chat_mutex);
+        close(fd);
+        return NULL;
+    }
+    chat_socks[chat_cnt++] = fd;
+    pthread_mutex_unlock(&chat_mutex);
+
+    bc_init(&in);
+    bc_init(&out);
+    while(bc_readv(&in, fd, 1) > 0)
+    {
+        pthread_mutex_lock(&chat_mutex);
+        for(i = 0; i < chat_cnt; i++)
+        {
+            bc_append_ref(&out, &in, 0, in.len);
+            while(out.len > 0 && bc_writev(&out, chat_socks[i]) > 0)
+                ;
+            bc_clear(&out);
+        }
+        pthread_mutex_unlock(&chat_mutex);
+        bc_consume(&in, in.len);
+    }
+    bc_clear(&in);
+
+    pthread_mutex_lock(&chat_mutex);
+    for(i = 0; i < chat_cnt; i++)
+    {
+        if(chat_socks[i] == fd)
+        {
+            chat_socks[i] = chat_socks[--chat_cnt];
+            break;
+        }
+    }
+    pthread_mutex_unlock(&chat_mutex);
+    close(fd);
+    return NULL;
+}
+
+/* -------------------- 计算器：[1 操作数个数][4 × 个数 操作数][1 运算符]（同 ch05 op_server） -------------------- */
+void* handle_calc(void* arg)
+{
+    int fd = (int)(long)arg, opnds[32], result, i;
+    unsigned char cnt;
+    char op;
+
+    if(read_full(fd, &cnt, 1) == 0 && cnt < 32
+       && read_full(fd, opnds, cnt * OPSZ) == 0 && read_full(fd, &op, 1) == 0)
+    {
+        result = cnt > 0 ? opnds[0] : 0;
+        for(i = 1; i < cnt; i++)
+        {
+            if(op == '+')
+                result += opnds[i];
+            else if(op == '-')
+                result -= opnds[i];
+            else if(op == '*')
+                result *= opnds[i];
+        }
+        write(fd, &result, sizeof(result));
+    }
+    close(fd);
+    return NULL;
+}
+
+/* -------------------- 回声：readv 进池化数据块，原样 writev 回去，不经过中间缓冲区 -------------------- */
+void* handle_echo(void* arg)
+{
+    int fd = (int)(long)arg;
+    bufchain c;
+    bc_zc* z = zerocopy ? bc_zc_open(fd) : NULL;
+
+    bc_init(&c);
+    while(bc_readv(&c, fd, ECHO_READ_CHUNKS) > 0)
+    {
+        while(c.len > 0 && send_chain(&c, fd, z) > 0)
+            ;
+    }
+    bc_clear(&c);
+    zc_finish(z, fd);
+    close(fd);
+    return NULL;
+}
+
+/* 写出缓冲链：开启了零拷贝时走 bc_writev_zc，并顺便回收已经完成的发送 */
+ssize_t send_chain(bufchain* c, int fd, bc_zc* z)
+{
+    ssize_t n;
+
+    if(z == NULL)
+        return bc_writev(c, fd);
+    n = bc_writev_zc(c, z);
+    bc_zc_reap(z, 0);
+    return n;
+}
+
+/* 等待零拷贝发送全部完成（必须在 close 之前），打印统计 */
+void zc_finish(bc_zc* z, int fd)
+{
+    bc_zc_stat st;
+
+    if(z == NULL)
+        return;
+    bc_zc_close(z, &st);
+    printf("fd %d: zerocopy sends %lu (kernel copied %lu), copied sends %lu\n",
+           fd, st.zc_sends, st.zc_copied, st.copy_sends);
+    fflush(stdout);
+}
+
+/* 读满 len 字节：成功返回 0 */
+int read_full(int fd, void* buf, int len)
+{
+    char* p = buf;
+    int n;
+
+    while(len > 0)
+    {
+        n = read(fd, p, len);
+        if(n <= 0)
+            return -1;
+        p += n;
+        len -= n;
+    }
+    return 0;
+}
+
+void error_handling(char *message)
+{
+    fputs(message, stderr);
+    fputc('\n', stderr);
+    exit(1);
+}
@@ -0,0 +1,340 @@
+#include <stdlib.h>     // malloc / calloc / free
+#include <string.h>     // memset / memcpy
+#include <immintrin.h>  // SSSE3 / AVX2 内建函数：_mm_shuffle_epi8 / _mm256_shuffle_epi8 等
+#include "fec.h"
+
+/*
+ * fec 的实现，接口说明见 fec.h
+ *
+ * GF(256) 使用本原多项式 x^8 + x^4 + x^3 + x^2 + 1（0x11d），加法即异或。
+ *
+ * 向量化乘法：c * x = c * (x 的低 4 位) ^ c * (x 的高 4 位 << 4)，
+ * 对每个系数 c 预先算好两张 16 项的表，pshufb 以 x 的每个 4 位为下标并行查表，
+ * 一条指令完成 16 个（AVX2 为 32 个）字节的乘法。
+ */
+
+static uint8_t gf_exp[512];         // gf_exp[i] = α^i，长度翻倍省去取模
+static uint8_t gf_log[256];
+static uint8_t gf_mul_tab[256][256];
+static uint8_t gf_lo[256][16];      // gf_lo[c][x] = c * x
+static uint8_t gf_hi[256][16];      // gf_hi[c][x] = c * (x << 4)
+static int gf_ready = 0;
+
+typedef void (*mul_add_fn)(uint8_t* dst, const uint8_t* src, uint8_t c, int len);
+static mul_add_fn mul_add_impl;
+static const char* mul_add_name;
+
+struct fec_code {
+    int k, m;
+    uint8_t* matrix;                // (k + m) × k 编码矩阵：前 k 行为单位矩阵，后 m 行为校验系数
+};
+
+static uint8_t gf_mul(uint8_t a, uint8_t b)
+{
+    if(a == 0 || b == 0)
+        return 0;
+    return gf_exp[gf_log[a] + gf_log[b]];
+}
+
+static uint8_t gf_inv(uint8_t a)
+{
+    return gf_exp[255 - gf_log[a]];
+}
+
+/* -------------------- 区域乘加：dst ^= c * src -------------------- */
+
+static void mul_add_scalar(uint8_t* dst, const uint8_t* src, uint8_t c, int len)
+{
+    const uint8_t* t = gf_mul_tab[c];
+    int i;
+
+    for(i = 0; i < len; i++)
+        dst[i] ^= t[src[i]];
+}
+
+__attribute__((target("ssse3")))
+static void mul_add_ssse3(uint8_t* dst, const uint8_t* src, uint8_t c, int len)
+{
+    __m128i lo = _mm_loadu_si128((const __m128i*)gf_lo[c]);
+    __m128i hi = _mm_loadu_si128((const __m128i*)gf_hi[c]);
+    __m128i mask = _mm_set1_epi8(0x0f);
+    __m128i s, p;
+    int i;
+
+    for(i = 0; i + 16 <= len; i += 16)
+    {
+        s = _mm_loadu_si128((const __m128i*)(src + i));
+        p = _mm_xor_si128(_mm_shuffle_epi8(lo, _mm_and_si128(s, mask)),
+                          _mm_shuffle_epi8(hi, _mm_and_si128(_mm_srli_epi64(s, 4), mask)));
+        _mm_storeu_si128((__m128i*)(dst + i), _mm_xor_si128(_mm_loadu_si128((const __m128i*)(dst + i)), p));
+    }
+    mul_add_scalar(dst + i, src + i, c, len - i);
+}
+
+__attribute__((target("avx2")))
+static void mul_add_avx2(uint8_t* dst, const uint8_t* src, uint8_t c, int len)
+{
+    __m256i lo = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)gf_lo[c]));
+    __m256i hi = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)gf_hi[c]));
+    __m256i mask = _mm256_set1_epi8(0x0f);
+    __m256i s, p;
+    int i;
+
+    for(i = 0; i + 32 <= len; i += 32)
+    {
+        s = _mm256_loadu_si256((const __m256i*)(src + i));
+        p = _mm256_xor_si256(_mm256_shuffle_epi8(lo, _mm256_and_si256(s, mask)),
+                             _mm256_shuffle_epi8(hi, _mm256_and_si256(_mm256_srli_epi64(s, 4), mask)));
+        _mm256_storeu_si256((__m256i*)(dst + i), _mm256_xor_si256(_mm256_loadu_si256((const __m256i*)(dst + i)), p));
+    }
+    mul_add_scalar(dst + i, src + i, c, len - i);
+}
+
+/* c == 1 时只需异或：按 8 字节处理，编译器会进一步向量化 */
+static void xor_region(uint8_t* dst, const uint8_t* src, int len)
+{
+    uint64_t a, b;
+    int i;
+
+    for(i = 0; i + 8 <= len; i += 8)
+    {
+        memcpy(&a, dst + i, 8);
+        memcpy(&b, src + i, 8);
+        a ^= b;
+        memcpy(dst + i, &a, 8);
+    }
+    for(; i < len; i++)
+        dst[i] ^= src[i];
+}
+
+void fec_mul_add(uint8_t* dst, const uint8_t* src, uint8_t c, int len)
+{
+    if(c == 0)
+        return;
+    if(c == 1)
+        xor_region(dst, src, len);
+    else
+        mul_add_impl(dst, src, c, len);
+}
+
+/* -------------------- 初始化 -------------------- */
+
+static void gf_init(void)
+{
+    int i, j, x = 1;
+
+    if(gf_ready)
+        return;
+    for(i = 0; i < 255; i++)
+    {
+        gf_exp[i] = (uint8_t)x;
+        gf_log[x] = (uint8_t)i;
+        x <<= 1;
+        if(x & 0x100)
+            x ^= 0x11d;
+    }
+    for(i = 255; i < 512; i++)
+        gf_exp[i] = gf_exp[i - 255];
+
+    for(i = 0; i < 256; i++)
+    {
+        for(j = 0; j < 256; j++)
+            gf_mul_tab[i][j] = gf_mul((uint8_t)i, (uint8_t)j);
+        for(j = 0; j < 16; j++)
+        {
+            gf_lo[i][j] = gf_mul((uint8_t)i, (uint8_t)j);
+            gf_hi[i][j] = gf_mul((uint8_t)i, (uint8_t)(j << 4));
+        }
+    }
+    if(mul_add_impl == NULL)
+        fec_use_simd(1);        // 默认使用 CPU 支持的最快实现
+    gf_ready = 1;
+}
+
+const char* fec_use_simd(int enable)
+{
+    mul_add_impl = mul_add_scalar;
+    mul_add_name = "scalar";
+    if(enable)
+    {
+        __builtin_cpu_init();
+        if(__builtin_cpu_supports("avx2"))
+        {
+            mul_add_impl = mul_add_avx2;
+            mul_add_name = "avx2";
+        }
+        else if(__builtin_cpu_supports("ssse3"))
+        {
+            mul_add_impl = mul_add_ssse3;
+            mul_add_name = "ssse3";
+        }
+    }
+    return mul_add_name;
+}
+
+/* -------------------- 编码 / 解码 -------------------- */
+
+fec_code* fec_new(int k, int m)
+{
+    fec_code* f;
+    uint8_t* row;
+    int i, j;
+
+    if(k < 1 || m < 1 || k + m > FEC_MAX_BLOCKS)
+        return NULL;
+    gf_init();
+
+    f = malloc(sizeof(fec_code));
+    if(f == NULL)
+        return NULL;
+    f->k = k;
+    f->m = m;
+    f->matrix = calloc((size_t)(k + m) * k, 1);
+    if(f->matrix == NULL)
+    {
+        free(f);
+        return NULL;
+    }
+
+    // 前 k 行：单位矩阵（系统码，数据块原样发送）
+    for(i = 0; i < k; i++)
+        f->matrix[i * k + i] = 1;
+
+    // 后 m 行：Cauchy 矩阵 1 / (x_i + y_j)，x_i = k + i，y_j = j。
+    // Cauchy 矩阵的任意方子阵都可逆，按列乘以非零常数后仍然成立；
+    // 每列除以第一行的元素，使第一行全为 1，于是 m = 1 时校验块恰好是异或
+    for(i = 0; i < m; i++)
+    {
+        row = f->matrix + (size_t)(k + i) * k;
+        for(j = 0; j < k; j++)
+            row[j] = gf_mul(gf_inv((uint8_t)((k + i) ^ j)), (uint8_t)(k ^ j));
+    }
+    return f;
+}
+
+void fec_free(fec_code* f)
+{
+    if(f == NULL)
+        return;
+    free(f->matrix);
+    free(f);
+}
+
+void fec_encode(const fec_code* f, const uint8_t* const* data, uint8_t* const* parity, int len)
+{
+    const uint8_t* row;
+    int i, j;
+
+    for(i = 0; i < f->m; i++)
+    {
+        row = f->matrix + (size_t)(f->k + i) * f->k;
+        memset(parity[i], 0, len);
+        for(j = 0; j < f->k; j++)
+            fec_mul_add(parity[i], data[j], row[j], len);
+    }
+}
+
+/* 在 GF(256) 上求 n × n 矩阵的逆（高斯-约当消元），不可逆返回 -1 */
+static int invert_matrix(uint8_t* a, uint8_t* inv, int n)
+{
+    int i, j, r, piv;
+    uint8_t t, c;
+
+    memset(inv, 0, (size_t)n * n);
+    for(i = 0; i < n; i++)
+        inv[i * n + i] = 1;
+
+    for(i = 0; i < n; i++)
+    {
+        for(piv = i; piv < n && a[piv * n + i] == 0; piv++)
+            ;
+        if(piv == n)
+            return -1;
+        if(piv != i)
+        {
+            for(j = 0; j < n; j++)
+            {
+                t = a[i * n + j]; a[i * n + j] = a[piv * n + j]; a[piv * n + j] = t;
+                t = inv[i * n + j]; inv[i * n + j] = inv[piv * n + j]; inv[piv * n + j] = t;
+            }
+        }
+        c = gf_inv(a[i * n + i]);
+        for(j = 0; j < n; j++)
+        {
+            a[i * n + j] = gf_mul(a[i * n + j], c);
+            inv[i * n + j] = gf_mul(inv[i * n + j], c);
+        }
+        for(r = 0; r < n; r++)
+        {
+            if(r == i || a[r * n + i] == 0)
+                continue;
+            c = a[r * n + i];
+            for(j = 0; j < n; j++)
+            {
+                a[r * n + j] ^= gf_mul(c, a[i * n + j]);
+                inv[r * n + j] ^= gf_mul(c, inv[i * n + j]);
+            }
+        }
+    }
+    return 0;
+}
+
+int fec_decode(const fec_code* f, uint8_t* const* blocks, const int* present, int len)
+{
+    int k = f->k, rows[FEC_MAX_BLOCKS], n = 0, missing = 0, i, j;
+    uint8_t *a, *inv;
+
+    // 选出 k 个已收到的块：优先数据块（对应单位矩阵的行，计算量最小）
+    for(i = 0; i < k + f->m && n < k; i++)
+        if(present[i])
+            rows[n++] = i;
+    if(n < k)
+        return -1;
+    for(i = 0; i < k; i++)
+        if(!present[i])
+            missing++;
+    if(missing == 0)
+        return 0;
+
+    // m = 1 且只丢一个数据块：丢失的块 = 校验块 ^ 其余所有数据块，无需求逆
+    if(f->m == 1)
+    {
+        for(i = 0; present[i]; i++)
+            ;
+        memcpy(blocks[i], blocks[k], len);
+        for(j = 0; j < k; j++)
+            if(j != i)
+                xor_region(blocks[i], blocks[j], len);
+        return 1;
+    }
+
+    // 取所选 k 个块在编码矩阵中的行组成方阵并求逆；
+    // 逆矩阵的第 i 行与所选块做线性组合，就得到第 i 个数据块
+    a = malloc((size_t)k * k);
+    inv = malloc((size_t)k * k);
+    if(a == NULL || inv == NULL)
+    {
+        free(a);
+        free(inv);
+        return -1;
+    }
+    for(i = 0; i < k; i++)
+        memcpy(a + (size_t)i * k, f->matrix + (size_t)rows[i] * k, k);
+    if(invert_matrix(a, inv, k) == -1)
+    {
+        free(a);
+        free(inv);
+        return -1;
+    }
+    for(i = 0; i < k; i++)
+    {
+        if(present[i])
+            continue;
+        memset(blocks[i], 0, len);
+        for(j = 0; j < k; j++)
+            fec_mul_add(blocks[i], blocks[rows[j]], inv[(size_t)i * k + j], len);
+    }
+    free(a);
+    free(inv);
+    return missing;
+}
@@ -0,0 +1,41 @@
+#ifndef FEC_H
+#define FEC_H
+
+#include <stdint.h>     // uint8_t
+
+/*
+ * fec：基于 GF(256) 的 Reed-Solomon 前向纠错（系统码）
+ *
+ * 每 k 个等长的数据块生成 m 个校验块，k + m 个块中任意收到 k 个即可恢复全部数据块。
+ *   - m = 1 时校验块就是所有数据块的异或（XOR），只能恢复一个丢失的块，但计算最便宜
+ *   - 校验矩阵由 Cauchy 矩阵按列缩放得到（第一行全为 1），任意 k 行组成的方阵都可逆
+ *
+ * 核心运算是"dst ^= c * src"（GF(256) 上的乘加）。按 4 位拆分查表，用 SSSE3/AVX2 的
+ * pshufb 指令一次查 16/32 个字节；运行时检测 CPU 支持的指令集，不支持时退回逐字节查表。
+ */
+
+#define FEC_MAX_BLOCKS 255      // k + m 的上限（GF(256) 中互不相同的元素个数所限）
+
+typedef struct fec_code fec_code;
+
+/* 创建 k 个数据块 + m 个校验块的编码器；参数非法返回 NULL */
+fec_code* fec_new(int k, int m);
+void fec_free(fec_code* f);
+
+/* 编码：由 data[0..k-1] 计算 parity[0..m-1]，每块 len 字节 */
+void fec_encode(const fec_code* f, const uint8_t* const* data, uint8_t* const* parity, int len);
+
+/*
+ * 解码：blocks[0..k+m-1] 依次为数据块和校验块，present[i] 非 0 表示第 i 块已收到。
+ * 丢失的数据块会被恢复到 blocks[i] 指向的缓冲区中（缓冲区由调用者提供）。
+ * 成功返回恢复的块数，收到的块不足 k 个返回 -1
+ */
+int fec_decode(const fec_code* f, uint8_t* const* blocks, const int* present, int len);
+
+/* dst ^= c * src（GF(256)），供基准测试直接调用 */
+void fec_mul_add(uint8_t* dst, const uint8_t* src, uint8_t c, int len);
+
+/* 选择实现：0 强制逐字节查表，1 使用 CPU 支持的最快 SIMD 实现；返回当前实现的名称 */
+const char* fec_use_simd(int enable);
+
+#endif
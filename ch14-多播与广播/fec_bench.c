@@ -0,0 +1,140 @@
+#include <stdio.h>      // 标准输入输出：printf / fputs / fputc 等
+#include <stdlib.h>     // 标准库：exit / atoi / atof / malloc / rand 等
+#include <string.h>     // 内存操作：memcmp / memset 等
+#include <stdint.h>     // uint8_t
+#include <time.h>       // clock_gettime：计时
+#include "fec.h"        // GF(256) Reed-Solomon 编解码
+
+/*
+ * FEC 编解码吞吐量基准测试
+ *
+ * 对 k 个数据块 + m 个校验块、每块 block_size 字节的分组：
+ *   - encode：反复计算校验块
+ *   - decode：丢弃前 min(m, k) 个数据块，用剩余的数据块和校验块恢复，并与原始数据比较
+ * 分别用逐字节查表和 SIMD（SSSE3/AVX2 pshufb）实现各运行 seconds 秒，
+ * 输出每秒处理的数据量（按 k 个数据块的字节数计算）。
+ *
+ * 用法：fec_bench [k] [m] [block_size] [seconds]
+ */
+
+#define DEFAULT_K 10
+#define DEFAULT_M 4
+#define DEFAULT_BLOCK 1400
+#define DEFAULT_SECS 1.0
+void run(int k, int m, int block, double secs, int simd);
+double now_secs(void);
+void error_handling(char *message);
+
+int main(int argc, char* argv[])
+{
+    int k = DEFAULT_K, m = DEFAULT_M, block = DEFAULT_BLOCK;
+    double secs = DEFAULT_SECS;
+
+    if(argc > 5)
+    {
+        printf("Usage: %s [k] [m] [block_size] [seconds]\n", argv[0]);
+        exit(1);
+    }
+    if(argc >= 2)
+        k = atoi(argv[1]);
+    if(argc >= 3)
+        m = atoi(argv[2]);
+    if(argc >= 4)
+        block = atoi(argv[3]);
+    if(argc >= 5)
+        secs = atof(argv[4]);
+    if(k < 1 || m < 1 || k + m > FEC_MAX_BLOCKS || block < 1 || secs <= 0)
+        error_handling("invalid k, m, block_size or seconds");
+
+    printf("k=%d data + m=%d parity blocks, %d bytes per block\n", k, m, block);
+    run(k, m, block, secs, 0);
+    run(k, m, block, secs, 1);
+    return 0;
+}
+
+void run(int k, int m, int block, double secs, int simd)
+{
+    fec_code* f;
+    uint8_t **blocks, **orig, *mem;
+    int *present, i, j, lost, errors = 0;
+    unsigned long long iters;
+    double start, elapsed, enc_mbs, dec_mbs;
+    const char* name;
+
+    name = fec_use_simd(simd);
+    f = fec_new(k, m);
+    if(f == NULL)
+        error_handling("fec_new() error");
+
+    // blocks[0..k+m-1]：数据块与校验块；orig：数据块的原始副本，用于校验解码结果
+    mem = malloc((size_t)(2 * k + m) * block);
+    blocks = malloc(sizeof(uint8_t*) * (k + m));
+    orig = malloc(sizeof(uint8_t*) * k);
+    present = malloc(sizeof(int) * (k + m));
+    if(!mem || !blocks || !orig || !present)
+        error_handling("malloc() error");
+    for(i = 0; i < k + m; i++)
+        blocks[i] = mem + (size_t)i * block;
+    for(i = 0; i < k; i++)
+    {
+        orig[i] = mem + (size_t)(k + m + i) * block;
+        for(j = 0; j < block; j++)
+            orig[i][j] = (uint8_t)rand();
+        memcpy(blocks[i], orig[i], block);
+    }
+
+    // -------------------- 编码 --------------------
+    iters = 0;
+    start = now_secs();
+    do
+    {
+        fec_encode(f, (const uint8_t* const*)blocks, blocks + k, block);
+        iters++;
+        elapsed = now_secs() - start;
+    } while(elapsed < secs);
+    enc_mbs = iters * (double)k * block / elapsed / (1024 * 1024);
+
+    // -------------------- 解码：丢弃前 lost 个数据块 --------------------
+    lost = m < k ? m : k;
+    for(i = 0; i < k + m; i++)
+        present[i] = i >= lost;
+    iters = 0;
+    start = now_secs();
+    do
+    {
+        for(i = 0; i < lost; i++)
+            memset(blocks[i], 0, block);
+        if(fec_decode(f, blocks, present, block) != lost)
+            errors++;
+        iters++;
+        elapsed = now_secs() - start;
+    } while(elapsed < secs);
+    dec_mbs = iters * (double)k * block / elapsed / (1024 * 1024);
+    for(i = 0; i < k; i++)
+        if(memcmp(blocks[i], orig[i], block) != 0)
+            errors++;
+
+    printf("%-7s encode %8.1f MB/s, decode (%d lost) %8.1f MB/s, %s\n",
+           name, enc_mbs, lost, dec_mbs, errors ? "VERIFY FAILED" : "verified");
+
+    free(present);
+    free(orig);
+    free(blocks);
+    free(mem);
+    fec_free(f);
+}
+
+double now_secs(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+void error_handling(char *message)
+{
+    fputs(message, stderr);
+    fputc('\n', stderr);
+    exit(1);
+}
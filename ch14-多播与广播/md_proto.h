@@ -0,0 +1,146 @@
+#ifndef MD_PROTO_H
+#define MD_PROTO_H
+
+#include <stdint.h>     // uint8_t / uint16_t / uint64_t
+#include <string.h>     // memcpy
+#include <endian.h>     // htobe16 / htobe64 / be16toh / be64toh
+
+/*
+ * 行情（market data）风格的组播数据包格式
+ *
+ * 每个数据包长度固定，由 24 字节包头和定长的报价载荷组成（网络字节序）：
+ *   [2 魔数][1 版本][1 标志][2 频道号][2 载荷长度][8 序号][8 发送时间（纳秒，CLOCK_REALTIME）]
+ *   [4 证券代码][4 数量][8 价格（万分之一）][填充……]
+ *
+ * 频道：发送端把数据分成多个频道，频道 i 发往 <组播地址>:<端口+i>，每个频道有独立递增的序号（从 1 开始），
+ * 接收端据此检测丢包、乱序和重复，只关心部分频道的接收端只需加入对应端口。
+ */
+
+#define MD_MAGIC 0x4d44         // "MD"
+#define MD_VERSION 1
+#define MD_HDR_SIZE 24
+#define MD_QUOTE_SIZE 16
+#define MD_MIN_PKT (MD_HDR_SIZE + MD_QUOTE_SIZE)
+#define MD_MAX_PKT 1400         // 不超过以太网 MTU，避免 IP 分片
+#define MD_MAX_CHANNELS 64
+
+/* 包头标志 */
+#define MD_FLAG_RETX 1          // 由重传服务器单播补发的数据包
+#define MD_FLAG_UNAVAIL 2       // 重传服务器已不再保存这些序号：seq 为第一个，载荷为 8 字节的个数
+#define MD_FLAG_HEARTBEAT 4     // 心跳：不携带数据，seq 为该频道最近发布的序号，让接收端发现末尾的丢包
+
+/*
+ * 重传请求（NACK，接收端单播给重传服务器，16 字节）：
+ *   [2 魔数][2 频道号][4 个数][8 起始序号]
+ * 服务器把 [起始序号, 起始序号 + 个数) 中仍保存着的包单播回请求方
+ */
+#define MD_NACK_MAGIC 0x4e4b    // "NK"
+#define MD_NACK_SIZE 16
+#define MD_NACK_MAX 1024        // 一个 NACK 最多请求的包数
+
+typedef struct {
+    uint16_t magic;
+    uint8_t version;
+    uint8_t flags;
+    uint16_t channel;
+    uint16_t len;               // 包头之后的字节数
+    uint64_t seq;
+    uint64_t send_ns;
+} md_hdr;
+
+typedef struct {
+    uint32_t instrument;
+    uint32_t qty;
+    int64_t price;
+} md_quote;
+
+typedef struct {
+    uint16_t channel;
+    uint32_t count;
+    uint64_t first;
+} md_nack;
+
+static inline void md_put_hdr(uint8_t* p, const md_hdr* h)
+{
+    uint16_t v16;
+    uint64_t v64;
+
+    v16 = htobe16(h->magic);    memcpy(p, &v16, 2);
+    p[2] = h->version;
+    p[3] = h->flags;
+    v16 = htobe16(h->channel);  memcpy(p + 4, &v16, 2);
+    v16 = htobe16(h->len);      memcpy(p + 6, &v16, 2);
+    v64 = htobe64(h->seq);      memcpy(p + 8, &v64, 8);
+    v64 = htobe64(h->send_ns);  memcpy(p + 16, &v64, 8);
+}
+
+/* 解析包头：长度不足或魔数/版本不符返回 -1 */
+static inline int md_get_hdr(const uint8_t* p, int len, md_hdr* h)
+{
+    uint16_t v16;
+    uint64_t v64;
+
+    if(len < MD_HDR_SIZE)
+        return -1;
+    memcpy(&v16, p, 2);      h->magic = be16toh(v16);
+    h->version = p[2];
+    h->flags = p[3];
+    memcpy(&v16, p + 4, 2);  h->channel = be16toh(v16);
+    memcpy(&v16, p + 6, 2);  h->len = be16toh(v16);
+    memcpy(&v64, p + 8, 8);  h->seq = be64toh(v64);
+    memcpy(&v64, p + 16, 8); h->send_ns = be64toh(v64);
+    if(h->magic != MD_MAGIC || h->version != MD_VERSION || MD_HDR_SIZE + h->len > len)
+        return -1;
+    return 0;
+}
+
+static inline void md_put_quote(uint8_t* p, const md_quote* q)
+{
+    uint32_t v32;
+    uint64_t v64;
+
+    v32 = htobe32(q->instrument);       memcpy(p, &v32, 4);
+    v32 = htobe32(q->qty);              memcpy(p + 4, &v32, 4);
+    v64 = htobe64((uint64_t)q->price);  memcpy(p + 8, &v64, 8);
+}
+
+static inline void md_get_quote(const uint8_t* p, md_quote* q)
+{
+    uint32_t v32;
+    uint64_t v64;
+
+    memcpy(&v32, p, 4);      q->instrument = be32toh(v32);
+    memcpy(&v32, p + 4, 4);  q->qty = be32toh(v32);
+    memcpy(&v64, p + 8, 8);  q->price = (int64_t)be64toh(v64);
+}
+
+static inline void md_put_nack(uint8_t* p, const md_nack* n)
+{
+    uint16_t v16;
+    uint32_t v32;
+    uint64_t v64;
+
+    v16 = htobe16(MD_NACK_MAGIC);   memcpy(p, &v16, 2);
+    v16 = htobe16(n->channel);      memcpy(p + 2, &v16, 2);
+    v32 = htobe32(n->count);        memcpy(p + 4, &v32, 4);
+    v64 = htobe64(n->first);        memcpy(p + 8, &v64, 8);
+}
+
+static inline int md_get_nack(const uint8_t* p, int len, md_nack* n)
+{
+    uint16_t v16;
+    uint32_t v32;
+    uint64_t v64;
+
+    if(len < MD_NACK_SIZE)
+        return -1;
+    memcpy(&v16, p, 2);
+    if(be16toh(v16) != MD_NACK_MAGIC)
+        return -1;
+    memcpy(&v16, p + 2, 2);  n->channel = be16toh(v16);
+    memcpy(&v32, p + 4, 4);  n->count = be32toh(v32);
+    memcpy(&v64, p + 8, 8);  n->first = be64toh(v64);
+    return 0;
+}
+
+#endif
@@ -0,0 +1,464 @@
+#define _GNU_SOURCE             // sendmmsg / struct mmsghdr 是 GNU 扩展
+#include <stdio.h>      // 标准输入输出：printf / fputs / fputc 等
+#include <stdlib.h>     // 标准库：exit / atoi / atof 等
+#include <string.h>     // 内存操作：memset 等
+#include <stdint.h>     // uint8_t / uint64_t
+#include <unistd.h>     // POSIX：close 等
+#include <errno.h>      // errno / ENOBUFS / EAGAIN
+#include <time.h>       // clock_gettime / nanosleep
+#include <pthread.h>    // 重传服务线程
+#include <arpa/inet.h>  // 网络地址与字节序：inet_addr / htons 等
+#include <sys/socket.h> // 套接字 API：socket / setsockopt / sendmmsg 等
+#include "md_proto.h"   // 行情数据包格式
+
+/*
+ * 高速率组播行情发布端
+ *
+ * news_sender.c 逐行读取文件、每个数据报之后 sleep(2)，每秒只能发出半个数据报。
+ * 本示例模拟行情发布：
+ *   - 定长二进制数据包，带频道号、每频道独立递增的序号和发送时间戳（格式见 md_proto.h）
+ *   - 令牌桶限速：令牌按 rate 个/秒匀速累积，攒满 batch 个才发一批；速率低、攒满要很久时，
+ *     最早的令牌等待 MAX_DELAY_US 微秒后有几个发几个，包的额外延迟不超过这个上限。
+ *     发送节奏完全由时钟计算得出，而不是靠 sleep 的时长，因此 sleep 的误差、系统调用的耗时都不会累积成速率偏差
+ *   - sendmmsg 批量发送：一次系统调用发出一批数据包，每个包可以发往不同频道（目的端口）
+ *   - 多频道：频道 i 发往 <GroupIP>:<PORT+i>，包按轮转方式分配到各频道
+ *   - 重传服务（可选，指定 retx_port 时启用）：每个频道最近 RING_SLOTS 个包保存在内存环形缓冲区中，
+ *     独立线程在 retx_port 上接收接收端的 NACK，把请求的包单播补发给该接收端；
+ *     已被覆盖的序号回复 MD_FLAG_UNAVAIL，接收端据此放弃等待。
+ *     所有接收端共享同一份组播流，只有丢了包的接收端才产生额外流量，没有 TCP 那样每个订阅者一条连接的开销
+ *   - 心跳：频道空闲超过 HEARTBEAT_MS 毫秒时发送心跳（带该频道最后的序号），发布结束后最后的心跳重复
+ *     FINAL_HEARTBEATS 次。一批包的末尾丢失时后面没有数据包可以暴露缺口，接收端靠心跳发现并 NACK
+ *
+ * 用法：md_publisher <GroupIP> <PORT> <rate_pps> <seconds> [channels] [pkt_size] [batch] [retx_port]
+ */
+
+#define TTL 64                  // 组播 TTL
+#define DEFAULT_CHANNELS 1
+#define DEFAULT_PKT_SIZE 64     // 默认包长：24 字节包头 + 16 字节报价 + 填充
+#define DEFAULT_BATCH 32        // 默认每次 sendmmsg 最多发送的包数
+#define MAX_BATCH 1024
+#define SPIN_NS 200000          // 距离下一次发送不足 200us 时忙等，否则先睡一会儿再重新计算
+#define MAX_DELAY_US 1000       // 攒批时一个包最多等待的时间
+#define MAX_BURST_MS 10         // 令牌桶容量（至少两批）：进程被调度走或 sleep 超时这么久，令牌也不丢失
+#define RING_SLOTS 65536        // 每个频道保存的最近包数（2 的幂）
+#define RETX_BATCH 64           // 重传线程每次 sendmmsg 最多补发的包数
+#define LINGER_SECS 2           // 发布结束后重传服务继续运行的时间，处理迟到的 NACK
+#define HEARTBEAT_MS 100        // 频道空闲多久发送一次心跳
+#define FINAL_HEARTBEATS 5      // 结束时最后的心跳重复发送的次数（间隔 HEARTBEAT_MS），单个心跳也可能丢失
+void* retx_server(void* arg);
+void send_heartbeats(int sock, struct sockaddr_in* ch_addr, uint64_t* ch_seq, uint64_t* ch_last,
+                     int channels, uint64_t now, uint64_t idle_ns);
+void error_handling(char* message);
+uint64_t now_ns(clockid_t clk);
+
+/* 重传环形缓冲区：频道 ch 的序号 seq 存放在槽位 ch * RING_SLOTS + (seq % RING_SLOTS) */
+typedef struct {
+    int sock;                   // 重传服务套接字
+    int channels, pkt_size;
+    uint8_t* data;              // channels * RING_SLOTS 个包
+    uint64_t* seq;              // 每个槽位当前保存的序号（0 表示空）
+    pthread_mutex_t mutex;      // 发布线程写入、重传线程读取
+    unsigned long long nacks, resent, unavail;
+} retx_ring;
+
+static retx_ring ring;
+
+int main(int argc, char* argv[])
+{
+    int send_sock;
+    int time_live = TTL;
+    int channels = DEFAULT_CHANNELS, pkt_size = DEFAULT_PKT_SIZE, batch = DEFAULT_BATCH, seconds;
+    double rate, tokens = 0, capacity;
+    static struct sockaddr_in ch_addr[MD_MAX_CHANNELS];
+    static uint64_t ch_seq[MD_MAX_CHANNELS];
+    static uint64_t ch_last[MD_MAX_CHANNELS];     // 每个频道最后一次发送（数据包或心跳）的时间
+    static struct mmsghdr msgs[MAX_BATCH];
+    static struct iovec iovs[MAX_BATCH];
+    static uint8_t bufs[MAX_BATCH][MD_MAX_PKT];
+    md_hdr hdr;
+    md_quote quote;
+    struct timespec ts;
+    uint64_t start, end, last, now, sec_start, wait_ns, hb_check, ready = 0;
+    unsigned long long sent = 0, calls = 0, dropped = 0, sec_sent = 0, sec_calls = 0;
+    int i, n, ch = 0, ret, retx_port = 0;
+    size_t slot;
+    struct sockaddr_in retx_addr;
+    pthread_t t_id;
+
+    if(argc < 5 || argc > 9)
+    {
+        printf("Usage: %s <GroupIP> <PORT> <rate_pps> <seconds> [channels] [pkt_size] [batch] [retx_port]\n", argv[0]);
+        exit(1);
+    }
+    rate = atof(argv[3]);
+    seconds = atoi(argv[4]);
+    if(argc >= 6)
+        channels = atoi(argv[5]);
+    if(argc >= 7)
+        pkt_size = atoi(argv[6]);
+    if(argc >= 8)
+        batch = atoi(argv[7]);
+    if(argc >= 9)
+        retx_port = atoi(argv[8]);
+    if(rate <= 0 || channels < 1 || channels > MD_MAX_CHANNELS
+       || pkt_size < MD_MIN_PKT || pkt_size > MD_MAX_PKT || batch < 1 || batch > MAX_BATCH)
+        error_handling("invalid rate, channels, pkt_size or batch");
+
+    send_sock = socket(PF_INET, SOCK_DGRAM, 0);
+    if(send_sock == -1)
+        error_handling("socket() error");
+    setsockopt(send_sock, IPPROTO_IP, IP_MULTICAST_TTL, (void*)&time_live, sizeof(time_live));
+
+    // 每个频道一个目的地址：同一组播地址，端口依次加 1
+    for(i = 0; i < channels; i++)
+    {
+        memset(&ch_addr[i], 0, sizeof(ch_addr[i]));
+        ch_addr[i].sin_family = AF_INET;
+        ch_addr[i].sin_addr.s_addr = inet_addr(argv[1]);
+        ch_addr[i].sin_port = htons(atoi(argv[2]) + i);
+        ch_seq[i] = 0;
+    }
+
+    // 预先把消息数组与缓冲区关联好，发送时只需填写数据和目的地址
+    memset(msgs, 0, sizeof(msgs));
+    memset(bufs, 0, sizeof(bufs));
+    for(i = 0; i < batch; i++)
+    {
+        iovs[i].iov_base = bufs[i];
+        iovs[i].iov_len = pkt_size;
+        msgs[i].msg_hdr.msg_iov = &iovs[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+        msgs[i].msg_hdr.msg_namelen = sizeof(struct sockaddr_in);
+    }
+
+    // -------------------- 重传服务 --------------------
+    if(retx_port > 0)
+    {
+        ring.channels = channels;
+        ring.pkt_size = pkt_size;
+        ring.data = malloc((size_t)channels * RING_SLOTS * pkt_size);
+        ring.seq = calloc((size_t)channels * RING_SLOTS, sizeof(uint64_t));
+        if(ring.data == NULL || ring.seq == NULL)
+            error_handling("malloc() error");
+        pthread_mutex_init(&ring.mutex, NULL);
+
+        ring.sock = socket(PF_INET, SOCK_DGRAM, 0);
+        if(ring.sock == -1)
+            error_handling("socket() error");
+        memset(&retx_addr, 0, sizeof(retx_addr));
+        retx_addr.sin_family = AF_INET;
+        retx_addr.sin_addr.s_addr = htonl(INADDR_ANY);
+        retx_addr.sin_port = htons(retx_port);
+        if(bind(ring.sock, (struct sockaddr*)&retx_addr, sizeof(retx_addr)) == -1)
+            error_handling("bind() error");
+        if(pthread_create(&t_id, NULL, retx_server, &ring) != 0)
+            error_handling("pthread_create() error");
+        pthread_detach(t_id);
+        printf("retransmission server on port %d, keeping %d packets per channel\n", retx_port, RING_SLOTS);
+    }
+
+    memset(&hdr, 0, sizeof(hdr));
+    hdr.magic = MD_MAGIC;
+    hdr.version = MD_VERSION;
+    hdr.len = (uint16_t)(pkt_size - MD_HDR_SIZE);
+
+    printf("publishing to %s:%d..%d, %.0f pkt/s, %d bytes, batch %d, %d s\n",
+           argv[1], atoi(argv[2]), atoi(argv[2]) + channels - 1, rate, pkt_size, batch, seconds);
+
+    // 容量太小时，一次调度延迟攒下的令牌会被截掉，实际速率达不到设定值；之后按每批 batch 个追上
+    capacity = rate * MAX_BURST_MS / 1000;
+    if(capacity < 2 * batch)
+        capacity = 2 * batch;
+
+    start = now_ns(CLOCK_MONOTONIC);
+    end = start + (uint64_t)seconds * 1000000000ull;
+    last = sec_start = hb_check = start;
+    for(i = 0; i < channels; i++)
+        ch_last[i] = start;
+    while(1)
+    {
+        // -------------------- 令牌桶：按经过的时间补充令牌 --------------------
+        now = now_ns(CLOCK_MONOTONIC);
+        if(now >= end)
+            break;
+
+        // 每 HEARTBEAT_MS / 10 检查一次空闲的频道：低速率或频道很多时，某个频道可能很久才轮到一个包
+        if(now - hb_check >= HEARTBEAT_MS * 100000ull)
+        {
+            send_heartbeats(send_sock, ch_addr, ch_seq, ch_last, channels, now, HEARTBEAT_MS * 1000000ull);
+            hb_check = now;
+        }
+
+        tokens += (now - last) * rate / 1e9;
+        if(tokens > capacity)
+            tokens = capacity;
+        last = now;
+        // ready：第一个令牌到达（第一个包可以发出）的时刻，用于限制攒批的等待时间
+        if(tokens >= 1 && ready == 0)
+            ready = now - (uint64_t)((tokens - 1) * 1e9 / rate);
+
+        if(tokens < batch && (tokens < 1 || now - ready < MAX_DELAY_US * 1000ull))
+        {
+            // 攒批：等到令牌攒满一批，或最早的令牌已等了 MAX_DELAY_US。sendmmsg 一次发出一整批，
+            // 系统调用的开销才能被摊薄。离发送时刻较远时短暂睡眠让出 CPU，临近时忙等以保证精度。
+            // 睡眠只决定"多久之后再检查"，实际能发多少仍由时钟算出的令牌数决定
+            wait_ns = (uint64_t)((batch - tokens) * 1e9 / rate);
+            if(tokens < 1 && (uint64_t)((1 - tokens) * 1e9 / rate) + MAX_DELAY_US * 1000ull < wait_ns)
+                wait_ns = (uint64_t)((1 - tokens) * 1e9 / rate) + MAX_DELAY_US * 1000ull;
+            else if(tokens >= 1 && ready + MAX_DELAY_US * 1000ull - now < wait_ns)
+                wait_ns = ready + MAX_DELAY_US * 1000ull - now;
+            if(wait_ns > SPIN_NS)
+            {
+                ts.tv_sec = 0;
+                ts.tv_nsec = (long)(wait_ns - SPIN_NS / 2);
+                if(ts.tv_nsec > 100000000)
+                    ts.tv_nsec = 100000000;
+                nanosleep(&ts, NULL);
+            }
+            continue;
+        }
+
+        // -------------------- 填充一批数据包 --------------------
+        n = tokens < batch ? (int)tokens : batch;
+        for(i = 0; i < n; i++)
+        {
+            hdr.channel = (uint16_t)ch;
+            hdr.seq = ++ch_seq[ch];
+            hdr.send_ns = now_ns(CLOCK_REALTIME);   // 接收端用同一时钟计算单向时延（同一主机或已对时的主机）
+            md_put_hdr(bufs[i], &hdr);
+            quote.instrument = (uint32_t)(hdr.seq % 1000) + 1;
+            quote.qty = (uint32_t)(hdr.seq % 100 + 1) * 100;
+            quote.price = 1000000 + (int64_t)(hdr.seq % 2000) - 1000;
+            md_put_quote(bufs[i] + MD_HDR_SIZE, &quote);
+            msgs[i].msg_hdr.msg_name = &ch_addr[ch];
+            ch_last[ch] = now;
+            ch = (ch + 1) % channels;
+        }
+
+        // 先存入重传缓冲区再发送：即使本地发送失败的包，接收端也能通过 NACK 取回
+        if(retx_port > 0)
+        {
+            pthread_mutex_lock(&ring.mutex);
+            for(i = 0; i < n; i++)
+            {
+                md_get_hdr(bufs[i], pkt_size, &hdr);
+                slot = (size_t)hdr.channel * RING_SLOTS + (hdr.seq & (RING_SLOTS - 1));
+                memcpy(ring.data + slot * pkt_size, bufs[i], pkt_size);
+                ring.seq[slot] = hdr.seq;
+            }
+            pthread_mutex_unlock(&ring.mutex);
+        }
+
+        // -------------------- sendmmsg 批量发送 --------------------
+        // 发送缓冲区满（ENOBUFS/EAGAIN）时本批剩余的包计为丢弃：行情数据宁可丢弃，也不能让后续数据越积越旧
+        i = 0;
+        while(i < n)
+        {
+            ret = sendmmsg(send_sock, msgs + i, n - i, 0);
+            calls++;
+            sec_calls++;
+            if(ret > 0)
+            {
+                i += ret;
+                continue;
+            }
+            if(ret == -1 && errno != ENOBUFS && errno != EAGAIN && errno != EINTR)
+                error_handling("sendmmsg() error");
+            dropped += n - i;
+            break;
+        }
+        sent += i;
+        sec_sent += i;
+        tokens -= n;
+        ready = 0;      // 剩下的令牌从下一次补充时重新计算等待时间
+
+        // -------------------- 每秒输出一次 --------------------
+        if(now - sec_start >= 1000000000ull)
+        {
+            printf("%.0f pkt/s, %.1f pkts per sendmmsg, %llu sent, %llu dropped\n",
+                   sec_sent * 1e9 / (now - sec_start), sec_calls ? (double)sec_sent / sec_calls : 0.0,
+                   sent, dropped);
+            fflush(stdout);
+            sec_sent = sec_calls = 0;
+            sec_start = now;
+        }
+    }
+
+    now = now_ns(CLOCK_MONOTONIC);
+    printf("sent %llu packets in %llu sendmmsg calls (%.1f s, %.0f pkt/s), %llu dropped\n",
+           sent, calls, (now - start) / 1e9, sent * 1e9 / (now - start), dropped);
+    printf("last sequence per channel:");
+    for(i = 0; i < channels; i++)
+        printf(" %llu", (unsigned long long)ch_seq[i]);
+    printf("\n");
+    fflush(stdout);
+
+    // 结束时为每个频道重复发送心跳（带最后的序号）：最后几个包丢失时，接收端没有后续包可以发现缺口，
+    // 只发一次的话这个心跳本身丢失就无从发现了
+    ts.tv_sec = HEARTBEAT_MS / 1000;
+    ts.tv_nsec = (HEARTBEAT_MS % 1000) * 1000000L;
+    for(n = 0; n < FINAL_HEARTBEATS; n++)
+    {
+        if(n > 0)
+            nanosleep(&ts, NULL);
+        send_heartbeats(send_sock, ch_addr, ch_seq, ch_last, channels, now_ns(CLOCK_MONOTONIC), 0);
+    }
+
+    if(retx_port > 0)
+    {
+        sleep(LINGER_SECS);
+        pthread_mutex_lock(&ring.mutex);
+        printf("retransmission: %llu NACKs, %llu packets resent, %llu unavailable\n",
+               ring.nacks, ring.resent, ring.unavail);
+        pthread_mutex_unlock(&ring.mutex);
+    }
+
+    close(send_sock);
+    return 0;
+}
+
+/*
+ * 为空闲超过 idle_ns 的频道发送心跳（idle_ns 为 0 时发给所有频道），seq 为该频道最后发布的序号。
+ * 还没有发布过数据的频道不发：接收端从收到的第一个数据包开始跟踪
+ */
+void send_heartbeats(int sock, struct sockaddr_in* ch_addr, uint64_t* ch_seq, uint64_t* ch_last,
+                     int channels, uint64_t now, uint64_t idle_ns)
+{
+    uint8_t buf[MD_HDR_SIZE];
+    md_hdr hdr;
+    int i;
+
+    memset(&hdr, 0, sizeof(hdr));
+    hdr.magic = MD_MAGIC;
+    hdr.version = MD_VERSION;
+    hdr.flags = MD_FLAG_HEARTBEAT;
+    hdr.len = 0;
+    for(i = 0; i < channels; i++)
+    {
+        if(ch_seq[i] == 0 || now - ch_last[i] < idle_ns)
+            continue;
+        hdr.channel = (uint16_t)i;
+        hdr.seq = ch_seq[i];
+        hdr.send_ns = now_ns(CLOCK_REALTIME);
+        md_put_hdr(buf, &hdr);
+        sendto(sock, buf, MD_HDR_SIZE, 0, (struct sockaddr*)&ch_addr[i], sizeof(ch_addr[i]));
+        ch_last[i] = now;
+    }
+}
+
+/*
+ * 重传服务线程：接收 NACK，把仍保存在环形缓冲区中的包单播补发给请求方
+ * 补发的包设置 MD_FLAG_RETX；已被覆盖（太旧）的序号合并成一个 MD_FLAG_UNAVAIL 回复
+ */
+void* retx_server(void* arg)
+{
+    retx_ring* r = (retx_ring*)arg;
+    uint8_t req[64], unavail_pkt[MD_HDR_SIZE + 8];
+    static uint8_t bufs[RETX_BATCH][MD_MAX_PKT];
+    struct mmsghdr msgs[RETX_BATCH];
+    struct iovec iovs[RETX_BATCH];
+    struct sockaddr_in clnt_addr;
+    socklen_t clnt_addr_sz;
+    md_nack nack;
+    md_hdr hdr;
+    uint64_t seq, end, miss_first = 0, miss_cnt = 0, be;
+    size_t slot;
+    int len, n, i, sent, resent;
+
+    while(1)
+    {
+        clnt_addr_sz = sizeof(clnt_addr);
+        len = recvfrom(r->sock, req, sizeof(req), 0, (struct sockaddr*)&clnt_addr, &clnt_addr_sz);
+        if(len == -1 || md_get_nack(req, len, &nack) == -1
+           || nack.channel >= r->channels || nack.count == 0 || nack.first == 0)
+            continue;
+        if(nack.count > MD_NACK_MAX)
+            nack.count = MD_NACK_MAX;
+
+        seq = nack.first;
+        end = nack.first + nack.count;
+        miss_cnt = 0;
+        resent = 0;
+        while(seq < end)
+        {
+            // 在锁内把一批包复制出来，发送时不持有锁，避免阻塞发布线程
+            n = 0;
+            pthread_mutex_lock(&r->mutex);
+            for(; seq < end && n < RETX_BATCH; seq++)
+            {
+                slot = (size_t)nack.channel * RING_SLOTS + (seq & (RING_SLOTS - 1));
+                if(r->seq[slot] != seq)
+                {
+                    // 尚未发布的序号直接忽略；已被覆盖的序号记为不可恢复
+                    if(r->seq[slot] > seq)
+                    {
+                        if(miss_cnt == 0)
+                            miss_first = seq;
+                        miss_cnt++;
+                    }
+                    continue;
+                }
+                memcpy(bufs[n], r->data + slot * r->pkt_size, r->pkt_size);
+                bufs[n][3] |= MD_FLAG_RETX;     // 包头第 4 字节是标志
+                n++;
+            }
+            pthread_mutex_unlock(&r->mutex);
+            resent += n;
+
+            for(i = 0; i < n; i++)
+            {
+                iovs[i].iov_base = bufs[i];
+                iovs[i].iov_len = r->pkt_size;
+                memset(&msgs[i], 0, sizeof(msgs[i]));
+                msgs[i].msg_hdr.msg_iov = &iovs[i];
+                msgs[i].msg_hdr.msg_iovlen = 1;
+                msgs[i].msg_hdr.msg_name = &clnt_addr;
+                msgs[i].msg_hdr.msg_namelen = clnt_addr_sz;
+            }
+            for(sent = 0; sent < n; )
+            {
+                i = sendmmsg(r->sock, msgs + sent, n - sent, 0);
+                if(i <= 0)
+                    break;
+                sent += i;
+            }
+        }
+
+        if(miss_cnt > 0)
+        {
+            memset(&hdr, 0, sizeof(hdr));
+            hdr.magic = MD_MAGIC;
+            hdr.version = MD_VERSION;
+            hdr.flags = MD_FLAG_UNAVAIL;
+            hdr.channel = nack.channel;
+            hdr.len = 8;
+            hdr.seq = miss_first;
+            md_put_hdr(unavail_pkt, &hdr);
+            be = htobe64(miss_cnt);
+            memcpy(unavail_pkt + MD_HDR_SIZE, &be, 8);
+            sendto(r->sock, unavail_pkt, sizeof(unavail_pkt), 0, (struct sockaddr*)&clnt_addr, clnt_addr_sz);
+        }
+
+        pthread_mutex_lock(&r->mutex);
+        r->nacks++;
+        r->resent += resent;
+        r->unavail += miss_cnt;
+        pthread_mutex_unlock(&r->mutex);
+    }
+    return NULL;
+}
+
+uint64_t now_ns(clockid_t clk)
+{
+    struct timespec ts;
+
+    clock_gettime(clk, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+void error_handling(char *message)
+{
+    fputs(message, stderr);
+    fputc('\n', stderr);
+    exit(1);
+}
@@ -0,0 +1,433 @@
+#include <stdio.h>      // 标准输入输出：printf / fputs / fputc 等
+#include <stdlib.h>     // 标准库：exit / atoi / atof / calloc / rand_r 等
+#include <string.h>     // 内存操作：memset / memcpy 等
+#include <stdint.h>     // uint8_t / uint64_t
+#include <unistd.h>     // POSIX：close / getpid 等
+#include <poll.h>       // poll：同时等待多个频道的套接字
+#include <time.h>       // clock_gettime
+#include <arpa/inet.h>  // 网络地址与字节序：inet_addr / htons 等
+#include <sys/socket.h> // 套接字 API：socket / setsockopt / bind / recv / sendto 等
+#include "md_proto.h"   // 行情数据包格式与 NACK 格式
+
+/*
+ * 带丢包检测与 NACK 重传的组播行情接收端（配合 md_publisher 的重传服务使用）
+ *
+ * news_receiver.c 收到什么就打印什么，无法察觉丢包。本示例按频道跟踪序号：
+ *   - 缺口检测：收到的序号大于"已见最大序号 + 1"时，中间的序号记为缺失
+ *   - 重排缓冲：先到达的后续包暂存在每频道的环形缓冲区中，缺口补齐后按序号顺序交付
+ *   - NACK：缺失超过 REORDER_WAIT_NS（给轻微乱序留出时间）仍未到达，就把连续的缺失区间
+ *     单播给重传服务器；补发的包同样经过重排缓冲交付。超时未收到则重发 NACK，多次失败或服务器
+ *     回复 MD_FLAG_UNAVAIL 时放弃，记为丢失并越过该序号，后续数据不会被永远卡住
+ *   - 重排缓冲放满（缺口太久未补上）时同样强制越过最旧的缺口
+ *
+ * 接收端从收到的第一个包开始跟踪（中途加入），之前的序号不会请求重传。
+ * drop% 参数在接收端随机丢弃组播包，用于在本机上验证重传流程（补发的单播包不受影响）。
+ *
+ * 用法：md_receiver <GroupIP> <PORT> <channels> <retx_IP> <retx_port> [drop%]
+ */
+
+#define REORDER_SLOTS 4096          // 每频道重排缓冲区槽位数（2 的幂）
+#define REORDER_WAIT_NS 2000000     // 发现缺口后等待 2ms 再请求重传
+#define NACK_RETRY_NS 30000000      // NACK 之后 30ms 仍未补齐则重发
+#define MAX_NACK_TRIES 5            // 同一个序号最多请求的次数
+#define RECV_BURST 64               // 每个套接字每次最多连续读取的包数
+#define IDLE_EXIT_SECS 3            // 收到过数据后空闲 3 秒即结束并输出统计
+#define RCVBUF_SIZE (4 * 1024 * 1024)
+
+enum { SLOT_EMPTY = 0, SLOT_MISSING, SLOT_READY, SLOT_LOST };
+
+typedef struct {
+    uint64_t seq;
+    uint64_t due_ns;                // SLOT_MISSING：下一次发送 NACK 的时刻
+    uint16_t len;
+    uint8_t state;
+    uint8_t tries;                  // 已发送 NACK 的次数
+    uint8_t data[MD_MAX_PKT];
+} reorder_slot;
+
+typedef struct {
+    int sock;
+    int started;
+    uint64_t expected;              // 下一个要交付的序号
+    uint64_t highest;               // 已见到的最大序号
+    reorder_slot* slots;
+    unsigned long long delivered, missing, recovered, late, lost, dup, dropped, bad, nacks;
+    double lat_sum;                 // 发布到交付的时延之和（纳秒）
+    uint64_t lat_max;
+} channel;
+
+static channel chans[MD_MAX_CHANNELS];
+static int nchan;
+static int nack_sock;
+static struct sockaddr_in retx_addr;
+
+uint64_t now_ns(clockid_t clk);
+void handle_packet(const uint8_t* buf, int len, uint64_t now);
+void mark_missing(channel* c, uint64_t upto, uint64_t now);
+void deliver_ready(channel* c);
+void send_nacks(int id, uint64_t now);
+void error_handling(char* message);
+
+int main(int argc, char* argv[])
+{
+    struct sockaddr_in addr;
+    struct ip_mreq join_adr;
+    struct pollfd pfds[MD_MAX_CHANNELS + 1];
+    static uint8_t buf[MD_MAX_PKT + 64];
+    double drop = 0;
+    unsigned int seed;
+    int i, k, len, on = 1, rcvbuf = RCVBUF_SIZE;
+    uint64_t now, last_rx = 0, sec_start;
+    unsigned long long prev_delivered = 0, delivered, missing, recovered, late, lost, dup, dropped, bad, nacks;
+    double lat_sum;
+    uint64_t lat_max;
+
+    if(argc != 6 && argc != 7)
+    {
+        printf("Usage: %s <GroupIP> <PORT> <channels> <retx_IP> <retx_port> [drop%%]\n", argv[0]);
+        exit(1);
+    }
+    nchan = atoi(argv[3]);
+    if(argc == 7)
+        drop = atof(argv[6]) / 100.0;
+    if(nchan < 1 || nchan > MD_MAX_CHANNELS)
+        error_handling("invalid channels");
+    seed = (unsigned int)(now_ns(CLOCK_MONOTONIC) ^ getpid());
+
+    // -------------------- 每个频道一个套接字，加入组播组 --------------------
+    for(i = 0; i < nchan; i++)
+    {
+        chans[i].slots = calloc(REORDER_SLOTS, sizeof(reorder_slot));
+        if(chans[i].slots == NULL)
+            error_handling("calloc() error");
+        chans[i].sock = socket(PF_INET, SOCK_DGRAM, 0);
+        if(chans[i].sock == -1)
+            error_handling("socket() error");
+        // 允许同一主机上运行多个接收端
+        setsockopt(chans[i].sock, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+        setsockopt(chans[i].sock, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+
+        memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_ANY);
+        addr.sin_port = htons(atoi(argv[2]) + i);
+        if(bind(chans[i].sock, (struct sockaddr*)&addr, sizeof(addr)) == -1)
+            error_handling("bind() error");
+
+        join_adr.imr_multiaddr.s_addr = inet_addr(argv[1]);
+        join_adr.imr_interface.s_addr = htonl(INADDR_ANY);
+        if(setsockopt(chans[i].sock, IPPROTO_IP, IP_ADD_MEMBERSHIP, (void*)&join_adr, sizeof(join_adr)) == -1)
+            error_handling("setsockopt(IP_ADD_MEMBERSHIP) error");
+
+        pfds[i].fd = chans[i].sock;
+        pfds[i].events = POLLIN;
+    }
+
+    // -------------------- NACK 套接字：发送请求，接收补发的包 --------------------
+    nack_sock = socket(PF_INET, SOCK_DGRAM, 0);
+    if(nack_sock == -1)
+        error_handling("socket() error");
+    setsockopt(nack_sock, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+    memset(&retx_addr, 0, sizeof(retx_addr));
+    retx_addr.sin_family = AF_INET;
+    retx_addr.sin_addr.s_addr = inet_addr(argv[4]);
+    retx_addr.sin_port = htons(atoi(argv[5]));
+    pfds[nchan].fd = nack_sock;
+    pfds[nchan].events = POLLIN;
+
+    printf("receiving %s:%d..%d, retransmission server %s:%s, simulated drop %.1f%%\n",
+           argv[1], atoi(argv[2]), atoi(argv[2]) + nchan - 1, argv[4], argv[5], drop * 100);
+
+    sec_start = now_ns(CLOCK_MONOTONIC);
+    while(1)
+    {
+        // 10ms 超时：即使没有新包到达，也要按时重发 NACK
+        poll(pfds, nchan + 1, 10);
+        now = now_ns(CLOCK_MONOTONIC);
+
+        for(i = 0; i <= nchan; i++)
+        {
+            if(!(pfds[i].revents & POLLIN))
+                continue;
+            for(k = 0; k < RECV_BURST; k++)
+            {
+                len = recv(pfds[i].fd, buf, sizeof(buf), MSG_DONTWAIT);
+                if(len <= 0)
+                    break;
+                last_rx = now;
+                // 模拟丢包：只丢组播包，补发的单播包照常处理
+                if(i < nchan && drop > 0 && rand_r(&seed) < drop * ((double)RAND_MAX + 1))
+                {
+                    chans[i].dropped++;
+                    continue;
+                }
+                handle_packet(buf, len, now);
+            }
+        }
+
+        for(i = 0; i < nchan; i++)
+            send_nacks(i, now);
+
+        // -------------------- 每秒输出一次汇总 --------------------
+        if(now - sec_start >= 1000000000ull || (last_rx && now - last_rx >= IDLE_EXIT_SECS * 1000000000ull))
+        {
+            delivered = missing = recovered = late = lost = dup = dropped = bad = nacks = 0;
+            lat_sum = 0;
+            lat_max = 0;
+            for(i = 0; i < nchan; i++)
+            {
+                delivered += chans[i].delivered;
+                missing += chans[i].missing;
+                recovered += chans[i].recovered;
+                late += chans[i].late;
+                lost += chans[i].lost;
+                dup += chans[i].dup;
+                dropped += chans[i].dropped;
+                bad += chans[i].bad;
+                nacks += chans[i].nacks;
+                lat_sum += chans[i].lat_sum;
+                if(chans[i].lat_max > lat_max)
+                    lat_max = chans[i].lat_max;
+            }
+            printf("%.0f msg/s delivered | total %llu, gaps %llu (recovered %llu, late %llu, lost %llu), "
+                   "dup %llu, dropped %llu, NACKs %llu\n",
+                   (delivered - prev_delivered) * 1e9 / (now - sec_start), delivered, missing,
+                   recovered, late, lost, dup, dropped, nacks);
+            fflush(stdout);
+            prev_delivered = delivered;
+            sec_start = now;
+
+            if(last_rx && now - last_rx >= IDLE_EXIT_SECS * 1000000000ull)
+            {
+                printf("idle for %d s, exiting\n", IDLE_EXIT_SECS);
+                printf("delivered %llu in sequence, %llu bad payloads, avg latency %.1f us, max %.1f us\n",
+                       delivered, bad, delivered ? lat_sum / delivered / 1e3 : 0.0, lat_max / 1e3);
+                for(i = 0; i < nchan; i++)
+                    printf("  channel %d: next expected seq %llu, delivered %llu, lost %llu\n", i,
+                           (unsigned long long)chans[i].expected, chans[i].delivered, chans[i].lost);
+                break;
+            }
+        }
+    }
+
+    for(i = 0; i < nchan; i++)
+    {
+        close(chans[i].sock);
+        free(chans[i].slots);
+    }
+    close(nack_sock);
+    return 0;
+}
+
+/* 处理一个数据包（组播或补发）：缺口检测、放入重排缓冲，然后尽可能按序交付 */
+void handle_packet(const uint8_t* buf, int len, uint64_t now)
+{
+    md_hdr h;
+    channel* c;
+    reorder_slot* r;
+    uint64_t s, cnt, be;
+
+    // 超过 MD_MAX_PKT 的包放不进重排缓冲区的槽位，不是合法的行情包，直接丢弃
+    if(len > MD_MAX_PKT || md_get_hdr(buf, len, &h) == -1 || h.channel >= nchan || h.seq == 0)
+        return;
+    c = &chans[h.channel];
+
+    // 重传服务器已没有这些序号：不再等待，记为丢失
+    if(h.flags & MD_FLAG_UNAVAIL)
+    {
+        if(h.len < 8)
+            return;
+        memcpy(&be, buf + MD_HDR_SIZE, 8);
+        cnt = be64toh(be);
+        // 从 max(h.seq, expected) 开始：已交付的序号不用再看，也避免 cnt 很大时从头空转
+        for(s = h.seq > c->expected ? h.seq : c->expected; s - h.seq < cnt && c->started && s <= c->highest; s++)
+        {
+            r = &c->slots[s & (REORDER_SLOTS - 1)];
+            if(r->seq == s && r->state == SLOT_MISSING)
+                r->state = SLOT_LOST;
+        }
+        deliver_ready(c);
+        return;
+    }
+
+    // 心跳：只用于发现末尾的缺口
+    if(h.flags & MD_FLAG_HEARTBEAT)
+    {
+        if(c->started && h.seq > c->highest && h.seq < c->expected + REORDER_SLOTS)
+            mark_missing(c, h.seq + 1, now);
+        return;
+    }
+
+    if(!c->started)
+    {
+        // 从第一个收到的包开始跟踪
+        c->started = 1;
+        c->expected = h.seq;
+        c->highest = h.seq - 1;
+    }
+    if(h.seq < c->expected)
+    {
+        c->dup++;
+        return;
+    }
+
+    // 超出重排缓冲区：强制越过最旧的序号（缺失的记为丢失），为新包腾出位置
+    while(h.seq >= c->expected + REORDER_SLOTS)
+    {
+        r = &c->slots[c->expected & (REORDER_SLOTS - 1)];
+        if(r->seq == c->expected && r->state == SLOT_READY)
+        {
+            deliver_ready(c);
+            continue;
+        }
+        if(c->expected <= c->highest)
+            c->lost++;
+        r->state = SLOT_EMPTY;
+        c->expected++;
+        if(c->highest < c->expected - 1)
+            c->highest = c->expected - 1;
+        deliver_ready(c);
+    }
+
+    r = &c->slots[h.seq & (REORDER_SLOTS - 1)];
+    if(h.seq <= c->highest)
+    {
+        if(r->seq != h.seq || r->state != SLOT_MISSING)
+        {
+            c->dup++;
+            return;
+        }
+        // 补上了一个缺口：来自重传服务器，或者只是乱序到达的组播包
+        if(h.flags & MD_FLAG_RETX)
+            c->recovered++;
+        else
+            c->late++;
+    }
+    else
+    {
+        mark_missing(c, h.seq, now);
+        c->highest = h.seq;
+    }
+
+    r->seq = h.seq;
+    r->state = SLOT_READY;
+    r->len = (uint16_t)len;
+    memcpy(r->data, buf, len);
+    deliver_ready(c);
+}
+
+/* 新的最大序号出现：(highest, upto) 之间跳过的序号记为缺失，等待 REORDER_WAIT_NS 后请求重传 */
+void mark_missing(channel* c, uint64_t upto, uint64_t now)
+{
+    reorder_slot* r;
+    uint64_t s;
+
+    for(s = c->highest + 1; s < upto; s++)
+    {
+        r = &c->slots[s & (REORDER_SLOTS - 1)];
+        r->seq = s;
+        r->state = SLOT_MISSING;
+        r->tries = 0;
+        r->due_ns = now + REORDER_WAIT_NS;
+        c->missing++;
+    }
+    if(upto - 1 > c->highest)
+        c->highest = upto - 1;
+}
+
+/* 从 expected 开始按序交付：遇到仍缺失的序号就停下，遇到已放弃的序号就跳过 */
+void deliver_ready(channel* c)
+{
+    reorder_slot* r;
+    md_hdr h;
+    md_quote q;
+    uint64_t lat, t;
+
+    while(c->expected <= c->highest)
+    {
+        r = &c->slots[c->expected & (REORDER_SLOTS - 1)];
+        if(r->seq != c->expected || r->state == SLOT_MISSING || r->state == SLOT_EMPTY)
+            break;
+        if(r->state == SLOT_LOST)
+            c->lost++;
+        else if(md_get_hdr(r->data, r->len, &h) == -1 || h.len < MD_QUOTE_SIZE)
+            c->bad++;
+        else
+        {
+            // 交付给应用：这里只校验报价内容并统计从发布到交付的时延
+            md_get_quote(r->data + MD_HDR_SIZE, &q);
+            if(q.instrument != (uint32_t)(h.seq % 1000) + 1)
+                c->bad++;
+            t = now_ns(CLOCK_REALTIME);
+            lat = t > h.send_ns ? t - h.send_ns : 0;
+            c->lat_sum += lat;
+            if(lat > c->lat_max)
+                c->lat_max = lat;
+            c->delivered++;
+        }
+        r->state = SLOT_EMPTY;
+        c->expected++;
+    }
+}
+
+/* 把到期的缺失序号按连续区间合并成 NACK 发给重传服务器 */
+void send_nacks(int id, uint64_t now)
+{
+    channel* c = &chans[id];
+    reorder_slot* r;
+    uint8_t pkt[MD_NACK_SIZE];
+    md_nack nack;
+    uint64_t s;
+    int gave_up = 0;
+
+    nack.channel = (uint16_t)id;
+    nack.count = 0;
+    nack.first = 0;
+    for(s = c->expected; s <= c->highest + 1 && c->started; s++)
+    {
+        r = &c->slots[s & (REORDER_SLOTS - 1)];
+        if(s <= c->highest && r->seq == s && r->state == SLOT_MISSING && r->due_ns <= now)
+        {
+            if(r->tries >= MAX_NACK_TRIES)
+            {
+                r->state = SLOT_LOST;       // 多次请求无果：放弃
+                gave_up = 1;
+            }
+            else
+            {
+                r->tries++;
+                r->due_ns = now + NACK_RETRY_NS;
+                if(nack.count == 0)
+                    nack.first = s;
+                nack.count++;
+                if(nack.count < MD_NACK_MAX)
+                    continue;
+            }
+        }
+        // 区间结束（或达到单个 NACK 的上限）：发送
+        if(nack.count > 0)
+        {
+            md_put_nack(pkt, &nack);
+            sendto(nack_sock, pkt, sizeof(pkt), 0, (struct sockaddr*)&retx_addr, sizeof(retx_addr));
+            c->nacks++;
+            nack.count = 0;
+        }
+    }
+    if(gave_up)
+        deliver_ready(c);
+}
+
+uint64_t now_ns(clockid_t clk)
+{
+    struct timespec ts;
+
+    clock_gettime(clk, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+void error_handling(char *message)
+{
+    fputs(message, stderr);
+    fputc('\n', stderr);
+    exit(1);
+}
@@ -0,0 +1,385 @@
+#define _GNU_SOURCE             // recvmmsg / struct mmsghdr / SO_RCVBUFFORCE 是 GNU 扩展
+#include <stdio.h>      // 标准输入输出：printf / fputs / fputc 等
+#include <stdlib.h>     // 标准库：exit / atoi / calloc / aligned_alloc 等
+#include <string.h>     // 内存操作：memset / memcpy 等
+#include <stdint.h>     // uint8_t / uint32_t / uint64_t
+#include <unistd.h>     // POSIX：close / usleep 等
+#include <poll.h>       // poll：等待任一频道的套接字可读
+#include <sched.h>      // sched_yield：消费者空闲时让出 CPU
+#include <time.h>       // clock_gettime
+#include <pthread.h>    // pthread_create：消费者线程
+#include <arpa/inet.h>  // 网络地址与字节序：inet_addr / htons 等
+#include <sys/socket.h> // 套接字 API：socket / setsockopt / bind / recvmmsg / CMSG_* 等
+#include "md_proto.h"   // 行情数据包格式
+
+/*
+ * 接收与处理分离的组播行情接收端：recvmmsg + 包池 + 单生产者/单消费者（SPSC）无锁环形队列
+ *
+ * news_receiver.c / md_receiver.c 在接收线程里直接处理每个包。处理一旦变慢（或出现突发流量），
+ * 套接字接收缓冲区就会被填满，内核开始丢包。本示例把两件事拆开：
+ *   - 接收线程只做一件事：用 recvmmsg 把内核缓冲区里的包批量取出，放进预先分配好的包池缓冲区，
+ *     然后按频道号交给对应的消费者线程（同一频道总是同一个消费者，保持顺序）
+ *   - 每个消费者有两个 SPSC 环形队列：full（接收线程 -> 消费者，待处理的包）和
+ *     free（消费者 -> 接收线程，处理完归还的缓冲区）。每个队列只有一个写者和一个读者，
+ *     只需原子地读写头尾下标（acquire/release），不需要任何锁
+ *   - 包池和队列吸收突发：处理暂时跟不上时包在用户态排队，内核缓冲区仍能及时腾空；
+ *     包池耗尽或队列已满时在用户态丢弃并计数（app drops），而不是让内核丢
+ *   - SO_RCVBUF 放大内核接收缓冲区；SO_RXQ_OVFL 让内核在每个包的控制消息中附带该套接字
+ *     累计丢弃的包数，从而区分"内核丢包"和"应用丢包"
+ *
+ * 消费者检查每个频道的序号连续性，并用 work_ns 模拟每个包的处理耗时。
+ *
+ * 用法：md_receiver_spsc <GroupIP> <PORT> <channels> [consumers] [work_ns] [rcvbuf_kb]
+ */
+
+#define MAX_CONSUMERS 16
+#define BATCH 64                    // 每次 recvmmsg 最多取出的包数
+#define POOL_SIZE 16384             // 包池中的缓冲区总数
+#define RING_SIZE POOL_SIZE         // 每个 SPSC 队列的容量（2 的幂）：等于包池大小，归还缓冲区时 free 队列不会满
+#define DEFAULT_RCVBUF_KB 4096
+#define IDLE_EXIT_SECS 3
+#define CACHE_LINE 64
+
+/* 包池中的一个缓冲区 */
+typedef struct {
+    uint16_t len;
+    uint8_t data[MD_MAX_PKT];
+} pkt_buf;
+
+/*
+ * SPSC 环形队列：head 只由生产者写，tail 只由消费者写。
+ * 两个下标放在不同的缓存行上，避免生产者与消费者互相使对方的缓存行失效（伪共享）
+ */
+typedef struct {
+    uint32_t head __attribute__((aligned(CACHE_LINE)));
+    uint32_t tail __attribute__((aligned(CACHE_LINE)));
+    pkt_buf* slots[RING_SIZE] __attribute__((aligned(CACHE_LINE)));
+} spsc_ring;
+
+typedef struct {
+    int id;
+    int work_ns;
+    spsc_ring full;                 // 接收线程 -> 消费者
+    spsc_ring free;                 // 消费者 -> 接收线程
+    // 以下统计只由消费者线程写
+    unsigned long processed __attribute__((aligned(CACHE_LINE)));
+    unsigned long gaps;             // 序号不连续的次数
+    unsigned long missing;          // 缺失的序号总数
+} consumer;
+
+static consumer* cons[MAX_CONSUMERS];
+static uint64_t expected[MD_MAX_CHANNELS];     // 每个频道期望的下一个序号（由负责该频道的消费者读写）
+
+uint64_t now_ns(void);
+int ring_push(spsc_ring* r, pkt_buf* p);
+pkt_buf* ring_pop(spsc_ring* r);
+void* consumer_main(void* arg);
+void error_handling(char* message);
+
+int main(int argc, char* argv[])
+{
+    int nchan, ncons = 1, work_ns = 0, rcvbuf, actual, on = 1, i, j, n, c, len, avail;
+    socklen_t optlen;
+    int socks[MD_MAX_CHANNELS];
+    struct pollfd pfds[MD_MAX_CHANNELS];
+    struct sockaddr_in addr;
+    struct ip_mreq join_adr;
+    pkt_buf *pool, *free_stack[POOL_SIZE], *batch_bufs[BATCH], *p;
+    static pkt_buf scratch;
+    int free_top = 0;
+    struct mmsghdr msgs[BATCH];
+    struct iovec iovs[BATCH];
+    char controls[BATCH][CMSG_SPACE(sizeof(uint32_t))];
+    struct cmsghdr* cmsg;
+    uint32_t ovfl[MD_MAX_CHANNELS];
+    pthread_t t_id;
+    md_hdr h;
+    uint64_t now, sec_start, last_rx = 0;
+    unsigned long long received = 0, calls = 0, app_drops = 0, kernel_drops = 0;
+    unsigned long long sec_received = 0, sec_calls = 0, processed, gaps, missing;
+
+    if(argc < 4 || argc > 7)
+    {
+        printf("Usage: %s <GroupIP> <PORT> <channels> [consumers] [work_ns] [rcvbuf_kb]\n", argv[0]);
+        exit(1);
+    }
+    nchan = atoi(argv[3]);
+    if(argc >= 5)
+        ncons = atoi(argv[4]);
+    if(argc >= 6)
+        work_ns = atoi(argv[5]);
+    rcvbuf = (argc >= 7 ? atoi(argv[6]) : DEFAULT_RCVBUF_KB) * 1024;
+    if(nchan < 1 || nchan > MD_MAX_CHANNELS || ncons < 1 || ncons > MAX_CONSUMERS || work_ns < 0 || rcvbuf <= 0)
+        error_handling("invalid channels, consumers, work_ns or rcvbuf");
+
+    // -------------------- 包池：一次性分配，运行期间不再 malloc --------------------
+    pool = calloc(POOL_SIZE, sizeof(pkt_buf));
+    if(pool == NULL)
+        error_handling("calloc() error");
+    for(i = 0; i < POOL_SIZE; i++)
+        free_stack[free_top++] = &pool[i];
+
+    // -------------------- 套接字 --------------------
+    for(i = 0; i < nchan; i++)
+    {
+        socks[i] = socket(PF_INET, SOCK_DGRAM, 0);
+        if(socks[i] == -1)
+            error_handling("socket() error");
+        setsockopt(socks[i], SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+
+        // SO_RCVBUF 受 net.core.rmem_max 限制；有 CAP_NET_ADMIN 权限时用 SO_RCVBUFFORCE 突破该限制
+        if(setsockopt(socks[i], SOL_SOCKET, SO_RCVBUFFORCE, &rcvbuf, sizeof(rcvbuf)) == -1)
+            setsockopt(socks[i], SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+        // 内核在每个包的控制消息中附带该套接字累计丢弃的包数
+        if(setsockopt(socks[i], SOL_SOCKET, SO_RXQ_OVFL, &on, sizeof(on)) == -1)
+            error_handling("setsockopt(SO_RXQ_OVFL) error");
+
+        memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_ANY);
+        addr.sin_port = htons(atoi(argv[2]) + i);
+        if(bind(socks[i], (struct sockaddr*)&addr, sizeof(addr)) == -1)
+            error_handling("bind() error");
+
+        join_adr.imr_multiaddr.s_addr = inet_addr(argv[1]);
+        join_adr.imr_interface.s_addr = htonl(INADDR_ANY);
+        if(setsockopt(socks[i], IPPROTO_IP, IP_ADD_MEMBERSHIP, (void*)&join_adr, sizeof(join_adr)) == -1)
+            error_handling("setsockopt(IP_ADD_MEMBERSHIP) error");
+
+        pfds[i].fd = socks[i];
+        pfds[i].events = POLLIN;
+        ovfl[i] = 0;
+    }
+    optlen = sizeof(actual);
+    getsockopt(socks[0], SOL_SOCKET, SO_RCVBUF, &actual, &optlen);
+    printf("%d channels, %d consumers, %d ns work per packet, SO_RCVBUF %d KB (requested %d KB)\n",
+           nchan, ncons, work_ns, actual / 1024, rcvbuf / 1024);
+
+    // -------------------- 消费者线程 --------------------
+    for(i = 0; i < ncons; i++)
+    {
+        cons[i] = aligned_alloc(CACHE_LINE, (sizeof(consumer) + CACHE_LINE - 1) / CACHE_LINE * CACHE_LINE);
+        if(cons[i] == NULL)
+            error_handling("aligned_alloc() error");
+        memset(cons[i], 0, sizeof(consumer));
+        cons[i]->id = i;
+        cons[i]->work_ns = work_ns;
+        if(pthread_create(&t_id, NULL, consumer_main, cons[i]) != 0)
+            error_handling("pthread_create() error");
+        pthread_detach(t_id);
+    }
+
+    memset(msgs, 0, sizeof(msgs));
+    for(i = 0; i < BATCH; i++)
+    {
+        msgs[i].msg_hdr.msg_iov = &iovs[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    sec_start = now_ns();
+    while(1)
+    {
+        poll(pfds, nchan, 100);
+        now = now_ns();
+
+        // 回收消费者归还的缓冲区
+        for(c = 0; c < ncons; c++)
+            while((p = ring_pop(&cons[c]->free)) != NULL)
+                free_stack[free_top++] = p;
+
+        for(i = 0; i < nchan; i++)
+        {
+            if(!(pfds[i].revents & POLLIN))
+                continue;
+
+            // 包池耗尽：仍要把包从内核取出（否则内核会丢包且无法统计），取出后直接丢弃
+            avail = free_top < BATCH ? free_top : BATCH;
+            if(avail == 0)
+            {
+                while(recv(socks[i], scratch.data, sizeof(scratch.data), MSG_DONTWAIT) > 0)
+                {
+                    received++;
+                    sec_received++;
+                    app_drops++;
+                }
+                last_rx = now;
+                continue;
+            }
+
+            for(j = 0; j < avail; j++)
+            {
+                batch_bufs[j] = free_stack[--free_top];
+                iovs[j].iov_base = batch_bufs[j]->data;
+                iovs[j].iov_len = MD_MAX_PKT;
+                msgs[j].msg_hdr.msg_control = controls[j];
+                msgs[j].msg_hdr.msg_controllen = sizeof(controls[j]);
+            }
+            n = recvmmsg(socks[i], msgs, avail, MSG_DONTWAIT, NULL);
+            if(n < 0)
+                n = 0;
+            calls += n > 0;
+            sec_calls += n > 0;
+
+            for(j = 0; j < n; j++)
+            {
+                p = batch_bufs[j];
+                len = msgs[j].msg_len;
+                p->len = (uint16_t)len;
+                received++;
+                sec_received++;
+                last_rx = now;
+
+                // SO_RXQ_OVFL：值为该套接字累计丢弃数，与上次的差就是新增的内核丢包
+                for(cmsg = CMSG_FIRSTHDR(&msgs[j].msg_hdr); cmsg != NULL; cmsg = CMSG_NXTHDR(&msgs[j].msg_hdr, cmsg))
+                {
+                    if(cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SO_RXQ_OVFL)
+                    {
+                        uint32_t v;
+                        memcpy(&v, CMSG_DATA(cmsg), sizeof(v));
+                        kernel_drops += v - ovfl[i];
+                        ovfl[i] = v;
+                    }
+                }
+
+                // 按频道交给消费者；队列已满则在用户态丢弃
+                if(md_get_hdr(p->data, len, &h) == -1 || h.channel >= nchan
+                   || ring_push(&cons[h.channel % ncons]->full, p) == -1)
+                {
+                    app_drops++;
+                    free_stack[free_top++] = p;
+                }
+            }
+            // 没用上的缓冲区放回空闲栈
+            for(j = n; j < avail; j++)
+                free_stack[free_top++] = batch_bufs[j];
+        }
+
+        // -------------------- 每秒输出一次 --------------------
+        if(now - sec_start >= 1000000000ull)
+        {
+            processed = gaps = missing = 0;
+            for(c = 0; c < ncons; c++)
+            {
+                processed += __atomic_load_n(&cons[c]->processed, __ATOMIC_RELAXED);
+                gaps += __atomic_load_n(&cons[c]->gaps, __ATOMIC_RELAXED);
+                missing += __atomic_load_n(&cons[c]->missing, __ATOMIC_RELAXED);
+            }
+            printf("%.0f pkt/s, %.1f per recvmmsg | received %llu, processed %llu, queued %llu, "
+                   "kernel drops %llu, app drops %llu, seq gaps %llu (%llu missing)\n",
+                   sec_received * 1e9 / (now - sec_start), sec_calls ? (double)sec_received / sec_calls : 0.0,
+                   received, processed, received - app_drops - processed, kernel_drops, app_drops, gaps, missing);
+            fflush(stdout);
+            sec_received = sec_calls = 0;
+            sec_start = now;
+
+            if(last_rx && now - last_rx >= IDLE_EXIT_SECS * 1000000000ull && received - app_drops == processed)
+            {
+                printf("idle for %d s, exiting: %llu received in %llu recvmmsg calls\n",
+                       IDLE_EXIT_SECS, received, calls);
+                break;
+            }
+        }
+    }
+
+    for(i = 0; i < nchan; i++)
+        close(socks[i]);
+    return 0;
+}
+
+/* 生产者入队：队列满返回 -1。release 保证消费者看到新的 head 时，slots 中的指针已经写好 */
+int ring_push(spsc_ring* r, pkt_buf* p)
+{
+    uint32_t head = r->head;        // 只有本线程写 head，直接读即可
+    uint32_t tail = __atomic_load_n(&r->tail, __ATOMIC_ACQUIRE);
+
+    if(head - tail == RING_SIZE)
+        return -1;
+    r->slots[head & (RING_SIZE - 1)] = p;
+    __atomic_store_n(&r->head, head + 1, __ATOMIC_RELEASE);
+    return 0;
+}
+
+/* 消费者出队：队列空返回 NULL */
+pkt_buf* ring_pop(spsc_ring* r)
+{
+    uint32_t tail = r->tail;        // 只有本线程写 tail
+    uint32_t head = __atomic_load_n(&r->head, __ATOMIC_ACQUIRE);
+    pkt_buf* p;
+
+    if(tail == head)
+        return NULL;
+    p = r->slots[tail & (RING_SIZE - 1)];
+    __atomic_store_n(&r->tail, tail + 1, __ATOMIC_RELEASE);
+    return p;
+}
+
+/*
+ * 消费者线程：取出包、检查序号、模拟处理，然后把缓冲区归还给接收线程。
+ * free 队列的方向与 full 相反：这里消费者是生产者
+ */
+void* consumer_main(void* arg)
+{
+    consumer* c = (consumer*)arg;
+    pkt_buf* p;
+    md_hdr h = {0};
+    uint64_t t;
+    int idle = 0;
+
+    while(1)
+    {
+        p = ring_pop(&c->full);
+        if(p == NULL)
+        {
+            // 空闲：先短暂让出 CPU，长时间没有数据再睡眠，避免空转占满 CPU
+            if(++idle < 100)
+                sched_yield();
+            else
+                usleep(100);
+            continue;
+        }
+        idle = 0;
+
+        md_get_hdr(p->data, p->len, &h);       // 接收线程已检查过包头
+        // 心跳携带的是该频道最后一个序号：据此发现末尾丢失的包
+        if(h.flags & MD_FLAG_HEARTBEAT)
+            h.seq++;
+        if(expected[h.channel] != 0 && h.seq != expected[h.channel])
+        {
+            __atomic_store_n(&c->gaps, c->gaps + 1, __ATOMIC_RELAXED);
+            if(h.seq > expected[h.channel])
+                __atomic_store_n(&c->missing, c->missing + (h.seq - expected[h.channel]), __ATOMIC_RELAXED);
+        }
+        if(h.seq >= expected[h.channel] && !(h.flags & MD_FLAG_HEARTBEAT))
+            expected[h.channel] = h.seq + 1;
+        else if(h.seq > expected[h.channel])
+            expected[h.channel] = h.seq;
+
+        // 模拟应用处理耗时
+        if(c->work_ns > 0)
+        {
+            t = now_ns() + c->work_ns;
+            while(now_ns() < t)
+                ;
+        }
+
+        __atomic_store_n(&c->processed, c->processed + 1, __ATOMIC_RELAXED);
+        // 归还缓冲区：free 队列容量等于包池大小，不会满
+        ring_push(&c->free, p);
+    }
+    return NULL;
+}
+
+uint64_t now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+void error_handling(char *message)
+{
+    fputs(message, stderr);
+    fputc('\n', stderr);
+    exit(1);
+}
@@ -0,0 +1,237 @@
+#include <stdio.h>      // 标准输入输出：printf / fputs / fputc / fwrite 等
+#include <stdlib.h>     // 标准库：exit / atoi / atof / rand_r 等
+#include <string.h>     // 内存操作：memset / memcpy 等
+#include <stdint.h>     // uint8_t / uint32_t
+#include <unistd.h>     // POSIX：close / getpid 等
+#include <errno.h>      // errno / EAGAIN：接收超时判断
+#include <time.h>       // time：随机数种子
+#include <arpa/inet.h>  // 网络字节序转换：htonl / ntohl / htons 等
+#include <sys/socket.h> // 套接字 API：socket / bind / setsockopt / recvfrom 等
+#include "fec.h"        // GF(256) Reed-Solomon 解码
+
+/*
+ * 带前向纠错（FEC）的组播 Receiver，配合 news_sender_fec 使用
+ *
+ * 按分组收集数据包（格式见 news_sender_fec.c）：
+ *   - 一组 k + m 个包中收到任意 k 个，就用 fec_decode 在本地恢复丢失的片段
+ *   - 各组按分组号顺序输出；某组迟迟凑不够 k 个（后面已经收到了 WINDOW 个分组之后的包，
+ *     或 IDLE_SECS 秒没有新数据），就输出已收到的片段并标记丢失
+ * drop% 参数在接收端随机丢弃数据包，用于在本机上观察 FEC 的恢复效果。
+ * 统计信息输出到 stderr，新闻内容输出到 stdout。
+ *
+ * 用法：news_receiver_fec <PORT> [GroupIP] [drop%]
+ */
+
+#define BUF_SIZE 30
+#define FEC_MAGIC 'F'
+#define FEC_HDR_SIZE 8
+#define BLOCK_SIZE (2 + BUF_SIZE - 1)
+#define MAX_GROUP 32
+#define WINDOW 8                // 同时缓存的分组数
+#define IDLE_SECS 5             // 空闲多久后输出未完成的分组
+
+typedef struct {
+    int used, done;
+    uint32_t group;
+    int k, m, count;
+    int present[MAX_GROUP];
+    uint8_t blocks[MAX_GROUP][BLOCK_SIZE];
+} fec_group;
+
+static fec_group groups[WINDOW];
+static uint32_t next_group;         // 下一个要输出的分组号
+static fec_code* code;
+static int code_k, code_m;
+static unsigned long received, dropped, recovered, lost;
+
+void add_packet(const uint8_t* pkt, int len);
+void try_decode(fec_group* g);
+void flush_group(void);
+void error_handling(char *message);
+
+int main(int argc, char *argv[])
+{
+    int recv_sock, len, started = 0;
+    struct sockaddr_in adr;
+    struct ip_mreq join_adr;
+    struct timeval tv;
+    uint8_t pkt[FEC_HDR_SIZE + BLOCK_SIZE + 16];
+    double drop = 0;
+    unsigned int seed;
+    uint32_t g;
+    int i;
+
+    if(argc < 2 || argc > 4)
+    {
+        printf("Usage : %s <PORT> [GroupIP] [drop%%]\n", argv[0]);
+        exit(1);
+    }
+    if(argc >= 4)
+        drop = atof(argv[3]) / 100.0;
+    seed = (unsigned int)(time(NULL) ^ getpid());
+
+    recv_sock = socket(PF_INET, SOCK_DGRAM, 0);
+    if(recv_sock == -1)
+        error_handling("socket() error");
+
+    memset(&adr, 0, sizeof(adr));
+    adr.sin_family = AF_INET;
+    adr.sin_addr.s_addr = htonl(INADDR_ANY);
+    adr.sin_port = htons(atoi(argv[1]));
+    if(bind(recv_sock, (struct sockaddr*)&adr, sizeof(adr)) == -1)
+        error_handling("bind() error");
+
+    // 指定了组播地址时加入该组（与 news_receiver_gro.c 相同）
+    if(argc >= 3)
+    {
+        join_adr.imr_multiaddr.s_addr = inet_addr(argv[2]);
+        join_adr.imr_interface.s_addr = htonl(INADDR_ANY);
+        if(setsockopt(recv_sock, IPPROTO_IP, IP_ADD_MEMBERSHIP, (void*)&join_adr, sizeof(join_adr)) == -1)
+            error_handling("setsockopt(IP_ADD_MEMBERSHIP) error");
+    }
+
+    tv.tv_sec = IDLE_SECS;
+    tv.tv_usec = 0;
+    setsockopt(recv_sock, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+
+    while(1)
+    {
+        len = recvfrom(recv_sock, pkt, sizeof(pkt), 0, NULL, 0);
+        if(len == -1 && (errno == EAGAIN || errno == EWOULDBLOCK))
+        {
+            // 空闲：输出所有未完成的分组
+            if(started)
+            {
+                for(i = 0; i < WINDOW; i++)
+                    flush_group();
+                fprintf(stderr, "\n[fec] received %lu, dropped %lu, recovered %lu, lost %lu\n",
+                        received, dropped, recovered, lost);
+                started = 0;
+            }
+            continue;
+        }
+        if(len < FEC_HDR_SIZE + BLOCK_SIZE || pkt[0] != FEC_MAGIC)
+            continue;
+
+        if(drop > 0 && rand_r(&seed) < drop * ((double)RAND_MAX + 1))
+        {
+            dropped++;
+            continue;
+        }
+        received++;
+
+        memcpy(&g, pkt + 4, 4);
+        g = ntohl(g);
+        if(!started)
+        {
+            next_group = g;     // 从收到的第一个分组开始输出
+            started = 1;
+        }
+        add_packet(pkt, len);
+    }
+
+    close(recv_sock);
+    return 0;
+}
+
+/* 把一个包放入所属分组，必要时先输出落后太多的分组 */
+void add_packet(const uint8_t* pkt, int len)
+{
+    fec_group* g;
+    uint32_t group;
+    int k = pkt[1], m = pkt[2], idx = pkt[3];
+
+    (void)len;
+    memcpy(&group, pkt + 4, 4);
+    group = ntohl(group);
+    if(k < 1 || m < 1 || k + m > MAX_GROUP || idx >= k + m)
+        return;
+    if((int32_t)(group - next_group) < 0)
+        return;     // 该组已经输出过（迟到或重复的包）
+
+    // 分组号超出缓存窗口：按顺序输出最旧的分组，腾出位置
+    while(group - next_group >= WINDOW)
+        flush_group();
+
+    g = &groups[group % WINDOW];
+    if(!g->used)
+    {
+        memset(g, 0, sizeof(*g));
+        g->used = 1;
+        g->group = group;
+        g->k = k;
+        g->m = m;
+    }
+    if(g->present[idx] || g->done)
+        return;
+    memcpy(g->blocks[idx], pkt + FEC_HDR_SIZE, BLOCK_SIZE);
+    g->present[idx] = 1;
+    g->count++;
+
+    if(g->count >= g->k)
+        try_decode(g);
+
+    // 按顺序输出已完成的分组
+    while(groups[next_group % WINDOW].used && groups[next_group % WINDOW].done)
+        flush_group();
+}
+
+/* 收到 k 个包：恢复丢失的数据块 */
+void try_decode(fec_group* g)
+{
+    uint8_t* blocks[MAX_GROUP];
+    int i, n;
+
+    if(code == NULL || code_k != g->k || code_m != g->m)
+    {
+        fec_free(code);
+        code = fec_new(g->k, g->m);
+        code_k = g->k;
+        code_m = g->m;
+        if(code == NULL)
+            error_handling("fec_new() error");
+    }
+    for(i = 0; i < g->k + g->m; i++)
+        blocks[i] = g->blocks[i];
+    n = fec_decode(code, blocks, g->present, BLOCK_SIZE);
+    if(n < 0)
+        return;
+    recovered += n;
+    for(i = 0; i < g->k; i++)
+        g->present[i] = 1;
+    g->done = 1;
+}
+
+/* 输出 next_group 分组中的片段（缺失的片段标记为丢失），然后前进到下一组 */
+void flush_group(void)
+{
+    fec_group* g = &groups[next_group % WINDOW];
+    int i, len;
+
+    if(g->used && g->group == next_group)
+    {
+        for(i = 0; i < g->k; i++)
+        {
+            if(!g->present[i])
+            {
+                lost++;
+                fputs("[...]", stdout);
+                continue;
+            }
+            len = (g->blocks[i][0] << 8) | g->blocks[i][1];
+            if(len > BUF_SIZE - 1)
+                len = BUF_SIZE - 1;
+            fwrite(g->blocks[i] + 2, 1, len, stdout);
+        }
+        fflush(stdout);
+        g->used = 0;
+    }
+    next_group++;
+}
+
+void error_handling(char *message)
+{
+    fputs(message, stderr);
+    fputc('\n', stderr);
+    exit(1);
+}
@@ -0,0 +1,112 @@
+#include <stdio.h>      // 标准输入输出：printf / fputs / fputc / fwrite 等
+#include <stdlib.h>     // 标准库：exit / atoi 等
+#include <string.h>     // 内存操作：memset / memcpy 等
+#include <unistd.h>     // POSIX：close 等
+#include <netinet/in.h> // IPPROTO_UDP / ip_mreq
+#include <netinet/udp.h> // UDP_GRO：UDP 接收合并
+#include <arpa/inet.h>  // 网络字节序转换：htonl / htons / inet_addr 等
+#include <sys/socket.h> // 套接字 API：socket / bind / setsockopt / recvmsg / CMSG_* 等
+
+/*
+ * 启用 UDP GRO（UDP_GRO）的 Receiver
+ *
+ * news_receiver.c 每次 recvfrom 只能取到一个数据报。启用 UDP_GRO 后，
+ * 内核会把同一条流上连续到达、长度相同的数据报合并成一个大缓冲区一次交给应用，
+ * 并通过控制消息告知原始的分段大小 gso_size。
+ * 应用按 gso_size 自己切分，即可还原出一个个独立的数据报（最后一个可能较短）。
+ *
+ * 可与 news_sender.c 或 news_sender_gso.c 配合运行：
+ *   news_receiver_gro <PORT> [GroupIP]     指定 GroupIP 时加入该组播组
+ */
+
+#define BUF_SIZE 65536                  // 接收缓冲区：要能容纳合并后的数据
+void error_handling(char *message);
+
+int main(int argc, char *argv[])
+{
+    int recv_sock;
+    struct sockaddr_in adr;
+    struct ip_mreq join_adr;
+    int on = 1, str_len, gso_size, off, seg, calls = 0, datagrams = 0;
+    static char buf[BUF_SIZE];
+    char control[CMSG_SPACE(sizeof(int))];
+    struct msghdr msg;
+    struct iovec iov;
+    struct cmsghdr *cmsg;
+
+    if (argc != 2 && argc != 3)
+    {
+        printf("Usage : %s <PORT> [GroupIP]\n", argv[0]);
+        exit(1);
+    }
+
+    recv_sock = socket(PF_INET, SOCK_DGRAM, 0);
+    if (recv_sock == -1)
+        error_handling("socket() error");
+
+    memset(&adr, 0, sizeof(adr));
+    adr.sin_family = AF_INET;
+    adr.sin_addr.s_addr = htonl(INADDR_ANY);
+    adr.sin_port = htons(atoi(argv[1]));
+    if (bind(recv_sock, (struct sockaddr *)&adr, sizeof(adr)) == -1)
+        error_handling("bind() error");
+
+    // 可选：加入组播组
+    if (argc == 3)
+    {
+        join_adr.imr_multiaddr.s_addr = inet_addr(argv[2]);
+        join_adr.imr_interface.s_addr = htonl(INADDR_ANY);
+        if (setsockopt(recv_sock, IPPROTO_IP, IP_ADD_MEMBERSHIP,
+                       (void *)&join_adr, sizeof(join_adr)) == -1)
+            error_handling("setsockopt(IP_ADD_MEMBERSHIP) error");
+    }
+
+    // 开启 UDP_GRO：之后 recvmsg 可能一次返回多个合并的数据报
+    if (setsockopt(recv_sock, IPPROTO_UDP, UDP_GRO, &on, sizeof(on)) == -1)
+        error_handling("setsockopt(UDP_GRO) error (kernel < 5.0?)");
+
+    while (1)
+    {
+        iov.iov_base = buf;
+        iov.iov_len = sizeof(buf);
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+
+        str_len = recvmsg(recv_sock, &msg, 0);
+        if (str_len < 0)
+            break;
+
+        // 取出 gso_size；没有该控制消息说明这次只收到了一个普通数据报
+        gso_size = str_len;
+        for (cmsg = CMSG_FIRSTHDR(&msg); cmsg != NULL; cmsg = CMSG_NXTHDR(&msg, cmsg))
+            if (cmsg->cmsg_level == IPPROTO_UDP && cmsg->cmsg_type == UDP_GRO)
+                memcpy(&gso_size, CMSG_DATA(cmsg), sizeof(int));
+        if (gso_size <= 0)
+            gso_size = str_len;
+
+        // 按 gso_size 切分，逐个处理原始数据报（这里与 news_receiver.c 一样直接输出）
+        for (off = 0; off < str_len; off += seg)
+        {
+            seg = str_len - off < gso_size ? str_len - off : gso_size;
+            fwrite(buf + off, 1, seg, stdout);
+            datagrams++;
+        }
+        fflush(stdout);
+        calls++;
+        fprintf(stderr, "[recvmsg #%d: %d bytes, gso_size %d, %d datagrams so far]\n",
+                calls, str_len, gso_size, datagrams);
+    }
+
+    close(recv_sock);
+    return 0;
+}
+
+void error_handling(char *message)
+{
+    fputs(message, stderr);
+    fputc('\n', stderr);
+    exit(1);
+}
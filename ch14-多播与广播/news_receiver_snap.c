@@ -0,0 +1,265 @@
+#include <stdio.h>      // 标准输入输出：printf / fputs / fputc / fwrite 等
+#include <stdlib.h>     // 标准库：exit / atoi / atof / rand_r 等
+#include <string.h>     // 内存操作：memset / memcpy 等
+#include <stdint.h>     // uint8_t / uint32_t
+#include <unistd.h>     // POSIX：close / read / getpid 等
+#include <time.h>       // time：随机数种子
+#include <sys/select.h> // select：取快照的同时缓存组播增量
+#include <arpa/inet.h>  // 网络地址与字节序：inet_addr / htons / ntohl 等
+#include <sys/socket.h> // 套接字 API：socket / bind / connect / setsockopt / recv 等
+#include "news_snap.h"  // 快照 + 增量协议
+
+/*
+ * 迟到加入的组播新闻 Receiver，配合 news_sender_snap 使用
+ *
+ * news_receiver 启动之前发送的新闻全部收不到。这里的做法是"快照 + 增量"：
+ *   1. 先加入组播组，再连接发布端的 TCP 快照服务——顺序很重要：
+ *      这样快照之后的每一条增量都一定已经在组播套接字上排队了
+ *   2. 接收快照期间，用 select 同时读组播套接字，把收到的增量缓存起来
+ *   3. 快照带有它对应的序号 S：缓存中序号 <= S 的增量已经包含在快照里，直接丢弃；
+ *      其余的按顺序应用到看板上，然后转入正常接收
+ * 不需要重放任何历史新闻，状态只有 NEWS_SLOTS 个栏位。
+ *
+ * 运行中如果发现序号不连续（丢包），或缓存溢出，就重新取一次快照，而不是等待重传。
+ * drop% 参数在接收端随机丢弃组播包，用于观察重新同步的过程。
+ *
+ * 用法：news_receiver_snap <GroupIP> <PORT> <SnapshotIP> <TCP_PORT> [drop%]
+ */
+
+#define PENDING_MAX 256         // 取快照期间最多缓存的增量数
+#define PKT_MAX (NEWS_UPD_HDR + NEWS_TEXT_MAX)
+#define SNAP_MAX (NEWS_SNAP_HDR + NEWS_SLOTS * (2 + NEWS_TEXT_MAX))
+
+typedef struct {
+    int len;
+    uint8_t data[PKT_MAX];
+} pending_pkt;
+
+static char board[NEWS_SLOTS][NEWS_TEXT_MAX];
+static int board_len[NEWS_SLOTS];
+static uint32_t cur_seq;                // 看板上最后应用的序号
+static pending_pkt pending[PENDING_MAX];
+static int npending;
+static double drop;
+static unsigned int seed;
+static unsigned long dropped, discarded, snapshots;    // discarded：本次快照已包含的缓存增量数
+
+int recv_update(int sock, uint8_t* buf);
+int resync(int udp_sock, struct sockaddr_in* snap_adr);
+int apply_update(const uint8_t* pkt, int n);
+void error_handling(char *message);
+
+int main(int argc, char *argv[])
+{
+    int recv_sock, len;
+    struct sockaddr_in adr, snap_adr;
+    struct ip_mreq join_adr;
+    uint8_t pkt[PKT_MAX];
+
+    if(argc < 5 || argc > 6)
+    {
+        printf("Usage : %s <GroupIP> <PORT> <SnapshotIP> <TCP_PORT> [drop%%]\n", argv[0]);
+        exit(1);
+    }
+    if(argc == 6)
+        drop = atof(argv[5]) / 100.0;
+    seed = (unsigned int)(time(NULL) ^ getpid());
+
+    recv_sock = socket(PF_INET, SOCK_DGRAM, 0);
+    if(recv_sock == -1)
+        error_handling("socket() error");
+    memset(&adr, 0, sizeof(adr));
+    adr.sin_family = AF_INET;
+    adr.sin_addr.s_addr = htonl(INADDR_ANY);
+    adr.sin_port = htons(atoi(argv[2]));
+    if(bind(recv_sock, (struct sockaddr*)&adr, sizeof(adr)) == -1)
+        error_handling("bind() error");
+
+    // 1. 先加入组播组：从此刻起的增量都会在 recv_sock 上排队
+    join_adr.imr_multiaddr.s_addr = inet_addr(argv[1]);
+    join_adr.imr_interface.s_addr = htonl(INADDR_ANY);
+    if(setsockopt(recv_sock, IPPROTO_IP, IP_ADD_MEMBERSHIP, (void*)&join_adr, sizeof(join_adr)) == -1)
+        error_handling("setsockopt(IP_ADD_MEMBERSHIP) error");
+
+    memset(&snap_adr, 0, sizeof(snap_adr));
+    snap_adr.sin_family = AF_INET;
+    snap_adr.sin_addr.s_addr = inet_addr(argv[3]);
+    snap_adr.sin_port = htons(atoi(argv[4]));
+
+    // 2、3. 取快照并应用缓存的增量
+    while(resync(recv_sock, &snap_adr) == -1)
+        sleep(1);
+
+    // -------------------- 正常接收：增量必须连续，否则重新同步 --------------------
+    while(1)
+    {
+        len = recv_update(recv_sock, pkt);
+        if(len <= 0)
+            continue;
+        if(apply_update(pkt, len) == -1)
+        {
+            fprintf(stderr, "[snap] gap after seq %u, resyncing\n", cur_seq);
+            while(resync(recv_sock, &snap_adr) == -1)
+                sleep(1);
+        }
+    }
+
+    close(recv_sock);
+    return 0;
+}
+
+/* 读一个组播包（按 drop% 模拟丢包）：被丢弃返回 0 */
+int recv_update(int sock, uint8_t* buf)
+{
+    int len = recvfrom(sock, buf, PKT_MAX, 0, NULL, 0);
+
+    if(len > 0 && drop > 0 && rand_r(&seed) < drop * ((double)RAND_MAX + 1))
+    {
+        dropped++;
+        return 0;
+    }
+    return len;
+}
+
+/*
+ * 取一次快照：连接快照服务，读到对方关闭连接为止；期间收到的组播增量放进 pending。
+ * 然后用快照替换看板，按顺序应用 pending 中序号在快照之后的增量。
+ * 连接失败或缓存的增量不连续（取快照期间丢了包）返回 -1，调用者稍后重试
+ */
+int resync(int udp_sock, struct sockaddr_in* snap_adr)
+{
+    static uint8_t snap[SNAP_MAX];
+    int tcp_sock, got = 0, n, i, nslots, off, len, maxfd;
+    fd_set reads;
+    uint32_t v32, snap_seq;
+    uint16_t v16;
+
+    tcp_sock = socket(PF_INET, SOCK_STREAM, 0);
+    if(tcp_sock == -1)
+        error_handling("socket() error");
+    if(connect(tcp_sock, (struct sockaddr*)snap_adr, sizeof(*snap_adr)) == -1)
+    {
+        fprintf(stderr, "[snap] connect() error, retrying\n");
+        close(tcp_sock);
+        return -1;
+    }
+
+    npending = 0;
+    discarded = 0;
+    maxfd = tcp_sock > udp_sock ? tcp_sock : udp_sock;
+    while(1)
+    {
+        FD_ZERO(&reads);
+        FD_SET(tcp_sock, &reads);
+        FD_SET(udp_sock, &reads);
+        if(select(maxfd + 1, &reads, 0, 0, NULL) == -1)
+            break;
+        if(FD_ISSET(udp_sock, &reads))
+        {
+            if(npending == PENDING_MAX)
+            {
+                // 缓存满了：快照太慢，放弃这次快照
+                close(tcp_sock);
+                return -1;
+            }
+            n = recv_update(udp_sock, pending[npending].data);
+            if(n > 0)
+                pending[npending++].len = n;
+        }
+        if(FD_ISSET(tcp_sock, &reads))
+        {
+            n = read(tcp_sock, snap + got, SNAP_MAX - got);
+            if(n <= 0)
+                break;      // 服务器发送完快照后关闭连接
+            got += n;
+        }
+    }
+    close(tcp_sock);
+
+    // -------------------- 解析快照 --------------------
+    if(got < NEWS_SNAP_HDR)
+        return -1;
+    memcpy(&v32, snap, 4);
+    if(ntohl(v32) != NEWS_SNAP_MAGIC)
+        return -1;
+    memcpy(&v32, snap + 4, 4);
+    snap_seq = ntohl(v32);
+    memcpy(&v16, snap + 8, 2);
+    nslots = ntohs(v16);
+    if(nslots != NEWS_SLOTS)
+        return -1;
+    off = NEWS_SNAP_HDR;
+    for(i = 0; i < NEWS_SLOTS; i++)
+    {
+        if(off + 2 > got)
+            return -1;
+        memcpy(&v16, snap + off, 2);
+        len = ntohs(v16);
+        if(len > NEWS_TEXT_MAX || off + 2 + len > got)
+            return -1;
+        memcpy(board[i], snap + off + 2, len);
+        board_len[i] = len;
+        off += 2 + len;
+    }
+    cur_seq = snap_seq;
+    snapshots++;
+
+    // 按序号从旧到新输出看板
+    printf("==== snapshot at seq %u (%d bytes) ====\n", snap_seq, got);
+    for(i = NEWS_SLOTS - 1; i >= 0; i--)
+    {
+        if(snap_seq < (uint32_t)i + 1)
+            continue;
+        len = board_len[(snap_seq - i) % NEWS_SLOTS];
+        printf("[%u] ", snap_seq - i);
+        fwrite(board[(snap_seq - i) % NEWS_SLOTS], 1, len, stdout);
+        if(len == 0 || board[(snap_seq - i) % NEWS_SLOTS][len - 1] != '\n')
+            putchar('\n');
+    }
+    printf("==== live ====\n");
+
+    // -------------------- 应用快照之后的缓存增量 --------------------
+    for(i = 0; i < npending; i++)
+    {
+        if(apply_update(pending[i].data, pending[i].len) == -1)
+            return -1;
+    }
+    fprintf(stderr, "[snap] snapshot #%lu at seq %u, %d buffered updates (%lu already in snapshot), "
+            "now at seq %u, %lu dropped so far\n", snapshots, snap_seq, npending, discarded, cur_seq, dropped);
+    fflush(stdout);
+    return 0;
+}
+
+/* 应用一条增量：已包含在看板中的返回 0 并忽略，正好是下一条则应用，出现缺口返回 -1 */
+int apply_update(const uint8_t* pkt, int n)
+{
+    int slot, len;
+    uint32_t seq;
+
+    if(news_get_upd(pkt, n, &slot, &len, &seq) == -1)
+        return 0;
+    if((int32_t)(seq - cur_seq) <= 0)
+    {
+        discarded++;
+        return 0;
+    }
+    if(seq != cur_seq + 1)
+        return -1;
+
+    memcpy(board[slot], pkt + NEWS_UPD_HDR, len);
+    board_len[slot] = len;
+    cur_seq = seq;
+    printf("[%u] ", seq);
+    fwrite(pkt + NEWS_UPD_HDR, 1, len, stdout);
+    if(len == 0 || pkt[NEWS_UPD_HDR + len - 1] != '\n')
+        putchar('\n');
+    fflush(stdout);
+    return 0;
+}
+
+void error_handling(char *message)
+{
+    fputs(message, stderr);
+    fputc('\n', stderr);
+    exit(1);
+}
@@ -0,0 +1,154 @@
+#include <stdio.h>      // 标准输入输出：printf / fputs / fputc / FILE / fopen / fgets / fclose 等
+#include <stdlib.h>     // 标准库：exit / atoi 等
+#include <string.h>     // 字符串操作：memset / memcpy / strlen 等
+#include <stdint.h>     // uint8_t / uint32_t
+#include <unistd.h>     // POSIX：close / usleep 等
+#include <arpa/inet.h>  // 网络地址与字节序：inet_addr / htons / htonl 等
+#include <sys/socket.h> // 套接字 API：socket / setsockopt / sendto 等
+#include "fec.h"        // GF(256) Reed-Solomon 编码
+
+/*
+ * 带前向纠错（FEC）的组播 Sender
+ *
+ * 与 news_sender.c 一样按 BUF_SIZE 读取 news.txt 的片段，但每 k 个片段组成一个 FEC 分组，
+ * 额外发送 m 个校验包。接收端收到分组中任意 k 个包就能在本地恢复丢失的片段，
+ * 不需要请求重传，也就没有重传的往返时延：
+ *   - m = 1：校验包是 k 个片段的异或，每组可以恢复 1 个丢失的包
+ *   - m > 1：Reed-Solomon 码，每组最多可以恢复 m 个丢失的包
+ * 代价是多发送 m/k 的流量。
+ *
+ * 数据包格式：
+ *   [1 魔数 'F'][1 k][1 m][1 组内下标][4 分组号] + 受保护的块
+ * 块（所有块等长，校验包也按块计算）：
+ *   [2 片段长度][片段内容，不足 BUF_SIZE - 1 时补 0]
+ * 片段长度放在块内一起参与编码，恢复出的块自然带有正确的长度。
+ *
+ * 用法：news_sender_fec <GroupIP> <PORT> [k] [m] [interval_ms]
+ */
+
+#define TTL 64                  // 组播 TTL
+#define BUF_SIZE 30             // 与 news_sender.c 相同：每个片段最多 29 字节
+#define FEC_MAGIC 'F'
+#define FEC_HDR_SIZE 8
+#define BLOCK_SIZE (2 + BUF_SIZE - 1)
+#define MAX_GROUP 32            // k + m 的上限（演示程序用小分组即可）
+#define DEFAULT_K 4
+#define DEFAULT_M 1
+#define DEFAULT_INTERVAL_MS 100 // 每个数据报之间的间隔（news_sender.c 为 2 秒）
+void send_group(int sock, struct sockaddr_in* addr, fec_code* f, int k, int m,
+                uint32_t group, uint8_t blocks[][BLOCK_SIZE], int interval_ms);
+void error_handling(char* message);
+
+int main(int argc, char* argv[])
+{
+    int send_sock;
+    struct sockaddr_in mul_addr;
+    int time_live = TTL;
+    int k = DEFAULT_K, m = DEFAULT_M, interval_ms = DEFAULT_INTERVAL_MS, n, len;
+    FILE* fp;
+    char buf[BUF_SIZE];
+    static uint8_t blocks[MAX_GROUP][BLOCK_SIZE];
+    fec_code* f;
+    uint32_t group = 0;
+
+    if(argc < 3 || argc > 6)
+    {
+        printf("Usage: %s <GroupIP> <PORT> [k] [m] [interval_ms]\n", argv[0]);
+        exit(1);
+    }
+    if(argc >= 4)
+        k = atoi(argv[3]);
+    if(argc >= 5)
+        m = atoi(argv[4]);
+    if(argc >= 6)
+        interval_ms = atoi(argv[5]);
+    if(k < 1 || m < 1 || k + m > MAX_GROUP || interval_ms < 0)
+        error_handling("invalid k, m or interval");
+
+    f = fec_new(k, m);
+    if(f == NULL)
+        error_handling("fec_new() error");
+
+    send_sock = socket(PF_INET, SOCK_DGRAM, 0);
+    if(send_sock == -1)
+        error_handling("socket() error");
+
+    memset(&mul_addr, 0, sizeof(mul_addr));
+    mul_addr.sin_family = AF_INET;
+    mul_addr.sin_addr.s_addr = inet_addr(argv[1]);
+    mul_addr.sin_port = htons(atoi(argv[2]));
+
+    setsockopt(send_sock, IPPROTO_IP, IP_MULTICAST_TTL,
+        (void*)&time_live, sizeof(time_live));
+
+    if((fp = fopen("news.txt", "r")) == NULL)
+        error_handling("fopen() error");
+
+    printf("FEC groups: %d data + %d parity (%s)\n", k, m, m == 1 ? "XOR" : "Reed-Solomon");
+
+    // -------------------- 每凑满 k 个片段编码并发送一组 --------------------
+    n = 0;
+    while(fgets(buf, BUF_SIZE, fp) != NULL)
+    {
+        len = strlen(buf);
+        memset(blocks[n], 0, BLOCK_SIZE);
+        blocks[n][0] = (uint8_t)(len >> 8);
+        blocks[n][1] = (uint8_t)len;
+        memcpy(blocks[n] + 2, buf, len);
+        if(++n == k)
+        {
+            send_group(send_sock, &mul_addr, f, k, m, group++, blocks, interval_ms);
+            n = 0;
+        }
+    }
+    // 最后一组不足 k 个片段：用长度为 0 的空块补齐，接收端会跳过它们
+    if(n > 0)
+    {
+        for(; n < k; n++)
+            memset(blocks[n], 0, BLOCK_SIZE);
+        send_group(send_sock, &mul_addr, f, k, m, group++, blocks, interval_ms);
+    }
+    printf("sent %u groups\n", group);
+
+    fclose(fp);
+    fec_free(f);
+    close(send_sock);
+    return 0;
+}
+
+/* 计算一组的 m 个校验块，然后依次发送 k 个数据包和 m 个校验包 */
+void send_group(int sock, struct sockaddr_in* addr, fec_code* f, int k, int m,
+                uint32_t group, uint8_t blocks[][BLOCK_SIZE], int interval_ms)
+{
+    uint8_t pkt[FEC_HDR_SIZE + BLOCK_SIZE];
+    const uint8_t* data[MAX_GROUP];
+    uint8_t* parity[MAX_GROUP];
+    uint32_t g = htonl(group);
+    int i;
+
+    for(i = 0; i < k; i++)
+        data[i] = blocks[i];
+    for(i = 0; i < m; i++)
+        parity[i] = blocks[k + i];
+    fec_encode(f, data, parity, BLOCK_SIZE);
+
+    for(i = 0; i < k + m; i++)
+    {
+        pkt[0] = FEC_MAGIC;
+        pkt[1] = (uint8_t)k;
+        pkt[2] = (uint8_t)m;
+        pkt[3] = (uint8_t)i;
+        memcpy(pkt + 4, &g, 4);
+        memcpy(pkt + FEC_HDR_SIZE, blocks[i], BLOCK_SIZE);
+        sendto(sock, pkt, sizeof(pkt), 0, (struct sockaddr*)addr, sizeof(*addr));
+        if(interval_ms > 0)
+            usleep(interval_ms * 1000);
+    }
+}
+
+void error_handling(char *message)
+{
+    fputs(message, stderr);
+    fputc('\n', stderr);
+    exit(1);
+}
@@ -0,0 +1,118 @@
+#include <stdio.h>      // 标准输入输出：printf / fputs / fputc / FILE / fopen / fread / fclose 等
+#include <stdlib.h>     // 标准库：exit / atoi 等
+#include <string.h>     // 字符串操作：memset 等
+#include <stdint.h>     // uint16_t：UDP_SEGMENT 控制消息的数据类型
+#include <unistd.h>     // POSIX：close 等
+#include <netinet/in.h> // IPPROTO_UDP
+#include <netinet/udp.h> // UDP_SEGMENT：UDP 分段卸载（GSO）
+#include <arpa/inet.h>  // 网络地址与字节序：inet_addr / htons 等
+#include <sys/socket.h> // 套接字 API：socket / setsockopt / sendmsg / CMSG_* 等
+
+/*
+ * 使用 UDP GSO（UDP_SEGMENT）批量发送的组播 Sender
+ *
+ * news_sender.c 每个 30 字节的片段都调用一次 sendto，并 sleep(2)。
+ * 批量发送时，逐个 sendto 的系统调用和协议栈开销会成为瓶颈。
+ *
+ * 本示例把 news.txt 整个读入内存，按固定长度 seg_size 切成片段，
+ * 每次 sendmsg 交给内核最多 MAX_SEGS 个片段，并通过控制消息 UDP_SEGMENT 告诉内核分段大小。
+ * 内核在协议栈最底层再切成独立的 UDP 数据报（最后一个可以短一些），
+ * 对接收端来说与逐个 sendto 发送的数据报完全相同，news_receiver.c 无需任何修改即可接收。
+ */
+
+#define TTL 64                  // 组播 TTL
+#define DEFAULT_SEG_SIZE 29     // 默认片段长度：与 news_sender.c 的 BUF_SIZE-1 相同
+#define MAX_SEGS 64             // 内核限制：一次 GSO 最多 64 个分段
+#define FILE_BUF_SIZE 65536     // news.txt 读入缓冲区
+void error_handling(char* message);
+
+int main(int argc, char* argv[])
+{
+    int send_sock;
+    struct sockaddr_in mul_addr;
+    int time_live = TTL;
+    int seg_size = DEFAULT_SEG_SIZE;
+    FILE* fp;
+    static char buf[FILE_BUF_SIZE];
+    size_t file_len, off, len;
+    int calls = 0, datagrams = 0;
+
+    struct msghdr msg;
+    struct iovec iov;
+    char control[CMSG_SPACE(sizeof(uint16_t))]; // 控制消息缓冲区：携带 uint16_t 类型的分段大小
+    struct cmsghdr* cmsg;
+
+    if(argc != 3 && argc != 4)
+    {
+        printf("Usage: %s <GroupIP> <PORT> [seg_size]\n", argv[0]);
+        exit(1);
+    }
+    if(argc == 4)
+        seg_size = atoi(argv[3]);
+    if(seg_size < 1 || seg_size * MAX_SEGS > FILE_BUF_SIZE)
+        error_handling("invalid seg_size");
+
+    send_sock = socket(PF_INET, SOCK_DGRAM, 0);
+    if(send_sock == -1)
+        error_handling("socket() error");
+
+    memset(&mul_addr, 0, sizeof(mul_addr));
+    mul_addr.sin_family = AF_INET;
+    mul_addr.sin_addr.s_addr = inet_addr(argv[1]);
+    mul_addr.sin_port = htons(atoi(argv[2]));
+
+    setsockopt(send_sock, IPPROTO_IP, IP_MULTICAST_TTL,
+        (void*)&time_live, sizeof(time_live));
+
+    // -------------------- 一次性读入整个文件 --------------------
+    if((fp = fopen("news.txt", "r")) == NULL)
+        error_handling("fopen() error");
+    file_len = fread(buf, 1, sizeof(buf), fp);
+    fclose(fp);
+
+    // -------------------- 准备 sendmsg 所需的结构 --------------------
+    // 与 setsockopt(UDP_SEGMENT) 设置套接字级默认值不同，这里通过 cmsg 逐次指定分段大小，
+    // 同一个套接字可以在不同的 sendmsg 中使用不同的分段大小
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_name = &mul_addr;
+    msg.msg_namelen = sizeof(mul_addr);
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+
+    cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = IPPROTO_UDP;     // 协议层：UDP
+    cmsg->cmsg_type = UDP_SEGMENT;      // 类型：分段大小
+    cmsg->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+    *(uint16_t*)CMSG_DATA(cmsg) = (uint16_t)seg_size;
+
+    // -------------------- 每次交给内核最多 MAX_SEGS 个片段 --------------------
+    for(off = 0; off < file_len; off += len)
+    {
+        len = file_len - off;
+        if(len > (size_t)seg_size * MAX_SEGS)
+            len = (size_t)seg_size * MAX_SEGS;
+
+        iov.iov_base = buf + off;
+        iov.iov_len = len;
+        if(sendmsg(send_sock, &msg, 0) == -1)
+            error_handling("sendmsg() error (kernel < 4.18?)");
+
+        calls++;
+        datagrams += (int)((len + seg_size - 1) / seg_size);
+    }
+
+    printf("sent %zu bytes as %d datagrams in %d sendmsg() calls\n",
+           file_len, datagrams, calls);
+
+    close(send_sock);
+    return 0;
+}
+
+void error_handling(char *message)
+{
+    fputs(message, stderr);
+    fputc('\n', stderr);
+    exit(1);
+}
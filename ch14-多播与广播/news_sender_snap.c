@@ -0,0 +1,192 @@
+#include <stdio.h>      // 标准输入输出：printf / fputs / fputc / FILE / fopen / fgets 等
+#include <stdlib.h>     // 标准库：exit / atoi 等
+#include <string.h>     // 字符串操作：memset / memcpy / strlen 等
+#include <stdint.h>     // uint8_t / uint32_t
+#include <unistd.h>     // POSIX：close / write 等
+#include <signal.h>     // signal：忽略 SIGPIPE（接收端提前断开时 write 返回错误而不是终止进程）
+#include <time.h>       // clock_gettime
+#include <sys/select.h> // select：在发送间隔中等待快照请求
+#include <arpa/inet.h>  // 网络地址与字节序：inet_addr / htons / htonl 等
+#include <sys/socket.h> // 套接字 API：socket / setsockopt / bind / listen / accept / sendto 等
+#include "news_snap.h"  // 快照 + 增量协议
+
+/*
+ * 支持迟到接收端的组播新闻 Sender
+ *
+ * 与 news_sender.c 一样逐行读取 news.txt 组播发送（读到文件末尾后从头循环），
+ * 但每条新闻带上序号，并写入内存中的新闻看板（格式见 news_snap.h）。
+ * 同时在 TCP 端口上提供快照服务：接收端连接后，立即收到当前看板的完整内容和对应的序号。
+ *
+ * 单线程：用 select 等待下一次发送的时刻，期间有快照请求就处理。快照在两次发送之间生成，
+ * 看板内容与快照序号一定是一致的。
+ *
+ * 用法：news_sender_snap <GroupIP> <PORT> <TCP_PORT> [interval_ms]
+ */
+
+#define TTL 64
+#define DEFAULT_INTERVAL_MS 500
+
+static char board[NEWS_SLOTS][NEWS_TEXT_MAX];
+static int board_len[NEWS_SLOTS];
+static uint32_t last_seq;           // 看板上最后应用的序号（0 表示还没有发送过）
+
+void serve_snapshot(int serv_sock);
+int write_full(int fd, const void* buf, int len);
+long long now_ms(void);
+void error_handling(char* message);
+
+int main(int argc, char* argv[])
+{
+    int send_sock, serv_sock, interval_ms = DEFAULT_INTERVAL_MS, len, slot, option = 1;
+    struct sockaddr_in mul_addr, serv_adr;
+    int time_live = TTL;
+    FILE* fp;
+    char line[NEWS_TEXT_MAX + 1];
+    uint8_t pkt[NEWS_UPD_HDR + NEWS_TEXT_MAX];
+    long long next_send, wait;
+    fd_set reads;
+    struct timeval timeout;
+
+    if(argc < 4 || argc > 5)
+    {
+        printf("Usage: %s <GroupIP> <PORT> <TCP_PORT> [interval_ms]\n", argv[0]);
+        exit(1);
+    }
+    if(argc == 5)
+        interval_ms = atoi(argv[4]);
+    if(interval_ms < 1)
+        error_handling("invalid interval");
+    signal(SIGPIPE, SIG_IGN);
+
+    send_sock = socket(PF_INET, SOCK_DGRAM, 0);
+    if(send_sock == -1)
+        error_handling("socket() error");
+    memset(&mul_addr, 0, sizeof(mul_addr));
+    mul_addr.sin_family = AF_INET;
+    mul_addr.sin_addr.s_addr = inet_addr(argv[1]);
+    mul_addr.sin_port = htons(atoi(argv[2]));
+    setsockopt(send_sock, IPPROTO_IP, IP_MULTICAST_TTL, (void*)&time_live, sizeof(time_live));
+
+    // -------------------- 快照服务的 TCP 监听套接字 --------------------
+    serv_sock = socket(PF_INET, SOCK_STREAM, 0);
+    if(serv_sock == -1)
+        error_handling("socket() error");
+    setsockopt(serv_sock, SOL_SOCKET, SO_REUSEADDR, &option, sizeof(option));
+    memset(&serv_adr, 0, sizeof(serv_adr));
+    serv_adr.sin_family = AF_INET;
+    serv_adr.sin_addr.s_addr = htonl(INADDR_ANY);
+    serv_adr.sin_port = htons(atoi(argv[3]));
+    if(bind(serv_sock, (struct sockaddr*)&serv_adr, sizeof(serv_adr)) == -1)
+        error_handling("bind() error");
+    if(listen(serv_sock, 16) == -1)
+        error_handling("listen() error");
+
+    if((fp = fopen("news.txt", "r")) == NULL)
+        error_handling("fopen() error");
+
+    next_send = now_ms();
+    while(1)
+    {
+        // -------------------- 等到下一次发送时刻，期间处理快照请求 --------------------
+        wait = next_send - now_ms();
+        if(wait > 0)
+        {
+            FD_ZERO(&reads);
+            FD_SET(serv_sock, &reads);
+            timeout.tv_sec = wait / 1000;
+            timeout.tv_usec = (wait % 1000) * 1000;
+            if(select(serv_sock + 1, &reads, 0, 0, &timeout) > 0)
+                serve_snapshot(serv_sock);
+            continue;
+        }
+        next_send += interval_ms;
+
+        // -------------------- 读一行新闻：写入看板，然后组播增量 --------------------
+        if(fgets(line, sizeof(line), fp) == NULL)
+        {
+            rewind(fp);     // 读完了从头循环，模拟持续不断的新闻流
+            continue;
+        }
+        len = strlen(line);
+        last_seq++;
+        slot = last_seq % NEWS_SLOTS;
+        memcpy(board[slot], line, len);
+        board_len[slot] = len;
+
+        news_put_upd(pkt, slot, len, last_seq);
+        memcpy(pkt + NEWS_UPD_HDR, line, len);
+        sendto(send_sock, pkt, NEWS_UPD_HDR + len, 0, (struct sockaddr*)&mul_addr, sizeof(mul_addr));
+    }
+
+    fclose(fp);
+    close(serv_sock);
+    close(send_sock);
+    return 0;
+}
+
+/* 接受一个快照请求：发送看板的全部栏位和对应序号，然后关闭连接 */
+void serve_snapshot(int serv_sock)
+{
+    int clnt_sock, i, n = NEWS_SNAP_HDR;
+    struct sockaddr_in clnt_adr;
+    socklen_t adr_sz = sizeof(clnt_adr);
+    static uint8_t buf[NEWS_SNAP_HDR + NEWS_SLOTS * (2 + NEWS_TEXT_MAX)];
+    uint32_t v32;
+    uint16_t v16;
+
+    clnt_sock = accept(serv_sock, (struct sockaddr*)&clnt_adr, &adr_sz);
+    if(clnt_sock == -1)
+        return;
+
+    v32 = htonl(NEWS_SNAP_MAGIC);
+    memcpy(buf, &v32, 4);
+    v32 = htonl(last_seq);
+    memcpy(buf + 4, &v32, 4);
+    v16 = htons(NEWS_SLOTS);
+    memcpy(buf + 8, &v16, 2);
+    for(i = 0; i < NEWS_SLOTS; i++)
+    {
+        v16 = htons((uint16_t)board_len[i]);
+        memcpy(buf + n, &v16, 2);
+        memcpy(buf + n + 2, board[i], board_len[i]);
+        n += 2 + board_len[i];
+    }
+    // 快照只有几 KB，一次写入 TCP 发送缓冲区即可，不会长时间阻塞组播发送
+    if(write_full(clnt_sock, buf, n) == 0)
+        printf("snapshot at seq %u sent to %s:%d (%d bytes)\n", last_seq,
+               inet_ntoa(clnt_adr.sin_addr), ntohs(clnt_adr.sin_port), n);
+    fflush(stdout);
+    close(clnt_sock);
+}
+
+/* 写满 len 字节：成功返回 0 */
+int write_full(int fd, const void* buf, int len)
+{
+    const char* p = buf;
+    int n;
+
+    while(len > 0)
+    {
+        n = write(fd, p, len);
+        if(n <= 0)
+            return -1;
+        p += n;
+        len -= n;
+    }
+    return 0;
+}
+
+long long now_ms(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000LL + ts.tv_nsec / 1000000;
+}
+
+void error_handling(char *message)
+{
+    fputs(message, stderr);
+    fputc('\n', stderr);
+    exit(1);
+}
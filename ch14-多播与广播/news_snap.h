@@ -0,0 +1,57 @@
+#ifndef NEWS_SNAP_H
+#define NEWS_SNAP_H
+
+#include <stdint.h>     // uint8_t / uint32_t
+#include <string.h>     // memcpy
+#include <arpa/inet.h>  // htonl / ntohl / htons / ntohs
+
+/*
+ * 快照 + 增量的新闻组播协议，news_sender_snap 与 news_receiver_snap 共用
+ *
+ * 发布端维护一块"新闻看板"：NEWS_SLOTS 个栏位，每条新闻写入 (序号 % NEWS_SLOTS) 栏位，
+ * 覆盖该栏位上的旧新闻。看板就是全部状态，大小固定，与已发布的历史长度无关。
+ *
+ * 组播增量（每条新闻一个数据报）：
+ *   [1 'U'][1 栏位][2 正文长度][4 序号] + 正文
+ * TCP 快照（连接后服务器发送完即关闭）：
+ *   [4 'SNAP'][4 快照对应的序号][2 栏位数]，然后每个栏位 [2 正文长度] + 正文
+ * 快照的序号是已经应用到看板上的最后一条增量；迟到的接收端在此序号之后的增量上继续即可。
+ */
+
+#define NEWS_SLOTS 8
+#define NEWS_TEXT_MAX 512
+#define NEWS_UPD_MAGIC 'U'
+#define NEWS_UPD_HDR 8
+#define NEWS_SNAP_MAGIC 0x534e4150u     // "SNAP"
+#define NEWS_SNAP_HDR 10
+
+static inline void news_put_upd(uint8_t* p, int slot, int len, uint32_t seq)
+{
+    uint16_t v16 = htons((uint16_t)len);
+    uint32_t v32 = htonl(seq);
+
+    p[0] = NEWS_UPD_MAGIC;
+    p[1] = (uint8_t)slot;
+    memcpy(p + 2, &v16, 2);
+    memcpy(p + 4, &v32, 4);
+}
+
+/* 解析增量包头：格式错误返回 -1 */
+static inline int news_get_upd(const uint8_t* p, int n, int* slot, int* len, uint32_t* seq)
+{
+    uint16_t v16;
+    uint32_t v32;
+
+    if(n < NEWS_UPD_HDR || p[0] != NEWS_UPD_MAGIC || p[1] >= NEWS_SLOTS)
+        return -1;
+    memcpy(&v16, p + 2, 2);
+    memcpy(&v32, p + 4, 4);
+    *slot = p[1];
+    *len = ntohs(v16);
+    *seq = ntohl(v32);
+    if(*len > NEWS_TEXT_MAX || NEWS_UPD_HDR + *len > n)
+        return -1;
+    return 0;
+}
+
+#endif
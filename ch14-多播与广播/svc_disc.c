@@ -0,0 +1,295 @@
+#include <stdlib.h>     // malloc / free / rand_r
+#include <string.h>     // memset / memcpy / strncpy / strcmp
+#include <unistd.h>     // close / getpid / usleep
+#include <poll.h>       // poll：带超时地等待公告
+#include <time.h>       // clock_gettime / time
+#include <pthread.h>    // pthread_create：公告线程
+#include <arpa/inet.h>  // inet_addr / htons / htonl / ntohl 等
+#include <sys/socket.h> // socket / setsockopt / sendto / recvfrom 等
+#include "svc_disc.h"
+
+/*
+ * svc_disc 的实现，接口说明见 svc_disc.h
+ */
+
+#define DISC_MAGIC 0x5344               // "SD"
+#define DISC_VERSION 1
+#define DISC_TICK_MS 100                // 公告线程检查负载变化的周期
+#define DISC_EXPIRE_INTERVALS 3         // 超过几个公告间隔没有消息就认为实例已下线
+
+typedef struct {
+    int sock;
+    struct sockaddr_in dst;
+    char service[DISC_NAME_LEN];
+    int svc_port, capacity;
+    const int* load;
+    uint32_t instance;
+} announcer;
+
+static int64_t now_ms(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000LL + ts.tv_nsec / 1000000;
+}
+
+static void put_announce(uint8_t* p, const announcer* a, uint32_t load)
+{
+    uint16_t v16;
+    uint32_t v32;
+
+    memset(p, 0, DISC_PKT_SIZE);
+    v16 = htons(DISC_MAGIC);
+    memcpy(p, &v16, 2);
+    p[2] = DISC_VERSION;
+    memcpy(p + 4, a->service, DISC_NAME_LEN);
+    v16 = htons((uint16_t)a->svc_port);
+    memcpy(p + 20, &v16, 2);
+    v32 = htonl(load);
+    memcpy(p + 24, &v32, 4);
+    v32 = htonl((uint32_t)a->capacity);
+    memcpy(p + 28, &v32, 4);
+    v32 = htonl(a->instance);
+    memcpy(p + 32, &v32, 4);
+    v32 = htonl(DISC_INTERVAL_MS);
+    memcpy(p + 36, &v32, 4);
+}
+
+/*
+ * 公告线程：每 DISC_INTERVAL_MS（加减 10% 的随机抖动，避免多个实例同步发送）公告一次；
+ * 负载变化超过容量的 1/10 时提前公告，让客户端尽快看到新的负载
+ */
+static void* announce_main(void* arg)
+{
+    announcer* a = (announcer*)arg;
+    uint8_t pkt[DISC_PKT_SIZE];
+    unsigned int seed = a->instance;
+    int64_t next = 0, now;
+    int load, last_load = -1, step = a->capacity / 10 > 0 ? a->capacity / 10 : 1;
+
+    while(1)
+    {
+        now = now_ms();
+        load = __atomic_load_n(a->load, __ATOMIC_RELAXED);
+        if(now >= next || last_load < 0 || load - last_load >= step || last_load - load >= step)
+        {
+            put_announce(pkt, a, load < 0 ? 0 : (uint32_t)load);
+            sendto(a->sock, pkt, sizeof(pkt), 0, (struct sockaddr*)&a->dst, sizeof(a->dst));
+            last_load = load;
+            next = now + DISC_INTERVAL_MS * 9 / 10 + rand_r(&seed) % (DISC_INTERVAL_MS / 5 + 1);
+        }
+        usleep(DISC_TICK_MS * 1000);
+    }
+    return NULL;
+}
+
+int disc_announce_start(const char* dst_ip, int disc_port, const char* service,
+                        int svc_port, int capacity, const int* load)
+{
+    announcer* a;
+    pthread_t t_id;
+    int on = 1, ttl = 1;
+
+    a = malloc(sizeof(announcer));
+    if(a == NULL)
+        return -1;
+    memset(a, 0, sizeof(*a));
+    a->sock = socket(PF_INET, SOCK_DGRAM, 0);
+    if(a->sock == -1)
+    {
+        free(a);
+        return -1;
+    }
+    a->dst.sin_family = AF_INET;
+    a->dst.sin_addr.s_addr = inet_addr(dst_ip);
+    a->dst.sin_port = htons(disc_port);
+
+    // 组播：TTL 1 只在本网段内传播；广播：必须开启 SO_BROADCAST
+    if(IN_MULTICAST(ntohl(a->dst.sin_addr.s_addr)))
+        setsockopt(a->sock, IPPROTO_IP, IP_MULTICAST_TTL, &ttl, sizeof(ttl));
+    else if(setsockopt(a->sock, SOL_SOCKET, SO_BROADCAST, &on, sizeof(on)) == -1)
+    {
+        close(a->sock);
+        free(a);
+        return -1;
+    }
+
+    strncpy(a->service, service, DISC_NAME_LEN - 1);
+    a->svc_port = svc_port;
+    a->capacity = capacity;
+    a->load = load;
+    a->instance = (uint32_t)(time(NULL) ^ (getpid() << 16) ^ svc_port);
+
+    if(pthread_create(&t_id, NULL, announce_main, a) != 0)
+    {
+        close(a->sock);
+        free(a);
+        return -1;
+    }
+    pthread_detach(t_id);
+    return 0;
+}
+
+int disc_table_open(disc_table* t, int disc_port, const char* group)
+{
+    struct sockaddr_in adr;
+    struct ip_mreq join_adr;
+    int on = 1;
+
+    memset(t, 0, sizeof(*t));
+    t->sock = socket(PF_INET, SOCK_DGRAM, 0);
+    if(t->sock == -1)
+        return -1;
+    // 同一台主机上的多个客户端都要收到公告：允许共用公告端口
+    setsockopt(t->sock, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+
+    memset(&adr, 0, sizeof(adr));
+    adr.sin_family = AF_INET;
+    adr.sin_addr.s_addr = htonl(INADDR_ANY);
+    adr.sin_port = htons(disc_port);
+    if(bind(t->sock, (struct sockaddr*)&adr, sizeof(adr)) == -1)
+    {
+        close(t->sock);
+        return -1;
+    }
+    if(group != NULL)
+    {
+        join_adr.imr_multiaddr.s_addr = inet_addr(group);
+        join_adr.imr_interface.s_addr = htonl(INADDR_ANY);
+        if(setsockopt(t->sock, IPPROTO_IP, IP_ADD_MEMBERSHIP, (void*)&join_adr, sizeof(join_adr)) == -1)
+        {
+            close(t->sock);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+void disc_table_close(disc_table* t)
+{
+    close(t->sock);
+    t->count = 0;
+}
+
+/* 解析一个公告并更新实例表 */
+static void update_entry(disc_table* t, const uint8_t* p, const struct sockaddr_in* from, int64_t now)
+{
+    disc_entry *e = NULL;
+    char service[DISC_NAME_LEN];
+    uint16_t v16, port;
+    uint32_t v32;
+    int i;
+
+    memcpy(&v16, p, 2);
+    if(ntohs(v16) != DISC_MAGIC || p[2] != DISC_VERSION)
+        return;
+    memcpy(service, p + 4, DISC_NAME_LEN);
+    service[DISC_NAME_LEN - 1] = 0;
+    memcpy(&v16, p + 20, 2);
+    port = v16;                         // 保持网络字节序，直接与 sin_port 比较
+
+    for(i = 0; i < t->count; i++)
+    {
+        if(t->entries[i].addr.sin_addr.s_addr == from->sin_addr.s_addr
+           && t->entries[i].addr.sin_port == port && strcmp(t->entries[i].service, service) == 0)
+        {
+            e = &t->entries[i];
+            break;
+        }
+    }
+    if(e == NULL)
+    {
+        if(t->count == DISC_MAX_ENTRIES)
+            return;
+        e = &t->entries[t->count++];
+        memset(e, 0, sizeof(*e));
+        memcpy(e->service, service, DISC_NAME_LEN);
+        e->addr.sin_family = AF_INET;
+        e->addr.sin_addr = from->sin_addr;
+        e->addr.sin_port = port;
+    }
+
+    memcpy(&v32, p + 24, 4);
+    e->load = ntohl(v32);
+    memcpy(&v32, p + 28, 4);
+    e->capacity = ntohl(v32);
+    memcpy(&v32, p + 32, 4);
+    if(e->instance != ntohl(v32))
+        e->failed = 0;                  // 服务重启过，之前的连接失败不再作数
+    e->instance = ntohl(v32);
+    memcpy(&v32, p + 36, 4);
+    e->interval_ms = ntohl(v32);
+    e->local_picks = 0;                 // 公告中的负载已经包含了之前分配过去的连接
+    e->last_seen_ms = now;
+}
+
+int disc_table_poll(disc_table* t, int timeout_ms)
+{
+    struct pollfd pfd;
+    struct sockaddr_in from;
+    socklen_t from_sz;
+    uint8_t p[DISC_PKT_SIZE + 1];
+    int64_t now, deadline = now_ms() + timeout_ms;
+    int n, i, got = 0, wait;
+
+    pfd.fd = t->sock;
+    pfd.events = POLLIN;
+    while(1)
+    {
+        wait = (int)(deadline - now_ms());
+        if(poll(&pfd, 1, wait > 0 ? wait : 0) <= 0)
+            break;
+        from_sz = sizeof(from);
+        n = recvfrom(t->sock, p, sizeof(p), 0, (struct sockaddr*)&from, &from_sz);
+        if(n == DISC_PKT_SIZE)
+        {
+            update_entry(t, p, &from, now_ms());
+            got++;
+        }
+    }
+
+    // 移除过期实例：用最后一个元素填补空位
+    now = now_ms();
+    for(i = 0; i < t->count; )
+    {
+        if(now - t->entries[i].last_seen_ms > (int64_t)t->entries[i].interval_ms * DISC_EXPIRE_INTERVALS)
+            t->entries[i] = t->entries[--t->count];
+        else
+            i++;
+    }
+    return got;
+}
+
+disc_entry* disc_pick(disc_table* t, const char* service)
+{
+    disc_entry *e, *best = NULL;
+    double ratio, best_ratio = 0;
+    int i;
+
+    for(i = 0; i < t->count; i++)
+    {
+        e = &t->entries[i];
+        if(e->capacity == 0 || e->failed || (service != NULL && strcmp(e->service, service) != 0))
+            continue;
+        if(e->load + e->local_picks >= e->capacity)
+            continue;   // 已满
+        ratio = (double)(e->load + e->local_picks) / e->capacity;
+        if(best == NULL || ratio < best_ratio)
+        {
+            best = e;
+            best_ratio = ratio;
+        }
+    }
+    return best;
+}
+
+void disc_picked(disc_entry* e)
+{
+    e->local_picks++;
+}
+
+void disc_failed(disc_entry* e)
+{
+    e->failed = 1;
+}
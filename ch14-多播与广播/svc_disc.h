@@ -0,0 +1,71 @@
+#ifndef SVC_DISC_H
+#define SVC_DISC_H
+
+#include <stdint.h>     // uint32_t / int64_t
+#include <netinet/in.h> // struct sockaddr_in
+
+/*
+ * 基于广播 / 组播的服务发现：不需要中心注册表
+ *
+ * 服务器端调用 disc_announce_start，后台线程定期向广播地址（如 255.255.255.255）或
+ * 组播组发送一个 40 字节的公告：服务名、服务端口、当前负载、容量、实例 ID。
+ * 公告的源 IP 就是实例的地址，接收端从 recvfrom 得到，不必写进公告。
+ *
+ * 客户端用 disc_table_open 监听公告端口，disc_table_poll 接收公告并维护本地实例表
+ * （超过 3 个公告间隔没有消息的实例会被移除），disc_pick 选出 负载/容量 最低的实例。
+ * 两次公告之间，本地每选中一次就给该实例的负载加 1，避免所有连接都涌向同一个实例。
+ *
+ * 公告格式（网络字节序）：
+ *   [2 魔数 'SD'][1 版本][1 标志][16 服务名][2 服务端口][2 保留]
+ *   [4 负载][4 容量][4 实例 ID][4 公告间隔 ms]
+ *
+ * 编译：gcc xxx.c svc_disc.c -lpthread（服务器端使用公告线程）
+ */
+
+#define DISC_PORT 9400                  // 默认公告端口
+#define DISC_NAME_LEN 16
+#define DISC_PKT_SIZE 40
+#define DISC_INTERVAL_MS 1000           // 常规公告间隔
+#define DISC_MAX_ENTRIES 64
+
+typedef struct {
+    char service[DISC_NAME_LEN];
+    struct sockaddr_in addr;            // 实例地址：公告的源 IP + 服务端口
+    uint32_t instance;                  // 实例 ID：同一地址上的服务重启后会变化
+    uint32_t load, capacity;
+    uint32_t interval_ms;
+    uint32_t local_picks;               // 自上次公告以来本地选中该实例的次数
+    int failed;                         // 本地连接失败过：不再选它，直到实例 ID 变化（服务重启）
+    int64_t last_seen_ms;
+} disc_entry;
+
+typedef struct {
+    int sock;
+    int count;
+    disc_entry entries[DISC_MAX_ENTRIES];
+} disc_table;
+
+/*
+ * 启动公告线程：dst_ip 为广播地址或组播地址，load 指向服务器维护的当前负载计数
+ * （公告线程只读取它）。成功返回 0，失败返回 -1
+ */
+int disc_announce_start(const char* dst_ip, int disc_port, const char* service,
+                        int svc_port, int capacity, const int* load);
+
+/* 监听公告：group 为 NULL 时只接收广播，否则同时加入该组播组。成功返回 0 */
+int disc_table_open(disc_table* t, int disc_port, const char* group);
+void disc_table_close(disc_table* t);
+
+/* 最多等待 timeout_ms 毫秒，接收所有到达的公告并移除过期实例；返回本次收到的公告数 */
+int disc_table_poll(disc_table* t, int timeout_ms);
+
+/* 选出某服务 负载/容量 最低的实例（service 为 NULL 时不限服务），没有可用实例返回 NULL */
+disc_entry* disc_pick(disc_table* t, const char* service);
+
+/* 连接选中的实例成功后调用：在下一次公告到来之前把该实例的负载计为加 1，连接失败则不计 */
+void disc_picked(disc_entry* e);
+
+/* 连接选中的实例失败后调用：之后 disc_pick 跳过该实例，直到它以新的实例 ID 重新公告 */
+void disc_failed(disc_entry* e);
+
+#endif
@@ -0,0 +1,147 @@
+#include <stdio.h>      // 标准输入输出：printf / fputs / fputc 等
+#include <stdlib.h>     // 标准库：exit / atoi / malloc 等
+#include <string.h>     // strcmp
+#include <unistd.h>     // close
+#include <arpa/inet.h>  // inet_ntoa / ntohs
+#include <sys/socket.h> // socket / connect
+#include "svc_disc.h"   // 广播 / 组播服务发现
+
+/*
+ * 服务发现客户端
+ *
+ * 只给出公告端口时，持续接收服务器的公告，每秒输出一次本地实例表。
+ * 给出服务名和连接数时，先收集一段时间的公告，然后依次用 disc_pick 选出负载最低的实例
+ * 建立 TCP 连接（每建立一个连接前都先处理新到的公告），保持 hold_secs 秒后断开，
+ * 最后输出各实例分到的连接数——负载生成器和客户端据此分散连接，无需中心注册表。
+ *
+ * 用法：svc_discover <disc_port> [GroupIP|-] [service count [hold_secs]]
+ *   GroupIP 为 - 或省略时只接收广播公告
+ */
+
+#define LEARN_MS 2500           // 选实例前先收集公告的时间（略多于 2 个公告间隔）
+#define DEFAULT_HOLD_SECS 5
+#define MAX_CONNS 4096
+
+void print_table(disc_table* t);
+void error_handling(char* message);
+
+int main(int argc, char* argv[])
+{
+    disc_table table;
+    disc_entry* e;
+    const char* group = NULL;
+    const char* service;
+    int count, hold = DEFAULT_HOLD_SECS, i, j, sock, opened = 0;
+    int* socks;
+    struct sockaddr_in picked[DISC_MAX_ENTRIES];
+    int picks[DISC_MAX_ENTRIES], npicked = 0;
+
+    if(argc < 2 || argc == 4 || argc > 6)
+    {
+        printf("Usage: %s <disc_port> [GroupIP|-] [service count [hold_secs]]\n", argv[0]);
+        exit(1);
+    }
+    if(argc >= 3 && strcmp(argv[2], "-") != 0)
+        group = argv[2];
+    if(disc_table_open(&table, atoi(argv[1]), group) == -1)
+        error_handling("disc_table_open() error");
+
+    // -------------------- 只监听：每秒输出实例表 --------------------
+    if(argc <= 3)
+    {
+        while(1)
+        {
+            disc_table_poll(&table, 1000);
+            print_table(&table);
+        }
+    }
+
+    // -------------------- 按负载分配连接 --------------------
+    service = argv[3];
+    count = atoi(argv[4]);
+    if(argc == 6)
+        hold = atoi(argv[5]);
+    if(count < 1 || count > MAX_CONNS)
+        error_handling("invalid count");
+    socks = malloc(sizeof(int) * count);
+    if(socks == NULL)
+        error_handling("malloc() error");
+
+    disc_table_poll(&table, LEARN_MS);
+    print_table(&table);
+
+    for(i = 0; i < count; i++)
+    {
+        disc_table_poll(&table, 0);     // 只处理已经到达的公告，不等待
+        e = disc_pick(&table, service);
+        if(e == NULL)
+        {
+            printf("no available instance of '%s'\n", service);
+            break;
+        }
+        sock = socket(PF_INET, SOCK_STREAM, 0);
+        if(sock == -1)
+            error_handling("socket() error");
+        if(connect(sock, (struct sockaddr*)&e->addr, sizeof(e->addr)) == -1)
+        {
+            // 标记失败，否则下一轮 disc_pick 还会选中这个连不上的实例
+            printf("connect to %s:%d failed, skipping it\n", inet_ntoa(e->addr.sin_addr), ntohs(e->addr.sin_port));
+            disc_failed(e);
+            close(sock);
+            i--;        // 这次不算，换一个实例重试
+            continue;
+        }
+        disc_picked(e);
+        socks[opened++] = sock;
+
+        for(j = 0; j < npicked; j++)
+            if(picked[j].sin_addr.s_addr == e->addr.sin_addr.s_addr && picked[j].sin_port == e->addr.sin_port)
+                break;
+        if(j == npicked && npicked < DISC_MAX_ENTRIES)
+        {
+            picked[npicked] = e->addr;
+            picks[npicked++] = 0;
+        }
+        if(j < npicked)
+            picks[j]++;
+    }
+
+    printf("%d connections opened:\n", opened);
+    for(j = 0; j < npicked; j++)
+        printf("  %s:%d  %d\n", inet_ntoa(picked[j].sin_addr), ntohs(picked[j].sin_port), picks[j]);
+
+    // 保持连接期间继续接收公告：可以看到各实例上报的负载随之上升
+    for(i = 0; i < hold; i++)
+        disc_table_poll(&table, 1000);
+    print_table(&table);
+
+    for(i = 0; i < opened; i++)
+        close(socks[i]);
+    free(socks);
+    disc_table_close(&table);
+    return 0;
+}
+
+void print_table(disc_table* t)
+{
+    disc_entry* e;
+    int i;
+
+    printf("%-16s %-21s %8s %8s %6s\n", "SERVICE", "ADDRESS", "LOAD", "CAPACITY", "USE%");
+    for(i = 0; i < t->count; i++)
+    {
+        e = &t->entries[i];
+        printf("%-16s %15s:%-5d %8u %8u %5.1f%%\n", e->service, inet_ntoa(e->addr.sin_addr),
+               ntohs(e->addr.sin_port), e->load, e->capacity,
+               e->capacity ? 100.0 * e->load / e->capacity : 0.0);
+    }
+    printf("\n");
+    fflush(stdout);
+}
+
+void error_handling(char *message)
+{
+    fputs(message, stderr);
+    fputc('\n', stderr);
+    exit(1);
+}
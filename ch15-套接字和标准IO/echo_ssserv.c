@@ -0,0 +1,86 @@
+#include <stdio.h>      // printf / puts / fputs
+#include <stdlib.h>     // exit / atoi
+#include <string.h>     // memset
+#include <unistd.h>     // close
+#include <arpa/inet.h>  // htonl / htons
+#include <sys/socket.h> // socket / bind / listen / accept
+#include "sockstream.h" // 带缓冲的套接字流（代替 fdopen 得到的 FILE*）
+
+/*
+ * 按行回显的服务器，功能同 echo_stdserv.c，但用 sockstream 代替 FILE*：
+ *   - 一个套接字只需要一个流（读写缓冲分开），不需要对同一个描述符 fdopen 两次
+ *   - ss_readline 返回指向读缓冲区内部的指针，不像 fgets 那样复制到 buf
+ *   - 不需要每行 fflush：使用 SS_FLUSH_IDLE 策略，读缓冲区中的行都处理完、
+ *     要等待新数据时才把积攒的回复一次写出。客户端连续发来多行时，一次 write 就能回复全部
+ *
+ * 用法：echo_ssserv <port>
+ */
+
+#define BUF_SIZE 4096
+void error_handling(char *message);
+
+int main(int argc, char* argv[])
+{
+    int serv_sock, clnt_sock, option = 1;
+    struct sockaddr_in serv_addr, clnt_addr;
+    socklen_t clnt_addr_sz;
+    sockstream ss;
+    const char* line;
+    ssize_t len;
+    unsigned long lines;
+
+    if(argc != 2)
+    {
+        printf("Usage: %s <port>\n", argv[0]);
+        exit(1);
+    }
+
+    serv_sock = socket(PF_INET, SOCK_STREAM, 0);
+    if(serv_sock == -1)
+        error_handling("socket() error");
+    setsockopt(serv_sock, SOL_SOCKET, SO_REUSEADDR, &option, sizeof(option));
+    memset(&serv_addr, 0, sizeof(serv_addr));
+    serv_addr.sin_family = AF_INET;
+    serv_addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    serv_addr.sin_port = htons(atoi(argv[1]));
+    if(bind(serv_sock, (struct sockaddr*)&serv_addr, sizeof(serv_addr)) == -1)
+        error_handling("bind() error");
+    if(listen(serv_sock, 5) == -1)
+        error_handling("listen() error");
+
+    while(1)
+    {
+        clnt_addr_sz = sizeof(clnt_addr);
+        clnt_sock = accept(serv_sock, (struct sockaddr*)&clnt_addr, &clnt_addr_sz);
+        if(clnt_sock == -1)
+            error_handling("accept() error");
+        puts("New Client connected...");
+        if(ss_open(&ss, clnt_sock, BUF_SIZE, BUF_SIZE) == -1)
+        {
+            close(clnt_sock);
+            continue;
+        }
+        ss_set_flush(&ss, SS_FLUSH_IDLE, 0);
+
+        // 读一行、写一行；是否真的写到套接字由刷新策略决定
+        lines = 0;
+        while((len = ss_readline(&ss, &line)) > 0)
+        {
+            if(ss_write(&ss, line, len) == -1)
+                break;
+            lines++;
+        }
+        printf("Client closed, %lu lines echoed\n", lines);
+        ss_close(&ss, 1);
+    }
+
+    close(serv_sock);
+    return 0;
+}
+
+void error_handling(char* message)
+{
+    fputs(message, stderr);
+    fputc('\n', stderr);
+    exit(1);
+}
@@ -0,0 +1,196 @@
+#include <stdlib.h>     // malloc / free
+#include <string.h>     // memchr / memcpy / memmove / strlen
+#include <unistd.h>     // read / write / close
+#include <errno.h>      // errno / EAGAIN / EINTR
+#include "sockstream.h"
+
+/*
+ * sockstream 的实现，接口说明见 sockstream.h
+ */
+
+int ss_open(sockstream* s, int fd, size_t rcap, size_t wcap)
+{
+    memset(s, 0, sizeof(*s));
+    s->fd = fd;
+    s->rbuf = malloc(rcap);
+    s->wbuf = malloc(wcap);
+    if(s->rbuf == NULL || s->wbuf == NULL || rcap == 0 || wcap == 0)
+    {
+        free(s->rbuf);
+        free(s->wbuf);
+        return -1;
+    }
+    s->rcap = rcap;
+    s->wcap = wcap;
+    s->flush_mode = SS_FLUSH_IDLE;
+    return 0;
+}
+
+void ss_set_flush(sockstream* s, int mode, size_t flush_size)
+{
+    s->flush_mode = mode;
+    s->flush_size = flush_size < s->wcap ? flush_size : s->wcap;
+}
+
+/*
+ * 从套接字读入更多数据到读缓冲区。读缓冲区中的数据都已经处理过、要等待新数据了，
+ * SS_FLUSH_IDLE 策略就在这里写出积攒的回复。返回值同 read，非阻塞时返回 SS_AGAIN
+ */
+static ssize_t fill(sockstream* s)
+{
+    ssize_t n;
+
+    // 未读数据移到开头，腾出尾部空间（没有未读数据时只需重置位置）
+    if(s->rstart == s->rend)
+        s->rstart = s->rend = 0;
+    else if(s->rend == s->rcap && s->rstart > 0)
+    {
+        memmove(s->rbuf, s->rbuf + s->rstart, s->rend - s->rstart);
+        s->rend -= s->rstart;
+        s->rstart = 0;
+    }
+    if(s->flush_mode == SS_FLUSH_IDLE && s->wlen > 0 && ss_flush(s) == -1)
+        return -1;
+
+    do
+        n = read(s->fd, s->rbuf + s->rend, s->rcap - s->rend);
+    while(n == -1 && errno == EINTR);
+    if(n == 0)
+        s->eof = 1;
+    else if(n > 0)
+        s->rend += n;
+    else if(errno == EAGAIN || errno == EWOULDBLOCK)
+        return SS_AGAIN;
+    return n;
+}
+
+ssize_t ss_readline(sockstream* s, const char** line)
+{
+    size_t scanned = 0, len;
+    char* nl;
+    ssize_t n;
+
+    while(1)
+    {
+        // 只在新读入的部分中找换行符
+        nl = memchr(s->rbuf + s->rstart + scanned, '\n', s->rend - s->rstart - scanned);
+        if(nl != NULL)
+            len = nl - (s->rbuf + s->rstart) + 1;
+        else if(s->rend - s->rstart == s->rcap || (s->eof && s->rend > s->rstart))
+            len = s->rend - s->rstart;      // 行太长，或最后一行没有换行符
+        else if(s->eof)
+            return 0;
+        else
+        {
+            scanned = s->rend - s->rstart;
+            n = fill(s);
+            if(n < 0)
+                return n;
+            continue;
+        }
+        *line = s->rbuf + s->rstart;
+        s->rstart += len;
+        return len;
+    }
+}
+
+ssize_t ss_read(sockstream* s, void* buf, size_t len)
+{
+    size_t avail = s->rend - s->rstart;
+    ssize_t n;
+
+    if(avail == 0 && !s->eof)
+    {
+        n = fill(s);
+        if(n <= 0)
+            return n;
+        avail = s->rend - s->rstart;
+    }
+    if(len > avail)
+        len = avail;
+    memcpy(buf, s->rbuf + s->rstart, len);
+    s->rstart += len;
+    return len;
+}
+
+ssize_t ss_write(sockstream* s, const void* data, size_t len)
+{
+    const char* p = data;
+    size_t done = 0, take;
+    ssize_t n;
+    int r;
+
+    while(done < len)
+    {
+        // 写缓冲区为空、剩下的数据比整个缓冲区还大：直接写出，不复制
+        if(s->wlen == 0 && len - done >= s->wcap)
+        {
+            n = write(s->fd, p + done, len - done);
+            if(n == -1 && errno == EINTR)
+                continue;
+            if(n == -1 && (errno == EAGAIN || errno == EWOULDBLOCK))
+                break;
+            if(n == -1)
+                return -1;
+            done += n;
+            continue;
+        }
+        take = s->wcap - s->wlen < len - done ? s->wcap - s->wlen : len - done;
+        if(take == 0)
+        {
+            r = ss_flush(s);
+            if(r == -1)
+                return -1;
+            if(r == SS_AGAIN && s->wlen == s->wcap)
+                break;
+            continue;
+        }
+        memcpy(s->wbuf + s->wlen, p + done, take);
+        s->wlen += take;
+        done += take;
+    }
+    if(s->flush_mode == SS_FLUSH_SIZE && s->wlen >= s->flush_size && ss_flush(s) == -1)
+        return -1;
+    return done;
+}
+
+ssize_t ss_puts(sockstream* s, const char* str)
+{
+    return ss_write(s, str, strlen(str));
+}
+
+int ss_flush(sockstream* s)
+{
+    size_t off = 0;
+    ssize_t n;
+    int ret = 0;
+
+    while(off < s->wlen)
+    {
+        n = write(s->fd, s->wbuf + off, s->wlen - off);
+        if(n == -1 && errno == EINTR)
+            continue;
+        if(n == -1)
+        {
+            ret = (errno == EAGAIN || errno == EWOULDBLOCK) ? SS_AGAIN : -1;
+            break;
+        }
+        off += n;
+    }
+    // 没写完的部分移到开头，等下次再写
+    if(off > 0 && off < s->wlen)
+        memmove(s->wbuf, s->wbuf + off, s->wlen - off);
+    s->wlen -= off;
+    return ret;
+}
+
+void ss_close(sockstream* s, int close_fd)
+{
+    if(s->wlen > 0)
+        ss_flush(s);
+    free(s->rbuf);
+    free(s->wbuf);
+    s->rbuf = s->wbuf = NULL;
+    if(close_fd)
+        close(s->fd);
+}
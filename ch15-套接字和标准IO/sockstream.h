@@ -0,0 +1,68 @@
+#ifndef SOCKSTREAM_H
+#define SOCKSTREAM_H
+
+#include <sys/types.h>  // ssize_t / size_t
+
+/*
+ * 轻量的带缓冲套接字流，代替 fdopen 得到的 FILE*
+ *
+ * 与 stdio 的区别：
+ *   - 读缓冲和写缓冲分开，一个套接字只需要一个流，不需要 dup 出第二个描述符再 fdopen
+ *   - ss_readline 不复制数据：返回指向读缓冲区内部的指针（直到下一次读操作前有效）
+ *   - 没有锁：一个流只能由一个线程使用（stdio 的每次调用都要加锁）
+ *   - 写缓冲什么时候真正写出由刷新策略决定，不用在每行之后 fflush：
+ *       SS_FLUSH_MANUAL  只在 ss_flush 或写缓冲满时写出
+ *       SS_FLUSH_SIZE    写缓冲中的数据达到 flush_size 时写出
+ *       SS_FLUSH_IDLE    读缓冲中的数据都处理完、即将等待新数据时写出。
+ *                        客户端连续发来多行时，这些行的回复合并成一次 write
+ *   - 支持非阻塞套接字：无法立即完成时返回 SS_AGAIN，数据留在缓冲区中，不会丢失
+ */
+
+#define SS_AGAIN (-2)           // 非阻塞套接字：需要等待可读 / 可写后再调用
+
+#define SS_FLUSH_MANUAL 0
+#define SS_FLUSH_SIZE 1
+#define SS_FLUSH_IDLE 2
+
+typedef struct {
+    int fd;
+    char* rbuf;
+    size_t rcap, rstart, rend;  // 未读数据位于 rbuf[rstart, rend)
+    char* wbuf;
+    size_t wcap, wlen;          // 待写出数据位于 wbuf[0, wlen)
+    int flush_mode;
+    size_t flush_size;
+    int eof;
+} sockstream;
+
+/* 为 fd 创建流，rcap / wcap 为读写缓冲区大小（同时也是一行的最大长度）；失败返回 -1 */
+int ss_open(sockstream* s, int fd, size_t rcap, size_t wcap);
+
+/* 设置刷新策略；flush_size 只对 SS_FLUSH_SIZE 有效 */
+void ss_set_flush(sockstream* s, int mode, size_t flush_size);
+
+/*
+ * 读一行（包括结尾的 '\n'），*line 指向读缓冲区内部，不以 '\0' 结尾。
+ * 返回行长度；对端关闭且没有剩余数据时返回 0；出错返回 -1；非阻塞且没有完整的一行时返回 SS_AGAIN。
+ * 一行超过读缓冲区时先返回读缓冲区大小的一段；对端关闭前的最后一行可以没有 '\n'
+ */
+ssize_t ss_readline(sockstream* s, const char** line);
+
+/* 读最多 len 字节（先取读缓冲区中的数据）；返回值同 read，非阻塞时返回 SS_AGAIN */
+ssize_t ss_read(sockstream* s, void* buf, size_t len);
+
+/*
+ * 把 len 字节写入写缓冲区，按刷新策略写出；比写缓冲区还大的数据在缓冲区为空时直接写出。
+ * 返回接收的字节数，出错返回 -1。阻塞套接字上总是全部接收；
+ * 非阻塞套接字上写缓冲区满且内核也不接收时可能少于 len，剩下的部分要等可写后再写
+ */
+ssize_t ss_write(sockstream* s, const void* data, size_t len);
+ssize_t ss_puts(sockstream* s, const char* str);
+
+/* 写出写缓冲区中的全部数据：成功返回 0，出错返回 -1，非阻塞且没写完返回 SS_AGAIN */
+int ss_flush(sockstream* s);
+
+/* 写出剩余数据并释放缓冲区；close_fd 非 0 时同时关闭套接字 */
+void ss_close(sockstream* s, int close_fd);
+
+#endif
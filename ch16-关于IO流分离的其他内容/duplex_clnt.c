@@ -0,0 +1,333 @@
+#include <stdio.h>      // 标准I/O：printf / fgets / fputs / fwrite
+#include <stdlib.h>     // exit / atoi / malloc / qsort
+#include <string.h>     // memset / memcpy / memchr / strlen
+#include <stdint.h>     // uint32_t / uint64_t
+#include <unistd.h>     // read / close / usleep
+#include <errno.h>      // errno / EINTR
+#include <sched.h>      // sched_yield：队列空/满时让出 CPU
+#include <time.h>       // clock_gettime
+#include <pthread.h>    // 读线程、写线程
+#include <arpa/inet.h>  // inet_addr / htons
+#include <sys/socket.h> // socket / connect / shutdown
+#include <sys/uio.h>    // writev：一次写出多个请求
+
+/*
+ * 读写分离的双工客户端：读线程和写线程共用一个连接，中间用无锁 SPSC 队列传递数据
+ *
+ * sep_clnt / sep_serv 用 dup + fdopen 分离读写流，echo_mpclient 用 fork 分离读写进程。
+ * 这里用两个线程分离读写，每对线程之间各有一个单生产者单消费者（SPSC）环形队列，不需要锁：
+ *   主线程 --tx--> 写线程：要发送的请求
+ *   写线程 --inflight--> 读线程：已经发出、等待响应的请求（发送时刻），回声服务器按顺序响应，
+ *                               读线程每收到一行就取出一个，得到这条请求的往返时延
+ * 写线程不等响应就继续发送，最多有 window 个请求同时在途；读线程同时接收响应，
+ * 所以吞吐量不再受往返时延限制。
+ *
+ * 半关闭：主线程没有更多请求时关闭 tx 队列，写线程把队列中的请求都发出后 shutdown(SHUT_WR)，
+ * 服务器读到 EOF；读线程继续接收，直到服务器回完所有响应并关闭连接（读到 EOF）为止。
+ *
+ * 两种模式：
+ *   交互模式（不带 requests 参数）：从标准输入逐行读取请求，响应打印到标准输出，
+ *                                  标准输入结束（Ctrl+D 或管道结束）时半关闭
+ *   测试模式：自动发送 requests 个请求，最后打印吞吐量和时延分布
+ *
+ * 用法：duplex_clnt <IP> <port> [requests] [window]（服务器用 ch10 echo_mpserver 等回声服务器）
+ */
+
+#define MSG_MAX 256             // 一个请求（一行）的最大长度
+#define RING_SIZE 1024          // 队列容量，必须是 2 的幂
+#define DEFAULT_WINDOW 64
+#define CACHE_LINE 64
+#define READ_BUF 65536
+#define BATCH 64                // 写线程一次 writev 最多发送的请求数
+
+typedef struct {
+    uint32_t len;
+    char data[MSG_MAX];
+} msg;
+
+/* SPSC 环形队列（同 ch14 md_receiver_spsc.c）：head 只由生产者写，tail 只由消费者写 */
+typedef struct {
+    uint32_t head __attribute__((aligned(CACHE_LINE)));
+    uint32_t tail __attribute__((aligned(CACHE_LINE)));
+    int closed __attribute__((aligned(CACHE_LINE)));     // 生产者不会再放入数据
+} spsc_hdr;
+
+typedef struct {
+    spsc_hdr h;
+    msg slots[RING_SIZE];
+} msg_ring;
+
+typedef struct {
+    spsc_hdr h;
+    uint64_t slots[RING_SIZE];  // 请求的发送时刻（ns）
+} time_ring;
+
+static msg_ring tx;
+static time_ring inflight;
+static int sock, window = DEFAULT_WINDOW, bench;
+static uint64_t* latencies;
+static unsigned long responses;
+
+void* writer_main(void* arg);
+void* reader_main(void* arg);
+void deliver(const char* p, size_t n);
+int ring_full(spsc_hdr* h);
+int ring_empty(spsc_hdr* h);
+void ring_wait(int* idle);
+int cmp_u64(const void* a, const void* b);
+uint64_t now_ns(void);
+void error_handling(char *message);
+
+int main(int argc, char *argv[])
+{
+    struct sockaddr_in serv_addr;
+    pthread_t w_id, r_id;
+    char line[MSG_MAX];
+    unsigned long requests = 0, i;
+    uint32_t head;
+    msg* m;
+    int idle = 0;
+    uint64_t start, elapsed;
+
+    if(argc != 3 && argc != 4 && argc != 5)
+    {
+        printf("Usage: %s <IP> <port> [requests] [window]\n", argv[0]);
+        exit(1);
+    }
+    if(argc >= 4)
+    {
+        bench = 1;
+        if(atol(argv[3]) <= 0)
+            error_handling("requests must be > 0");
+        requests = atol(argv[3]);
+        latencies = malloc(sizeof(uint64_t) * requests);
+        if(latencies == NULL)
+            error_handling("malloc() error");
+    }
+    if(argc == 5)
+        window = atoi(argv[4]);
+    if(window < 1 || window > RING_SIZE)
+        error_handling("window must be 1 ~ 1024");
+
+    sock = socket(PF_INET, SOCK_STREAM, 0);
+    memset(&serv_addr, 0, sizeof(serv_addr));
+    serv_addr.sin_family = AF_INET;
+    serv_addr.sin_addr.s_addr = inet_addr(argv[1]);
+    serv_addr.sin_port = htons(atoi(argv[2]));
+    if(connect(sock, (struct sockaddr*)&serv_addr, sizeof(serv_addr)) == -1)
+        error_handling("connect() error");
+
+    start = now_ns();
+    pthread_create(&w_id, NULL, writer_main, NULL);
+    pthread_create(&r_id, NULL, reader_main, NULL);
+
+    // -------------------- 主线程：生产请求，放入 tx 队列 --------------------
+    for(i = 0; !bench || i < requests; i++)
+    {
+        if(bench)
+            snprintf(line, sizeof(line), "request %lu\n", i);
+        else if(fgets(line, sizeof(line), stdin) == NULL)
+            break;
+        while(ring_full(&tx.h))
+            ring_wait(&idle);
+        idle = 0;
+        head = tx.h.head;
+        m = &tx.slots[head & (RING_SIZE - 1)];
+        m->len = strlen(line);
+        memcpy(m->data, line, m->len);
+        __atomic_store_n(&tx.h.head, head + 1, __ATOMIC_RELEASE);
+    }
+    // 没有更多请求：关闭 tx 队列，写线程发完后半关闭
+    __atomic_store_n(&tx.h.closed, 1, __ATOMIC_RELEASE);
+
+    pthread_join(w_id, NULL);
+    pthread_join(r_id, NULL);
+    elapsed = now_ns() - start;
+    close(sock);
+
+    if(bench)
+    {
+        printf("%lu/%lu responses, window %d, %.3f s, %.0f req/s\n", responses, requests, window,
+               elapsed / 1e9, responses / (elapsed / 1e9));
+        if(responses > 0)
+        {
+            qsort(latencies, responses, sizeof(uint64_t), cmp_u64);
+            printf("latency: p50 %.1f us, p99 %.1f us, max %.1f us\n", latencies[responses / 2] / 1e3,
+                   latencies[(unsigned long)(responses * 0.99)] / 1e3, latencies[responses - 1] / 1e3);
+        }
+    }
+    return 0;
+}
+
+/*
+ * 写线程：从 tx 取请求，批量 writev 发出，并把发送时刻放入 inflight 队列。
+ * 在途请求数达到 window 时等读线程收到响应；tx 关闭且取空后 shutdown(SHUT_WR)
+ */
+void* writer_main(void* arg)
+{
+    struct iovec iov[BATCH];
+    uint32_t tail, ihead, n, i, k;
+    size_t total, done;
+    ssize_t w;
+    uint64_t t;
+    int idle = 0, closed;
+
+    (void)arg;
+    while(1)
+    {
+        // 先读 closed 再看队列：关闭之前放入的请求一定能看到
+        closed = __atomic_load_n(&tx.h.closed, __ATOMIC_ACQUIRE);
+        tail = tx.h.tail;
+        n = __atomic_load_n(&tx.h.head, __ATOMIC_ACQUIRE) - tail;
+        // 窗口：在途请求数 = inflight 中尚未被读线程取走的数量
+        ihead = inflight.h.head;
+        i = window - (ihead - __atomic_load_n(&inflight.h.tail, __ATOMIC_ACQUIRE));
+        if(n > i)
+            n = i;
+        if(n > BATCH)
+            n = BATCH;
+        if(n == 0)
+        {
+            if(closed && ring_empty(&tx.h))
+                break;
+            ring_wait(&idle);
+            continue;
+        }
+        idle = 0;
+
+        total = 0;
+        for(i = 0; i < n; i++)
+        {
+            iov[i].iov_base = tx.slots[(tail + i) & (RING_SIZE - 1)].data;
+            iov[i].iov_len = tx.slots[(tail + i) & (RING_SIZE - 1)].len;
+            total += iov[i].iov_len;
+        }
+        // 先登记发送时刻再发送：响应可能在 writev 返回之前就到达
+        t = now_ns();
+        for(i = 0; i < n; i++)
+            inflight.slots[(ihead + i) & (RING_SIZE - 1)] = t;
+        __atomic_store_n(&inflight.h.head, ihead + n, __ATOMIC_RELEASE);
+
+        // 阻塞套接字上 writev 也可能只写出一部分（被信号打断等），跳过已写完的 iovec 继续写
+        for(k = 0; total > 0; total -= w)
+        {
+            w = writev(sock, iov + k, n - k);
+            if(w == -1 && errno == EINTR)
+            {
+                w = 0;
+                continue;
+            }
+            if(w <= 0)
+                error_handling("writev() error");
+            for(done = w; k < n && done >= iov[k].iov_len; k++)
+                done -= iov[k].iov_len;
+            if(k < n)
+            {
+                iov[k].iov_base = (char*)iov[k].iov_base + done;
+                iov[k].iov_len -= done;
+            }
+        }
+        // 请求都已写入内核，槽位可以还给主线程
+        __atomic_store_n(&tx.h.tail, tail + n, __ATOMIC_RELEASE);
+    }
+
+    shutdown(sock, SHUT_WR);
+    return NULL;
+}
+
+/* 读线程：按行切分响应，每一行对应 inflight 中最早的一个请求 */
+void* reader_main(void* arg)
+{
+    static char buf[READ_BUF];
+    size_t len = 0, start;
+    ssize_t n;
+    char* nl;
+    uint32_t tail;
+
+    (void)arg;
+    while((n = read(sock, buf + len, sizeof(buf) - len)) > 0)
+    {
+        len += n;
+        start = 0;
+        while((nl = memchr(buf + start, '\n', len - start)) != NULL)
+        {
+            deliver(buf + start, nl - buf + 1 - start);
+            start = nl - buf + 1;
+        }
+        // 不完整的一行移到开头；一行超过缓冲区时直接丢弃
+        memmove(buf, buf + start, len - start);
+        len -= start;
+        if(len == sizeof(buf))
+            len = 0;
+    }
+    // 对端关闭前发来的最后一行可能没有 '\n'，也算一个响应
+    if(len > 0)
+        deliver(buf, len);
+
+    tail = inflight.h.tail;
+    if(tail != __atomic_load_n(&inflight.h.head, __ATOMIC_ACQUIRE))
+        fprintf(stderr, "connection closed with %u requests unanswered\n",
+                __atomic_load_n(&inflight.h.head, __ATOMIC_ACQUIRE) - tail);
+    return NULL;
+}
+
+/* 收到一行响应：对应 inflight 中最早的请求，记录时延；交互模式下输出到标准输出 */
+void deliver(const char* p, size_t n)
+{
+    uint64_t t = now_ns();
+    uint32_t tail = inflight.h.tail;
+
+    if(tail != __atomic_load_n(&inflight.h.head, __ATOMIC_ACQUIRE))
+    {
+        if(bench)
+            latencies[responses] = t - inflight.slots[tail & (RING_SIZE - 1)];
+        __atomic_store_n(&inflight.h.tail, tail + 1, __ATOMIC_RELEASE);
+        responses++;
+    }
+    if(!bench)
+    {
+        fwrite(p, 1, n, stdout);
+        fflush(stdout);
+    }
+}
+
+int ring_full(spsc_hdr* h)
+{
+    return h->head - __atomic_load_n(&h->tail, __ATOMIC_ACQUIRE) == RING_SIZE;
+}
+
+int ring_empty(spsc_hdr* h)
+{
+    return __atomic_load_n(&h->head, __ATOMIC_ACQUIRE) == __atomic_load_n(&h->tail, __ATOMIC_ACQUIRE);
+}
+
+/* 队列空 / 满时等待：先短暂让出 CPU，等得久了再睡眠，避免空转占满 CPU */
+void ring_wait(int* idle)
+{
+    if(++*idle < 100)
+        sched_yield();
+    else
+        usleep(50);
+}
+
+int cmp_u64(const void* a, const void* b)
+{
+    uint64_t x = *(const uint64_t*)a, y = *(const uint64_t*)b;
+
+    return x < y ? -1 : x > y;
+}
+
+uint64_t now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+void error_handling(char *message)
+{
+    fputs(message, stderr);
+    fputc('\n', stderr);
+    exit(1);
+}
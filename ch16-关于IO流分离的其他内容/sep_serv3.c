@@ -0,0 +1,74 @@
+#include <stdio.h>      // printf / fwrite / fputs
+#include <stdlib.h>     // exit / atoi
+#include <string.h>     // memset
+#include <unistd.h>     // close
+#include <arpa/inet.h>  // htonl / htons
+#include <sys/socket.h> // socket / bind / listen / accept / shutdown
+#include "sockstream.h" // 带缓冲的套接字流（见 ch15 sockstream.c）
+
+/*
+ * sep_serv2.c 的 sockstream 版本：半关闭后接收客户端最后发送的字符串
+ *
+ * sep_serv2 为了分离读写，要 dup 出第二个描述符，再分别 fdopen 成读流和写流。
+ * sockstream 本身就有独立的读缓冲和写缓冲，一个套接字一个流即可：
+ *   ss_flush 写出缓冲中的数据 -> shutdown(SHUT_WR) 发送 EOF -> 继续 ss_readline 读取
+ * 没有第二个描述符，也就不存在"关闭了一个 FILE* 却没有发送 EOF"的问题。
+ *
+ * 用法：sep_serv3 <port>（客户端用 sep_clnt）
+ */
+
+#define BUF_SIZE 1024
+void error_handling(char *message);
+
+int main(int argc, char *argv[])
+{
+    int serv_sock, clnt_sock;
+    struct sockaddr_in serv_adr, clnt_adr;
+    socklen_t clnt_adr_sz;
+    sockstream ss;
+    const char* line;
+    ssize_t len;
+
+    if(argc != 2)
+    {
+        printf("Usage: %s <port>\n", argv[0]);
+        exit(1);
+    }
+
+    serv_sock = socket(PF_INET, SOCK_STREAM, 0);
+    memset(&serv_adr, 0, sizeof(serv_adr));
+    serv_adr.sin_family = AF_INET;
+    serv_adr.sin_addr.s_addr = htonl(INADDR_ANY);
+    serv_adr.sin_port = htons(atoi(argv[1]));
+    if(bind(serv_sock, (struct sockaddr*)&serv_adr, sizeof(serv_adr)) == -1)
+        error_handling("bind() error");
+    listen(serv_sock, 5);
+    clnt_adr_sz = sizeof(clnt_adr);
+    clnt_sock = accept(serv_sock, (struct sockaddr*)&clnt_adr, &clnt_adr_sz);
+    if(clnt_sock == -1 || ss_open(&ss, clnt_sock, BUF_SIZE, BUF_SIZE) == -1)
+        error_handling("accept() error");
+
+    // 三行都先进写缓冲，手动刷新时一次写出
+    ss_set_flush(&ss, SS_FLUSH_MANUAL, 0);
+    ss_puts(&ss, "FROM SERVER: Hi~ client? \n");
+    ss_puts(&ss, "I love all of the world \n");
+    ss_puts(&ss, "You are awesome! \n");
+    ss_flush(&ss);
+
+    // 半关闭：发送 EOF，读方向仍然可用
+    shutdown(clnt_sock, SHUT_WR);
+
+    len = ss_readline(&ss, &line);
+    if(len > 0)
+        fwrite(line, 1, len, stdout);
+    ss_close(&ss, 1);
+    close(serv_sock);
+    return 0;
+}
+
+void error_handling(char *message)
+{
+    fputs(message, stderr);
+    fputc('\n', stderr);
+    exit(1);
+}
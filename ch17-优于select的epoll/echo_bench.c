@@ -0,0 +1,144 @@
+#include <stdio.h>      // 标准I/O：printf, fputs, stderr 等
+#include <stdlib.h>     // exit, malloc, atoi, atof
+#include <string.h>     // memset
+#include <unistd.h>     // close, read, write
+#include <fcntl.h>      // fcntl, O_NONBLOCK
+#include <errno.h>      // errno, EAGAIN
+#include <poll.h>       // poll：同时等待可读和可写
+#include <time.h>       // clock_gettime
+#include <pthread.h>    // 每个连接一个线程
+#include <arpa/inet.h>  // inet_addr, htons
+#include <sys/socket.h> // socket, connect, shutdown
+
+/*
+ * 回声服务器吞吐测试，配合 echo_splice_serv（或 echo_epollserv）使用
+ *
+ * 开 conns 个连接，每个连接发送 MB_per_conn 的数据并把回声全部收回来，
+ * 收发同时进行（poll 等待可读/可写），发送完毕后 shutdown(SHUT_WR) 通知服务器。
+ * 收到的字节数与发送的一致才算完成。
+ *
+ * 用法：echo_bench <IP> <port> <conns> <MB_per_conn> [write_size]
+ */
+
+#define DEFAULT_WRITE_SIZE (64 * 1024)
+#define MAX_CONNS 256
+
+typedef struct {
+    struct sockaddr_in addr;
+    unsigned long long total;       // 每个连接要发送的字节数
+    size_t write_size;
+    int ok;
+} bench_arg;
+
+void* bench_conn(void* arg);
+double now_sec(void);
+void error_handling(char *message);
+
+int main(int argc, char *argv[])
+{
+    pthread_t tids[MAX_CONNS];
+    bench_arg args[MAX_CONNS];
+    int conns, i, ok = 0;
+    size_t write_size = DEFAULT_WRITE_SIZE;
+    double start, wall, mb;
+
+    if(argc != 5 && argc != 6)
+    {
+        printf("Usage : %s <IP> <port> <conns> <MB_per_conn> [write_size]\n", argv[0]);
+        exit(1);
+    }
+    conns = atoi(argv[3]);
+    mb = atof(argv[4]);
+    if(argc == 6)
+        write_size = atoi(argv[5]);
+    if(conns < 1 || conns > MAX_CONNS || mb <= 0 || write_size < 1)
+        error_handling("invalid conns, MB_per_conn or write_size");
+
+    start = now_sec();
+    for(i = 0; i < conns; i++)
+    {
+        memset(&args[i], 0, sizeof(args[i]));
+        args[i].addr.sin_family = AF_INET;
+        args[i].addr.sin_addr.s_addr = inet_addr(argv[1]);
+        args[i].addr.sin_port = htons(atoi(argv[2]));
+        args[i].total = (unsigned long long)(mb * 1048576);
+        args[i].write_size = write_size;
+        pthread_create(&tids[i], NULL, bench_conn, &args[i]);
+    }
+    for(i = 0; i < conns; i++)
+    {
+        pthread_join(tids[i], NULL);
+        ok += args[i].ok;
+    }
+    wall = now_sec() - start;
+
+    printf("%d/%d connections complete, %.1f MB echoed in %.2f s (%.1f MB/s)\n",
+           ok, conns, mb * conns, wall, mb * conns / wall);
+    return ok == conns ? 0 : 1;
+}
+
+void* bench_conn(void* arg)
+{
+    bench_arg* a = arg;
+    unsigned long long sent = 0, recvd = 0;
+    struct pollfd pfd;
+    char* wbuf = calloc(1, a->write_size);
+    char* rbuf = malloc(DEFAULT_WRITE_SIZE);
+    size_t len;
+    ssize_t n;
+    int sock = socket(PF_INET, SOCK_STREAM, 0);
+
+    if(wbuf == NULL || rbuf == NULL || connect(sock, (struct sockaddr*)&a->addr, sizeof(a->addr)) == -1)
+    {
+        fputs("connect() error\n", stderr);
+        goto out;
+    }
+    fcntl(sock, F_SETFL, fcntl(sock, F_GETFL, 0) | O_NONBLOCK);
+
+    pfd.fd = sock;
+    while(recvd < a->total)
+    {
+        pfd.events = POLLIN | (sent < a->total ? POLLOUT : 0);
+        if(poll(&pfd, 1, -1) == -1)
+            break;
+        if(pfd.revents & POLLOUT)
+        {
+            len = a->total - sent < a->write_size ? a->total - sent : a->write_size;
+            n = write(sock, wbuf, len);
+            if(n > 0 && (sent += n) == a->total)
+                shutdown(sock, SHUT_WR);    // 发送完毕：半关闭，服务器读到 EOF 后关闭连接
+            else if(n == -1 && errno != EAGAIN)
+                break;
+        }
+        if(pfd.revents & (POLLIN | POLLHUP | POLLERR))
+        {
+            n = read(sock, rbuf, DEFAULT_WRITE_SIZE);
+            if(n == 0 || (n == -1 && errno != EAGAIN))
+                break;
+            if(n > 0)
+                recvd += n;
+        }
+    }
+    a->ok = recvd == a->total;
+
+out:
+    close(sock);
+    free(wbuf);
+    free(rbuf);
+    return NULL;
+}
+
+double now_sec(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+void error_handling(char *message)
+{
+    fputs(message, stderr);
+    fputc('\n', stderr);
+    exit(1);
+}
@@ -5,9 +5,14 @@
 #include <arpa/inet.h>  // htonl, htons（网络字节序转换）
 #include <sys/socket.h> // socket, bind, listen, accept（套接字系统调用）
 #include <sys/epoll.h>  // epoll_create, epoll_ctl, epoll_wait 以及 epoll_event
+#include "svc_disc.h"   // 服务发现公告（见 ch14 svc_disc.c）
+#include "sockopt_profile.h" // 套接字可选项配置（见 ch09 sockopt_profile.c）
+#include "tcp_stats.h"  // TCP_INFO 遥测（见 ch09 tcp_stats.c）
+#include "bufchain.h"   // readv / writev 缓冲链（见 ch13 bufchain.c）
 
-#define BUF_SIZE 100    // 读写缓冲区大小：一次最多读 100 字节再回显给客户端
+#define READ_CHUNKS 1   // 每次 readv 最多使用的新数据块数（每块 4KB，见 bufchain.h）
 #define EPOLL_SIZE 50   // epoll_wait 一次最多返回 50 个就绪事件（也用于分配事件数组）
+#define CAPACITY 1024   // 服务发现公告中的容量（名义上的最大连接数）
 void error_handling(char *buf);
 
 int main(int argc, char* argv[])
@@ -16,24 +21,36 @@ int main(int argc, char* argv[])
     struct sockaddr_in serv_addr, clnt_addr;
     socklen_t clnt_addr_sz;
     int str_len;
-    char buf[BUF_SIZE];
+    bufchain chain;         // 回显用的缓冲链：数据直接读进池化的数据块，再从同一批数据块写回
 
     int epfd, event_cnt;
+    int clnt_cnt = 0;           // 当前连接数：服务发现公告中的负载（公告线程只读取）
     struct epoll_event event;
     struct epoll_event* ep_events;
+    sockopt_profile prof;       // 套接字可选项：默认什么都不设置
 
     /*
      * 参数检查：
      * - 程序需要一个参数：监听端口
      * argv[0]：程序名
      * argv[1]：端口号字符串
+     * argv[2]、argv[3]（可选）：服务发现的广播/组播地址和公告端口
+     * 最后一个参数（可选）：套接字可选项配置文件（由 ch09 sockopt_tune 生成）
      */
-    if(argc != 2)
+    if(argc < 2 || argc > 5)
     {
-        printf("Usage: %s <port>\n", argv[0]);
+        printf("Usage: %s <port> [disc_IP disc_port] [profile]\n", argv[0]);
         exit(1);
     }
 
+    /*
+     * 启动时读入可选项配置：参数个数为 3 或 5 时最后一个参数是配置文件。
+     * 配置有错就不启动，避免服务器带着与预期不同的设置运行
+     */
+    sp_default(&prof);
+    if((argc == 3 || argc == 5) && sp_load(&prof, argv[argc - 1]) == -1)
+        error_handling("sp_load() error");
+
     /* -------------------- 第一部分：建立 TCP 监听 socket -------------------- */
 
     /*
@@ -50,6 +67,13 @@ int main(int argc, char* argv[])
     if(serv_sock == -1)
         error_handling("socket() error");
 
+    /*
+     * 缓冲区大小要在 listen 之前设置（接收窗口的扩大因子在握手时确定），
+     * accept 得到的客户端套接字会继承监听套接字的设置
+     */
+    if(sp_apply(&prof, serv_sock) == -1)
+        error_handling("sp_apply() error");
+
     /*
      * 准备服务器地址结构体：
      * memset 清零是为了避免结构体中未初始化字段造成不可预期行为
@@ -83,6 +107,20 @@ int main(int argc, char* argv[])
     if(listen(serv_sock, 5) == -1)
         error_handling("listen() error");
 
+    /*
+     * 传输层遥测：后台线程轮流对客户端连接采样 TCP_INFO，kill -USR1 <pid> 输出直方图。
+     * 它会屏蔽 SIGUSR1，要在创建其他线程（服务发现公告线程）之前启动
+     */
+    if(ts_start() == -1)
+        error_handling("ts_start() error");
+
+    /*
+     * 服务发现（可选）：后台线程定期广播本实例的端口、当前连接数和容量，
+     * 客户端据此选择负载最低的回声服务器实例
+     */
+    if(argc >= 4 && disc_announce_start(argv[2], atoi(argv[3]), "echo", atoi(argv[1]), CAPACITY, &clnt_cnt) == -1)
+        error_handling("disc_announce_start() error");
+
     /* -------------------- 第二部分：创建 epoll 并注册监听 socket -------------------- */
 
     /*
@@ -117,6 +155,8 @@ int main(int argc, char* argv[])
 
     /* -------------------- 第三部分：事件循环（I/O 多路复用） -------------------- */
 
+    bc_init(&chain);
+
     while(1)
     {
         /*
@@ -172,9 +212,12 @@ int main(int argc, char* argv[])
                  * - 只要 socket 接收缓冲区里还有数据没读完，epoll_wait 可能持续返回该 fd 可读
                  * - 因此即使一次 read 没读完，下次还会继续收到通知（相对不容易“丢事件”）
                  */
+                sp_apply(&prof, clnt_sock);
+                ts_add(clnt_sock);
                 event.events = EPOLLIN;
                 event.data.fd = clnt_sock;
                 epoll_ctl(epfd, EPOLL_CTL_ADD, clnt_sock, &event);
+                __atomic_add_fetch(&clnt_cnt, 1, __ATOMIC_RELAXED);
                 printf("Connected client: %d\n", clnt_sock);
             }
             else
@@ -186,10 +229,11 @@ int main(int argc, char* argv[])
                  * 或
                  * - 对端关闭连接，导致 read 返回 0（EOF）
                  */
-                str_len = read(ep_events[i].data.fd, buf, BUF_SIZE);
+                str_len = bc_readv(&chain, ep_events[i].data.fd, READ_CHUNKS);
+                sp_quickack(&prof, ep_events[i].data.fd);   // 配置中启用时立即回复 ACK
 
                 /*
-                 * read 返回值含义（教学重点）：
+                 * bc_readv 返回值同 read（教学重点）：
                  * - >0：成功读取到 str_len 个字节
                  * -  0：对端关闭连接（EOF）
                  * - <0：发生错误（本示例未处理 <0 的情况，工程中应处理）
@@ -202,22 +246,24 @@ int main(int argc, char* argv[])
                      * 2) close 关闭 socket
                      */
                     epoll_ctl(epfd, EPOLL_CTL_DEL, ep_events[i].data.fd, NULL);
+                    ts_remove(ep_events[i].data.fd);    // 先注销再关闭，fd 被复用前不会再被采样
                     close(ep_events[i].data.fd);
+                    __atomic_sub_fetch(&clnt_cnt, 1, __ATOMIC_RELAXED);
                     printf("Closed client: %d\n", ep_events[i].data.fd);
                 }
                 else
                 {
                     /*
                      * 回显（echo）逻辑：
-                     * - 把刚读到的 str_len 字节原样写回给客户端
+                     * - 把刚读进数据块的 str_len 字节原样写回给客户端，中间不经过缓冲区复制
                      *
                      * 教学提示：
-                     * - write 也可能出现“部分写”（返回值 < str_len），
-                     *   但在阻塞 socket 且数据量不大时通常会写完
-                     * - 本示例未检查 write 返回值，作为教学简化
+                     * - bc_writev 也可能“部分写”，写出的部分会从链上移除，循环直到写完或出错
                      */
-                    write(ep_events[i].data.fd, buf, str_len);
+                    while(chain.len > 0 && bc_writev(&chain, ep_events[i].data.fd) > 0)
+                        ;
                 }
+                bc_clear(&chain);   // 出错时丢弃没写完的数据，数据块回到池中
             }
         }
     }
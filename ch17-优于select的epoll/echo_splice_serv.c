@@ -0,0 +1,259 @@
+#define _GNU_SOURCE     // splice / SPLICE_F_* 是 Linux 扩展
+#include <stdio.h>      // 标准I/O：printf, puts, fputs, stderr 等
+#include <stdlib.h>     // exit, malloc, atoi
+#include <string.h>     // memset, strcmp
+#include <unistd.h>     // close, read, write, pipe（POSIX I/O）
+#include <fcntl.h>      // fcntl, O_NONBLOCK, splice
+#include <errno.h>      // errno, EAGAIN
+#include <time.h>       // clock_gettime
+#include <arpa/inet.h>  // htonl, htons（网络字节序转换）
+#include <sys/socket.h> // socket, bind, listen, accept（套接字系统调用）
+#include <sys/epoll.h>  // epoll_create, epoll_ctl, epoll_wait, epoll_event
+#include <sys/resource.h> // getrusage：统计 CPU 时间
+
+/*
+ * 数据不经过用户空间的回声服务器：socket -> pipe -> socket
+ *
+ * echo_epollserv 把每个字节 read 到 buf 再 write 回去，数据要在内核和用户空间之间复制两次。
+ * 这里每个连接配一个管道：
+ *   splice(clnt_sock -> pipe) 把接收缓冲区中的数据页移入管道，
+ *   splice(pipe -> clnt_sock) 再把它们送进发送缓冲区，载荷字节始终留在内核中。
+ * 两次 splice 都带 SPLICE_F_NONBLOCK，由 epoll 的可读/可写通知驱动：
+ *   - 管道为空时关注 EPOLLIN，读入一批后立即尝试写回
+ *   - 写回遇到 EAGAIN（对端接收慢）时管道里留有数据，改为关注 EPOLLOUT，
+ *     期间不再读取新数据，对客户端形成反压
+ * 带 copy 参数时使用同样的结构，只是把管道换成用户空间缓冲区（read / write），用于对比。
+ *
+ * 所有客户端都断开后，打印这一轮回显的字节数、耗时和 CPU 时间（每 GB 消耗的 CPU 秒数），
+ * 配合 echo_bench 使用。
+ *
+ * 用法：echo_splice_serv <port> [copy]
+ */
+
+#define CHUNK_SIZE (64 * 1024)  // 一次搬运的最大字节数（与默认管道容量相同）
+#define EPOLL_SIZE 50
+
+typedef struct {
+    int fd;
+    int pipefd[2];              // splice 模式：[0] 读端，[1] 写端
+    char* buf;                  // copy 模式：用户空间缓冲区
+    size_t pending, off;        // 管道 / 缓冲区中尚未写回的字节数，以及 copy 模式下的写出位置
+    int want_out;               // 当前是否关注 EPOLLOUT
+} conn;
+
+static int copy_mode;
+static unsigned long long total_bytes, total_calls;
+
+conn* conn_open(int fd);
+void conn_close(conn* c);
+int pump(conn* c);
+double cpu_seconds(void);
+double now_sec(void);
+void setnonblockingmode(int fd);
+void error_handling(char *buf);
+
+int main(int argc, char* argv[])
+{
+    int serv_sock, clnt_sock, epfd, event_cnt, i, r, clnt_cnt = 0, option = 1;
+    struct sockaddr_in serv_addr, clnt_addr;
+    socklen_t clnt_addr_sz;
+    struct epoll_event event, ep_events[EPOLL_SIZE];
+    conn* c;
+    double start_wall = 0, start_cpu = 0, wall, cpu;
+
+    if(argc != 2 && argc != 3)
+    {
+        printf("Usage: %s <port> [copy]\n", argv[0]);
+        exit(1);
+    }
+    if(argc == 3 && strcmp(argv[2], "copy") == 0)
+        copy_mode = 1;
+
+    serv_sock = socket(PF_INET, SOCK_STREAM, 0);
+    if(serv_sock == -1)
+        error_handling("socket() error");
+    setsockopt(serv_sock, SOL_SOCKET, SO_REUSEADDR, &option, sizeof(option));
+    memset(&serv_addr, 0, sizeof(serv_addr));
+    serv_addr.sin_family = AF_INET;
+    serv_addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    serv_addr.sin_port = htons(atoi(argv[1]));
+    if(bind(serv_sock, (struct sockaddr*)&serv_addr, sizeof(serv_addr)) == -1)
+        error_handling("bind() error");
+    if(listen(serv_sock, 128) == -1)
+        error_handling("listen() error");
+
+    // 监听 socket 的 data.ptr 为 NULL，客户端 socket 的 data.ptr 指向其 conn
+    epfd = epoll_create(EPOLL_SIZE);
+    event.events = EPOLLIN;
+    event.data.ptr = NULL;
+    epoll_ctl(epfd, EPOLL_CTL_ADD, serv_sock, &event);
+    printf("echo mode: %s\n", copy_mode ? "copy (read/write)" : "splice (socket -> pipe -> socket)");
+
+    while(1)
+    {
+        event_cnt = epoll_wait(epfd, ep_events, EPOLL_SIZE, -1);
+        if(event_cnt == -1)
+        {
+            puts("epoll_wait() error");
+            break;
+        }
+
+        for(i = 0; i < event_cnt; i++)
+        {
+            if(ep_events[i].data.ptr == NULL)
+            {
+                clnt_addr_sz = sizeof(clnt_addr);
+                clnt_sock = accept(serv_sock, (struct sockaddr*)&clnt_addr, &clnt_addr_sz);
+                if(clnt_sock == -1)
+                    continue;
+                c = conn_open(clnt_sock);
+                if(c == NULL)
+                {
+                    close(clnt_sock);
+                    continue;
+                }
+                event.events = EPOLLIN;
+                event.data.ptr = c;
+                epoll_ctl(epfd, EPOLL_CTL_ADD, clnt_sock, &event);
+                if(clnt_cnt++ == 0)
+                {
+                    // 新一轮测试开始
+                    total_bytes = total_calls = 0;
+                    start_wall = now_sec();
+                    start_cpu = cpu_seconds();
+                }
+                continue;
+            }
+
+            c = ep_events[i].data.ptr;
+            r = pump(c);
+            if(r == -1)
+            {
+                epoll_ctl(epfd, EPOLL_CTL_DEL, c->fd, NULL);
+                conn_close(c);
+                if(--clnt_cnt == 0 && total_bytes > 0)
+                {
+                    wall = now_sec() - start_wall;
+                    cpu = cpu_seconds() - start_cpu;
+                    printf("%s: echoed %.1f MB in %.2f s (%.1f MB/s), %llu syscalls, CPU %.2f s = %.2f CPU s/GB\n",
+                           copy_mode ? "copy" : "splice", total_bytes / 1048576.0, wall,
+                           total_bytes / 1048576.0 / wall, total_calls, cpu,
+                           cpu / (total_bytes / 1073741824.0));
+                    fflush(stdout);
+                }
+            }
+            else if(r != c->want_out)
+            {
+                // 管道中还有数据没写回时只等可写，否则只等可读
+                c->want_out = r;
+                event.events = r ? EPOLLOUT : EPOLLIN;
+                event.data.ptr = c;
+                epoll_ctl(epfd, EPOLL_CTL_MOD, c->fd, &event);
+            }
+        }
+    }
+
+    close(serv_sock);
+    close(epfd);
+    return 0;
+}
+
+/*
+ * 在一个连接上尽量多地搬运数据：先把管道（缓冲区）中剩余的数据写回，再读入新的一批。
+ * 返回 1 表示需要等待可写，0 表示需要等待可读，-1 表示连接已结束
+ */
+int pump(conn* c)
+{
+    ssize_t n;
+
+    while(1)
+    {
+        while(c->pending > 0)
+        {
+            if(copy_mode)
+                n = write(c->fd, c->buf + c->off, c->pending);
+            else
+                n = splice(c->pipefd[0], NULL, c->fd, NULL, c->pending, SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+            total_calls++;
+            if(n == -1)
+                return (errno == EAGAIN || errno == EWOULDBLOCK) ? 1 : -1;
+            c->pending -= n;
+            c->off += n;
+            total_bytes += n;
+        }
+
+        // 管道为空时 EAGAIN 只可能表示 socket 中没有数据
+        if(copy_mode)
+            n = read(c->fd, c->buf, CHUNK_SIZE);
+        else
+            n = splice(c->fd, NULL, c->pipefd[1], NULL, CHUNK_SIZE, SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+        total_calls++;
+        if(n == 0)
+            return -1;      // 对端关闭，数据已经全部写回
+        if(n == -1)
+            return (errno == EAGAIN || errno == EWOULDBLOCK) ? 0 : -1;
+        c->pending = n;
+        c->off = 0;
+    }
+}
+
+conn* conn_open(int fd)
+{
+    conn* c = calloc(1, sizeof(conn));
+
+    if(c == NULL)
+        return NULL;
+    c->fd = fd;
+    c->pipefd[0] = c->pipefd[1] = -1;
+    if(copy_mode)
+        c->buf = malloc(CHUNK_SIZE);
+    if((copy_mode && c->buf == NULL) || (!copy_mode && pipe(c->pipefd) == -1))
+    {
+        free(c->buf);
+        free(c);
+        return NULL;
+    }
+    setnonblockingmode(fd);
+    return c;
+}
+
+void conn_close(conn* c)
+{
+    close(c->fd);
+    if(c->pipefd[0] != -1)
+    {
+        close(c->pipefd[0]);
+        close(c->pipefd[1]);
+    }
+    free(c->buf);
+    free(c);
+}
+
+double cpu_seconds(void)
+{
+    struct rusage ru;
+
+    getrusage(RUSAGE_SELF, &ru);
+    return ru.ru_utime.tv_sec + ru.ru_stime.tv_sec + (ru.ru_utime.tv_usec + ru.ru_stime.tv_usec) / 1e6;
+}
+
+double now_sec(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+void setnonblockingmode(int fd)
+{
+    int flag = fcntl(fd, F_GETFL, 0);
+    fcntl(fd, F_SETFL, flag | O_NONBLOCK);
+}
+
+void error_handling(char *buf)
+{
+    fputs(buf, stderr);
+    fputc('\n', stderr);
+    exit(1);
+}
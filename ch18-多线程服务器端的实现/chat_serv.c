@@ -6,8 +6,12 @@
 #include <sys/socket.h> // socket, bind, listen, accept（套接字系统调用）
 #include <netinet/in.h> // sockaddr_in 等（与 arpa/inet.h 配合使用）
 #include <pthread.h>    // pthread_create, pthread_detach, pthread_mutex_*（线程与互斥锁）
+#include "svc_disc.h"   // 服务发现公告（见 ch14 svc_disc.c）
+#include "sockopt_profile.h" // 套接字可选项配置（见 ch09 sockopt_profile.c）
+#include "tcp_stats.h"  // TCP_INFO 遥测（见 ch09 tcp_stats.c）
+#include "bufchain.h"   // readv / writev 缓冲链（见 ch13 bufchain.c）
 
-#define BUF_SIZE 100    // 每次从客户端读消息的缓冲区大小（一次最多读 100 字节）
+#define READ_CHUNKS 1   // 每次 readv 最多使用的新数据块数（每块 4KB，见 bufchain.h）
 #define MAX_CLNT 256    // 允许同时连接的最大客户端数量（客户端 socket 数组容量）
 
 /*
@@ -18,7 +22,7 @@
  * - error_handling：错误处理，打印并退出
  */
 void* handle_clnt(void* arg);
-void send_msg(char *msg, int len);
+void send_msg(const bufchain* msg);
 void error_handling(char* message);
 
 /* -------------------- 全局共享数据（多线程共享，需要互斥保护） -------------------- */
@@ -26,6 +30,7 @@ void error_handling(char* message);
 pthread_mutex_t mutex;          // 互斥锁：保护 clnt_socks 与 clnt_cnt 的并发访问
 int clnt_socks[MAX_CLNT];       // 保存所有已连接客户端的 socket FD（文件描述符）
 int clnt_cnt = 0;               // 当前已连接客户端数量
+sockopt_profile prof;           // 套接字可选项：默认什么都不设置（客户端线程只读取）
 
 int main(int argc, char* argv[])
 {
@@ -39,13 +44,23 @@ int main(int argc, char* argv[])
      * - 服务器只需要一个参数：监听端口
      * argv[0]：程序名
      * argv[1]：端口字符串，例如 "8080"
+     * argv[2]、argv[3]（可选）：服务发现的广播/组播地址和公告端口
+     * 最后一个参数（可选）：套接字可选项配置文件（由 ch09 sockopt_tune 生成）
      */
-    if(argc != 2)
+    if(argc < 2 || argc > 5)
     {
-        printf("Usage: %s <port>\n", argv[0]);
+        printf("Usage: %s <port> [disc_IP disc_port] [profile]\n", argv[0]);
         exit(1);
     }
 
+    /*
+     * 启动时读入可选项配置：参数个数为 3 或 5 时最后一个参数是配置文件，
+     * 配置有错就不启动
+     */
+    sp_default(&prof);
+    if((argc == 3 || argc == 5) && sp_load(&prof, argv[argc - 1]) == -1)
+        error_handling("sp_load() error");
+
     /*
      * 初始化互斥锁：
      * - mutex 用于保护共享资源 clnt_socks[] 与 clnt_cnt
@@ -65,6 +80,12 @@ int main(int argc, char* argv[])
     if(serv_sock == -1)
         error_handling("socket() error");
 
+    /*
+     * 缓冲区大小要在 listen 之前设置，accept 得到的客户端套接字会继承
+     */
+    if(sp_apply(&prof, serv_sock) == -1)
+        error_handling("sp_apply() error");
+
     /*
      * 填充服务器地址结构体：
      * memset 清零避免未初始化字段影响 bind
@@ -90,6 +111,22 @@ int main(int argc, char* argv[])
     if(listen(serv_sock, 5) == -1)
         error_handling("listen() error");
 
+    /*
+     * 传输层遥测：
+     * - 后台线程轮流对客户端连接采样 TCP_INFO，kill -USR1 <pid> 输出直方图
+     * - 它会屏蔽 SIGUSR1，要在创建其他线程（公告线程、客户端线程）之前启动
+     */
+    if(ts_start() == -1)
+        error_handling("ts_start() error");
+
+    /*
+     * 服务发现（可选）：
+     * - 后台线程定期广播本实例的端口、当前连接数 clnt_cnt 和容量 MAX_CLNT
+     * - 客户端据此选择负载最低的聊天服务器实例
+     */
+    if(argc >= 4 && disc_announce_start(argv[2], atoi(argv[3]), "chat", atoi(argv[1]), MAX_CLNT, &clnt_cnt) == -1)
+        error_handling("disc_announce_start() error");
+
     /* -------------------- 第二部分：主线程循环 accept 新连接 -------------------- */
 
     while(1)
@@ -111,8 +148,11 @@ int main(int argc, char* argv[])
          * - 防止其它线程正在遍历/写入 clnt_socks 时出现数据竞争
          */
         pthread_mutex_lock(&mutex);
-        clnt_socks[clnt_cnt++] = clnt_sock;
+        clnt_socks[clnt_cnt] = clnt_sock;
+        __atomic_add_fetch(&clnt_cnt, 1, __ATOMIC_RELAXED);    // 公告线程不加锁读取，写入也用原子操作
         pthread_mutex_unlock(&mutex);
+        sp_apply(&prof, clnt_sock);
+        ts_add(clnt_sock);
 
         /*
          * 为该客户端创建一个独立线程处理收消息：
@@ -163,22 +203,27 @@ void* handle_clnt(void* arg)
      */
     int clnt_sock = *((int*)arg);
 
-    int str_len = 0;
-    char msg[BUF_SIZE];
+    bufchain msg;           // 读到的消息：直接读进池化的数据块，广播时各客户端引用同一批数据块
 
     /*
      * 循环读取该客户端发送的数据，并广播：
      *
-     * read 返回值含义（教学重点）：
+     * bc_readv 返回值同 read（教学重点）：
      * - >0：读到的字节数
      * -  0：对端关闭连接（EOF）
      * - -1：出错（本代码未处理 -1，实际中应处理并关闭连接）
      *
-     * 本循环条件：read(...) != 0
-     * - 当客户端正常断开时，read 返回 0，循环结束
+     * 本循环条件：bc_readv(...) > 0
+     * - 当客户端正常断开（返回 0）或出错（返回 -1）时，循环结束
      */
-    while((str_len = read(clnt_sock, msg, sizeof(msg))) != 0)
-        send_msg(msg, str_len);
+    bc_init(&msg);
+    while(bc_readv(&msg, clnt_sock, READ_CHUNKS) > 0)
+    {
+        sp_quickack(&prof, clnt_sock);  // 配置中启用时立即回复 ACK
+        send_msg(&msg);
+        bc_consume(&msg, msg.len);      // 数据块在所有引用释放后才回到池中
+    }
+    bc_clear(&msg);
 
     /*
      * 客户端断开后，需要从全局客户端数组 clnt_socks[] 中移除该 socket：
@@ -207,22 +252,25 @@ void* handle_clnt(void* arg)
     }
 
     /*
-     * 客户端数量减 1
+     * 客户端数量减 1（公告线程不加锁读取 clnt_cnt，写入也用原子操作）
      */
-    clnt_cnt--;
+    __atomic_sub_fetch(&clnt_cnt, 1, __ATOMIC_RELAXED);
 
     pthread_mutex_unlock(&mutex);
 
     /*
-     * 关闭该客户端 socket
+     * 先从遥测中注销，再关闭该客户端 socket（fd 被复用前不会再被采样）
      */
+    ts_remove(clnt_sock);
     close(clnt_sock);
 
     return NULL;
 }
 
-void send_msg(char* msg, int len)
+void send_msg(const bufchain* msg)
 {
+    bufchain out;
+
     /*
      * 广播函数：把一条消息发送给所有已连接客户端
      *
@@ -235,13 +283,16 @@ void send_msg(char* msg, int len)
     for(int i = 0; i < clnt_cnt; i++)
     {
         /*
-         * write：向每个客户端 socket 写入同样的消息
-         *
-         * 教学提示：
-         * - write 可能出现“部分写”（返回值 < len），严谨实现需要处理
-         * - 若某个客户端异常断开，write 可能失败（例如 EPIPE），本示例未处理
+         * 向每个客户端 socket 写入同样的消息：
+         * - bc_append_ref 只引用 msg 的数据块（增加引用计数），不复制消息内容
+         * - bc_writev 可能“部分写”，写出的部分从链上移除，循环直到写完
+         * - 若某个客户端异常断开，bc_writev 失败（例如 EPIPE），丢弃剩下的数据
          */
-        write(clnt_socks[i], msg, len);
+        bc_init(&out);
+        bc_append_ref(&out, msg, 0, msg->len);
+        while(out.len > 0 && bc_writev(&out, clnt_socks[i]) > 0)
+            ;
+        bc_clear(&out);
     }
 
     pthread_mutex_unlock(&mutex);
@@ -1,13 +1,18 @@
-#include <stdio.h>      // printf, fputs, fgets, FILE, fdopen, fopen, fclose, fflush 等标准I/O
+#include <stdio.h>      // printf, fputs, FILE, fopen, fread, fclose 等标准I/O（只用于读本地文件）
 #include <stdlib.h>     // exit, atoi
-#include <unistd.h>     // close, dup（文件描述符复制）
+#include <unistd.h>     // close
 #include <string.h>     // memset, strcpy, strcmp, strstr, strtok
 #include <arpa/inet.h>  // inet_ntoa, htonl, htons, ntohs：IP/端口转换与字节序
 #include <sys/socket.h> // socket, bind, listen, accept：套接字系统调用
+#include <sys/stat.h>   // fstat：响应头中的 Content-length
 #include <pthread.h>    // pthread_create, pthread_detach：多线程
+#include "svc_disc.h"   // 服务发现公告（见 ch14 svc_disc.c）
+#include "sockstream.h" // 带缓冲的套接字流，代替 fdopen 得到的 FILE*（见 ch15 sockstream.c）
+#include "sockopt_profile.h" // 套接字可选项配置（见 ch09 sockopt_profile.c）
 
 #define BUF_SIZE 1024   // 发送文件内容时的缓冲区大小（一次最多读 1024 字节）
 #define SMALL_BUF 100   // 解析请求行、拼接响应头等用的小缓冲区
+#define CAPACITY 256    // 服务发现公告中的容量（名义上同时处理的最大请求数）
 
 /*
  * 这是一个非常简化的“多线程 HTTP 服务器”示例：
@@ -17,17 +22,21 @@
  *
  * 教学重点：
  * 1) HTTP 的基本结构：请求行、响应行、响应头、空行、响应体
- * 2) TCP 连接 + 标准 I/O（fdopen/fputs/fgets）结合使用
+ * 2) TCP 连接 + 带缓冲的套接字流（sockstream：ss_readline/ss_puts/ss_write）
  * 3) 多线程：每个连接一个线程（并发处理多个客户端）
  * 4) 该示例为了简单，省略了大量工程级健壮性处理（注释会指出）
  */
 
-void *request_handler(void *arg);                 // 线程入口：处理一个客户端请求
-void send_data(FILE *fp, char *ct, char *file_name); // 发送 200 OK + 文件内容
+void *request_handler(void *arg);                 // 处理一个客户端请求
+void *counted_handler(void *arg);                 // 线程入口：调用 request_handler 并维护活跃请求数
+void send_data(sockstream *ss, char *ct, char *file_name); // 发送 200 OK + 文件内容
 char *content_type(char *file);                   // 根据文件扩展名确定 MIME 类型
-void send_error(FILE *fp);                        // 发送 400 Bad Request
+void send_error(sockstream *ss);                  // 发送 400 Bad Request
 void error_handling(char *message);               // 通用错误处理（打印并退出）
 
+int active_cnt = 0;     // 正在处理的请求数：服务发现公告中的负载
+sockopt_profile prof;   // 套接字可选项：默认什么都不设置（工作线程只读取）
+
 int main(int argc, char *argv[])
 {
     int serv_sock, clnt_sock;
@@ -38,13 +47,23 @@ int main(int argc, char *argv[])
     /*
      * 参数：只需要一个端口号
      * argv[1]：端口字符串，例如 "8080"
+     * argv[2]、argv[3]（可选）：服务发现的广播/组播地址和公告端口
+     * 最后一个参数（可选）：套接字可选项配置文件（由 ch09 sockopt_tune 生成）
      */
-    if (argc != 2)
+    if (argc < 2 || argc > 5)
     {
-        printf("Usage : %s <port>\n", argv[0]);
+        printf("Usage : %s <port> [disc_IP disc_port] [profile]\n", argv[0]);
         exit(1);
     }
 
+    /*
+     * 启动时读入可选项配置：参数个数为 3 或 5 时最后一个参数是配置文件，
+     * 配置有错就不启动
+     */
+    sp_default(&prof);
+    if ((argc == 3 || argc == 5) && sp_load(&prof, argv[argc - 1]) == -1)
+        error_handling("sp_load() error");
+
     /* -------------------- 第一部分：创建并启动监听 socket -------------------- */
 
     /*
@@ -55,6 +74,12 @@ int main(int argc, char *argv[])
      */
     serv_sock = socket(PF_INET, SOCK_STREAM, 0);
 
+    /*
+     * 缓冲区大小要在 listen 之前设置，accept 得到的客户端套接字会继承
+     */
+    if (sp_apply(&prof, serv_sock) == -1)
+        error_handling("sp_apply() error");
+
     /*
      * 设置服务器地址：
      * - sin_family：IPv4
@@ -79,6 +104,13 @@ int main(int argc, char *argv[])
     if (listen(serv_sock, 20) == -1)
         error_handling("listen() error");
 
+    /*
+     * 服务发现（可选）：后台线程定期广播本实例的端口、正在处理的请求数和容量，
+     * 客户端据此选择负载最低的 HTTP 服务器实例
+     */
+    if (argc >= 4 && disc_announce_start(argv[2], atoi(argv[3]), "http", atoi(argv[1]), CAPACITY, &active_cnt) == -1)
+        error_handling("disc_announce_start() error");
+
     /* -------------------- 第二部分：主循环 accept 并创建线程处理 -------------------- */
 
     while (1)
@@ -110,7 +142,8 @@ int main(int argc, char *argv[])
          *   （典型的“传栈上变量地址给线程”的坑）
          * - 工程上通常做法：为每个连接 malloc 一个 int 保存 fd，再传指针，线程里用完 free
          */
-        pthread_create(&t_id, NULL, request_handler, &clnt_sock);
+        __atomic_add_fetch(&active_cnt, 1, __ATOMIC_RELAXED);
+        pthread_create(&t_id, NULL, counted_handler, &clnt_sock);
         pthread_detach(t_id);
     }
 
@@ -139,8 +172,9 @@ void *request_handler(void *arg)
      * 注意：这里只读第一行，不处理后续头字段
      */
 
-    FILE *clnt_read;
-    FILE *clnt_write;
+    sockstream ss;
+    const char *line;
+    ssize_t len;
 
     char method[10];
     char ct[15];
@@ -156,25 +190,37 @@ void *request_handler(void *arg)
      */
 
     /*
-     * fdopen：把 socket FD 包装成标准I/O流
-     * - clnt_read 用于 fgets 读请求
-     * - clnt_write 用于 fputs 写响应
-     *
-     * 这里对写端使用 fdopen(dup(clnt_sock),"w")：
-     * 教学重点：为什么要 dup？
-     * - 如果对同一个 FD 分别 fdopen 成读流和写流，两个 fclose 都可能关闭同一 FD
-     * - 通过 dup 得到一个新的 FD 给写流使用：
-     *   clnt_read 关闭原 FD，clnt_write 关闭 dup 出来的 FD，避免“双重关闭”的风险
+     * ss_open：为 socket 创建一个带缓冲的流
+     * - 读缓冲和写缓冲分开，一个流就能读请求、写响应
+     * - 以前用 fdopen 时要 dup 出第二个 FD 分别做读流和写流，避免两个 fclose 关闭同一 FD；这里不再需要
+     * - 刷新策略用 SS_FLUSH_MANUAL：响应头和文件内容先攒在写缓冲中，满了才写出，
+     *   最后由 ss_close 写出剩余部分，不用每行 fflush
      */
-    clnt_read = fdopen(clnt_sock, "r");
-    clnt_write = fdopen(dup(clnt_sock), "w");
+    if (ss_open(&ss, clnt_sock, BUF_SIZE, BUF_SIZE) == -1)
+    {
+        close(clnt_sock);
+        return NULL;
+    }
+    ss_set_flush(&ss, SS_FLUSH_MANUAL, 0);
+    sp_apply(&prof, clnt_sock);
 
     /*
      * 读取请求行（只读第一行）：
-     * - fgets 读取到 '\n' 或读满 SMALL_BUF-1 为止
-     * - HTTP 请求行通常以 "\r\n" 结尾，fgets 会把 '\n' 读入缓冲
+     * - ss_readline 返回指向读缓冲区内部的指针，包括结尾的 '\n'
+     * - strtok 会修改字符串，所以把请求行复制到 req_line（最多 SMALL_BUF-1 字节）并补 '\0'
      */
-    fgets(req_line, SMALL_BUF, clnt_read);
+    len = ss_readline(&ss, &line);
+    sp_quickack(&prof, clnt_sock);  // 配置中启用时立即回复 ACK
+    if (len <= 0)
+    {
+        // 对端没有发来任何数据就关闭了连接，或者读出错：line 无效，直接关闭
+        ss_close(&ss, 1);
+        return NULL;
+    }
+    if (len > SMALL_BUF - 1)
+        len = SMALL_BUF - 1;
+    memcpy(req_line, line, len);
+    req_line[len] = 0;
 
     /*
      * 粗略判断是否像 HTTP 请求：
@@ -182,10 +228,9 @@ void *request_handler(void *arg)
      */
     if (strstr(req_line, "HTTP/") == NULL)
     {
-        send_error(clnt_write);
-        fclose(clnt_read);
-        fclose(clnt_write);
-        return; // 注意：此处返回类型为 void*，但直接 return 在 C 中允许（等价返回 NULL）
+        send_error(&ss);
+        ss_close(&ss, 1);
+        return NULL;
     }
 
     /*
@@ -220,26 +265,36 @@ void *request_handler(void *arg)
      */
     if (strcmp(method, "GET") != 0)
     {
-        send_error(clnt_write);
-        fclose(clnt_read);
-        fclose(clnt_write);
-        return;
+        send_error(&ss);
+        ss_close(&ss, 1);
+        return NULL;
     }
 
-    /*
-     * 读完请求行后就关闭读流：
-     * - 这个示例并不读取剩余的请求头，也不支持持久连接（keep-alive）
-     */
-    fclose(clnt_read);
-
     /*
      * 发送文件内容（响应体）：
      * - send_data 内部会先写响应行和响应头，再写文件内容
+     * - 这个示例并不读取剩余的请求头，也不支持持久连接（keep-alive）：
+     *   ss_close 写出写缓冲中剩余的数据后关闭连接（HTTP/1.0 常见行为）
      */
-    send_data(clnt_write, ct, file_name);
+    sp_cork(&prof, clnt_sock, 1);   // 响应头和文件内容分多次写出：配置中启用时合并成满长度的报文段
+    send_data(&ss, ct, file_name);
+    ss_flush(&ss);
+    sp_cork(&prof, clnt_sock, 0);
+    ss_close(&ss, 1);
+    return NULL;
+}
+
+/*
+ * 线程入口：request_handler 有多个返回点，在这里统一把活跃请求数减 1
+ */
+void *counted_handler(void *arg)
+{
+    request_handler(arg);
+    __atomic_sub_fetch(&active_cnt, 1, __ATOMIC_RELAXED);
+    return NULL;
 }
 
-void send_data(FILE *fp, char *ct, char *file_name)
+void send_data(sockstream *ss, char *ct, char *file_name)
 {
     /*
      * 发送一个最简化的 HTTP 响应：
@@ -254,16 +309,12 @@ void send_data(FILE *fp, char *ct, char *file_name)
     char protocol[] = "HTTP/1.0 200 OK\r\n";
     char server[] = "Server:Linux Web Server \r\n";
 
-    /*
-     * 注意：这里 Content-length 被写死为 2048，这是“示例化/不严谨”的地方
-     * - 实际应根据文件真实字节数计算
-     * - 否则浏览器可能等待更多数据或认为数据不足
-     */
-    char cnt_len[] = "Content-length:2048\r\n";
-
+    char cnt_len[SMALL_BUF];
     char cnt_type[SMALL_BUF];
     char buf[BUF_SIZE];
+    size_t n;
     FILE *send_file;
+    struct stat st;
 
     /*
      * Content-type 头：
@@ -277,46 +328,44 @@ void send_data(FILE *fp, char *ct, char *file_name)
      * - 以文本方式 "r" 打开（示例只处理文本）
      * - 若文件不存在，返回错误响应
      */
-    send_file = fopen(file_name, "r");
+    send_file = fopen(file_name, "rb");
     if (send_file == NULL)
     {
-        send_error(fp);
+        send_error(ss);
+        return;
+    }
+
+    /*
+     * Content-length 必须是文件的真实字节数：
+     * - 写多了浏览器会一直等待剩余数据，写少了会截断内容
+     * - 用 fstat 取得已打开文件的大小；目录等非普通文件按错误处理
+     */
+    if (fstat(fileno(send_file), &st) == -1 || !S_ISREG(st.st_mode))
+    {
+        fclose(send_file);
+        send_error(ss);
         return;
     }
+    sprintf(cnt_len, "Content-length:%lld\r\n", (long long)st.st_size);
 
     /* -------- 发送响应头 -------- */
-    fputs(protocol, fp);
-    fputs(server, fp);
-    fputs(cnt_len, fp);
-    fputs(cnt_type, fp);
+    ss_puts(ss, protocol);
+    ss_puts(ss, server);
+    ss_puts(ss, cnt_len);
+    ss_puts(ss, cnt_type);
 
     /* -------- 发送响应体（文件内容） --------
      *
-     * 教学重点：这里用 fgets/fputs 逐行发送
-     * - 适合纯文本文件
-     * - 对二进制文件（图片、压缩包）不适用，会破坏内容
-     * - 更通用做法应使用 fread/fwrite 按字节块发送
-     *
-     * 由于 stdio 有缓冲，示例里每行发送后 fflush(fp)，保证尽快发出
-     * （严格来说并不需要每行都 flush，末尾 flush 一次也可，但这里为了演示“立即发送”）
+     * 按字节块读取文件并写入流（以前用 fgets/fputs 逐行发送，对二进制文件会破坏内容）：
+     * - 响应头和文件内容都进写缓冲，写缓冲满了才真正 write 到 socket
+     * - 不需要每行 fflush，剩余部分由调用方的 ss_close 写出
      */
-    while (fgets(buf, BUF_SIZE, send_file) != NULL)
+    while ((n = fread(buf, 1, BUF_SIZE, send_file)) > 0)
     {
-        fputs(buf, fp);
-        fflush(fp);
+        if (ss_write(ss, buf, n) == -1)
+            break;
     }
-
-    /*
-     * 最后再 flush 一次，确保缓冲区内容都写到 socket
-     */
-    fflush(fp);
-
-    /*
-     * 关闭输出流：
-     * - fclose(fp) 会关闭它底层的 FD（也就是 dup 出来的 socket FD）
-     * - 对客户端而言，服务器发送完毕后关闭连接（HTTP/1.0 常见行为）
-     */
-    fclose(fp);
+    fclose(send_file);
 }
 
 char *content_type(char *file)
@@ -353,40 +402,33 @@ char *content_type(char *file)
         return "text/plain";
 }
 
-void send_error(FILE *fp)
+void send_error(sockstream *ss)
 {
     /*
      * 发送一个非常简化的错误响应（400 Bad Request）：
      * - 响应行：HTTP/1.0 400 Bad Request
      * - 响应头：Server、Content-length、Content-type
-     * - 响应体：一段简单的 HTML 错误页面
-     *
-     * 同样注意：
-     * - Content-length 写死为 2048，不严谨
+     * - 响应体：一段简单的 HTML 错误页面，Content-length 为它的字节数
      */
     char protocol[] = "HTTP/1.0 400 Bad Request\r\n";
     char server[] = "Server:Linux Web Server \r\n";
-    char cnt_len[] = "Content-length:2048\r\n";
+    char cnt_len[SMALL_BUF];
     char cnt_type[] = "Content-type:text/html\r\n\r\n";
     char content[] = "<html><head><title>NETWORK</title></head>"
                      "<body><font size=+5><br>发生错误! 查看请求文件名和请求方式!"
                      "</font></body></html>";
 
-    /*
-     * 发送响应行与响应头
-     */
-    fputs(protocol, fp);
-    fputs(server, fp);
-    fputs(cnt_len, fp);
-    fputs(cnt_type, fp);
+    sprintf(cnt_len, "Content-length:%d\r\n", (int)strlen(content));
 
     /*
-     * 教学提示（不改代码，仅说明）：
-     * - 这里并没有把 content（错误页面正文）写出去，浏览器可能收到空正文
-     * - 更完整应 fputs(content, fp)
-     * - 但题目要求不改代码，所以仅在注释指出
+     * 发送响应行、响应头和错误页面正文
      */
-    fflush(fp);
+    ss_puts(ss, protocol);
+    ss_puts(ss, server);
+    ss_puts(ss, cnt_len);
+    ss_puts(ss, cnt_type);
+    ss_puts(ss, content);
+    ss_flush(ss);
 }
 
 void error_handling(char *message)